@@ -0,0 +1,196 @@
+#ifndef ADAPTIVE_SAMPLER_H
+#define ADAPTIVE_SAMPLER_H
+
+#include <stdint.h>
+#include <math.h>
+
+/**
+ * @brief Per-channel sampling limits and activity thresholds.
+ *
+ * Activity is the smoothed rate of change divided by slopeScale, so 1.0 means
+ * "moving at the rate we consider significant for this channel".
+ */
+struct SamplerConfig {
+    uint32_t minIntervalMs;   // Ceiling rate while the signal is moving
+    uint32_t maxIntervalMs;   // Floor rate while the signal is flat
+    float slopeScale;         // Units per second considered significant
+    float activityHigh;       // Enter fast mode above this activity
+    float activityLow;        // Leave fast mode below this activity (hysteresis)
+};
+
+/**
+ * @brief Event-driven sampling scheduler.
+ *
+ * Each channel estimates its local rate of change incrementally (EWMA of
+ * |dv/dt|) and shrinks its interval towards minIntervalMs while active, then
+ * backs off towards maxIntervalMs once the signal is flat again.
+ *
+ * A global token bucket caps the bus time spent on reads. Samples faster than
+ * the floor rate are only granted when the bucket holds enough budget for the
+ * channel's measured read cost, so speeding up can never saturate the buses.
+ * Floor-rate samples are always granted.
+ *
+ * No allocation, no Arduino dependency: the caller passes millis()/micros().
+ */
+template <uint8_t N>
+class AdaptiveSampler {
+public:
+    /**
+     * @param busBudgetMsPerSec Bus time (ms) that may be spent per second of wall time.
+     */
+    explicit AdaptiveSampler(uint32_t busBudgetMsPerSec = 250)
+        : _budgetMsPerSec(busBudgetMsPerSec), _tokensUs((int32_t)busBudgetMsPerSec * 1000), _lastRefillMs(0) {
+        for (uint8_t i = 0; i < N; i++) {
+            _cfg[i] = { 1000, 30000, 1.0f, 1.0f, 0.3f };
+            _state[i] = State();
+            _state[i].intervalMs = _cfg[i].maxIntervalMs;
+        }
+    }
+
+    void configure(uint8_t ch, const SamplerConfig& cfg) {
+        if (ch >= N) return;
+        _cfg[ch] = cfg;
+        _state[ch].intervalMs = cfg.maxIntervalMs;
+    }
+
+    /**
+     * @brief Sets the global bus-time budget (ms of bus activity per second).
+     */
+    void setBusBudget(uint32_t busBudgetMsPerSec) {
+        _budgetMsPerSec = busBudgetMsPerSec;
+    }
+
+    /**
+     * @brief Returns true when channel ch should be read now.
+     */
+    bool isDue(uint8_t ch, uint32_t nowMs) {
+        if (ch >= N) return false;
+        refill(nowMs);
+
+        State& s = _state[ch];
+        if (!s.started) return true;
+
+        uint32_t elapsed = nowMs - s.lastSampleMs;
+        if (elapsed < s.intervalMs) return false;
+
+        // Floor-rate samples are unconditional
+        if (elapsed >= _cfg[ch].maxIntervalMs) return true;
+
+        // Faster-than-floor samples must fit the bus budget
+        if (_tokensUs < (int32_t)s.costUs) {
+            s.deferred++;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Records a successful read.
+     * @param busyUs Time the read held its bus (micros() delta).
+     */
+    void record(uint8_t ch, uint32_t nowMs, float value, uint32_t busyUs) {
+        if (ch >= N) return;
+        State& s = _state[ch];
+        spend(s, busyUs);
+
+        if (s.hasValue && !isnan(value)) {
+            uint32_t dt = nowMs - s.lastValueMs;
+            if (dt > 0) {
+                float slope = fabsf(value - s.lastValue) * 1000.0f / (float)dt;
+                float activity = slope / _cfg[ch].slopeScale;
+                s.activity += ALPHA * (activity - s.activity);
+            }
+        }
+        if (!isnan(value)) {
+            s.lastValue = value;
+            s.lastValueMs = nowMs;
+            s.hasValue = true;
+        }
+
+        // Hysteresis between fast and slow mode. An event jumps straight to the
+        // ceiling rate; the back-off towards the floor is gradual.
+        if (!s.fast && s.activity > _cfg[ch].activityHigh) {
+            s.fast = true;
+            s.intervalMs = _cfg[ch].minIntervalMs;
+        } else if (s.fast && s.activity < _cfg[ch].activityLow) {
+            s.fast = false;
+        }
+
+        if (s.fast) {
+            s.intervalMs = s.intervalMs / 2;
+            if (s.intervalMs < _cfg[ch].minIntervalMs) s.intervalMs = _cfg[ch].minIntervalMs;
+        } else {
+            s.intervalMs = s.intervalMs + s.intervalMs / 2;
+            if (s.intervalMs > _cfg[ch].maxIntervalMs) s.intervalMs = _cfg[ch].maxIntervalMs;
+        }
+
+        s.lastSampleMs = nowMs;
+        s.started = true;
+    }
+
+    /**
+     * @brief Records a failed read. Bus time is still charged, cadence is kept.
+     */
+    void recordFailure(uint8_t ch, uint32_t nowMs, uint32_t busyUs) {
+        if (ch >= N) return;
+        State& s = _state[ch];
+        spend(s, busyUs);
+        s.lastSampleMs = nowMs;
+        s.started = true;
+    }
+
+    /**
+     * @brief Current sampling rate of channel ch in Hz.
+     */
+    float rateHz(uint8_t ch) const {
+        if (ch >= N || _state[ch].intervalMs == 0) return 0;
+        return 1000.0f / (float)_state[ch].intervalMs;
+    }
+
+    uint32_t intervalMs(uint8_t ch) const { return ch < N ? _state[ch].intervalMs : 0; }
+    float activity(uint8_t ch) const { return ch < N ? _state[ch].activity : 0; }
+    bool isFast(uint8_t ch) const { return ch < N && _state[ch].fast; }
+    uint32_t deferredCount(uint8_t ch) const { return ch < N ? _state[ch].deferred : 0; }
+    int32_t budgetRemainingUs() const { return _tokensUs; }
+
+private:
+    static constexpr float ALPHA = 0.4f;       // EWMA weight of the newest slope
+    static constexpr float COST_ALPHA = 0.25f; // EWMA weight of the newest read cost
+
+    struct State {
+        uint32_t intervalMs = 0;
+        uint32_t lastSampleMs = 0;
+        uint32_t lastValueMs = 0;
+        uint32_t costUs = 0;
+        uint32_t deferred = 0;
+        float lastValue = 0;
+        float activity = 0;
+        bool hasValue = false;
+        bool started = false;
+        bool fast = false;
+    };
+
+    void refill(uint32_t nowMs) {
+        uint32_t dt = nowMs - _lastRefillMs;
+        _lastRefillMs = nowMs;
+        int32_t cap = (int32_t)_budgetMsPerSec * 1000;
+        // budget ms/s == budget us/ms
+        int64_t tokens = (int64_t)_tokensUs + (int64_t)dt * _budgetMsPerSec;
+        _tokensUs = tokens > cap ? cap : (int32_t)tokens;
+    }
+
+    void spend(State& s, uint32_t busyUs) {
+        s.costUs = s.costUs == 0 ? busyUs : (uint32_t)(s.costUs + COST_ALPHA * ((float)busyUs - (float)s.costUs));
+        int32_t minTokens = -(int32_t)_budgetMsPerSec * 1000;
+        int64_t tokens = (int64_t)_tokensUs - busyUs;
+        _tokensUs = tokens < minTokens ? minTokens : (int32_t)tokens;
+    }
+
+    SamplerConfig _cfg[N];
+    State _state[N];
+    uint32_t _budgetMsPerSec;
+    int32_t _tokensUs;
+    uint32_t _lastRefillMs;
+};
+
+#endif // ADAPTIVE_SAMPLER_H
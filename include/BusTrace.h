@@ -0,0 +1,337 @@
+#ifndef BUS_TRACE_H
+#define BUS_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "Channels.h"
+
+// ============================================================================
+// Bus Trace Format
+// ============================================================================
+// Compact binary record of the bus traffic seen by SensorReader, replayed on
+// the host (test/native/sim) against the same SensorReader code.
+//
+// A trace is a sequence of chunks; every chunk starts with a header so chunks
+// can be decoded on their own and concatenated into a file:
+//
+//   header : u8 0x00, 'B', 'T', u8 version, u32 startUs (little-endian)
+//   record : u8 (type << 4 | bus), varint dtUs (since previous record), payload
+//
+//   TR_CYCLE      u8 hardware slot        (a scheduled read starts)
+//   TR_UART_RX    u8 len, len bytes       (bytes read from a UART)
+//   TR_UART_TX    u8 len, len bytes       (bytes written to a UART)
+//   TR_I2C_PROBE  u8 address, u8 result   (Wire.endTransmission() code)
+//   TR_OP         u8 op, i16 result, u8 n, n x f32   (driver call and outputs)
+
+static const uint8_t BUS_TRACE_VERSION = 1;
+static const size_t BUS_TRACE_HEADER_SIZE = 8;
+static const uint8_t BUS_TRACE_MAX_VALUES = 4;
+
+enum TraceRecordType : uint8_t {
+    TR_HEADER = 0,
+    TR_CYCLE,
+    TR_UART_RX,
+    TR_UART_TX,
+    TR_I2C_PROBE,
+    TR_OP,
+};
+
+/**
+ * @brief Driver-level operations (libraries that own their bus traffic).
+ */
+enum TraceOp : uint8_t {
+    OP_SGP40_BEGIN = 1,
+    OP_SGP40_VOC,           // result: VOC index
+    OP_SGP30_BEGIN,
+    OP_SGP30_INIT,
+    OP_SGP30_MEASURE,       // values: eCO2, TVOC
+    OP_SGP30_HUMIDITY,
+    OP_SPS30_WAKEUP,        // result: Sensirion error code
+    OP_SPS30_STOP,
+    OP_SPS30_RESET,
+    OP_SPS30_SERIAL,
+    OP_SPS30_START,
+    OP_SPS30_READ,          // values: PM1, PM2.5, PM4, PM10
+    OP_BMP_BEGIN,
+    OP_BMP_PRESSURE,        // values: Pa
+    OP_BMP_TEMPERATURE,     // values: °C
+    OP_SHT_BEGIN,
+    OP_SHT_RESET,
+    OP_SHT_READ,            // values: °C, %
+    OP_DHT_FRAME,           // result: DhtStatus, values: °C, %
+};
+
+/**
+ * @brief One decoded record. data points into the trace buffer.
+ */
+struct TraceRecord {
+    TraceRecordType type;
+    uint8_t bus;
+    uint64_t timeUs;        // Absolute, from the chunk start times
+    uint8_t hw;             // TR_CYCLE
+    uint8_t address;        // TR_I2C_PROBE
+    uint8_t op;             // TR_OP
+    int16_t result;         // TR_I2C_PROBE, TR_OP
+    uint8_t len;            // TR_UART_*: byte count, TR_OP: value count
+    const uint8_t* data;    // TR_UART_*
+    float values[BUS_TRACE_MAX_VALUES];
+};
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+/**
+ * @brief Appends records to a fixed buffer and hands full chunks to a sink
+ * (side channel, flash file...). No allocation.
+ *
+ * Consecutive UART reads on the same bus less than MERGE_US apart are merged
+ * into one record.
+ */
+class BusTraceWriter {
+public:
+    // Returns false if the chunk could not be stored / sent (counted as dropped)
+    typedef bool (*Sink)(const uint8_t* data, size_t len, void* ctx);
+
+    static const uint32_t MERGE_US = 100;
+
+    BusTraceWriter(uint8_t* buffer, size_t size, Sink sink, void* ctx = nullptr)
+        : _buf(buffer), _size(size), _sink(sink), _ctx(ctx) {}
+
+    void cycle(uint32_t nowUs, uint8_t bus, uint8_t hw) {
+        if (!open(nowUs, TR_CYCLE, bus, 1)) return;
+        put8(hw);
+    }
+
+    void uart(uint32_t nowUs, uint8_t bus, bool rx, const uint8_t* data, size_t len) {
+        while (len > 0) {
+            TraceRecordType type = rx ? TR_UART_RX : TR_UART_TX;
+            // Extend the previous record when it is the same burst
+            if (_lastLen > 0 && _lastType == type && _lastBus == bus && nowUs - _lastUs < MERGE_US &&
+                _buf[_lastLen] < 255 && _pos < _size) {
+                size_t n = 255 - _buf[_lastLen];
+                if (n > len) n = len;
+                if (n > _size - _pos) n = _size - _pos;
+                memcpy(_buf + _pos, data, n);
+                _pos += n;
+                _buf[_lastLen] += (uint8_t)n;
+                data += n;
+                len -= n;
+                continue;
+            }
+            size_t n = len > 255 ? 255 : len;
+            if (!open(nowUs, type, bus, 1 + n)) return;
+            _lastLen = _pos;
+            put8((uint8_t)n);
+            memcpy(_buf + _pos, data, n);
+            _pos += n;
+            data += n;
+            len -= n;
+        }
+    }
+
+    void probe(uint32_t nowUs, uint8_t bus, uint8_t address, uint8_t result) {
+        if (!open(nowUs, TR_I2C_PROBE, bus, 2)) return;
+        put8(address);
+        put8(result);
+    }
+
+    void op(uint32_t nowUs, uint8_t bus, uint8_t op, int16_t result, const float* values, uint8_t count) {
+        if (count > BUS_TRACE_MAX_VALUES) count = BUS_TRACE_MAX_VALUES;
+        if (!open(nowUs, TR_OP, bus, 4 + 4 * count)) return;
+        put8(op);
+        put8((uint8_t)(result & 0xFF));
+        put8((uint8_t)((uint16_t)result >> 8));
+        put8(count);
+        for (uint8_t i = 0; i < count; i++) {
+            memcpy(_buf + _pos, &values[i], sizeof(float));
+            _pos += sizeof(float);
+        }
+    }
+
+    /**
+     * @brief Sends the current chunk to the sink.
+     */
+    void flush() {
+        if (_pos > BUS_TRACE_HEADER_SIZE) {
+            if (!_sink || !_sink(_buf, _pos, _ctx)) _droppedChunks++;
+        }
+        _pos = 0;
+        _lastLen = 0;
+    }
+
+    size_t size() const { return _pos; }
+    uint32_t droppedChunks() const { return _droppedChunks; }
+
+private:
+    // Starts a record (flushing first if it does not fit), false if it never fits
+    bool open(uint32_t nowUs, TraceRecordType type, uint8_t bus, size_t payload) {
+        size_t need = 1 + 5 + payload;
+        if (BUS_TRACE_HEADER_SIZE + need > _size) return false;
+        if (_pos > 0 && _pos + need > _size) flush();
+        if (_pos == 0) {
+            put8(TR_HEADER);
+            put8('B');
+            put8('T');
+            put8(BUS_TRACE_VERSION);
+            put32(nowUs);
+            _prevUs = nowUs;
+        }
+        put8((uint8_t)(type << 4 | (bus & 0x0F)));
+        putVarint(nowUs - _prevUs);
+        _prevUs = nowUs;
+        _lastType = type;
+        _lastBus = bus;
+        _lastUs = nowUs;
+        _lastLen = 0;
+        return true;
+    }
+
+    void put8(uint8_t v) { _buf[_pos++] = v; }
+
+    void put32(uint32_t v) {
+        for (int i = 0; i < 4; i++) put8((v >> (8 * i)) & 0xFF);
+    }
+
+    void putVarint(uint32_t v) {
+        while (v >= 0x80) {
+            put8((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        put8((uint8_t)v);
+    }
+
+    uint8_t* _buf;
+    size_t _size;
+    Sink _sink;
+    void* _ctx;
+    size_t _pos = 0;
+    uint32_t _prevUs = 0;
+    uint32_t _droppedChunks = 0;
+
+    // Last record, for UART merging (_lastLen: offset of its length byte)
+    TraceRecordType _lastType = TR_HEADER;
+    uint8_t _lastBus = 0;
+    uint32_t _lastUs = 0;
+    size_t _lastLen = 0;
+};
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+/**
+ * @brief Iterates the records of a trace (one or more concatenated chunks).
+ */
+class BusTraceReader {
+public:
+    BusTraceReader(const uint8_t* data, size_t len) : _data(data), _len(len) {}
+
+    /**
+     * @brief Decodes the next record. Returns false at the end or on a
+     * malformed record (then error() is true).
+     */
+    bool next(TraceRecord& r) {
+        while (_pos < _len) {
+            uint8_t tag = _data[_pos];
+            if ((tag >> 4) == TR_HEADER) {
+                if (!readHeader()) return fail();
+                continue;
+            }
+            if (!_started) return fail();
+            _pos++;
+
+            uint32_t dt;
+            if (!getVarint(dt)) return fail();
+            _timeUs += dt;
+
+            memset(&r, 0, sizeof(r));
+            r.type = (TraceRecordType)(tag >> 4);
+            r.bus = tag & 0x0F;
+            r.timeUs = _timeUs;
+
+            switch (r.type) {
+                case TR_CYCLE:
+                    if (!need(1)) return fail();
+                    r.hw = _data[_pos++];
+                    return true;
+                case TR_UART_RX:
+                case TR_UART_TX:
+                    if (!need(1)) return fail();
+                    r.len = _data[_pos++];
+                    if (!need(r.len)) return fail();
+                    r.data = _data + _pos;
+                    _pos += r.len;
+                    return true;
+                case TR_I2C_PROBE:
+                    if (!need(2)) return fail();
+                    r.address = _data[_pos++];
+                    r.result = _data[_pos++];
+                    return true;
+                case TR_OP:
+                    if (!need(4)) return fail();
+                    r.op = _data[_pos];
+                    r.result = (int16_t)(_data[_pos + 1] | (_data[_pos + 2] << 8));
+                    r.len = _data[_pos + 3];
+                    _pos += 4;
+                    if (r.len > BUS_TRACE_MAX_VALUES || !need(4 * r.len)) return fail();
+                    for (uint8_t i = 0; i < r.len; i++) {
+                        memcpy(&r.values[i], _data + _pos, sizeof(float));
+                        _pos += sizeof(float);
+                    }
+                    return true;
+                default:
+                    return fail();
+            }
+        }
+        return false;
+    }
+
+    bool error() const { return _error; }
+
+private:
+    bool readHeader() {
+        if (!need(BUS_TRACE_HEADER_SIZE)) return false;
+        const uint8_t* h = _data + _pos;
+        if (h[1] != 'B' || h[2] != 'T' || h[3] != BUS_TRACE_VERSION) return false;
+        uint32_t startUs = h[4] | (h[5] << 8) | (h[6] << 16) | ((uint32_t)h[7] << 24);
+        // Chunk start times are 32-bit micros(): keep the timeline monotonic
+        if (!_started) {
+            _timeUs = startUs;
+        } else {
+            _timeUs += (uint32_t)(startUs - (uint32_t)_timeUs);
+        }
+        _started = true;
+        _pos += BUS_TRACE_HEADER_SIZE;
+        return true;
+    }
+
+    bool getVarint(uint32_t& v) {
+        v = 0;
+        for (uint8_t shift = 0; shift < 35; shift += 7) {
+            if (_pos >= _len) return false;
+            uint8_t b = _data[_pos++];
+            v |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    bool need(size_t n) const { return _pos + n <= _len; }
+
+    bool fail() {
+        _error = true;
+        _pos = _len;
+        return false;
+    }
+
+    const uint8_t* _data;
+    size_t _len;
+    size_t _pos = 0;
+    uint64_t _timeUs = 0;
+    bool _started = false;
+    bool _error = false;
+};
+
+#endif // BUS_TRACE_H
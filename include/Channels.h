@@ -0,0 +1,108 @@
+#ifndef CHANNELS_H
+#define CHANNELS_H
+
+#include <stdint.h>
+
+// ============================================================================
+// Hardware / Bus Table
+// ============================================================================
+// One slot per SensorReader read group. Kept free of Arduino includes so the
+// same table can be used by host-side tools and tests.
+
+/**
+ * @brief Physical bus a hardware slot talks over.
+ */
+enum BusId : uint8_t {
+    BUS_I2C_MAIN = 0,   // Wire (GPIO 21/22)
+    BUS_I2C_SGP,        // wireSGP (GPIO 32/33)
+    BUS_UART_CO2,       // UART2 - MH-Z14A
+    BUS_UART_SPS30,     // UART1 - SPS30
+    BUS_SOFT_CO,        // SoftwareSerial - SC16-CO
+    BUS_GPIO_DHT,       // Single-wire - DHT22
+    BUS_COUNT
+};
+
+/**
+ * @brief Hardware read groups, in loop() order.
+ */
+enum HardwareSlot : uint8_t {
+    HW_MHZ14A = 0,
+    HW_DHT22,
+    HW_SGP40,
+    HW_SGP30,
+    HW_SPS30,
+    HW_BMP280,
+    HW_SHT31,
+    HW_SC16CO,
+    HW_COUNT
+};
+
+struct HardwareInfo {
+    const char* id;     // Hardware ID used in MQTT topics
+    const char* name;   // Human readable name sent at registration
+    BusId bus;
+};
+
+static const HardwareInfo HARDWARE_TABLE[HW_COUNT] = {
+    { "mhz14a", "MH-Z14A CO2 Sensor",      BUS_UART_CO2   },
+    { "dht22",  "DHT22 Temp/Humidity",     BUS_GPIO_DHT   },
+    { "sgp40",  "SGP40 VOC Sensor",        BUS_I2C_SGP    },
+    { "sgp30",  "SGP30 eCO2/TVOC",         BUS_I2C_SGP    },
+    { "sps30",  "SPS30 Particulate",       BUS_UART_SPS30 },
+    { "bmp280", "BMP280 Pressure",         BUS_I2C_MAIN   },
+    { "sht31",  "SHT31 Temp/Humidity",     BUS_I2C_SGP    },
+    { "sc16co", "SC16-CO Carbon Monoxide", BUS_SOFT_CO    },
+};
+
+// ============================================================================
+// Measurement Channels
+// ============================================================================
+
+/**
+ * @brief One published measurement ({moduleId}/{hardwareId}/{measurement}).
+ */
+enum Channel : uint8_t {
+    CH_MHZ14A_CO2 = 0,
+    CH_DHT22_TEMPERATURE,
+    CH_DHT22_HUMIDITY,
+    CH_SGP40_VOC,
+    CH_SGP30_ECO2,
+    CH_SGP30_TVOC,
+    CH_SPS30_PM1,
+    CH_SPS30_PM25,
+    CH_SPS30_PM4,
+    CH_SPS30_PM10,
+    CH_BMP280_PRESSURE,
+    CH_BMP280_TEMPERATURE,
+    CH_SHT31_TEMPERATURE,
+    CH_SHT31_HUMIDITY,
+    CH_SC16CO_CO,
+    CH_COUNT
+};
+
+struct ChannelInfo {
+    HardwareSlot hw;
+    const char* measurement;
+    float step;         // Quantization step for compact (int16) storage
+    uint8_t decimals;   // Published payload precision (TopicTable.h)
+};
+
+static const ChannelInfo CHANNEL_TABLE[CH_COUNT] = {
+    { HW_MHZ14A, "co2",         1.0f,  0 },   // ppm
+    { HW_DHT22,  "temperature", 0.01f, 2 },   // °C
+    { HW_DHT22,  "humidity",    0.1f,  1 },   // %
+    { HW_SGP40,  "voc",         1.0f,  0 },   // index 0-500
+    { HW_SGP30,  "eco2",        2.0f,  0 },   // ppm (up to 60000)
+    { HW_SGP30,  "tvoc",        2.0f,  0 },   // ppb (up to 60000)
+    { HW_SPS30,  "pm1",         0.1f,  1 },   // µg/m³
+    { HW_SPS30,  "pm25",        0.1f,  1 },
+    { HW_SPS30,  "pm4",         0.1f,  1 },
+    { HW_SPS30,  "pm10",        0.1f,  1 },
+    { HW_BMP280, "pressure",    0.1f,  2 },   // hPa
+    { HW_BMP280, "temperature", 0.01f, 2 },   // °C
+    { HW_SHT31,  "temperature", 0.01f, 2 },   // °C
+    { HW_SHT31,  "humidity",    0.1f,  1 },   // %
+    { HW_SC16CO, "co",          1.0f,  0 },   // ppm
+};
+
+#endif // CHANNELS_H
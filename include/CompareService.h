@@ -0,0 +1,74 @@
+#ifndef COMPARE_SERVICE_H
+#define COMPARE_SERVICE_H
+
+#include <Arduino.h>
+#include "Channels.h"
+#include "profile.h"
+#include "PairStats.h"
+#include "SideChannel.h"
+
+/**
+ * @brief On-device comparison of the redundant channels (PairStats.h pairs).
+ *
+ * A pair sample is taken once both channels published since the previous
+ * one, at the second of the two values, if the first is at most maxSkewMs
+ * old: a pair yields one sample per update of its slower channel, whatever
+ * the rate of the other. Per pair, over a sliding
+ * window and over the lifetime: bias (mean b - a), RMS difference, Pearson r
+ * and drift (slope of b - a, units per hour). Published as JSON on
+ * {moduleId}/compare:
+ *
+ *   {"uptime":123,"windowS":3600,"pairs":[{"pair":"temperature/sht31-dht22",
+ *     "window":{"n":..,"bias":..,"rms":..,"r":..,"drift":..},"lifetime":{...}}]}
+ *
+ * Only pairs whose two sensors are compiled in have storage.
+ */
+class CompareService {
+public:
+    static const char* TOPIC;   // "compare"
+    static const uint8_t WINDOW_BLOCKS = 12;
+
+    CompareService(SideChannel& channel, unsigned long intervalMs = 60000,
+                   uint32_t blockMs = 300000, uint32_t maxSkewMs = 30000);
+
+    /**
+     * @brief Feeds one published value. Completes a pair sample when the
+     * partner published since the last one.
+     */
+    void observe(Channel ch, float value, uint32_t nowMs);
+
+    /**
+     * @brief Publishes the report when the interval elapsed. Call from loop().
+     */
+    void loop(unsigned long nowMs);
+
+private:
+    // Pairs with both sensors in the active profile (see COMPARE_PAIRS)
+    static const uint8_t STORED_PAIRS_RAW =
+        (SENSOR_SHT31 && SENSOR_DHT22) * 2 + (SENSOR_SHT31 && SENSOR_BMP280) +
+        (SENSOR_DHT22 && SENSOR_BMP280) + (SENSOR_MHZ14A && SENSOR_SGP30);
+    static const uint8_t STORED_PAIRS = STORED_PAIRS_RAW > 0 ? STORED_PAIRS_RAW : 1;
+
+    // _fresh bits: channel updated since the last sample of the pair
+    static const uint8_t FRESH_A = 0x01;
+    static const uint8_t FRESH_B = 0x02;
+
+    size_t appendMoments(size_t pos, const char* key, const PairMoments& m);
+
+    SideChannel& _channel;
+    unsigned long _intervalMs;
+    unsigned long _lastReport = 0;
+    uint32_t _maxSkewMs;
+
+    PairStats<WINDOW_BLOCKS> _stats[STORED_PAIRS];
+    uint8_t _pair[STORED_PAIRS];        // _stats index -> COMPARE_PAIRS index
+    uint8_t _pairCount = 0;
+    uint8_t _fresh[STORED_PAIRS] = {};
+
+    float _last[CH_COUNT];
+    uint32_t _lastMs[CH_COUNT];
+
+    char _report[1536];
+};
+
+#endif // COMPARE_SERVICE_H
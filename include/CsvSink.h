@@ -0,0 +1,120 @@
+#ifndef CSV_SINK_H
+#define CSV_SINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "SampleSink.h"
+#include "TopicTable.h"
+
+// ============================================================================
+// CSV Sample Sink
+// ============================================================================
+// One line per value, for a serial plotter or a logger on the USB port:
+//
+//   time_ms,hardware,measurement,value
+//   183004,sht31,temperature,21.37
+//   # dropped 2
+//
+// Lines are only written whole, when the transport has room for them (the
+// loop never waits on a full UART buffer); the rest of the set waits for the
+// next pass. Sets that arrive while 4 are pending push out the oldest one,
+// reported by a comment line.
+//
+// Pure logic (no Arduino dependency): the transport is a pair of callbacks.
+
+/**
+ * @tparam Topics TopicTable the sample handles refer to
+ */
+template <typename Topics>
+class CsvSink : public SampleSink {
+public:
+    typedef void (*WriteFn)(const char* data, size_t len, void* ctx);
+    typedef size_t (*RoomFn)(void* ctx);    // Bytes the transport takes without blocking
+
+    static const size_t LINE_SIZE = 96;
+
+    CsvSink(const Topics& topics, WriteFn write, RoomFn room, void* ctx = nullptr)
+        : SampleSink(MAX_DEPTH, SINK_DROP_OLDEST, 0), _topics(topics), _write(write), _room(room), _ctx(ctx) {}
+
+    uint32_t lines() const { return _lines; }
+
+protected:
+    uint8_t consume(const SampleSet& set, uint8_t from, uint32_t) override {
+        char line[LINE_SIZE];
+        if (!_headerSent) {
+            static const char HEADER[] = "time_ms,hardware,measurement,value\n";
+            if (!send(HEADER, sizeof(HEADER) - 1)) return from;
+            _headerSent = true;
+        }
+        if (dropped() != _droppedReported) {
+            size_t len = 0;
+            append(line, len, "# dropped ", 10);
+            len += formatUnsigned(line + len, dropped() - _droppedReported);
+            line[len++] = '\n';
+            if (!send(line, len)) return from;
+            _droppedReported = dropped();
+        }
+        for (uint8_t i = from; i < set.size(); i++) {
+            size_t len = encode(set, set[i], line);
+            if (len > 0 && !send(line, len)) return i;
+            _lines += len > 0;
+        }
+        return set.size();
+    }
+
+private:
+    /**
+     * @brief Writes one line, 0 when it does not fit (topic too long or
+     * unknown).
+     */
+    size_t encode(const SampleSet& set, const Sample& s, char* line) const {
+        const char* label = _topics.label(s.topic);
+        if (!label) return 0;
+        size_t labelLength = strlen(label);
+        // time, ',' label ',' value '\n'
+        if (10 + 1 + labelLength + 1 + FIXED_MAX_CHARS + 1 > LINE_SIZE) return 0;
+
+        size_t len = formatUnsigned(line, set.timeMs());
+        line[len++] = ',';
+        size_t start = len;
+        append(line, len, label, labelLength);
+        line[start + _topics.hardwareIdLength(s.topic)] = ',';   // hardware/measurement
+        line[len++] = ',';
+        len += _topics.render(s.topic, s.value, line + len, FIXED_MAX_CHARS);
+        line[len++] = '\n';
+        return len;
+    }
+
+    bool send(const char* data, size_t len) {
+        if (_room(_ctx) < len) return false;
+        _write(data, len, _ctx);
+        return true;
+    }
+
+    static void append(char* line, size_t& len, const char* s, size_t n) {
+        memcpy(line + len, s, n);
+        len += n;
+    }
+
+    static size_t formatUnsigned(char* out, uint32_t v) {
+        char digits[10];
+        size_t n = 0;
+        do {
+            digits[n++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v > 0);
+        for (size_t i = 0; i < n; i++) out[i] = digits[n - 1 - i];
+        return n;
+    }
+
+    const Topics& _topics;
+    WriteFn _write;
+    RoomFn _room;
+    void* _ctx;
+    bool _headerSent = false;
+    uint32_t _droppedReported = 0;
+    uint32_t _lines = 0;
+};
+
+#endif // CSV_SINK_H
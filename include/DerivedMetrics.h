@@ -0,0 +1,350 @@
+#ifndef DERIVED_METRICS_H
+#define DERIVED_METRICS_H
+
+#include <stdint.h>
+#include <math.h>
+#include "Channels.h"
+
+// ============================================================================
+// Thermodynamics
+// ============================================================================
+
+/**
+ * @brief Saturation vapour pressure (hPa), Magnus formula over water.
+ */
+inline float saturationVaporPressure(float tempC) {
+    return 6.112f * expf(17.62f * tempC / (243.12f + tempC));
+}
+
+/**
+ * @brief Dew point (°C) from temperature (°C) and relative humidity (%).
+ */
+inline float dewPoint(float tempC, float rh) {
+    if (rh <= 0) return NAN;
+    float gamma = logf(rh / 100.0f) + 17.62f * tempC / (243.12f + tempC);
+    return 243.12f * gamma / (17.62f - gamma);
+}
+
+/**
+ * @brief Absolute humidity (g/m³) from temperature (°C) and relative humidity (%).
+ */
+inline float absoluteHumidity(float tempC, float rh) {
+    float vapour = rh / 100.0f * saturationVaporPressure(tempC);  // hPa
+    return 216.7f * vapour / (273.15f + tempC);
+}
+
+/**
+ * @brief Sea-level pressure (hPa) from station pressure, temperature and altitude.
+ */
+inline float seaLevelPressure(float pressureHpa, float tempC, float altitudeM) {
+    float h = 0.0065f * altitudeM;
+    return pressureHpa * powf(1.0f - h / (tempC + h + 273.15f), -5.257f);
+}
+
+/**
+ * @brief NDIR CO2 reading referred to standard pressure (1013.25 hPa).
+ * NDIR sensors count molecules per volume, so readings scale with pressure.
+ */
+inline float co2PressureCompensated(float ppm, float pressureHpa) {
+    if (pressureHpa <= 0) return NAN;
+    return ppm * 1013.25f / pressureHpa;
+}
+
+// ============================================================================
+// Air Quality Index (US EPA, 2024 PM2.5 breakpoints)
+// ============================================================================
+
+struct AqiBreakpoint {
+    float cLow, cHigh;
+    uint16_t iLow, iHigh;
+};
+
+static const AqiBreakpoint AQI_PM25[] = {
+    { 0.0f,   9.0f,   0,   50  },
+    { 9.1f,   35.4f,  51,  100 },
+    { 35.5f,  55.4f,  101, 150 },
+    { 55.5f,  125.4f, 151, 200 },
+    { 125.5f, 225.4f, 201, 300 },
+    { 225.5f, 325.4f, 301, 500 },
+};
+
+static const AqiBreakpoint AQI_PM10[] = {
+    { 0,   54,  0,   50  },
+    { 55,  154, 51,  100 },
+    { 155, 254, 101, 150 },
+    { 255, 354, 151, 200 },
+    { 355, 424, 201, 300 },
+    { 425, 604, 301, 500 },
+};
+
+/**
+ * @brief Linear AQI interpolation. Concentration is truncated to the table
+ * resolution (step) as specified by the EPA. Returns -1 for NAN.
+ */
+inline int aqiFromConcentration(float c, const AqiBreakpoint* table, uint8_t count, float step) {
+    if (isnan(c)) return -1;
+    if (c < 0) c = 0;
+    c = floorf(c / step) * step;
+    for (uint8_t i = 0; i < count; i++) {
+        const AqiBreakpoint& b = table[i];
+        if (c <= b.cHigh) {
+            return (int)roundf((b.iHigh - b.iLow) * (c - b.cLow) / (b.cHigh - b.cLow) + b.iLow);
+        }
+    }
+    return 500;
+}
+
+inline int aqiPm25(float c) { return aqiFromConcentration(c, AQI_PM25, 6, 0.1f); }
+inline int aqiPm10(float c) { return aqiFromConcentration(c, AQI_PM10, 6, 1.0f); }
+
+// ============================================================================
+// NowCast
+// ============================================================================
+
+/**
+ * @brief EPA NowCast over a fixed 12-slot ring of hourly averages.
+ *
+ * add() is O(1): samples accumulate into the current clock hour, which is
+ * pushed to the ring when the hour changes (missing hours become gaps).
+ * nowcast() weighs the current partial hour as the most recent hour so the
+ * value moves within the hour; it needs 2 of the 3 most recent hours.
+ */
+class NowCast {
+public:
+    static const uint8_t HOURS = 12;
+    static const uint32_t HOUR_MS = 3600000UL;
+
+    NowCast() {
+        for (uint8_t i = 0; i < HOURS; i++) _hourly[i] = NAN;
+    }
+
+    void add(float value, uint32_t nowMs) {
+        if (isnan(value)) return;
+        uint32_t hour = nowMs / HOUR_MS;
+        if (!_started) {
+            _hour = hour;
+            _started = true;
+        }
+        if (hour != _hour) {
+            closeHours(hour);
+        }
+        _sum += value;
+        _count++;
+    }
+
+    /**
+     * @brief NowCast concentration, NAN if not enough recent data.
+     */
+    float nowcast() const {
+        float c[HOURS];
+        // c[0] = current partial hour, c[i] = i-th previous full hour
+        c[0] = _count > 0 ? _sum / _count : NAN;
+        for (uint8_t i = 1; i < HOURS; i++) c[i] = at(i - 1);
+
+        uint8_t recent = 0;
+        for (uint8_t i = 0; i < 3; i++) if (!isnan(c[i])) recent++;
+        if (recent < 2) return NAN;
+
+        float cMin = INFINITY, cMax = -INFINITY;
+        for (uint8_t i = 0; i < HOURS; i++) {
+            if (isnan(c[i])) continue;
+            if (c[i] < cMin) cMin = c[i];
+            if (c[i] > cMax) cMax = c[i];
+        }
+        float w = cMax > 0 ? cMin / cMax : 1.0f;
+        if (w < 0.5f) w = 0.5f;
+
+        float num = 0, den = 0, weight = 1.0f;
+        for (uint8_t i = 0; i < HOURS; i++) {
+            if (!isnan(c[i])) {
+                num += weight * c[i];
+                den += weight;
+            }
+            weight *= w;
+        }
+        return den > 0 ? num / den : NAN;
+    }
+
+private:
+    // age 0 = last full hour
+    float at(uint8_t age) const {
+        return _hourly[(uint8_t)((_head + HOURS - age) % HOURS)];
+    }
+
+    void push(float v) {
+        _head = (uint8_t)((_head + 1) % HOURS);
+        _hourly[_head] = v;
+    }
+
+    void closeHours(uint32_t hour) {
+        push(_count > 0 ? _sum / _count : NAN);
+        uint32_t missing = hour - _hour - 1;
+        if (missing > HOURS) missing = HOURS;
+        for (uint32_t i = 0; i < missing; i++) push(NAN);
+        _hour = hour;
+        _sum = 0;
+        _count = 0;
+    }
+
+    float _hourly[HOURS];
+    uint8_t _head = HOURS - 1;
+    uint32_t _hour = 0;
+    float _sum = 0;
+    uint32_t _count = 0;
+    bool _started = false;
+};
+
+// ============================================================================
+// Derived Metrics Engine
+// ============================================================================
+
+/**
+ * @brief Values published under the "derived" hardware.
+ */
+enum DerivedMetric : uint8_t {
+    DM_DEW_POINT = 0,
+    DM_ABS_HUMIDITY,
+    DM_SEA_LEVEL_PRESSURE,
+    DM_CO2_COMPENSATED,
+    DM_PM25_NOWCAST,
+    DM_PM10_NOWCAST,
+    DM_AQI,
+    DM_COUNT
+};
+
+struct DerivedInfo {
+    const char* measurement;
+    HardwareSlot needs;     // Required hardware
+    HardwareSlot alt;       // Alternative source (HW_COUNT: none)
+    HardwareSlot also;      // Second required hardware (HW_COUNT: none)
+    uint8_t decimals;       // Published payload precision (TopicTable.h)
+};
+
+static const DerivedInfo DERIVED_TABLE[DM_COUNT] = {
+    { "dewpoint",           HW_SHT31,  HW_DHT22, HW_COUNT,  2 },   // °C
+    { "abs_humidity",       HW_SHT31,  HW_DHT22, HW_COUNT,  2 },   // g/m³
+    { "sea_level_pressure", HW_BMP280, HW_COUNT, HW_COUNT,  2 },   // hPa
+    { "co2_compensated",    HW_MHZ14A, HW_COUNT, HW_BMP280, 0 },   // ppm @ 1013.25 hPa
+    { "pm25_nowcast",       HW_SPS30,  HW_COUNT, HW_COUNT,  1 },   // µg/m³
+    { "pm10_nowcast",       HW_SPS30,  HW_COUNT, HW_COUNT,  1 },   // µg/m³
+    { "aqi",                HW_SPS30,  HW_COUNT, HW_COUNT,  0 },   // max(PM2.5, PM10) NowCast AQI
+};
+
+/**
+ * @brief True when the inputs of m can be produced by the given hardware set.
+ */
+inline bool derivedAvailable(uint8_t m, const bool* hardware) {
+    const DerivedInfo& d = DERIVED_TABLE[m];
+    bool source = hardware[d.needs] || (d.alt < HW_COUNT && hardware[d.alt]);
+    return source && (d.also >= HW_COUNT || hardware[d.also]);
+}
+
+/**
+ * @brief Incremental derived-metrics stage.
+ *
+ * observe() is called with every published (filtered) channel value and only
+ * stores it; compute() then evaluates each derived value once from the latest
+ * inputs. SHT31 is preferred over DHT22 as humidity source. Inputs older than
+ * maxAgeMs are ignored and the dependent values come out as NAN.
+ */
+class DerivedMetrics {
+public:
+    explicit DerivedMetrics(float altitudeM = 0, uint32_t maxAgeMs = 120000)
+        : _altitudeM(altitudeM), _maxAgeMs(maxAgeMs) {
+        for (uint8_t i = 0; i < INPUT_COUNT; i++) {
+            _inputs[i] = NAN;
+            _inputMs[i] = 0;
+        }
+    }
+
+    void observe(Channel ch, float value, uint32_t nowMs) {
+        if (isnan(value)) return;
+        if (ch == CH_SPS30_PM25) {
+            _pm25.add(value, nowMs);
+            _dirty = true;
+            return;
+        }
+        if (ch == CH_SPS30_PM10) {
+            _pm10.add(value, nowMs);
+            _dirty = true;
+            return;
+        }
+        int8_t in = inputFor(ch);
+        if (in < 0) return;
+        _inputs[in] = value;
+        _inputMs[in] = nowMs;
+        _dirty = true;
+    }
+
+    /**
+     * @brief True when an input changed since the last compute().
+     */
+    bool dirty() const { return _dirty; }
+
+    /**
+     * @brief Evaluates all derived values into out[DM_COUNT] (NAN if unavailable).
+     */
+    void compute(uint32_t nowMs, float* out) {
+        _dirty = false;
+
+        float t, rh;
+        if (fresh(IN_SHT_T, nowMs) && fresh(IN_SHT_RH, nowMs)) {
+            t = _inputs[IN_SHT_T];
+            rh = _inputs[IN_SHT_RH];
+        } else if (fresh(IN_DHT_T, nowMs) && fresh(IN_DHT_RH, nowMs)) {
+            t = _inputs[IN_DHT_T];
+            rh = _inputs[IN_DHT_RH];
+        } else {
+            t = rh = NAN;
+        }
+        out[DM_DEW_POINT] = isnan(rh) ? NAN : dewPoint(t, rh);
+        out[DM_ABS_HUMIDITY] = isnan(rh) ? NAN : absoluteHumidity(t, rh);
+
+        float p = fresh(IN_PRESSURE, nowMs) ? _inputs[IN_PRESSURE] : NAN;
+        float bmpT = fresh(IN_BMP_T, nowMs) ? _inputs[IN_BMP_T] : t;
+        out[DM_SEA_LEVEL_PRESSURE] = (isnan(p) || isnan(bmpT)) ? NAN : seaLevelPressure(p, bmpT, _altitudeM);
+        out[DM_CO2_COMPENSATED] = (isnan(p) || !fresh(IN_CO2, nowMs)) ? NAN
+                                  : co2PressureCompensated(_inputs[IN_CO2], p);
+
+        out[DM_PM25_NOWCAST] = _pm25.nowcast();
+        out[DM_PM10_NOWCAST] = _pm10.nowcast();
+        int a25 = aqiPm25(out[DM_PM25_NOWCAST]);
+        int a10 = aqiPm10(out[DM_PM10_NOWCAST]);
+        int aqi = a25 > a10 ? a25 : a10;
+        out[DM_AQI] = aqi < 0 ? NAN : (float)aqi;
+    }
+
+private:
+    enum Input : uint8_t {
+        IN_SHT_T = 0, IN_SHT_RH, IN_DHT_T, IN_DHT_RH,
+        IN_PRESSURE, IN_BMP_T, IN_CO2,
+        INPUT_COUNT
+    };
+
+    static int8_t inputFor(Channel ch) {
+        switch (ch) {
+            case CH_SHT31_TEMPERATURE:  return IN_SHT_T;
+            case CH_SHT31_HUMIDITY:     return IN_SHT_RH;
+            case CH_DHT22_TEMPERATURE:  return IN_DHT_T;
+            case CH_DHT22_HUMIDITY:     return IN_DHT_RH;
+            case CH_BMP280_PRESSURE:    return IN_PRESSURE;
+            case CH_BMP280_TEMPERATURE: return IN_BMP_T;
+            case CH_MHZ14A_CO2:         return IN_CO2;
+            default:                    return -1;
+        }
+    }
+
+    bool fresh(uint8_t in, uint32_t nowMs) const {
+        return !isnan(_inputs[in]) && (nowMs - _inputMs[in]) <= _maxAgeMs;
+    }
+
+    float _altitudeM;
+    uint32_t _maxAgeMs;
+    float _inputs[INPUT_COUNT];
+    uint32_t _inputMs[INPUT_COUNT];
+    bool _dirty = false;
+    NowCast _pm25;
+    NowCast _pm10;
+};
+
+#endif // DERIVED_METRICS_H
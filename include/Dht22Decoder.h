@@ -0,0 +1,105 @@
+#ifndef DHT22_DECODER_H
+#define DHT22_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// ============================================================================
+// DHT22 Pulse Train Decoder
+// ============================================================================
+// Pure decoding of a captured single-wire response (RMT on the ESP32, recorded
+// timings on the host). After the host start pulse the sensor answers:
+//
+//     low 80 us, high 80 us, 40 x (low 50 us, high 26-28 us = 0 / 70 us = 1)
+//
+// Bytes: RH high, RH low, T high (bit 7 = sign), T low, checksum.
+
+/**
+ * @brief One captured line segment: level held for us microseconds.
+ */
+struct DhtEdge {
+    uint8_t level;
+    uint16_t us;
+};
+
+enum DhtStatus : uint8_t {
+    DHT_OK = 0,
+    DHT_NO_RESPONSE,    // No 80/80 us preamble found
+    DHT_TRUNCATED,      // Fewer than 40 bits captured
+    DHT_BAD_TIMING,     // A bit pulse out of tolerance (glitch, collision)
+    DHT_BAD_CHECKSUM,
+};
+
+struct DhtFrame {
+    DhtStatus status;
+    uint8_t bytes[5];
+    float temperature;  // °C, NAN unless status == DHT_OK
+    float humidity;     // %, NAN unless status == DHT_OK
+};
+
+// Pulse tolerances (us), wide enough for sensor and capture jitter
+static const uint16_t DHT_PREAMBLE_MIN_US = 50;
+static const uint16_t DHT_PREAMBLE_MAX_US = 120;
+static const uint16_t DHT_BIT_LOW_MIN_US = 30;
+static const uint16_t DHT_BIT_LOW_MAX_US = 90;
+static const uint16_t DHT_BIT_HIGH_MIN_US = 10;
+static const uint16_t DHT_BIT_HIGH_MAX_US = 100;
+static const uint16_t DHT_BIT_ONE_US = 48;     // High longer than this is a 1
+
+inline bool dhtInRange(uint16_t us, uint16_t lo, uint16_t hi) {
+    return us >= lo && us <= hi;
+}
+
+/**
+ * @brief Decodes a captured DHT22 response. Leading segments (idle line, end
+ * of the host start pulse) are skipped up to the response preamble.
+ */
+inline DhtFrame decodeDht22(const DhtEdge* edges, size_t count) {
+    DhtFrame f;
+    f.status = DHT_NO_RESPONSE;
+    for (uint8_t i = 0; i < 5; i++) f.bytes[i] = 0;
+    f.temperature = NAN;
+    f.humidity = NAN;
+
+    size_t i = 0;
+    for (; i + 1 < count; i++) {
+        if (edges[i].level == 0 && edges[i + 1].level == 1 &&
+            dhtInRange(edges[i].us, DHT_PREAMBLE_MIN_US, DHT_PREAMBLE_MAX_US) &&
+            dhtInRange(edges[i + 1].us, DHT_PREAMBLE_MIN_US, DHT_PREAMBLE_MAX_US)) {
+            break;
+        }
+    }
+    if (i + 1 >= count) return f;
+    i += 2;
+
+    for (uint8_t bit = 0; bit < 40; bit++, i += 2) {
+        if (i + 1 >= count) {
+            f.status = DHT_TRUNCATED;
+            return f;
+        }
+        const DhtEdge& low = edges[i];
+        const DhtEdge& high = edges[i + 1];
+        if (low.level != 0 || high.level != 1 ||
+            !dhtInRange(low.us, DHT_BIT_LOW_MIN_US, DHT_BIT_LOW_MAX_US) ||
+            !dhtInRange(high.us, DHT_BIT_HIGH_MIN_US, DHT_BIT_HIGH_MAX_US)) {
+            f.status = DHT_BAD_TIMING;
+            return f;
+        }
+        f.bytes[bit / 8] = (uint8_t)((f.bytes[bit / 8] << 1) | (high.us > DHT_BIT_ONE_US ? 1 : 0));
+    }
+
+    uint8_t sum = (uint8_t)(f.bytes[0] + f.bytes[1] + f.bytes[2] + f.bytes[3]);
+    if (sum != f.bytes[4]) {
+        f.status = DHT_BAD_CHECKSUM;
+        return f;
+    }
+
+    f.humidity = ((f.bytes[0] << 8) | f.bytes[1]) / 10.0f;
+    float t = (((f.bytes[2] & 0x7F) << 8) | f.bytes[3]) / 10.0f;
+    f.temperature = (f.bytes[2] & 0x80) ? -t : t;
+    f.status = DHT_OK;
+    return f;
+}
+
+#endif // DHT22_DECODER_H
@@ -0,0 +1,71 @@
+#ifndef DHT22_RMT_H
+#define DHT22_RMT_H
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+#include <esp_timer.h>
+#include "Dht22Decoder.h"
+
+/**
+ * @brief Non-blocking DHT22 driver: the response is captured by the RMT
+ * peripheral instead of bit-banged with interrupts disabled.
+ *
+ * start() pulls the line low; an esp_timer releases it after START_PULSE_US
+ * and arms the RMT receiver. poll() picks up the captured pulse train from
+ * the RMT ring buffer and decodes it (Dht22Decoder.h). The CPU is only busy
+ * for a few tens of microseconds per read, so UART and SoftwareSerial
+ * traffic is not disturbed.
+ *
+ * Uses the legacy driver/rmt.h API (Arduino-ESP32 2.x / IDF 4.4).
+ */
+class Dht22Rmt {
+public:
+    static const uint32_t MIN_INTERVAL_MS = 2000;   // Sensor limit: 0.5 Hz
+    static const uint32_t START_PULSE_US = 1100;    // Host start signal (>= 1 ms)
+    static const uint32_t TIMEOUT_MS = 25;          // Start + 5 ms frame, with margin
+    static const uint16_t IDLE_THRESHOLD_US = 200;  // End of frame (longest pulse is 80 us)
+
+    Dht22Rmt(uint8_t pin, rmt_channel_t channel = RMT_CHANNEL_0);
+
+    /**
+     * @brief Installs the RMT receiver and the start timer. Safe to call again
+     * (reset): aborts any read in progress.
+     */
+    bool begin();
+
+    /**
+     * @brief Starts a read. Returns false if one is in progress, the driver is
+     * not installed, or the previous read is less than MIN_INTERVAL_MS old.
+     */
+    bool start(uint32_t nowMs);
+
+    bool busy() const { return _state != IDLE; }
+
+    /**
+     * @brief Completes a read. Returns true once per started read (also on
+     * timeout), with the decoded frame.
+     */
+    bool poll(uint32_t nowMs, DhtFrame& frame);
+
+    uint32_t failures() const { return _failures; }
+
+private:
+    enum State : uint8_t { IDLE, START_PULSE, CAPTURING };
+
+    static void onStartPulseEnd(void* arg);
+
+    uint8_t _pin;
+    rmt_channel_t _channel;
+    RingbufHandle_t _ring = nullptr;
+    esp_timer_handle_t _timer = nullptr;
+    bool _installed = false;
+
+    volatile State _state = IDLE;
+    uint32_t _startMs = 0;
+    bool _started = false;
+    uint32_t _failures = 0;
+
+    DhtEdge _edges[96];
+};
+
+#endif // DHT22_RMT_H
@@ -0,0 +1,65 @@
+#ifndef FILTER_CONFIG_H
+#define FILTER_CONFIG_H
+
+#include <stdint.h>
+#include "Channels.h"
+#include "StreamFilter.h"
+
+// ============================================================================
+// Channel Filters
+// ============================================================================
+// Filter settings per channel, shared by the firmware and the host tests
+// (test/native/test_stream_filter).
+//
+// Applied between the read and the publish: Hampel outlier rejection over the
+// last 7 raw samples, then slope limiter, then EMA. The sampler sees the raw
+// reads, so the smoothing does not delay event detection.
+//
+// Slope limits sit above what the sensor can physically follow (NDIR and
+// electrochemical cells take a minute or more to settle), so they only clip
+// glitches Hampel lets through. PM is smoothed but never slope-limited: a
+// plume is a real step.
+//
+// CO and CO2 clamp outliers instead of replacing them: their baseline is flat
+// (MAD 0), so replacing would hide the first 4 samples of every real event
+// and a short CO spike entirely. Clamped, the step shows at once (minDeviation
+// above the median, then the slope limiter) and in full from the 5th sample.
+typedef FilterChain<Hampel<float, 7>, RateLimiter<float>, Ema<float>> ChannelFilter;
+
+struct FilterConfig {
+    float hampelK;          // <= 0 disables outlier rejection
+    HampelMode outliers;    // Replace by the median, drop, or clamp
+    float minDeviation;     // Never flag deviations below this (flat windows)
+    float maxPerSecond;     // <= 0 disables the rate limiter
+    float emaAlpha;         // 1.0 disables smoothing
+};
+
+static const FilterConfig FILTER_CONFIG[CH_COUNT] = {
+    { 3.0f, HAMPEL_CLAMP,   50.0f, 20.0f, 1.0f },   // mhz14a/co2 (T90 ~2 min)
+    { 3.0f, HAMPEL_REPLACE, 0.5f,  0,     1.0f },   // dht22/temperature
+    { 3.0f, HAMPEL_REPLACE, 2.0f,  0,     1.0f },   // dht22/humidity
+    { 0,    HAMPEL_REPLACE, 0,     0,     1.0f },   // sgp40/voc (already an algorithm output)
+    { 3.0f, HAMPEL_REPLACE, 50.0f, 0,     1.0f },   // sgp30/eco2
+    { 3.0f, HAMPEL_REPLACE, 50.0f, 0,     1.0f },   // sgp30/tvoc
+    { 3.5f, HAMPEL_REPLACE, 5.0f,  0,     0.5f },   // sps30/pm1 (1 s reads, counting noise at low levels)
+    { 3.5f, HAMPEL_REPLACE, 5.0f,  0,     0.5f },   // sps30/pm25
+    { 3.5f, HAMPEL_REPLACE, 5.0f,  0,     0.5f },   // sps30/pm4
+    { 3.5f, HAMPEL_REPLACE, 5.0f,  0,     0.5f },   // sps30/pm10
+    { 3.0f, HAMPEL_REPLACE, 0.5f,  0,     1.0f },   // bmp280/pressure
+    { 3.0f, HAMPEL_REPLACE, 0.5f,  0,     1.0f },   // bmp280/temperature
+    { 3.0f, HAMPEL_REPLACE, 0.5f,  0,     1.0f },   // sht31/temperature
+    { 3.0f, HAMPEL_REPLACE, 2.0f,  0,     1.0f },   // sht31/humidity
+    { 3.0f, HAMPEL_CLAMP,   5.0f,  5.0f,  0.5f },   // sc16co/co (1 ppm steps, T90 ~1 min)
+};
+
+/**
+ * @brief Builds the filter chain of one channel from its FILTER_CONFIG row.
+ */
+inline ChannelFilter makeChannelFilter(const FilterConfig& f) {
+    ChannelFilter filter(Hampel<float, 7>(f.hampelK, f.outliers),
+                         RateLimiter<float>(f.maxPerSecond), Ema<float>(f.emaAlpha));
+    filter.first().setMinDeviation(f.minDeviation);
+    return filter;
+}
+
+#endif // FILTER_CONFIG_H
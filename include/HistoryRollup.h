@@ -0,0 +1,233 @@
+#ifndef HISTORY_ROLLUP_H
+#define HISTORY_ROLLUP_H
+
+#include <stdint.h>
+#include <math.h>
+
+// ============================================================================
+// Rollup Resolutions (override with -D HISTORY_L*_...)
+// ============================================================================
+// Defaults: 10 s x 10 min, 5 min x 24 h, 1 h x 7 d = 516 slots x 6 bytes
+// = ~3 KB per channel, ~46 KB for all 15 channels of the full profile.
+
+#ifndef HISTORY_L0_PERIOD_MS
+#define HISTORY_L0_PERIOD_MS    10000UL
+#endif
+#ifndef HISTORY_L0_SLOTS
+#define HISTORY_L0_SLOTS        60
+#endif
+#ifndef HISTORY_L1_PERIOD_MS
+#define HISTORY_L1_PERIOD_MS    300000UL
+#endif
+#ifndef HISTORY_L1_SLOTS
+#define HISTORY_L1_SLOTS        288
+#endif
+#ifndef HISTORY_L2_PERIOD_MS
+#define HISTORY_L2_PERIOD_MS    3600000UL
+#endif
+#ifndef HISTORY_L2_SLOTS
+#define HISTORY_L2_SLOTS        168
+#endif
+
+#define HISTORY_LEVELS          3
+#define HISTORY_GAP             INT16_MIN   // Slot with no sample
+
+/**
+ * @brief One rollup slot: min/mean/max quantized to the channel step.
+ */
+struct RollupPoint {
+    int16_t min;
+    int16_t mean;
+    int16_t max;
+};
+
+/**
+ * @brief Running min/sum/max of the samples falling in one open bucket.
+ */
+struct RollupAccumulator {
+    float min;
+    float max;
+    float sum;
+    uint32_t count;
+
+    void reset() { min = INFINITY; max = -INFINITY; sum = 0; count = 0; }
+
+    void add(float v) {
+        if (v < min) min = v;
+        if (v > max) max = v;
+        sum += v;
+        count++;
+    }
+
+    // Merges a closed finer bucket into this coarser one (exact mean)
+    void merge(const RollupAccumulator& o) {
+        if (o.count == 0) return;
+        if (o.min < min) min = o.min;
+        if (o.max > max) max = o.max;
+        sum += o.sum;
+        count += o.count;
+    }
+};
+
+/**
+ * @brief Fixed-capacity ring of rollup points, newest at index 0.
+ */
+template <uint16_t SLOTS>
+class RollupRing {
+public:
+    void push(const RollupPoint& p) {
+        _head = (uint16_t)((_head + 1) % SLOTS);
+        _data[_head] = p;
+        if (_size < SLOTS) _size++;
+    }
+
+    // age 0 = most recent closed bucket
+    const RollupPoint& at(uint16_t age) const {
+        return _data[(uint16_t)((_head + SLOTS - age) % SLOTS)];
+    }
+
+    uint16_t size() const { return _size; }
+    static constexpr uint16_t capacity() { return SLOTS; }
+
+private:
+    RollupPoint _data[SLOTS];
+    uint16_t _head = SLOTS - 1;
+    uint16_t _size = 0;
+};
+
+/**
+ * @brief Multi-resolution history of one channel, built incrementally.
+ *
+ * Each sample lands in the open level-0 bucket. When a bucket's period ends it
+ * is quantized into its ring and merged into the open bucket of the next level,
+ * so coarser levels never re-read finer data. Buckets with no sample are
+ * stored as HISTORY_GAP to keep slots aligned on wall-clock periods.
+ */
+class ChannelHistory {
+public:
+    explicit ChannelHistory(float step = 1.0f) : _step(step) {
+        for (uint8_t l = 0; l < HISTORY_LEVELS; l++) {
+            _acc[l].reset();
+            _bucketStartMs[l] = 0;
+        }
+    }
+
+    void setStep(float step) { _step = step; }
+    float step() const { return _step; }
+
+    /**
+     * @brief Adds one sample. Closes any bucket whose period ended before nowMs.
+     */
+    void add(float value, uint32_t nowMs) {
+        advance(nowMs);
+        if (!isnan(value)) _acc[0].add(value);
+    }
+
+    /**
+     * @brief Closes elapsed buckets without adding a sample.
+     */
+    void advance(uint32_t nowMs) {
+        if (!_started) {
+            for (uint8_t l = 0; l < HISTORY_LEVELS; l++) {
+                _bucketStartMs[l] = nowMs - (nowMs % periodMs(l));
+            }
+            _started = true;
+            return;
+        }
+        closeElapsed(0, nowMs);
+    }
+
+    uint16_t size(uint8_t level) const {
+        switch (level) {
+            case 0: return _ring0.size();
+            case 1: return _ring1.size();
+            default: return _ring2.size();
+        }
+    }
+
+    static uint32_t periodMs(uint8_t level) {
+        switch (level) {
+            case 0: return HISTORY_L0_PERIOD_MS;
+            case 1: return HISTORY_L1_PERIOD_MS;
+            default: return HISTORY_L2_PERIOD_MS;
+        }
+    }
+
+    static uint16_t capacity(uint8_t level) {
+        switch (level) {
+            case 0: return HISTORY_L0_SLOTS;
+            case 1: return HISTORY_L1_SLOTS;
+            default: return HISTORY_L2_SLOTS;
+        }
+    }
+
+    const RollupPoint& at(uint8_t level, uint16_t age) const {
+        switch (level) {
+            case 0: return _ring0.at(age);
+            case 1: return _ring1.at(age);
+            default: return _ring2.at(age);
+        }
+    }
+
+    /**
+     * @brief End time (millis) of the most recent closed bucket at level.
+     */
+    uint32_t newestEndMs(uint8_t level) const { return _bucketStartMs[level]; }
+
+    int16_t quantize(float v) const {
+        float q = roundf(v / _step);
+        if (q > INT16_MAX) return INT16_MAX;
+        if (q <= INT16_MIN) return INT16_MIN + 1;
+        return (int16_t)q;
+    }
+
+    float dequantize(int16_t q) const { return q == HISTORY_GAP ? NAN : q * _step; }
+
+private:
+    void closeElapsed(uint8_t level, uint32_t nowMs) {
+        uint32_t period = periodMs(level);
+        uint16_t closed = 0;
+
+        while (nowMs - _bucketStartMs[level] >= period) {
+            // After a long outage, only the last ring-full of buckets matters
+            if (closed >= capacity(level) && _acc[level].count == 0) {
+                uint32_t skip = (nowMs - _bucketStartMs[level]) / period;
+                _bucketStartMs[level] += skip * period;
+                if (level + 1 < HISTORY_LEVELS) closeElapsed(level + 1, _bucketStartMs[level]);
+                break;
+            }
+            pushPoint(level, toPoint(_acc[level]));
+            if (level + 1 < HISTORY_LEVELS) {
+                _acc[level + 1].merge(_acc[level]);
+            }
+            _acc[level].reset();
+            _bucketStartMs[level] += period;
+            closed++;
+
+            if (level + 1 < HISTORY_LEVELS) closeElapsed(level + 1, _bucketStartMs[level]);
+        }
+    }
+
+    RollupPoint toPoint(const RollupAccumulator& a) const {
+        if (a.count == 0) return { HISTORY_GAP, HISTORY_GAP, HISTORY_GAP };
+        return { quantize(a.min), quantize(a.sum / a.count), quantize(a.max) };
+    }
+
+    void pushPoint(uint8_t level, const RollupPoint& p) {
+        switch (level) {
+            case 0: _ring0.push(p); break;
+            case 1: _ring1.push(p); break;
+            default: _ring2.push(p); break;
+        }
+    }
+
+    float _step;
+    bool _started = false;
+    RollupAccumulator _acc[HISTORY_LEVELS];
+    uint32_t _bucketStartMs[HISTORY_LEVELS];
+    RollupRing<HISTORY_L0_SLOTS> _ring0;
+    RollupRing<HISTORY_L1_SLOTS> _ring1;
+    RollupRing<HISTORY_L2_SLOTS> _ring2;
+};
+
+#endif // HISTORY_ROLLUP_H
@@ -0,0 +1,98 @@
+#ifndef HISTORY_SERVICE_H
+#define HISTORY_SERVICE_H
+
+#include <Arduino.h>
+#include "Channels.h"
+#include "profile.h"
+#include "HistoryRollup.h"
+#include "SideChannel.h"
+
+/**
+ * @brief On-device multi-resolution history, queryable over MQTT.
+ *
+ * Request  : {moduleId}/history/get  {"channel":"sps30/pm25","resolution":300,"range":86400}
+ *            resolution and range are in seconds; the finest level whose period
+ *            is >= resolution is used, range defaults to the whole ring.
+ * Response : {moduleId}/history/data  binary chunks, little-endian:
+ *
+ *   off  size  field
+ *    0   u8    version (1)
+ *    1   u8    channel index (Channels.h)
+ *    2   u8    level
+ *    3   u8    flags (bit0: last chunk, bit1: error)
+ *    4   u16   sequence number
+ *    6   u16   point count in this chunk
+ *    8   u32   bucket period (ms)
+ *   12   u32   age (ms) of the end of the first point in this chunk
+ *   16   f32   quantization step
+ *   20   count x { i16 min, i16 mean, i16 max }, newest first, INT16_MIN = gap
+ */
+class HistoryService {
+public:
+    static const char* REQUEST_TOPIC;   // "history/get"
+    static const char* RESPONSE_TOPIC;  // "history/data"
+
+    static const uint8_t VERSION = 1;
+    static const uint8_t FLAG_LAST = 0x01;
+    static const uint8_t FLAG_ERROR = 0x02;
+    static const size_t HEADER_SIZE = 20;
+    static const size_t CHUNK_SIZE = 256;
+    static const uint16_t POINTS_PER_CHUNK = (CHUNK_SIZE - HEADER_SIZE) / sizeof(RollupPoint);
+
+    explicit HistoryService(SideChannel& channel);
+
+    void begin();
+
+    /**
+     * @brief Feeds one published value into the channel's rollups.
+     */
+    void add(Channel ch, float value, uint32_t nowMs);
+
+    /**
+     * @brief Queues a request payload. Safe to call from the MQTT task.
+     */
+    void handleRequest(const uint8_t* payload, size_t len);
+
+    /**
+     * @brief Parses pending requests and streams a few chunks. Call from loop().
+     */
+    void loop(uint32_t nowMs);
+
+    /**
+     * @brief True when ch belongs to a compiled-in sensor (has rollup storage).
+     */
+    bool hasChannel(uint8_t ch) const { return ch < CH_COUNT && _slot[ch] >= 0; }
+
+    const ChannelHistory& history(Channel ch) const { return _history[_slot[ch]]; }
+
+private:
+    static const size_t MAX_REQUEST = 192;
+    static const uint8_t CHUNKS_PER_LOOP = 2;
+
+    bool parseRequest(uint32_t nowMs);
+    void sendChunk(uint32_t nowMs);
+    void sendError(uint8_t channel);
+
+    // Rollup storage only for the channels of the active sensor profile
+    static const uint8_t STORED_CHANNELS = SENSOR_CHANNEL_COUNT > 0 ? SENSOR_CHANNEL_COUNT : 1;
+
+    SideChannel& _channel;
+    ChannelHistory _history[STORED_CHANNELS];
+    int8_t _slot[CH_COUNT];     // Channel -> _history index, -1 if not compiled in
+
+    // Filled by the MQTT task, consumed by loop()
+    uint8_t _request[MAX_REQUEST + 1];
+    volatile size_t _requestLen = 0;
+    volatile bool _requestPending = false;
+
+    // Active stream
+    bool _streaming = false;
+    uint8_t _streamChannel = 0;
+    uint8_t _streamLevel = 0;
+    uint16_t _streamNext = 0;
+    uint16_t _streamEnd = 0;
+    uint16_t _streamSeq = 0;
+    uint8_t _chunk[CHUNK_SIZE];
+};
+
+#endif // HISTORY_SERVICE_H
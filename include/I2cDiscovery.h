@@ -0,0 +1,268 @@
+#ifndef I2C_DISCOVERY_H
+#define I2C_DISCOVERY_H
+
+#include <stdint.h>
+#include <string.h>
+#include "Channels.h"
+
+// ============================================================================
+// I2C Hot-Plug Discovery
+// ============================================================================
+// Replaces the blocking full-bus scan by a few probes per round: every round
+// checks the addresses of the known drivers on the bus, then advances a sweep
+// of the other addresses by SWEEP_PER_ROUND. The caller bounds the bus time
+// spent per round; a round cut short resumes where it stopped.
+//
+// Known devices that start answering are reported once (init + register),
+// devices missing LOST_AFTER rounds in a row are reported lost (retired).
+//
+// The budget is only checked between probes, and a probe on a bus held low
+// costs the whole Wire timeout (1 s after a recovery). A probe that times out
+// or hits a bus error ends the round and skips the bus for 1, 2, 4, ...
+// BUS_BACKOFF_MAX rounds, until a probe completes again. Such a probe says
+// nothing about the device: presence is left to the read stage, whose budget
+// escalation handles a bus that stays stuck.
+
+// Wire endTransmission() results
+static const uint8_t WIRE_OK = 0;
+static const uint8_t WIRE_NACK_ADDRESS = 2;
+static const uint8_t WIRE_OTHER_ERROR = 4;
+static const uint8_t WIRE_TIMEOUT = 5;
+
+/**
+ * @brief Driver bound to an I2C address.
+ */
+struct KnownI2cDevice {
+    BusId bus;
+    uint8_t address;
+    HardwareSlot hw;
+};
+
+static const KnownI2cDevice KNOWN_I2C_DEVICES[] = {
+    { BUS_I2C_MAIN, 0x76, HW_BMP280 },
+    { BUS_I2C_SGP,  0x58, HW_SGP30  },
+    { BUS_I2C_SGP,  0x59, HW_SGP40  },
+    { BUS_I2C_SGP,  0x44, HW_SHT31  },
+};
+static const uint8_t KNOWN_I2C_COUNT = sizeof(KNOWN_I2C_DEVICES) / sizeof(KNOWN_I2C_DEVICES[0]);
+
+inline bool isI2cHardware(uint8_t hw) {
+    return HARDWARE_TABLE[hw].bus == BUS_I2C_MAIN || HARDWARE_TABLE[hw].bus == BUS_I2C_SGP;
+}
+
+enum DiscoveryEvent : uint8_t {
+    DISCOVERY_NONE = 0,
+    DISCOVERY_APPEARED,     // Known device answering: init and register it
+    DISCOVERY_LOST,         // Known device gone: stop reading it
+    DISCOVERY_UNKNOWN,      // First answer of an address without driver
+    DISCOVERY_BUS_FAULT,    // Probe timed out / bus error: bus skipped for backoff() rounds
+};
+
+/**
+ * @brief Probe schedule and presence tracking of the two I2C buses.
+ *
+ * Pure logic: the caller probes the address returned by nextProbe() and
+ * passes the result to report().
+ */
+class I2cDiscovery {
+public:
+    static const uint8_t FIRST_ADDRESS = 0x08;  // 0x00-0x07 and 0x78-0x7F are reserved
+    static const uint8_t LAST_ADDRESS = 0x77;
+    static const uint8_t SWEEP_PER_ROUND = 3;
+    static const uint8_t LOST_AFTER = 3;        // Missed rounds before a device is retired
+    static const uint8_t INIT_HOLDOFF = 10;     // Rounds skipped after a failed hot-plug init
+    static const uint8_t BUS_BACKOFF_MAX = 64;  // Rounds skipped at most after a bus fault
+
+    /**
+     * @param compiled Hardware with a driver in this build (HARDWARE_COMPILED)
+     */
+    explicit I2cDiscovery(const bool compiled[HW_COUNT]) {
+        memset(_present, 0, sizeof(_present));
+        memset(_misses, 0, sizeof(_misses));
+        memset(_holdoff, 0, sizeof(_holdoff));
+        memset(_seen, 0, sizeof(_seen));
+        for (uint8_t i = 0; i < KNOWN_I2C_COUNT; i++) _enabled[i] = compiled[KNOWN_I2C_DEVICES[i].hw];
+        for (uint8_t b = 0; b < I2C_BUSES; b++) {
+            _step[b] = 0;
+            _cursor[b] = FIRST_ADDRESS;
+            _sweeps[b] = 0;
+            _faultStreak[b] = 0;
+            _backoff[b] = 0;
+            _aborted[b] = false;
+        }
+    }
+
+    /**
+     * @brief Presence found by the boot init.
+     */
+    void setPresent(HardwareSlot hw, bool present) {
+        int8_t i = deviceOf(hw);
+        if (i < 0) return;
+        _present[i] = present;
+        _misses[i] = 0;
+    }
+
+    bool present(uint8_t hw) const {
+        int8_t i = deviceOf(hw);
+        return i >= 0 && _present[i];
+    }
+
+    /**
+     * @brief A hot-plug init failed: retried after INIT_HOLDOFF rounds.
+     */
+    void initFailed(HardwareSlot hw) {
+        int8_t i = deviceOf(hw);
+        if (i < 0) return;
+        _present[i] = false;
+        _holdoff[i] = INIT_HOLDOFF;
+    }
+
+    /**
+     * @brief Next address to probe on bus, false at the end of the round (the
+     * next call starts a new one).
+     */
+    bool nextProbe(BusId bus, uint8_t& address) {
+        uint8_t b = busIndex(bus);
+        if (b >= I2C_BUSES) return false;
+        if (_aborted[b]) {
+            _aborted[b] = false;
+            return false;
+        }
+        if (_step[b] == 0 && _backoff[b] > 0) {
+            _backoff[b]--;
+            return false;
+        }
+
+        // Known addresses first
+        while (_step[b] < KNOWN_I2C_COUNT) {
+            uint8_t i = _step[b]++;
+            if (KNOWN_I2C_DEVICES[i].bus != bus || !_enabled[i]) continue;
+            if (_holdoff[i] > 0) {
+                _holdoff[i]--;
+                continue;
+            }
+            address = KNOWN_I2C_DEVICES[i].address;
+            return true;
+        }
+        // Then a slice of the sweep
+        if (_step[b] < KNOWN_I2C_COUNT + SWEEP_PER_ROUND) {
+            _step[b]++;
+            do {
+                address = _cursor[b];
+                if (++_cursor[b] > LAST_ADDRESS) {
+                    _cursor[b] = FIRST_ADDRESS;
+                    _sweeps[b]++;
+                }
+            } while (knownIndex(bus, address) >= 0);
+            return true;
+        }
+        _step[b] = 0;
+        return false;
+    }
+
+    /**
+     * @brief Result of the probe of address (Wire endTransmission() code).
+     * hw is set for known devices.
+     */
+    DiscoveryEvent report(BusId bus, uint8_t address, uint8_t result, uint8_t& hw) {
+        hw = HW_COUNT;
+        uint8_t b = busIndex(bus);
+        if (b >= I2C_BUSES) return DISCOVERY_NONE;
+        if (result == WIRE_TIMEOUT || result == WIRE_OTHER_ERROR) {
+            if (_faultStreak[b] < 8) _faultStreak[b]++;
+            uint16_t rounds = 1 << (_faultStreak[b] - 1);
+            _backoff[b] = rounds > BUS_BACKOFF_MAX ? BUS_BACKOFF_MAX : rounds;
+            _step[b] = 0;
+            _aborted[b] = true;
+            return DISCOVERY_BUS_FAULT;
+        }
+        _faultStreak[b] = 0;
+
+        bool ack = result == WIRE_OK;
+        int8_t i = knownIndex(bus, address);
+        if (i < 0) {
+            if (address > LAST_ADDRESS) return DISCOVERY_NONE;
+            uint8_t mask = 1 << (address & 7);
+            bool seen = _seen[b][address >> 3] & mask;
+            if (ack) _seen[b][address >> 3] |= mask;
+            else _seen[b][address >> 3] &= ~mask;
+            return ack && !seen ? DISCOVERY_UNKNOWN : DISCOVERY_NONE;
+        }
+
+        hw = KNOWN_I2C_DEVICES[i].hw;
+        if (ack) {
+            _misses[i] = 0;
+            if (_present[i]) return DISCOVERY_NONE;
+            _present[i] = true;
+            return DISCOVERY_APPEARED;
+        }
+        if (!_present[i] || ++_misses[i] < LOST_AFTER) return DISCOVERY_NONE;
+        _present[i] = false;
+        _misses[i] = 0;
+        return DISCOVERY_LOST;
+    }
+
+    /**
+     * @brief Answering addresses without driver on bus.
+     */
+    uint8_t unknownCount(BusId bus) const {
+        uint8_t b = busIndex(bus);
+        if (b >= I2C_BUSES) return 0;
+        uint8_t n = 0;
+        for (uint8_t k = 0; k < 16; k++) n += __builtin_popcount(_seen[b][k]);
+        return n;
+    }
+
+    /**
+     * @brief Rounds the bus is still skipped for after a fault.
+     */
+    uint8_t backoff(BusId bus) const {
+        uint8_t b = busIndex(bus);
+        return b < I2C_BUSES ? _backoff[b] : 0;
+    }
+
+    /**
+     * @brief Completed sweeps of bus (one sweep covers every address).
+     */
+    uint32_t sweeps(BusId bus) const {
+        uint8_t b = busIndex(bus);
+        return b < I2C_BUSES ? _sweeps[b] : 0;
+    }
+
+private:
+    static const uint8_t I2C_BUSES = 2;
+
+    static uint8_t busIndex(BusId bus) {
+        return bus == BUS_I2C_MAIN ? 0 : (bus == BUS_I2C_SGP ? 1 : I2C_BUSES);
+    }
+
+    int8_t knownIndex(BusId bus, uint8_t address) const {
+        for (uint8_t i = 0; i < KNOWN_I2C_COUNT; i++) {
+            if (KNOWN_I2C_DEVICES[i].bus == bus && KNOWN_I2C_DEVICES[i].address == address) {
+                return _enabled[i] ? i : -1;    // Without its driver, an unknown device
+            }
+        }
+        return -1;
+    }
+
+    int8_t deviceOf(uint8_t hw) const {
+        for (uint8_t i = 0; i < KNOWN_I2C_COUNT; i++) {
+            if (KNOWN_I2C_DEVICES[i].hw == hw) return _enabled[i] ? i : -1;
+        }
+        return -1;
+    }
+
+    bool _enabled[KNOWN_I2C_COUNT];
+    bool _present[KNOWN_I2C_COUNT];
+    uint8_t _misses[KNOWN_I2C_COUNT];
+    uint8_t _holdoff[KNOWN_I2C_COUNT];
+    uint8_t _step[I2C_BUSES];           // Position in the current round
+    uint8_t _cursor[I2C_BUSES];         // Next sweep address
+    uint32_t _sweeps[I2C_BUSES];
+    uint8_t _faultStreak[I2C_BUSES];    // Faulted probes in a row
+    uint8_t _backoff[I2C_BUSES];        // Rounds left to skip
+    bool _aborted[I2C_BUSES];           // Round ended by a fault
+    uint8_t _seen[I2C_BUSES][16];       // Unknown addresses answering (bitmap)
+};
+
+#endif // I2C_DISCOVERY_H
@@ -0,0 +1,189 @@
+#ifndef I2C_MUX_H
+#define I2C_MUX_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "Channels.h"
+
+// ============================================================================
+// Multi-Instance I2C Sensors (TCA9548A)
+// ============================================================================
+// Sensor comparison benches fit several identical I2C sensors on one module.
+// Sensors with the same address sit on different channels of a TCA9548A
+// multiplexer; each instance is addressed by (bus, mux channel, address) and
+// published under its own hardware ID.
+//
+// The read plan orders the instances by bus and mux channel, so a read cycle
+// selects every channel once, however the instances were declared.
+//
+// Pure logic (no Arduino dependency): the driver side is MuxSensors.
+
+static const uint8_t TCA9548A_ADDRESS = 0x70;   // A0-A2 low
+static const uint8_t MUX_CHANNELS = 8;
+static const uint8_t MUX_DIRECT = 0xFF;         // On the bus itself, not behind the mux
+
+enum MuxSensorKind : uint8_t {
+    MUX_SGP40 = 0,
+    MUX_SGP30,
+    MUX_SHT31,
+    MUX_BMP280,
+    MUX_KIND_COUNT
+};
+
+static const uint8_t MUX_MAX_MEASUREMENTS = 2;
+
+/**
+ * @brief Driver family of an instance: hardware ID prefix and measurements.
+ */
+struct MuxKindInfo {
+    const char* id;
+    const char* name;
+    uint8_t address;        // Default address
+    bool fixedAddress;      // The driver cannot talk to another one
+    uint8_t measurementCount;
+    const char* measurement[MUX_MAX_MEASUREMENTS];
+    uint8_t decimals[MUX_MAX_MEASUREMENTS];     // Same precision as the single-instance channels
+};
+
+static const MuxKindInfo MUX_KIND_TABLE[MUX_KIND_COUNT] = {
+    { "sgp40",  "SGP40 VOC Sensor",    0x59, true,  1, { "voc",         nullptr       }, { 0, 0 } },
+    { "sgp30",  "SGP30 eCO2/TVOC",     0x58, true,  2, { "eco2",        "tvoc"        }, { 0, 0 } },
+    { "sht31",  "SHT31 Temp/Humidity", 0x44, false, 2, { "temperature", "humidity"    }, { 2, 1 } },
+    { "bmp280", "BMP280 Pressure",     0x76, false, 2, { "pressure",    "temperature" }, { 2, 2 } },
+};
+
+/**
+ * @brief One sensor instance.
+ */
+struct MuxSensorSpec {
+    MuxSensorKind kind;
+    BusId bus;          // BUS_I2C_MAIN or BUS_I2C_SGP
+    uint8_t channel;    // 0-7, MUX_DIRECT if not behind the mux
+    uint8_t address;
+};
+
+/**
+ * @brief Hardware ID of an instance: {kind}-{bus}{channel}-{address}, bus 'm'
+ * (Wire) or 's' (wireSGP), channel 0-7 or 'd' (direct), address in hex.
+ * Example: "sht31-s3-44" for an SHT31 at 0x44 on channel 3 of the SGP bus.
+ */
+inline size_t muxHardwareId(const MuxSensorSpec& s, char* out, size_t size) {
+    char channel = s.channel == MUX_DIRECT ? 'd' : (char)('0' + s.channel);
+    int n = snprintf(out, size, "%s-%c%c-%02x", MUX_KIND_TABLE[s.kind].id, s.bus == BUS_I2C_MAIN ? 'm' : 's',
+                     channel, s.address);
+    return (n < 0 || (size_t)n >= size) ? 0 : (size_t)n;
+}
+
+/**
+ * @brief Channel selections a cycle costs when instances are read in the
+ * given order, the selection being kept between consecutive reads.
+ */
+inline uint8_t muxSwitches(const MuxSensorSpec* specs, const uint8_t* order, uint8_t count) {
+    uint8_t switches = 0;
+    uint8_t selected[2] = { MUX_DIRECT, MUX_DIRECT };
+    for (uint8_t i = 0; i < count; i++) {
+        const MuxSensorSpec& s = specs[order ? order[i] : i];
+        uint8_t b = s.bus == BUS_I2C_MAIN ? 0 : 1;
+        if (s.channel == MUX_DIRECT || s.channel == selected[b]) continue;
+        selected[b] = s.channel;
+        switches++;
+    }
+    return switches;
+}
+
+enum MuxPlanError : uint8_t {
+    MUX_PLAN_OK = 0,
+    MUX_PLAN_TOO_MANY,      // More than MuxReadPlan::MAX_INSTANCES
+    MUX_PLAN_BAD_SPEC,      // Unknown kind, bus or channel, or address the driver cannot use
+    MUX_PLAN_DUPLICATE,     // Same (bus, channel, address) twice
+    MUX_PLAN_MUX_ADDRESS,   // Instance at the multiplexer address
+};
+
+/**
+ * @brief Read order of the instances, grouped per (bus, mux channel).
+ *
+ * Direct instances come first on each bus, then one group per channel in
+ * channel order. Within a group the declaration order is kept.
+ */
+class MuxReadPlan {
+public:
+    static const uint8_t MAX_INSTANCES = 16;
+
+    struct Group {
+        BusId bus;
+        uint8_t channel;    // MUX_DIRECT: no selection needed
+        uint8_t first;      // Index in order()
+        uint8_t count;
+    };
+
+    MuxPlanError build(const MuxSensorSpec* specs, uint8_t count) {
+        _count = 0;
+        _groupCount = 0;
+        if (count > MAX_INSTANCES) return MUX_PLAN_TOO_MANY;
+        for (uint8_t i = 0; i < count; i++) {
+            const MuxSensorSpec& s = specs[i];
+            if (s.kind >= MUX_KIND_COUNT || (s.bus != BUS_I2C_MAIN && s.bus != BUS_I2C_SGP) ||
+                (s.channel >= MUX_CHANNELS && s.channel != MUX_DIRECT) ||
+                (MUX_KIND_TABLE[s.kind].fixedAddress && s.address != MUX_KIND_TABLE[s.kind].address)) {
+                return MUX_PLAN_BAD_SPEC;
+            }
+            if (s.address == TCA9548A_ADDRESS) return MUX_PLAN_MUX_ADDRESS;
+            for (uint8_t j = 0; j < i; j++) {
+                if (specs[j].bus == s.bus && specs[j].channel == s.channel && specs[j].address == s.address) {
+                    return MUX_PLAN_DUPLICATE;
+                }
+            }
+        }
+
+        // Stable insertion sort on (bus, channel), direct first
+        for (uint8_t i = 0; i < count; i++) {
+            uint8_t j = _count++;
+            while (j > 0 && key(specs[i]) < key(specs[_order[j - 1]])) {
+                _order[j] = _order[j - 1];
+                j--;
+            }
+            _order[j] = i;
+        }
+        for (uint8_t i = 0; i < _count; i++) {
+            const MuxSensorSpec& s = specs[_order[i]];
+            if (_groupCount > 0 && _groups[_groupCount - 1].bus == s.bus &&
+                _groups[_groupCount - 1].channel == s.channel) {
+                _groups[_groupCount - 1].count++;
+                continue;
+            }
+            _groups[_groupCount++] = { s.bus, s.channel, i, 1 };
+        }
+        _switches = muxSwitches(specs, _order, _count);
+        return MUX_PLAN_OK;
+    }
+
+    uint8_t count() const { return _count; }
+    const uint8_t* order() const { return _order; }
+    uint8_t groupCount() const { return _groupCount; }
+    const Group& group(uint8_t g) const { return _groups[g]; }
+
+    /**
+     * @brief Instance (index in the spec table) read at position i of the cycle.
+     */
+    uint8_t instance(uint8_t i) const { return _order[i]; }
+
+    /**
+     * @brief Channel selections per cycle (one per channel group in use).
+     */
+    uint8_t switchesPerCycle() const { return _switches; }
+
+private:
+    static uint16_t key(const MuxSensorSpec& s) {
+        // Direct (0xFF) before the channels: +1 wraps it to 0
+        return (uint16_t)((s.bus == BUS_I2C_MAIN ? 0 : 1) << 8 | (uint8_t)(s.channel + 1));
+    }
+
+    uint8_t _order[MAX_INSTANCES];
+    Group _groups[MAX_INSTANCES];
+    uint8_t _count = 0;
+    uint8_t _groupCount = 0;
+    uint8_t _switches = 0;
+};
+
+#endif // I2C_MUX_H
@@ -0,0 +1,100 @@
+#ifndef LOOP_WATCHDOG_H
+#define LOOP_WATCHDOG_H
+
+#include <Arduino.h>
+#include "StageBudget.h"
+#include "SideChannel.h"
+
+/**
+ * @brief Stage budgets of loop() backed by the task watchdog.
+ *
+ * enter() / leave() bracket every loop stage: the stage in flight is written
+ * to RTC memory, the task watchdog is fed and the run is accounted against
+ * its budget (StageBudget). Escalation, mildest first:
+ *
+ *   1. overrun            counted per stage ({moduleId}/system/stages)
+ *   2. repeated overruns  the hardware read is backed off, then disabled
+ *                         until a reset command for that hardware
+ *   3. stage hangs        the task watchdog resets the chip; at boot the
+ *                         stall is reported and the hardware read stays
+ *                         quarantined (not initialised, not read)
+ *
+ * The last stall (stage, duration, uptime) survives resets in RTC memory and
+ * is reported at boot.
+ */
+class LoopWatchdog {
+public:
+    static const char* TOPIC;   // "system/stages"
+    static const uint32_t STALL_RECORD_MS = 1000;  // Overruns at least this long are kept as the last stall
+    static const uint32_t TIMELINE_MIN_US = 200;   // Shorter stages are left out of the timeline (-D TIMELINE)
+
+    LoopWatchdog(SideChannel& channel, uint32_t timeoutS = 8, unsigned long reportIntervalMs = 60000);
+
+    /**
+     * @brief Reads the RTC stall record. Call first in setup().
+     */
+    void begin();
+
+    /**
+     * @brief Arms the task watchdog for the calling (loop) task. Call once the
+     * blocking part of setup() (WiFi connection) is over.
+     */
+    void arm();
+
+    /**
+     * @brief Description of the last stall, empty if there is none to report.
+     */
+    const char* bootReport() const { return _bootReport; }
+
+    /**
+     * @brief Starts a stage. False if it is backed off, disabled or quarantined:
+     * skip it.
+     */
+    bool enter(LoopStage stage);
+
+    /**
+     * @brief Ends the stage started by enter().
+     * @param account False for stages outside loop() (sensor init): tracked
+     *        for stall attribution only.
+     * @return Escalation step reached by this run.
+     */
+    StageAction leave(bool account = true);
+
+    /**
+     * @brief False while the stage is backed off, disabled or quarantined.
+     */
+    bool allowed(uint8_t stage, uint32_t nowMs) { return _budget.allowed(stage, nowMs); }
+
+    /**
+     * @brief Stage currently running, STAGE_COUNT between stages.
+     */
+    uint8_t current() const { return _stage; }
+
+    /**
+     * @brief Lifts the backoff / disable / quarantine of a hardware read.
+     */
+    void clear(HardwareSlot hw) { _budget.clear(readStage(hw)); }
+
+    /**
+     * @brief Publishes the per-stage report when the interval elapsed.
+     */
+    void loop(unsigned long nowMs);
+
+    const char* collect(unsigned long nowMs);
+
+private:
+    SideChannel& _channel;
+    uint32_t _timeoutS;
+    unsigned long _intervalMs;
+    unsigned long _lastReport = 0;
+    StageBudget _budget;
+    uint8_t _stage = STAGE_COUNT;
+    uint32_t _startUs = 0;
+#ifdef TIMELINE
+    uint32_t _startCycles = 0;
+#endif
+    char _bootReport[160];
+    char _report[1536];
+};
+
+#endif // LOOP_WATCHDOG_H
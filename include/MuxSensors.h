@@ -0,0 +1,131 @@
+#ifndef MUX_SENSORS_H
+#define MUX_SENSORS_H
+
+#include "profile.h"
+#if SENSOR_I2C_MUX
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_SGP40.h>
+#include <Adafruit_SGP30.h>
+#include <Adafruit_SHT31.h>
+#include <Adafruit_BMP280.h>
+#include "I2cMux.h"
+
+/**
+ * @brief Outcome of one instance in a group read.
+ */
+enum MuxEvent : uint8_t {
+    MUX_SAMPLE = 0,     // values hold a good reading
+    MUX_FAILED,         // Read failed, still present
+    MUX_APPEARED,       // Initialised (boot or replugged): register it, values hold a reading
+    MUX_LOST,           // LOST_AFTER failed reads in a row: retired, init retried later
+};
+
+struct MuxResult {
+    uint8_t instance;   // Index in the spec table
+    MuxEvent event;
+    float values[MUX_MAX_MEASUREMENTS];
+};
+
+/**
+ * @brief Multiple identical I2C sensors behind TCA9548A multiplexers.
+ *
+ * One driver object per instance. A read cycle walks the MuxReadPlan one
+ * channel group per call to readGroup(), so a loop pass holds the bus for a
+ * single group; the channel stays selected until another group needs a
+ * different one (the multiplexer is only written when the selection changes).
+ *
+ * Instances that do not answer are initialised again every RETRY_CYCLES
+ * cycles, so sensors can be plugged on a channel at any time.
+ */
+class MuxSensors {
+public:
+    static const uint8_t MAX_PER_KIND = 8;
+    static const uint8_t LOST_AFTER = 3;        // Failed reads in a row before retiring
+    static const uint8_t RETRY_CYCLES = 10;     // Cycles between init attempts of a missing instance
+    static const uint8_t ID_SIZE = 16;
+
+    MuxSensors(TwoWire& wireMain, TwoWire& wireSGP) : _wire{ &wireMain, &wireSGP } {}
+
+    /**
+     * @brief Plans the reads and creates the drivers (no bus traffic besides
+     * releasing the multiplexers). specs must outlive this object.
+     */
+    MuxPlanError begin(const MuxSensorSpec* specs, uint8_t count);
+
+    /**
+     * @brief Starts a read cycle. False while the previous one is running.
+     */
+    bool startCycle();
+    bool busy() const { return _running; }
+
+    /**
+     * @brief Selects the channel of the next group and reads its instances
+     * (initialising the missing ones that are due).
+     * @return Results written to out (MuxReadPlan::MAX_INSTANCES max)
+     */
+    uint8_t readGroup(MuxResult* out);
+
+    /**
+     * @brief Initialises instance i again in its next group read (reset
+     * command).
+     */
+    void retry(uint8_t i) {
+        _present[i] = false;
+        _misses[i] = 0;
+        _holdoff[i] = 0;
+    }
+
+    /**
+     * @brief Deselects every channel, so the bus only shows its direct
+     * devices (before the hot-plug discovery sweeps it).
+     */
+    void release();
+
+    const MuxReadPlan& plan() const { return _plan; }
+    uint8_t count() const { return _count; }
+    const MuxSensorSpec& spec(uint8_t i) const { return _specs[i]; }
+    const char* hardwareId(uint8_t i) const { return _id[i]; }
+    bool present(uint8_t i) const { return _present[i]; }
+
+    uint32_t lastCycleUs() const { return _lastCycleUs; }           // Bus time of the last complete cycle
+    uint8_t lastCycleSelects() const { return _lastCycleSelects; }  // Multiplexer writes in it
+    uint32_t cycles() const { return _cycles; }
+
+private:
+    bool select(BusId bus, uint8_t channel);
+    bool init(uint8_t i);
+    bool answers(uint8_t i);
+    bool read(uint8_t i, float* values, float compensationT, float compensationH);
+
+    TwoWire* _wire[2];
+    const MuxSensorSpec* _specs = nullptr;
+    uint8_t _count = 0;
+    MuxReadPlan _plan;
+    bool _mux[2] = {};                  // A multiplexer sits on the bus
+    uint8_t _selected[2] = { MUX_DIRECT, MUX_DIRECT };
+
+    // Drivers, per kind, allocated once by begin()
+    uint8_t _slot[MuxReadPlan::MAX_INSTANCES];
+    Adafruit_SGP40* _sgp40[MAX_PER_KIND] = {};
+    Adafruit_SGP30* _sgp30[MAX_PER_KIND] = {};
+    Adafruit_SHT31* _sht31[MAX_PER_KIND] = {};
+    Adafruit_BMP280* _bmp280[MAX_PER_KIND] = {};
+
+    char _id[MuxReadPlan::MAX_INSTANCES][ID_SIZE];
+    bool _present[MuxReadPlan::MAX_INSTANCES] = {};
+    uint8_t _misses[MuxReadPlan::MAX_INSTANCES] = {};
+    uint8_t _holdoff[MuxReadPlan::MAX_INSTANCES] = {};
+
+    bool _running = false;
+    uint8_t _nextGroup = 0;
+    uint32_t _cycleBusUs = 0;
+    uint8_t _cycleSelects = 0;
+    uint32_t _lastCycleUs = 0;
+    uint8_t _lastCycleSelects = 0;
+    uint32_t _cycles = 0;
+};
+
+#endif // SENSOR_I2C_MUX
+
+#endif // MUX_SENSORS_H
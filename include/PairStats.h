@@ -0,0 +1,183 @@
+#ifndef PAIR_STATS_H
+#define PAIR_STATS_H
+
+#include <stdint.h>
+#include <math.h>
+#include "Channels.h"
+
+// ============================================================================
+// Pairwise Moments
+// ============================================================================
+
+/**
+ * @brief Streaming co-moments of (x, y, t) for one sensor pair.
+ *
+ * Welford update and Chan merge, so sliding windows can be built from
+ * per-block moments without keeping the samples. d = y - x is the
+ * difference against the reference sensor x.
+ */
+struct PairMoments {
+    uint32_t n = 0;
+    double mx = 0, my = 0, mt = 0;
+    double sxx = 0, syy = 0, stt = 0, sxy = 0, stx = 0, sty = 0;
+
+    void reset() { *this = PairMoments(); }
+
+    void add(double x, double y, double t) {
+        n++;
+        double dx = x - mx, dy = y - my, dt = t - mt;
+        mx += dx / n;
+        my += dy / n;
+        mt += dt / n;
+        sxx += dx * (x - mx);
+        syy += dy * (y - my);
+        stt += dt * (t - mt);
+        sxy += dx * (y - my);
+        stx += dt * (x - mx);
+        sty += dt * (y - my);
+    }
+
+    void merge(const PairMoments& o) {
+        if (o.n == 0) return;
+        if (n == 0) {
+            *this = o;
+            return;
+        }
+        double total = (double)n + o.n;
+        double f = (double)n * o.n / total;
+        double dx = o.mx - mx, dy = o.my - my, dt = o.mt - mt;
+        sxx += o.sxx + dx * dx * f;
+        syy += o.syy + dy * dy * f;
+        stt += o.stt + dt * dt * f;
+        sxy += o.sxy + dx * dy * f;
+        stx += o.stx + dt * dx * f;
+        sty += o.sty + dt * dy * f;
+        mx += dx * o.n / total;
+        my += dy * o.n / total;
+        mt += dt * o.n / total;
+        n += o.n;
+    }
+
+    // Mean of y - x
+    double bias() const { return my - mx; }
+
+    // Root mean square of y - x
+    double rms() const {
+        if (n == 0) return NAN;
+        double varD = (sxx + syy - 2 * sxy) / n;
+        if (varD < 0) varD = 0;
+        return sqrt(varD + bias() * bias());
+    }
+
+    // Pearson correlation of x and y, NAN when either is constant
+    double pearson() const {
+        double den = sxx * syy;
+        return den > 0 ? sxy / sqrt(den) : NAN;
+    }
+
+    // Least-squares slope of (y - x) against t (units of d per unit of t)
+    double drift() const {
+        return stt > 0 ? (sty - stx) / stt : NAN;
+    }
+};
+
+// ============================================================================
+// Pair Statistics
+// ============================================================================
+
+/**
+ * @brief Lifetime moments plus a sliding window of BLOCKS blocks of blockMs.
+ *
+ * add() is O(1); window() merges the blocks (O(BLOCKS)), meant for the
+ * periodic report only. Time is kept in hours since the first sample, from
+ * a 64-bit elapsed counter so millis() wrap-around does not break the drift.
+ */
+template <uint8_t BLOCKS>
+class PairStats {
+public:
+    explicit PairStats(uint32_t blockMs = 300000) : _blockMs(blockMs) {}
+
+    void add(float x, float y, uint32_t nowMs) {
+        if (!_started) {
+            _started = true;
+            _lastMs = nowMs;
+            _blockStartMs = nowMs;
+        }
+        _elapsedMs += (uint32_t)(nowMs - _lastMs);
+        _lastMs = nowMs;
+        rollBlocks(nowMs);
+
+        double t = _elapsedMs / 3600000.0;
+        _current.add(x, y, t);
+        _lifetime.add(x, y, t);
+    }
+
+    /**
+     * @brief Moments of the last BLOCKS full blocks plus the current one.
+     */
+    PairMoments window(uint32_t nowMs) {
+        if (_started) rollBlocks(nowMs);
+        PairMoments m;
+        for (uint8_t i = 0; i < BLOCKS; i++) m.merge(_blocks[i]);
+        m.merge(_current);
+        return m;
+    }
+
+    const PairMoments& lifetime() const { return _lifetime; }
+
+    uint32_t windowMs() const { return _blockMs * BLOCKS; }
+
+private:
+    void rollBlocks(uint32_t nowMs) {
+        uint32_t elapsed = nowMs - _blockStartMs;
+        if (elapsed < _blockMs) return;
+        uint32_t closed = elapsed / _blockMs;
+        _blockStartMs += closed * _blockMs;
+        if (closed > BLOCKS) {
+            // Gap longer than the window: even the current block fell out of it
+            for (uint8_t i = 0; i < BLOCKS; i++) _blocks[i].reset();
+            _current.reset();
+            return;
+        }
+        for (uint8_t i = 0; i < closed; i++) {
+            _head = (uint8_t)((_head + 1) % BLOCKS);
+            _blocks[_head] = _current;
+            _current.reset();
+        }
+    }
+
+    uint32_t _blockMs;
+    PairMoments _blocks[BLOCKS];
+    PairMoments _current;
+    PairMoments _lifetime;
+    uint8_t _head = 0;
+    bool _started = false;
+    uint32_t _lastMs = 0;
+    uint32_t _blockStartMs = 0;
+    uint64_t _elapsedMs = 0;
+};
+
+// ============================================================================
+// Redundant Channels
+// ============================================================================
+
+/**
+ * @brief One compared pair: sensor b against reference a.
+ */
+struct ComparePair {
+    const char* name;       // Pair ID in the report
+    Channel a;              // Reference
+    Channel b;
+};
+
+static const ComparePair COMPARE_PAIRS[] = {
+    { "temperature/sht31-dht22",  CH_SHT31_TEMPERATURE, CH_DHT22_TEMPERATURE  },
+    { "temperature/sht31-bmp280", CH_SHT31_TEMPERATURE, CH_BMP280_TEMPERATURE },
+    { "temperature/dht22-bmp280", CH_DHT22_TEMPERATURE, CH_BMP280_TEMPERATURE },
+    { "humidity/sht31-dht22",     CH_SHT31_HUMIDITY,    CH_DHT22_HUMIDITY     },
+    { "co2/mhz14a-sgp30",         CH_MHZ14A_CO2,        CH_SGP30_ECO2         },
+};
+
+static const uint8_t COMPARE_PAIR_COUNT = sizeof(COMPARE_PAIRS) / sizeof(COMPARE_PAIRS[0]);
+
+#endif // PAIR_STATS_H
@@ -0,0 +1,78 @@
+#ifndef RESOURCE_MONITOR_H
+#define RESOURCE_MONITOR_H
+
+// Compile out entirely with -D DISABLE_RESOURCE_TELEMETRY
+#ifndef DISABLE_RESOURCE_TELEMETRY
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "SideChannel.h"
+
+/**
+ * @brief Periodic system resource report published on {moduleId}/system/resources.
+ *
+ * Reports heap (free, minimum ever free, largest free block, fragmentation
+ * ratio), per-task stack high-water marks, per-task and per-core CPU share
+ * from FreeRTOS runtime stats, and loop() iterations per second.
+ *
+ * Collection uses only static buffers (no String / JSON document) and is
+ * bounded to MAX_TASKS tasks. Tasks that do not fit in the report buffer are
+ * left out and counted (truncated), so the report stays valid JSON. Its own
+ * cost is measured and included in the report (collectUs, collectMaxUs).
+ *
+ * Per-task CPU needs configGENERATE_RUN_TIME_STATS, which the prebuilt
+ * Arduino-ESP32 framework leaves disabled: cpu and cores are null there.
+ */
+class ResourceMonitor {
+public:
+    static const char* TOPIC;   // "system/resources"
+    static const uint8_t MAX_TASKS = 32;
+    // Room kept after the task list for cores, truncated, collectUs and collectMaxUs
+    static const size_t TAIL_RESERVE = 128;
+
+    ResourceMonitor(SideChannel& channel, unsigned long intervalMs = 60000);
+
+    /**
+     * @brief Counts one loop() iteration. Call once per loop.
+     */
+    void tick() { _loopCount++; }
+
+    /**
+     * @brief Collects and publishes a report when the interval elapsed.
+     */
+    void loop(unsigned long nowMs);
+
+    /**
+     * @brief Collects a report into the internal buffer and returns it (JSON).
+     */
+    const char* collect(unsigned long nowMs);
+
+private:
+    struct TaskSample {
+        TaskHandle_t handle;
+        uint32_t runtime;
+    };
+
+    SideChannel& _channel;
+    unsigned long _intervalMs;
+    unsigned long _lastReport = 0;
+    unsigned long _lastLoopCountMs = 0;
+    uint32_t _loopCount = 0;
+    uint32_t _collectMaxUs = 0;
+
+#if configUSE_TRACE_FACILITY
+    bool previousRuntime(TaskHandle_t handle, uint32_t& runtime) const;
+
+    TaskStatus_t _tasks[MAX_TASKS];
+    TaskSample _previous[MAX_TASKS];
+    uint8_t _previousCount = 0;
+    uint32_t _previousTotalRuntime = 0;
+#endif
+
+    char _report[1536];
+};
+
+#endif // DISABLE_RESOURCE_TELEMETRY
+
+#endif // RESOURCE_MONITOR_H
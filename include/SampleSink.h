@@ -0,0 +1,235 @@
+#ifndef SAMPLE_SINK_H
+#define SAMPLE_SINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// Sample Sets & Output Sinks
+// ============================================================================
+// Every value published during a loop pass is appended once to a SampleSet:
+// a topic handle and the raw float, nothing formatted. At the end of the pass
+// the set is sealed and offered by pointer to every sink (MQTT, serial CSV,
+// ...). Each sink encodes it in its own format, when its own schedule is due,
+// and holds it as long as it needs to: sets are reference counted and go
+// back to the pool with their last release. A slow sink only drops sets from
+// its own queue, following its own policy.
+//
+// Single-threaded (loop() only): reference counts are plain integers.
+//
+// Pure logic (no Arduino dependency), shared with the host tests.
+
+struct Sample {
+    uint8_t topic;      // TopicTable handle: topic string, labels and decimals
+    float value;
+};
+
+/**
+ * @brief The values of one loop pass, read-only once sealed.
+ */
+class SampleSet {
+public:
+    static const uint8_t CAPACITY = 32;     // A fuller pass is split into several sets
+
+    uint32_t timeMs() const { return _timeMs; }
+    uint32_t sequence() const { return _sequence; }
+    uint8_t size() const { return _count; }
+    const Sample& operator[](uint8_t i) const { return _samples[i]; }
+
+    // Sealed sets are only seen through const pointers: holding one does not
+    // make it writable
+    void retain() const { _refs++; }
+    void release() const { _refs--; }
+    uint8_t refs() const { return _refs; }
+
+private:
+    template <uint8_t, uint8_t> friend class SampleFanout;
+
+    Sample _samples[CAPACITY];
+    uint8_t _count = 0;
+    uint32_t _timeMs = 0;
+    uint32_t _sequence = 0;
+    mutable uint8_t _refs = 0;
+};
+
+enum SinkPolicy : uint8_t {
+    SINK_DROP_OLDEST = 0,   // Queue full: the oldest set is released for the new one
+    SINK_DROP_NEWEST,       // Queue full: the new set is refused
+};
+
+/**
+ * @brief Output of the sample sets.
+ *
+ * Queues up to depth sets. When its interval is due, service() hands the
+ * queued sets to consume() from the oldest; consume() may stop inside a set
+ * when its transport is full and is called again from that sample later.
+ */
+class SampleSink {
+public:
+    static const uint8_t MAX_DEPTH = 4;
+
+    /**
+     * @param depth      Sets held at most (1..MAX_DEPTH)
+     * @param policy     Set dropped when the queue is full
+     * @param intervalMs Minimum time between two services, 0: every loop pass
+     */
+    SampleSink(uint8_t depth, SinkPolicy policy, uint32_t intervalMs)
+        : _depth(depth < 1 ? 1 : depth > MAX_DEPTH ? MAX_DEPTH : depth), _policy(policy),
+          _intervalMs(intervalMs) {}
+
+    virtual ~SampleSink() { clear(); }
+
+    /**
+     * @brief Queues set (retained), or drops following the policy.
+     */
+    void offer(const SampleSet* set) {
+        if (_queued == _depth) {
+            _dropped++;
+            if (_policy == SINK_DROP_NEWEST) return;
+            pop();
+        }
+        set->retain();
+        _queue[(_head + _queued) % MAX_DEPTH] = set;
+        _queued++;
+    }
+
+    /**
+     * @brief Encodes the queued sets if the schedule is due, until the
+     * transport refuses more.
+     */
+    void service(uint32_t nowMs) {
+        if (_queued == 0) return;
+        if (_intervalMs > 0 && _serviced && nowMs - _lastServiceMs < _intervalMs) return;
+        _serviced = true;
+        _lastServiceMs = nowMs;
+        while (_queued > 0) {
+            const SampleSet& set = *_queue[_head];
+            _cursor = consume(set, _cursor, nowMs);
+            if (_cursor < set.size()) return;
+            pop();
+            _delivered++;
+        }
+    }
+
+    /**
+     * @brief Releases every queued set.
+     */
+    void clear() {
+        while (_queued > 0) pop();
+    }
+
+    uint8_t depth() const { return _depth; }
+    uint8_t queued() const { return _queued; }
+    uint32_t delivered() const { return _delivered; }   // Sets fully consumed
+    uint32_t dropped() const { return _dropped; }       // Sets lost to the policy
+
+protected:
+    /**
+     * @brief Encodes and sends set from sample from.
+     * @return Index of the first sample not sent, set.size() when done
+     */
+    virtual uint8_t consume(const SampleSet& set, uint8_t from, uint32_t nowMs) = 0;
+
+private:
+    void pop() {
+        _queue[_head]->release();
+        _head = (_head + 1) % MAX_DEPTH;
+        _queued--;
+        _cursor = 0;
+    }
+
+    const SampleSet* _queue[MAX_DEPTH] = {};
+    uint8_t _depth;
+    SinkPolicy _policy;
+    uint32_t _intervalMs;
+    uint8_t _head = 0;
+    uint8_t _queued = 0;
+    uint8_t _cursor = 0;        // Next sample of the head set
+    bool _serviced = false;
+    uint32_t _lastServiceMs = 0;
+    uint32_t _delivered = 0;
+    uint32_t _dropped = 0;
+};
+
+/**
+ * @brief Collects the samples of a loop pass and shares them with the sinks.
+ *
+ * The pool holds the set being filled plus a full queue of every sink, so a
+ * set is always available: sinks are refused by attach() beyond that.
+ *
+ * @tparam MAX_SINKS Sinks attached at most
+ * @tparam SETS      Sets in the pool
+ */
+template <uint8_t MAX_SINKS, uint8_t SETS>
+class SampleFanout {
+public:
+    /**
+     * @brief Adds a sink. False when MAX_SINKS are attached or the pool
+     * cannot back its queue.
+     */
+    bool attach(SampleSink* sink) {
+        if (_sinkCount >= MAX_SINKS || 1 + _reserved + sink->depth() > SETS) return false;
+        _reserved += sink->depth();
+        _sinks[_sinkCount++] = sink;
+        return true;
+    }
+
+    /**
+     * @brief Appends a value to the set of the current pass (opened at the
+     * first value, dispatched early if full).
+     */
+    void add(uint8_t topic, float value, uint32_t nowMs) {
+        if (_open && _open->_count >= SampleSet::CAPACITY) dispatch();
+        if (!_open) open(nowMs);
+        _open->_samples[_open->_count++] = { topic, value };
+        _samples++;
+    }
+
+    /**
+     * @brief Seals the set of the pass, offers it to every sink, then lets
+     * every due sink encode what it holds.
+     */
+    void flush(uint32_t nowMs) {
+        dispatch();
+        for (uint8_t i = 0; i < _sinkCount; i++) _sinks[i]->service(nowMs);
+    }
+
+    uint8_t sinkCount() const { return _sinkCount; }
+    SampleSink* sink(uint8_t i) const { return _sinks[i]; }
+    uint32_t sets() const { return _sequence; }         // Sets dispatched
+    uint32_t samples() const { return _samples; }       // Values added
+    uint8_t setsInUse() const {
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < SETS; i++) n += _pool[i]._refs > 0;
+        return n;
+    }
+
+private:
+    void open(uint32_t nowMs) {
+        uint8_t i = 0;
+        while (_pool[i]._refs > 0) i++;     // Sized by attach(): one is free
+        _open = &_pool[i];
+        _open->_refs = 1;
+        _open->_count = 0;
+        _open->_timeMs = nowMs;
+        _open->_sequence = _sequence;
+    }
+
+    void dispatch() {
+        if (!_open) return;
+        _sequence++;
+        for (uint8_t i = 0; i < _sinkCount; i++) _sinks[i]->offer(_open);
+        _open->release();
+        _open = nullptr;
+    }
+
+    SampleSet _pool[SETS];
+    SampleSet* _open = nullptr;
+    SampleSink* _sinks[MAX_SINKS] = {};
+    uint8_t _sinkCount = 0;
+    uint8_t _reserved = 0;
+    uint32_t _sequence = 0;
+    uint32_t _samples = 0;
+};
+
+#endif // SAMPLE_SINK_H
@@ -0,0 +1,27 @@
+#ifndef SAMPLER_CONFIG_H
+#define SAMPLER_CONFIG_H
+
+#include <stdint.h>
+#include "Channels.h"
+#include "AdaptiveSampler.h"
+
+// ============================================================================
+// Sampling Cadences
+// ============================================================================
+// Adaptive sampler settings per hardware slot: minIntervalMs while the signal
+// moves, backing off to maxIntervalMs when flat. Shared by the firmware and
+// the load generator (tools/loadgen), which publishes at the same cadences.
+
+// { minIntervalMs, maxIntervalMs, slopeScale (units/s), activityHigh, activityLow }
+static const SamplerConfig SAMPLER_CONFIG[HW_COUNT] = {
+    { 2000, 15000, 5.0f,  1.0f, 0.3f },   // mhz14a  - CO2 ppm
+    { 2000, 30000, 0.05f, 1.0f, 0.3f },   // dht22   - °C (sensor limit: 0.5 Hz)
+    { 1000, 10000, 2.0f,  1.0f, 0.3f },   // sgp40   - VOC index
+    { 1000, 15000, 10.0f, 1.0f, 0.3f },   // sgp30   - eCO2 ppm
+    { 1000, 15000, 1.0f,  1.0f, 0.3f },   // sps30   - PM2.5 µg/m³
+    { 5000, 60000, 0.05f, 1.0f, 0.3f },   // bmp280  - hPa
+    { 1000, 30000, 0.05f, 1.0f, 0.3f },   // sht31   - °C
+    { 1000, 15000, 1.0f,  1.0f, 0.3f },   // sc16co  - CO ppm
+};
+
+#endif // SAMPLER_CONFIG_H
@@ -2,19 +2,69 @@
 #define SENSOR_READER_H
 
 #include <Arduino.h>
-#include <DHT_U.h>
+#include <Wire.h>
+#include "profile.h"
+#include "Channels.h"
+#if SENSOR_DHT22
+#include "Dht22Rmt.h"
+#endif
+#if SENSOR_SGP40
 #include <Adafruit_SGP40.h>
+#endif
+#if SENSOR_BMP280
 #include <Adafruit_BMP280.h>
+#endif
+#if SENSOR_SGP30
 #include <Adafruit_SGP30.h>
+#endif
+#if SENSOR_SHT31
 #include <Adafruit_SHT31.h>
-#include <SensirionUartSps30.h>
+#endif
+#if SENSOR_SPS30
+#include "Sps30Shdlc.h"
+#endif
+#if SENSOR_SC16CO
 #include <SoftwareSerial.h>
+#endif
+#ifdef BUS_TRACE
+#include "BusTrace.h"
+#endif
+
 struct DhtReading {
     float temperature;
     float humidity;
     bool valid;
 };
 
+struct Sps30Reading {
+    float pm1;
+    float pm25;
+    float pm4;
+    float pm10;
+    bool valid;
+};
+
+/**
+ * @brief Bus handles for the sensors compiled in by the active profile (profile.h).
+ */
+struct SensorPorts {
+#if SENSOR_MHZ14A
+    HardwareSerial* co2Serial;
+#endif
+#if SENSOR_SPS30
+    HardwareSerial* sps30Serial;
+#endif
+#if SENSOR_DHT22
+    Dht22Rmt* dht;
+#endif
+#if SENSOR_I2C_SGP_BUS
+    TwoWire* wireSGP;       // SGP40, SGP30 and SHT31 use the second I2C bus
+#endif
+#if SENSOR_SC16CO
+    SoftwareSerial* coSerial;
+#endif
+};
+
 /**
  * @brief Handles communication with all connected sensors (BMP280, SGP40, SGP30, DHT, CO2, CO).
  * 
@@ -26,62 +76,96 @@ struct DhtReading {
  */
 class SensorReader {
 public:
-    // SGP40 and SGP30 will use the second I2C bus (wireSGP)
-    SensorReader(HardwareSerial& co2Serial, HardwareSerial& sps30Serial, DHT_Unified& dht, TwoWire& wireSGP, SoftwareSerial& coSerial);
-    
+    // Only the drivers selected by the sensor profile are compiled in
+    explicit SensorReader(const SensorPorts& ports);
+
+#ifdef BUS_TRACE
+    /**
+     * @brief Records UART bytes, I2C probes and driver results into trace
+     * (nullptr stops recording). Build with -D BUS_TRACE.
+     */
+    void setTrace(BusTraceWriter* trace) { _trace = trace; }
 
+    /**
+     * @brief Marks the start of a scheduled read of hw in the trace.
+     */
+    void traceCycle(HardwareSlot hw);
+#else
+    void traceCycle(HardwareSlot) {}
+#endif
+
+#if SENSOR_BMP280
     /**
      * @brief Initializes the BMP280 sensor (Pressure/Temp).
      * @param maxAttempts Number of retries before failing.
      * @return true if successful, false otherwise.
      */
     bool initBMP(int maxAttempts = 3, int delayBetweenMs = 100);
+#endif
 
+#if SENSOR_SGP40
     /**
      * @brief Initializes the SGP40 sensor (VOC).
      * @return true if successful, false otherwise.
      */
     bool initSGP(int maxAttempts = 3, int delayBetweenMs = 100);
+#endif
 
+#if SENSOR_SGP30
     /**
      * @brief Initializes the SGP30 sensor (eCO2/TVOC).
      * @return true if successful, false otherwise.
      */
     bool initSGP30(int maxAttempts = 3, int delayBetweenMs = 100);
+#endif
 
+#if SENSOR_SPS30
     /**
-     * @brief Initializes the SPS30 sensor (PM) via UART.
-     * @return true if successful, false otherwise.
+     * @brief Starts the SPS30 (PM) bring-up over UART: wake-up, stop, reset,
+     * serial number, start. Non-blocking, the sequence runs from pollSPS30().
+     * @param maxAttempts Bring-up sequences tried before giving up
+     * @param delayBetweenMs Pause before a new sequence
+     * @return true if the sequence was queued
      */
     bool initSPS30(int maxAttempts = 3, int delayBetweenMs = 100);
+#endif
 
     /**
-     * @brief Scans an I2C bus and logs found devices.
-     * @return Number of devices found.
+     * @brief Probes one address (I2cDiscovery).
+     * @return Wire.endTransmission() code: 0 ACK, 2 NACK on address, 5 timeout.
      */
-    int scanI2C(TwoWire& wire, const char* busName);
+    uint8_t probeI2C(BusId bus, uint8_t address);
 
+#if SENSOR_MHZ14A
     /**
      * @brief Reads CO2 concentration from MH-Z19/14A sensor via Serial.
      * @return CO2 ppm value, or negative error code (-1: timeout, -2: header error, -3: range error).
      */
     int readCO2();
+#endif
 
+#if SENSOR_SGP40
     /**
      * @brief Checks if SGP40 is reachable on the I2C bus.
      */
     bool isSGPConnected();
+#endif
     
+#if SENSOR_SGP30
     /**
      * @brief Checks if SGP30 is reachable on the I2C bus.
      */
     bool isSGP30Connected();
+#endif
 
+#if SENSOR_BMP280
     /**
      * @brief Checks if BMP280 is reachable on the I2C bus.
      */
     bool isBMPConnected();
+#endif
 
+#if SENSOR_SGP40
     /**
      * @brief Reads Voc Index from SGP40.
      * Returns -1 if sensor is disconnected.
@@ -89,7 +173,9 @@ public:
      * @return VOC Index (0-500), or -1 on error.
      */
     int readVocIndex();
+#endif
 
+#if SENSOR_SGP30
     /**
      * @brief Reads eCO2 and TVOC from SGP30.
      * @param eco2 Reference to store eCO2 value (ppm)
@@ -98,6 +184,15 @@ public:
      */
     bool readSGP30(int& eco2, int& tvoc);
 
+    /**
+     * @brief Sets SGP30 humidity compensation.
+     * @param absHumidity Absolute humidity in g/m³ (e.g. from DerivedMetrics)
+     * @return true if the command was accepted
+     */
+    bool setSGP30Humidity(float absHumidity);
+#endif
+
+#if SENSOR_BMP280
     /**
      * @brief Reads Pressure from BMP280.
      * Returns NAN if sensor is disconnected.
@@ -114,15 +209,36 @@ public:
      * @brief Resets the BMP280 sensor including I2C bus recovery.
      */
     bool resetBMP();
+#endif
 
+#if SENSOR_SGP40
     /**
      * @brief Resets the SGP40 sensor.
      */
     bool resetSGP();
+#endif
 
+#if SENSOR_DHT22
     void resetDHT();
+
+    /**
+     * @brief Starts an asynchronous DHT22 read (RMT capture, non-blocking).
+     * @return false if a read is in progress or the sensor needs more time.
+     */
+    bool startDhtRead();
+
+    /**
+     * @brief Collects the DHT22 read started by startDhtRead().
+     * @param reading Filled when the read completed (valid = false on error)
+     * @return true once per started read, when it completed or timed out
+     */
+    bool pollDht(DhtReading& reading);
+
+    bool isDhtBusy() const { return _ports.dht->busy(); }
+#endif
+#if SENSOR_MHZ14A
     void resetCO2();
-    DhtReading readDhtSensors();
+#endif
 
     /**
      * @brief Manual I2C bus recovery routine.
@@ -132,16 +248,27 @@ public:
      */
     void recoverI2C(int sdaPin = 21, int sclPin = 22);
 
+#if SENSOR_SPS30
     /**
-     * @brief Reads PM values from SPS30.
-     * @param pm1 Reference to store PM1.0
-     * @param pm25 Reference to store PM2.5
-     * @param pm4 Reference to store PM4.0
-     * @param pm10 Reference to store PM10
-     * @return true if read successful, false otherwise
+     * @brief Queues an SPS30 measurement read (non-blocking).
+     * @return false while the sensor is starting, measuring for less than
+     * SPS30_FIRST_DATA_MS, or a read is pending. A sensor whose bring-up
+     * failed gets a new wake-up + start sequence instead.
+     */
+    bool startSPS30Read();
+
+    /**
+     * @brief Runs the SPS30 command queue and collects the read started by
+     * startSPS30Read(). Call on every loop pass.
+     * @param reading Filled when the read completed (valid = false on error)
+     * @return true once per started read, when it completed or timed out
      */
-    bool readSPS30(float& pm1, float& pm25, float& pm4, float& pm10);
+    bool pollSPS30(Sps30Reading& reading);
 
+    bool isSps30Busy() const { return _sps30State == SPS30_STARTING || _sps30Reading; }
+#endif
+
+#if SENSOR_SHT31
     /**
      * @brief Initializes the SHT3x sensor (Temp/Hum).
      * @return true if successful, false otherwise.
@@ -165,7 +292,9 @@ public:
      * @brief Resets the SHT3x sensor.
      */
     void resetSHT();
+#endif
 
+#if SENSOR_SC16CO
     // ============ SC16-CO (Carbon Monoxide) ============
     
     /**
@@ -185,23 +314,51 @@ public:
      * @brief Clears the CO serial buffer.
      */
     void resetCOBuffer();
+#endif
     
 private:
-    HardwareSerial& co2Serial;
-    HardwareSerial& sps30Serial;
-    SoftwareSerial& _coSerial;
-    DHT_Unified& dht;
-    TwoWire& _wireSGP;
-    Adafruit_SGP40 sgp;
-    Adafruit_SGP30 sgp30;
-    Adafruit_SHT31 sht;
-    Adafruit_BMP280 bmp;
-    SensirionUartSps30 sps30;
+    SensorPorts _ports;     // Bus handles of the compiled drivers
+
+#ifdef BUS_TRACE
+    BusTraceWriter* _trace = nullptr;
+#endif
+#if SENSOR_MHZ14A
     static const uint8_t CO2_READ_CMD[9];
-    
+#endif
+#if SENSOR_SPS30
+    enum Sps30State : uint8_t { SPS30_OFF, SPS30_STARTING, SPS30_MEASURING, SPS30_FAILED };
+    static const uint32_t SPS30_FIRST_DATA_MS = 1000;  // First measurement after start
+
+    void queueSPS30Start(bool bringUp, uint16_t delayMs);
+    bool sps30StepDone(const Sps30Shdlc::Result& result);   // false: sequence failed
+
+    Sps30Shdlc sps30;
+    Sps30State _sps30State = SPS30_OFF;
+    bool _sps30Reading = false;
+    uint8_t _sps30Attempts = 0;         // Bring-up sequences left
+    uint16_t _sps30RetryMs = 0;
+    uint32_t _sps30StartedMs = 0;       // Start acknowledged
+#endif
+#if SENSOR_SC16CO
     // SC16-CO buffer for parsing auto-upload frames
     uint8_t _coBuffer[9];
     int _coBufferIndex = 0;
+#endif
+#if SENSOR_DHT22
+    DhtReading _lastDht = {0.0, 0.0, false};   // Last valid read (SGP40 compensation fallback)
+#endif
+#if SENSOR_SGP40
+    Adafruit_SGP40 sgp;
+#endif
+#if SENSOR_SGP30
+    Adafruit_SGP30 sgp30;
+#endif
+#if SENSOR_SHT31
+    Adafruit_SHT31 sht;
+#endif
+#if SENSOR_BMP280
+    Adafruit_BMP280 bmp;
+#endif
 };
 
 #endif
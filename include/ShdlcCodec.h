@@ -0,0 +1,196 @@
+#ifndef SHDLC_CODEC_H
+#define SHDLC_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ============================================================================
+// SHDLC Frame Codec
+// ============================================================================
+// Sensirion SHDLC framing, as spoken by the SPS30 on its UART (115200 8N1):
+//
+//   MOSI (request) : 0x7E, ADR, CMD, L, data[L], CHK, 0x7E
+//   MISO (response): 0x7E, ADR, CMD, STATE, L, data[L], CHK, 0x7E
+//
+// CHK is the inverted low byte of the sum of ADR..data. Between the two flags,
+// 0x7E, 0x7D, 0x11 and 0x13 are sent as 0x7D followed by the byte XOR 0x20.
+// Multi-byte values are big-endian.
+//
+// Pure logic (no Arduino dependency): the decoder is fed one byte at a time
+// from whatever receives the UART bytes, so frames can arrive in any split.
+
+static const uint8_t SHDLC_FLAG = 0x7E;
+static const uint8_t SHDLC_ESCAPE = 0x7D;
+static const uint8_t SHDLC_ESCAPE_XOR = 0x20;
+static const uint8_t SHDLC_MAX_DATA = 64;       // SPS30: 40-byte measurement, 32-byte strings
+// Flags + every byte of ADR..CHK stuffed
+static const size_t SHDLC_MAX_FRAME = 2 + 2 * (4 + SHDLC_MAX_DATA + 1);
+
+/**
+ * @brief One decoded (unstuffed) frame.
+ */
+struct ShdlcFrame {
+    uint8_t address;
+    uint8_t command;
+    uint8_t state;      // MISO only: bit 7 device error flag, bits 0-6 execution error code
+    uint8_t len;
+    uint8_t data[SHDLC_MAX_DATA];
+};
+
+enum ShdlcStatus : uint8_t {
+    SHDLC_PENDING = 0,  // Byte consumed, no frame completed
+    SHDLC_FRAME,        // frame() holds a valid frame
+    SHDLC_BAD_CHECKSUM,
+    SHDLC_BAD_LENGTH,   // L does not match the frame, or frame too long
+};
+
+inline bool shdlcIsReserved(uint8_t b) {
+    return b == SHDLC_FLAG || b == SHDLC_ESCAPE || b == 0x11 || b == 0x13;
+}
+
+/**
+ * @brief Encodes f into out. response selects the MISO layout (with state).
+ * @return Encoded size, 0 if out is too small or f.len too large.
+ */
+inline size_t shdlcEncode(const ShdlcFrame& f, bool response, uint8_t* out, size_t size) {
+    if (f.len > SHDLC_MAX_DATA) return 0;
+    uint8_t raw[4 + SHDLC_MAX_DATA + 1];
+    size_t n = 0;
+    raw[n++] = f.address;
+    raw[n++] = f.command;
+    if (response) raw[n++] = f.state;
+    raw[n++] = f.len;
+    memcpy(raw + n, f.data, f.len);
+    n += f.len;
+    uint8_t sum = 0;
+    for (size_t i = 0; i < n; i++) sum += raw[i];
+    raw[n++] = (uint8_t)~sum;
+
+    size_t pos = 0;
+    if (size < 2) return 0;
+    out[pos++] = SHDLC_FLAG;
+    for (size_t i = 0; i < n; i++) {
+        if (shdlcIsReserved(raw[i])) {
+            if (pos + 2 > size - 1) return 0;
+            out[pos++] = SHDLC_ESCAPE;
+            out[pos++] = raw[i] ^ SHDLC_ESCAPE_XOR;
+        } else {
+            if (pos + 1 > size - 1) return 0;
+            out[pos++] = raw[i];
+        }
+    }
+    out[pos++] = SHDLC_FLAG;
+    return pos;
+}
+
+/**
+ * @brief Reads a big-endian float (SPS30 IEEE754 output format).
+ */
+inline float shdlcFloat(const uint8_t* p) {
+    uint32_t bits = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+inline void shdlcPutFloat(uint8_t* p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    p[0] = (uint8_t)(bits >> 24);
+    p[1] = (uint8_t)(bits >> 16);
+    p[2] = (uint8_t)(bits >> 8);
+    p[3] = (uint8_t)bits;
+}
+
+/**
+ * @brief Incremental frame decoder.
+ *
+ * Bytes outside a frame (the 0xFF wake-up pulse, line noise) are ignored. A
+ * flag right after another one, or closing an invalid frame, is taken as a
+ * start flag, so the decoder resynchronises on the next frame after a lost or
+ * corrupted byte.
+ */
+class ShdlcDecoder {
+public:
+    /**
+     * @param response true to decode MISO frames (device answers), false for
+     * MOSI frames (requests, used by the host device simulation)
+     */
+    explicit ShdlcDecoder(bool response = true) : _response(response) { reset(); }
+
+    void reset() {
+        _inFrame = false;
+        _escaped = false;
+        _overflow = false;
+        _pos = 0;
+    }
+
+    /**
+     * @brief Consumes one received byte.
+     * @return SHDLC_FRAME when b closed a valid frame (see frame()), an error
+     * status when it closed an invalid one, SHDLC_PENDING otherwise
+     */
+    ShdlcStatus feed(uint8_t b) {
+        if (b == SHDLC_FLAG) {
+            if (!_inFrame || (_pos == 0 && !_overflow)) {
+                _inFrame = true;
+                _escaped = false;
+                return SHDLC_PENDING;
+            }
+            ShdlcStatus status = _overflow || _escaped ? SHDLC_BAD_LENGTH : decode();
+            reset();
+            // A bad frame may have lost its end flag: this one can start the next
+            _inFrame = status != SHDLC_FRAME;
+            return status;
+        }
+        if (!_inFrame) return SHDLC_PENDING;
+        if (b == SHDLC_ESCAPE) {
+            _escaped = true;
+            return SHDLC_PENDING;
+        }
+        if (_escaped) {
+            b ^= SHDLC_ESCAPE_XOR;
+            _escaped = false;
+        }
+        if (_pos < sizeof(_raw)) _raw[_pos++] = b;
+        else _overflow = true;
+        return SHDLC_PENDING;
+    }
+
+    const ShdlcFrame& frame() const { return _frame; }
+
+    /**
+     * @brief True while no frame content was received: the next byte starts
+     * a frame (or is noise between frames).
+     */
+    bool empty() const { return _pos == 0 && !_escaped; }
+
+private:
+    ShdlcStatus decode() {
+        const uint8_t header = _response ? 4 : 3;
+        if (_pos < header + 1) return SHDLC_BAD_LENGTH;
+        uint8_t len = _raw[header - 1];
+        if (len > SHDLC_MAX_DATA || _pos != header + len + 1) return SHDLC_BAD_LENGTH;
+        uint8_t sum = 0;
+        for (uint8_t i = 0; i < _pos - 1; i++) sum += _raw[i];
+        if ((uint8_t)~sum != _raw[_pos - 1]) return SHDLC_BAD_CHECKSUM;
+
+        _frame.address = _raw[0];
+        _frame.command = _raw[1];
+        _frame.state = _response ? _raw[2] : 0;
+        _frame.len = len;
+        memcpy(_frame.data, _raw + header, len);
+        return SHDLC_FRAME;
+    }
+
+    bool _response;
+    bool _inFrame;
+    bool _escaped;
+    bool _overflow;
+    uint8_t _pos;
+    uint8_t _raw[4 + SHDLC_MAX_DATA + 1];
+    ShdlcFrame _frame;
+};
+
+#endif // SHDLC_CODEC_H
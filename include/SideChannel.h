@@ -0,0 +1,69 @@
+#ifndef SIDE_CHANNEL_H
+#define SIDE_CHANNEL_H
+
+#include <Arduino.h>
+#include <AsyncMqttClient.h>
+
+/**
+ * @brief Secondary MQTT connection for raw / binary topics.
+ *
+ * IotMesurable only publishes float measurements under {moduleId}/{hw}/{m}.
+ * Services that need their own request topics or binary payloads (history,
+ * diagnostics) go through this connection instead. Topics are given as
+ * suffixes and prefixed with the module ID.
+ *
+ * Message handlers run in the AsyncTCP task: copy what you need and defer the
+ * work to loop().
+ */
+class SideChannel {
+public:
+    typedef void (*MessageHandler)(const char* suffix, const uint8_t* payload, size_t len);
+
+    explicit SideChannel(const char* moduleId);
+
+    void begin(const char* host, uint16_t port);
+
+    /**
+     * @brief Reconnects with backoff once WiFi is up. Call from loop().
+     */
+    void loop();
+
+    bool connected();
+
+    /**
+     * @brief Subscribes to {moduleId}/{suffix}. Re-applied on every reconnect.
+     */
+    bool subscribe(const char* suffix);
+
+    /**
+     * @brief Publishes raw bytes to {moduleId}/{suffix} (QoS 0).
+     */
+    bool publish(const char* suffix, const uint8_t* data, size_t len, bool retain = false);
+
+    /**
+     * @brief Publishes to a complete topic as given (QoS 0), without building
+     * it: for the interned measurement topics of the hot path (TopicTable.h).
+     */
+    bool publishTopic(const char* topic, const char* payload, size_t len);
+
+    void onMessage(MessageHandler handler);
+
+private:
+    static const uint8_t MAX_SUBSCRIPTIONS = 4;
+    static const unsigned long RECONNECT_MIN_MS = 2000;
+    static const unsigned long RECONNECT_MAX_MS = 60000;
+
+    void buildTopic(char* out, size_t outLen, const char* suffix) const;
+
+    AsyncMqttClient _client;
+    const char* _moduleId;
+    char _clientId[48];
+    const char* _subscriptions[MAX_SUBSCRIPTIONS];
+    uint8_t _subscriptionCount = 0;
+    MessageHandler _handler = nullptr;
+    unsigned long _lastAttempt = 0;
+    unsigned long _backoffMs = RECONNECT_MIN_MS;
+    bool _started = false;
+};
+
+#endif // SIDE_CHANNEL_H
@@ -0,0 +1,121 @@
+#ifndef SPS30_SHDLC_H
+#define SPS30_SHDLC_H
+
+#include <Arduino.h>
+#include "ShdlcCodec.h"
+
+/**
+ * @brief Non-blocking SHDLC transport for the SPS30 on a hardware UART.
+ *
+ * Commands are queued with submit(); poll() sends the next one once the line
+ * is free (a frame fits in the UART TX FIFO, write() returns at once) and
+ * hands back one completed command per call. Answers are decoded byte by byte
+ * from the UART receive callback (onReceive, UART event task) with
+ * ShdlcCodec.h, so the loop never waits while bytes are on the wire.
+ *
+ * Only one command is in flight: the SPS30 answers every request, a request
+ * without answer after RESPONSE_TIMEOUT_MS completes with ERROR_TIMEOUT. The
+ * next one then waits LATE_ANSWER_GUARD_MS more, and a frame whose first byte
+ * arrived before the command in flight was sent is dropped: a late answer
+ * never completes the next command, even one with the same command byte.
+ */
+class Sps30Shdlc {
+public:
+    static const uint8_t QUEUE_SIZE = 8;
+    static const uint32_t RESPONSE_TIMEOUT_MS = 100;    // Datasheet: answer within 20 ms
+    static const uint32_t LATE_ANSWER_GUARD_MS = 100;   // Line left quiet after a timeout
+
+    // Result codes above the 8-bit device state
+    static const int16_t ERROR_FRAME = 0x0101;          // Checksum / length error
+    static const int16_t ERROR_TIMEOUT = 0x0102;        // No answer
+
+    enum Command : uint8_t {
+        CMD_START = 0x00,           // data: 0x01, 0x03 (float output)
+        CMD_STOP = 0x01,
+        CMD_READ = 0x03,            // answer: 10 floats, or no data if not ready
+        CMD_WAKEUP = 0x11,          // preceded by a 0xFF pulse on the line
+        CMD_DEVICE_INFO = 0xD0,     // data: 0x03 (serial number)
+        CMD_RESET = 0xD3,
+    };
+
+    /**
+     * @brief A completed command.
+     */
+    struct Result {
+        uint8_t command;
+        int16_t error;              // 0, the device state (execution error), or ERROR_*
+        uint8_t len;
+        uint8_t data[SHDLC_MAX_DATA];
+    };
+
+    explicit Sps30Shdlc(HardwareSerial& serial) : _serial(serial) {}
+
+    /**
+     * @brief Opens the UART and installs the receive callback. Safe to call
+     * again (reset): drops the queued commands.
+     */
+    void begin(int8_t rxPin, int8_t txPin);
+
+    /**
+     * @brief Queues a command, sent delayMs after the previous one completed
+     * (reset / start settling times).
+     * @return false if the queue is full
+     */
+    bool submit(uint8_t command, const uint8_t* data = nullptr, uint8_t len = 0, uint16_t delayMs = 0);
+
+    /**
+     * @brief Sends the next queued command when due and collects answers.
+     * @return true once per completed command, with its result
+     */
+    bool poll(uint32_t nowMs, Result& result);
+
+    bool busy() const { return _inFlight || _count > 0; }
+
+    /**
+     * @brief Drops the queued commands. An answer to the one in flight is
+     * discarded when it arrives.
+     */
+    void clear();
+
+    uint32_t frameErrors() const { return _frameErrors; }
+
+private:
+    struct Request {
+        uint8_t command;
+        uint8_t len;
+        uint16_t delayMs;
+        uint8_t data[4];
+    };
+
+    void send(const Request& request, uint32_t nowMs);
+    void receive();
+
+    HardwareSerial& _serial;
+    bool _installed = false;
+
+    Request _queue[QUEUE_SIZE];
+    uint8_t _head = 0;
+    uint8_t _count = 0;
+    uint8_t _tx[1 + SHDLC_MAX_FRAME];   // Encoded request (+ wake-up pulse)
+
+    bool _inFlight = false;
+    uint8_t _command = 0;
+    uint32_t _sentMs = 0;
+    uint32_t _doneMs = 0;
+    uint32_t _guardMs = 0;              // Added to the next delay after a timeout
+
+    // UART event task only
+    ShdlcDecoder _decoder;
+    uint8_t _frameGeneration = 0;       // _txGeneration when the frame started
+
+    // Hand-off to the loop: the UART event task and the loop run on different
+    // cores, every access holds _rxLock
+    portMUX_TYPE _rxLock = portMUX_INITIALIZER_UNLOCKED;
+    ShdlcFrame _rxFrame;
+    ShdlcStatus _rxStatus = SHDLC_PENDING;
+    bool _rxReady = false;
+    volatile uint8_t _txGeneration = 0; // Bumped by every send()
+    uint32_t _frameErrors = 0;
+};
+
+#endif // SPS30_SHDLC_H
@@ -0,0 +1,165 @@
+#ifndef STAGE_BUDGET_H
+#define STAGE_BUDGET_H
+
+#include <stdint.h>
+#include "Channels.h"
+
+// ============================================================================
+// Loop Stages
+// ============================================================================
+// Every stage of loop() declares a time budget. Overruns are counted per
+// stage; a hardware read that keeps overrunning is backed off, then disabled,
+// before the task watchdog (LoopWatchdog) has to reset the chip.
+
+enum LoopStage : uint8_t {
+    STAGE_BRAIN_LOOP = 0,   // brain.loop(): WiFi / MQTT / status
+    STAGE_SIDE_CHANNEL,     // sideChannel.loop()
+    STAGE_SERVICES,         // history, compare, resources, trace flush
+    STAGE_DISCOVERY,        // I2C hot-plug probes and inits
+    STAGE_READ,             // + HardwareSlot: one scheduled read
+    STAGE_PUBLISH = STAGE_READ + HW_COUNT,  // derived metrics, sampler rates, output sinks
+    STAGE_MUX,              // One channel group of the multiplexed sensors (MuxSensors)
+    STAGE_COUNT
+};
+
+inline LoopStage readStage(HardwareSlot hw) {
+    return (LoopStage)(STAGE_READ + hw);
+}
+
+/**
+ * @brief Hardware read by a stage, HW_COUNT for the other stages.
+ */
+inline uint8_t stageHardware(uint8_t stage) {
+    return (stage >= STAGE_READ && stage < STAGE_PUBLISH) ? stage - STAGE_READ : HW_COUNT;
+}
+
+// Budgets cover the normal worst case of each stage (retries included), so an
+// overrun means something is wrong, not just slow
+static const uint16_t STAGE_BUDGET_MS[STAGE_COUNT] = {
+    250,    // brain        - reconnect attempts, status publish
+    100,    // side         - reconnect attempts
+    50,     // services     - report formatting
+    150,    // discovery    - < 1 ms of probes, hot-plug init (SHT31 settles 100 ms)
+    600,    // mhz14a       - 500 ms answer timeout
+    20,     // dht22        - RMT start only, the capture runs in the background
+    150,    // sgp40        - measureRaw ~30 ms, one bus recovery
+    150,    // sgp30        - IAQmeasure 12 ms, one bus recovery
+    20,     // sps30        - queues the read, the SHDLC answer is collected in the background
+    100,    // bmp280
+    150,    // sht31        - 15 ms measurement, one bus recovery
+    250,    // sc16co       - 150 ms frame timeout
+    100,    // publish      - every value read in the pass, on every output
+    150,    // mux          - SHT31 15 ms + SGP40 30 ms per channel, a few instances per channel
+};
+
+inline const char* stageName(uint8_t stage) {
+    static const char* const NAMES[] = { "brain", "side", "services", "discovery" };
+    if (stage < STAGE_READ) return NAMES[stage];
+    if (stage < STAGE_PUBLISH) return HARDWARE_TABLE[stage - STAGE_READ].id;
+    if (stage == STAGE_PUBLISH) return "publish";
+    return stage == STAGE_MUX ? "mux" : "?";
+}
+
+// ============================================================================
+// Budget Accounting / Escalation
+// ============================================================================
+
+enum StageAction : uint8_t {
+    STAGE_OK = 0,
+    STAGE_OVERRUN,      // Counted
+    STAGE_BACKOFF,      // Hardware read skipped for BACKOFF_MS
+    STAGE_DISABLED,     // Hardware read stopped until clear()
+};
+
+struct StageStats {
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t maxUs;
+    uint32_t lastOverrunUs;
+    uint8_t streak;         // Consecutive overruns
+    bool disabled;
+    bool backedOff;         // backoffUntilMs is meaningful only while set
+    uint32_t backoffUntilMs;
+};
+
+/**
+ * @brief Per-stage run / overrun counters and the skip -> disable ladder.
+ *
+ * Only hardware read stages escalate: the other stages cannot be skipped and
+ * are left to the task watchdog.
+ */
+class StageBudget {
+public:
+    static const uint8_t BACKOFF_AFTER = 3;     // Consecutive overruns
+    static const uint8_t DISABLE_AFTER = 6;
+    static const uint32_t BACKOFF_MS = 60000;
+
+    /**
+     * @brief False while the stage is backed off or disabled. An expired
+     * backoff is lifted here, so the comparison never runs on a deadline
+     * more than 2^31 ms away (millis() wrap safe).
+     */
+    bool allowed(uint8_t stage, uint32_t nowMs) {
+        if (stage >= STAGE_COUNT) return false;
+        StageStats& s = _stats[stage];
+        if (s.disabled) return false;
+        if (!s.backedOff) return true;
+        if ((int32_t)(nowMs - s.backoffUntilMs) < 0) return false;
+        s.backedOff = false;
+        return true;
+    }
+
+    /**
+     * @brief Accounts one run of the stage and returns the escalation step.
+     */
+    StageAction record(uint8_t stage, uint32_t elapsedUs, uint32_t nowMs) {
+        if (stage >= STAGE_COUNT) return STAGE_OK;
+        StageStats& s = _stats[stage];
+        s.runs++;
+        if (elapsedUs > s.maxUs) s.maxUs = elapsedUs;
+        if (elapsedUs <= (uint32_t)STAGE_BUDGET_MS[stage] * 1000) {
+            s.streak = 0;
+            return STAGE_OK;
+        }
+        s.overruns++;
+        s.lastOverrunUs = elapsedUs;
+        if (s.streak < 255) s.streak++;
+        if (stageHardware(stage) == HW_COUNT) return STAGE_OVERRUN;
+
+        if (s.streak >= DISABLE_AFTER) {
+            s.disabled = true;
+            return STAGE_DISABLED;
+        }
+        if (s.streak == BACKOFF_AFTER) {
+            s.backedOff = true;
+            s.backoffUntilMs = nowMs + BACKOFF_MS;
+            return STAGE_BACKOFF;
+        }
+        return STAGE_OVERRUN;
+    }
+
+    /**
+     * @brief Disables a stage without an overrun (quarantine after a watchdog reset).
+     */
+    void disable(uint8_t stage) {
+        if (stage < STAGE_COUNT) _stats[stage].disabled = true;
+    }
+
+    /**
+     * @brief Re-enables a stage (hardware reset command) and restarts its ladder.
+     */
+    void clear(uint8_t stage) {
+        if (stage >= STAGE_COUNT) return;
+        StageStats& s = _stats[stage];
+        s.streak = 0;
+        s.disabled = false;
+        s.backedOff = false;
+    }
+
+    const StageStats& stats(uint8_t stage) const { return _stats[stage]; }
+
+private:
+    StageStats _stats[STAGE_COUNT] = {};
+};
+
+#endif // STAGE_BUDGET_H
@@ -0,0 +1,263 @@
+#ifndef STREAM_FILTER_H
+#define STREAM_FILTER_H
+
+#include <stdint.h>
+#include <math.h>
+
+// ============================================================================
+// Streaming Filter Stages
+// ============================================================================
+// Header-only, allocation-free, templated on value type and window size.
+// Every stage implements:
+//
+//     bool apply(T& value, uint32_t nowMs);
+//
+// which updates value in place and returns false when the sample must be
+// dropped. Stages are combined with FilterChain<...> and applied between the
+// read and the publish.
+
+/**
+ * @brief Fixed-capacity sliding window with an incrementally sorted copy.
+ *
+ * push() is O(N): one removal and one insertion in the sorted array, no sort.
+ */
+template <typename T, uint8_t N>
+class SlidingWindow {
+public:
+    static_assert(N > 0, "window size must be > 0");
+
+    void push(T v) {
+        if (_count == N) {
+            removeSorted(_ring[_head]);
+        } else {
+            _count++;
+        }
+        _ring[_head] = v;
+        _head = (uint8_t)((_head + 1) % N);
+        insertSorted(v);
+    }
+
+    T median() const {
+        uint8_t mid = _count / 2;
+        if (_count & 1) return _sorted[mid];
+        return (_sorted[mid - 1] + _sorted[mid]) / 2;
+    }
+
+    // Median absolute deviation around m (O(N) merge from the sorted window)
+    T mad(T m) const {
+        T dev[N];
+        // Deviations below and above m are each already sorted: merge them
+        int16_t lo = 0;
+        while (lo < _count && _sorted[lo] < m) lo++;
+        int16_t i = lo - 1;
+        int16_t j = lo;
+        for (uint8_t k = 0; k < _count; k++) {
+            if (j >= _count || (i >= 0 && (m - _sorted[i]) <= (_sorted[j] - m))) {
+                dev[k] = m - _sorted[i--];
+            } else {
+                dev[k] = _sorted[j++] - m;
+            }
+        }
+        uint8_t mid = _count / 2;
+        if (_count & 1) return dev[mid];
+        return (dev[mid - 1] + dev[mid]) / 2;
+    }
+
+    uint8_t size() const { return _count; }
+    bool full() const { return _count == N; }
+    void clear() { _count = 0; _head = 0; }
+
+private:
+    void insertSorted(T v) {
+        uint8_t i = _count - 1;
+        while (i > 0 && _sorted[i - 1] > v) {
+            _sorted[i] = _sorted[i - 1];
+            i--;
+        }
+        _sorted[i] = v;
+    }
+
+    void removeSorted(T v) {
+        uint8_t i = 0;
+        while (i < _count - 1 && _sorted[i] != v) i++;
+        for (; i < _count - 1; i++) _sorted[i] = _sorted[i + 1];
+    }
+
+    T _ring[N];
+    T _sorted[N];
+    uint8_t _head = 0;
+    uint8_t _count = 0;
+};
+
+/**
+ * @brief Replaces each sample with the median of the last N samples.
+ */
+template <typename T, uint8_t N>
+class RunningMedian {
+public:
+    bool apply(T& v, uint32_t) {
+        _window.push(v);
+        v = _window.median();
+        return true;
+    }
+
+private:
+    SlidingWindow<T, N> _window;
+};
+
+/**
+ * @brief What Hampel does with an outlier.
+ */
+enum HampelMode : uint8_t {
+    HAMPEL_REPLACE,     // Replaced by the window median
+    HAMPEL_REJECT,      // Dropped (apply() returns false)
+    HAMPEL_CLAMP        // Clamped to the outlier threshold around the median
+};
+
+/**
+ * @brief Hampel identifier: flags samples further than k * 1.4826 * MAD from
+ * the median of the previous N samples. k <= 0 disables the stage.
+ *
+ * On a flat window MAD is 0, so the first samples of a genuine step are
+ * flagged until it takes over the median (N/2 + 1 samples). Replace and
+ * reject hide such a step until then; clamp lets it through at once,
+ * bounded to the threshold.
+ */
+template <typename T, uint8_t N>
+class Hampel {
+public:
+    explicit Hampel(float k = 3.0f, HampelMode mode = HAMPEL_REPLACE) : _k(k), _mode(mode) {}
+
+    bool apply(T& v, uint32_t) {
+        if (_k <= 0) return true;
+        if (!_window.full()) {
+            _window.push(v);
+            return true;
+        }
+
+        // Compare against the previous N raw samples, then add the raw sample:
+        // a genuine level shift takes over the median after N/2 samples.
+        T m = _window.median();
+        float sigma = 1.4826f * (float)_window.mad(m);
+        float dev = fabsf((float)v - (float)m);
+        _window.push(v);
+
+        float threshold = _k * sigma > _minDeviation ? _k * sigma : _minDeviation;
+        if (dev > threshold) {
+            _outliers++;
+            if (_mode == HAMPEL_REJECT) return false;
+            if (_mode == HAMPEL_CLAMP) {
+                v = (T)((float)v > (float)m ? (float)m + threshold : (float)m - threshold);
+            } else {
+                v = m;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Deviations below this are never outliers (avoids flagging
+     * quantization steps when the window is perfectly flat).
+     */
+    void setMinDeviation(float d) { _minDeviation = d; }
+
+    uint32_t outliers() const { return _outliers; }
+
+private:
+    SlidingWindow<T, N> _window;
+    float _k;
+    HampelMode _mode;
+    float _minDeviation = 0;
+    uint32_t _outliers = 0;
+};
+
+/**
+ * @brief Exponential moving average. alpha = 1 passes samples through.
+ */
+template <typename T>
+class Ema {
+public:
+    explicit Ema(float alpha = 1.0f) : _alpha(alpha) {}
+
+    bool apply(T& v, uint32_t) {
+        if (!_primed) {
+            _state = (float)v;
+            _primed = true;
+        } else {
+            _state += _alpha * ((float)v - _state);
+        }
+        v = (T)_state;
+        return true;
+    }
+
+private:
+    float _alpha;
+    float _state = 0;
+    bool _primed = false;
+};
+
+/**
+ * @brief Limits the slope between published samples to maxPerSecond.
+ * maxPerSecond <= 0 disables the stage.
+ */
+template <typename T>
+class RateLimiter {
+public:
+    explicit RateLimiter(float maxPerSecond = 0) : _maxPerSecond(maxPerSecond) {}
+
+    bool apply(T& v, uint32_t nowMs) {
+        if (_maxPerSecond > 0 && _primed) {
+            float maxStep = _maxPerSecond * (float)(nowMs - _lastMs) / 1000.0f;
+            float delta = (float)v - (float)_last;
+            if (delta > maxStep) v = (T)((float)_last + maxStep);
+            else if (delta < -maxStep) v = (T)((float)_last - maxStep);
+        }
+        _last = v;
+        _lastMs = nowMs;
+        _primed = true;
+        return true;
+    }
+
+private:
+    float _maxPerSecond;
+    T _last = 0;
+    uint32_t _lastMs = 0;
+    bool _primed = false;
+};
+
+/**
+ * @brief Applies stages in order; stops at the first stage that drops the sample.
+ *
+ *     FilterChain<Hampel<float, 7>, RateLimiter<float>, Ema<float>> f(
+ *         Hampel<float, 7>(3.0f), RateLimiter<float>(50.0f), Ema<float>(0.5f));
+ */
+template <typename... Stages>
+class FilterChain;
+
+template <>
+class FilterChain<> {
+public:
+    template <typename T>
+    bool apply(T&, uint32_t) { return true; }
+};
+
+template <typename First, typename... Rest>
+class FilterChain<First, Rest...> {
+public:
+    FilterChain() = default;
+    explicit FilterChain(const First& first, const Rest&... rest) : _first(first), _rest(rest...) {}
+
+    template <typename T>
+    bool apply(T& v, uint32_t nowMs) {
+        return _first.apply(v, nowMs) && _rest.apply(v, nowMs);
+    }
+
+    First& first() { return _first; }
+    FilterChain<Rest...>& rest() { return _rest; }
+
+private:
+    First _first;
+    FilterChain<Rest...> _rest;
+};
+
+#endif // STREAM_FILTER_H
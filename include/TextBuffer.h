@@ -0,0 +1,22 @@
+#ifndef TEXT_BUFFER_H
+#define TEXT_BUFFER_H
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stddef.h>
+
+/**
+ * @brief Appends to a fixed buffer, never overflows (output is truncated instead).
+ * @return New write position.
+ */
+inline size_t appendf(char* buf, size_t size, size_t pos, const char* fmt, ...) {
+    if (pos >= size) return pos;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + pos, size - pos, fmt, args);
+    va_end(args);
+    if (n < 0) return pos;
+    return (pos + n >= size) ? size - 1 : pos + n;
+}
+
+#endif // TEXT_BUFFER_H
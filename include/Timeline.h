@@ -0,0 +1,281 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "StageBudget.h"
+
+// ============================================================================
+// Execution Timeline
+// ============================================================================
+// Spans and counters in a fixed ring, stamped with the CPU cycle counter.
+// Build with -D TIMELINE (ring size: -D TIMELINE_EVENTS=1024); the TL_* macros
+// compile out otherwise.
+//
+// Scoped spans are written once, when they end, as one complete event (start +
+// duration): half the ring space of a begin / end pair, and spans shorter than
+// a threshold (idle loop stages) can be dropped so the ring covers seconds of
+// real work instead of milliseconds of idle loops. TL_BEGIN / TL_END remain
+// for spans that cross functions.
+//
+// The ring is dumped on request (serial 'T', or {moduleId}/timeline/get) and
+// converted on the host by scripts/timeline_to_chrome.py into Chrome trace
+// JSON (chrome://tracing, ui.perfetto.dev).
+//
+// Dump format (little-endian), self-describing so the converter needs no copy
+// of the names below:
+//
+//   'T' 'L' u8 version u8 nameCount u16 cyclesPerUs u32 count u32 overwritten
+//   nameCount x (u8 len, len chars)
+//   count x event (u32 cycles, u8 kind, u8 name, u8 core, u8 reserved, i32 value)
+//
+// cycles is the start time; value is the duration in cycles for 'X' events,
+// the sample for counters.
+
+static const uint8_t TIMELINE_VERSION = 1;
+
+enum TimelineKind : uint8_t {
+    TL_KIND_BEGIN = 'B',
+    TL_KIND_END = 'E',
+    TL_KIND_COMPLETE = 'X',
+    TL_KIND_COUNTER = 'C',
+    TL_KIND_INSTANT = 'i',
+};
+
+enum TimelineName : uint8_t {
+    TL_STAGE = 0,                       // + LoopStage (LoopWatchdog enter / leave)
+    TL_LOOP = TL_STAGE + STAGE_COUNT,
+    // SensorReader
+    TL_INIT_BMP,
+    TL_INIT_SGP40,
+    TL_INIT_SGP30,
+    TL_INIT_SPS30,
+    TL_INIT_SHT,
+    TL_INIT_CO,
+    TL_READ_CO2,
+    TL_DHT_START,
+    TL_DHT_POLL,
+    TL_READ_VOC,
+    TL_READ_SGP30,
+    TL_SGP30_HUMIDITY,
+    TL_SPS30_START,
+    TL_SPS30_POLL,
+    TL_READ_PRESSURE,
+    TL_READ_BMP_TEMPERATURE,
+    TL_READ_SHT,
+    TL_READ_CO,
+    TL_RESET_BMP,
+    TL_RESET_SGP,
+    TL_RESET_SHT,
+    TL_I2C_RECOVERY,
+    TL_HOTPLUG,                         // I2C discovery: init of an appeared device
+    TL_MUX_GROUP,                       // MuxSensors: one channel group
+    // MQTT
+    TL_PUBLISH,                         // brain.publish()
+    TL_SIDE_PUBLISH,                    // SideChannel::publish()
+    TL_SIDE_MESSAGE,                    // SideChannel message callback (AsyncTCP task)
+    TL_BRAIN_CONNECT,                   // brain.onConnect callback
+    TL_BRAIN_RESET,                     // brain.onResetChange callback
+    // Counters
+    TL_HEAP_FREE,
+    TL_HEAP_LARGEST,
+    TL_NAME_COUNT
+};
+
+inline const char* timelineName(uint8_t name) {
+    static const char* const NAMES[TL_NAME_COUNT - TL_LOOP] = {
+        "loop",
+        "initBMP", "initSGP", "initSGP30", "initSPS30", "initSHT", "initCO",
+        "readCO2", "startDhtRead", "pollDht", "readVocIndex", "readSGP30", "setSGP30Humidity",
+        "startSPS30Read", "pollSPS30", "readPressure", "readBMPTemperature", "readSHT", "readCO",
+        "resetBMP", "resetSGP", "resetSHT", "recoverI2C", "hotplug", "muxGroup",
+        "brain.publish", "side.publish", "side.onMessage", "brain.onConnect", "brain.onResetChange",
+        "heap.free", "heap.largest",
+    };
+    if (name < TL_LOOP) return stageName(name - TL_STAGE);
+    return name < TL_NAME_COUNT ? NAMES[name - TL_LOOP] : "?";
+}
+
+struct TimelineEvent {
+    uint32_t cycles;
+    uint8_t kind;
+    uint8_t name;
+    uint8_t core;
+    uint8_t reserved;
+    int32_t value;
+};
+
+/**
+ * @brief Fixed ring of timeline events, written lock-free from any task.
+ *
+ * The oldest events are overwritten. Writers reserve a slot with an atomic
+ * increment; the ring is frozen while it is dumped.
+ */
+template <uint16_t N>
+class TimelineRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "TimelineRing size must be a power of two");
+
+public:
+    void record(uint32_t cycles, TimelineKind kind, uint8_t name, uint8_t core, int32_t value = 0) {
+        if (_frozen) return;
+        uint32_t i = __atomic_fetch_add(&_head, 1, __ATOMIC_RELAXED);
+        TimelineEvent& e = _events[i & (N - 1)];
+        e.cycles = cycles;
+        e.kind = kind;
+        e.name = name;
+        e.core = core;
+        e.reserved = 0;
+        e.value = value;
+    }
+
+    uint32_t count() const { return _head < N ? _head : N; }
+    uint32_t overwritten() const { return _head > N ? _head - N : 0; }
+
+    /**
+     * @brief k-th oldest event still in the ring.
+     */
+    const TimelineEvent& at(uint32_t k) const { return _events[(_head - count() + k) & (N - 1)]; }
+
+    void freeze(bool frozen) { _frozen = frozen; }
+
+    void clear() { _head = 0; }
+
+private:
+    TimelineEvent _events[N];
+    volatile uint32_t _head = 0;
+    volatile bool _frozen = false;
+};
+
+/**
+ * @brief Dump of a (frozen) ring in the format above, readable at any offset
+ * so it can be streamed a few chunks per loop.
+ */
+template <uint16_t N>
+class TimelineDump {
+public:
+    static const size_t EVENT_SIZE = 12;
+
+    TimelineDump(const TimelineRing<N>& ring, uint16_t cyclesPerUs) : _ring(ring) {
+        _count = ring.count();
+        put(0, 'T');
+        put(1, 'L');
+        put(2, TIMELINE_VERSION);
+        put(3, TL_NAME_COUNT);
+        put16(4, cyclesPerUs);
+        put32(6, _count);
+        put32(10, ring.overwritten());
+        _prefixSize = 14;
+        for (uint8_t i = 0; i < TL_NAME_COUNT; i++) {
+            const char* name = timelineName(i);
+            size_t len = strlen(name);
+            if (_prefixSize + 1 + len > sizeof(_prefix)) len = 0;
+            put(_prefixSize++, (uint8_t)len);
+            for (size_t c = 0; c < len; c++) put(_prefixSize++, (uint8_t)name[c]);
+        }
+    }
+
+    size_t size() const { return _prefixSize + _count * EVENT_SIZE; }
+
+    /**
+     * @brief Copies up to len bytes from offset. Returns the count copied.
+     */
+    size_t read(size_t offset, uint8_t* out, size_t len) const {
+        size_t n = 0;
+        while (n < len && offset < size()) {
+            if (offset < _prefixSize) {
+                out[n++] = _prefix[offset++];
+                continue;
+            }
+            size_t k = (offset - _prefixSize) / EVENT_SIZE;
+            size_t field = (offset - _prefixSize) % EVENT_SIZE;
+            const TimelineEvent& e = _ring.at(k);
+            uint8_t b;
+            if (field < 4) b = (e.cycles >> (8 * field)) & 0xFF;
+            else if (field == 4) b = e.kind;
+            else if (field == 5) b = e.name;
+            else if (field == 6) b = e.core;
+            else if (field == 7) b = 0;
+            else b = ((uint32_t)e.value >> (8 * (field - 8))) & 0xFF;
+            out[n++] = b;
+            offset++;
+        }
+        return n;
+    }
+
+private:
+    void put(size_t i, uint8_t v) { _prefix[i] = v; }
+    void put16(size_t i, uint16_t v) {
+        put(i, v & 0xFF);
+        put(i + 1, v >> 8);
+    }
+    void put32(size_t i, uint32_t v) {
+        for (int b = 0; b < 4; b++) put(i + b, (v >> (8 * b)) & 0xFF);
+    }
+
+    const TimelineRing<N>& _ring;
+    uint32_t _count;
+    uint8_t _prefix[768];
+    size_t _prefixSize;
+};
+
+// ============================================================================
+// Instrumentation Macros
+// ============================================================================
+
+#ifdef TIMELINE
+
+#ifndef TIMELINE_EVENTS
+#define TIMELINE_EVENTS 1024
+#endif
+
+typedef TimelineRing<TIMELINE_EVENTS> Timeline;
+extern Timeline timeline;
+
+// Cycle counter of the loop core; other cores are mapped onto it (TimelineService.cpp)
+uint32_t timelineNow();
+uint8_t timelineCore();
+uint32_t timelineCyclesPerUs();
+
+/**
+ * @brief Span bound to a scope, recorded when it ends if it lasted at least
+ * minUs.
+ */
+class TimelineScope {
+public:
+    explicit TimelineScope(uint8_t name, uint32_t minUs = 0)
+        : _name(name), _minUs(minUs), _start(timelineNow()) {}
+
+    ~TimelineScope() {
+        uint32_t d = timelineNow() - _start;
+        if (d < _minUs * timelineCyclesPerUs()) return;
+        timeline.record(_start, TL_KIND_COMPLETE, _name, timelineCore(), d > INT32_MAX ? INT32_MAX : (int32_t)d);
+    }
+
+private:
+    uint8_t _name;
+    uint32_t _minUs;
+    uint32_t _start;
+};
+
+#define TL_CONCAT_(a, b) a##b
+#define TL_CONCAT(a, b) TL_CONCAT_(a, b)
+#define TL_BEGIN(name)              timeline.record(timelineNow(), TL_KIND_BEGIN, (name), timelineCore())
+#define TL_END(name)                timeline.record(timelineNow(), TL_KIND_END, (name), timelineCore())
+#define TL_COUNTER(name, value)     timeline.record(timelineNow(), TL_KIND_COUNTER, (name), timelineCore(), (int32_t)(value))
+#define TL_INSTANT(name, value)     timeline.record(timelineNow(), TL_KIND_INSTANT, (name), timelineCore(), (int32_t)(value))
+#define TL_SCOPE(name)              TimelineScope TL_CONCAT(_tlScope, __LINE__)(name)
+#define TL_SCOPE_MIN(name, minUs)   TimelineScope TL_CONCAT(_tlScope, __LINE__)(name, minUs)
+
+#else
+
+#define TL_BEGIN(name)          do {} while (0)
+#define TL_END(name)            do {} while (0)
+#define TL_COUNTER(name, value) do { (void)(value); } while (0)
+#define TL_INSTANT(name, value) do { (void)(value); } while (0)
+#define TL_SCOPE(name)          do {} while (0)
+#define TL_SCOPE_MIN(name, minUs) do {} while (0)
+
+#endif // TIMELINE
+
+#endif // TIMELINE_H
@@ -0,0 +1,68 @@
+#ifndef TIMELINE_SERVICE_H
+#define TIMELINE_SERVICE_H
+
+// Compiled only with -D TIMELINE
+#ifdef TIMELINE
+
+#include <Arduino.h>
+#include "Timeline.h"
+#include "SideChannel.h"
+
+/**
+ * @brief Owns the timeline clock and dumps the ring on request.
+ *
+ * Request : serial 'T'              -> hex lines "TL:<hex>", then "TL:END"
+ *           {moduleId}/timeline/get -> binary chunks on {moduleId}/timeline/data
+ *
+ * The ring is frozen from the request until the last chunk is sent, so the
+ * dump is one consistent window. Both dumps are streamed a little per loop
+ * (serial lines only while the UART buffer has room), so the dump does not
+ * show up as a stall of the services stage. Convert with
+ * scripts/timeline_to_chrome.py.
+ */
+class TimelineService {
+public:
+    static const char* REQUEST_TOPIC;   // "timeline/get"
+    static const char* RESPONSE_TOPIC;  // "timeline/data"
+    static const size_t CHUNK_SIZE = 1024;
+    static const uint8_t CHUNKS_PER_LOOP = 2;
+    static const unsigned long COUNTER_INTERVAL_MS = 1000;
+    static const size_t SERIAL_LINE_BYTES = 48;         // Dump bytes per "TL:" line
+    static const uint8_t SERIAL_LINES_PER_LOOP = 4;
+
+    explicit TimelineService(SideChannel& channel);
+
+    /**
+     * @brief Binds the clock to the calling (loop) core and subscribes.
+     */
+    void begin();
+
+    /**
+     * @brief Queues an MQTT dump. Safe to call from the MQTT task.
+     */
+    void handleRequest() { _mqttRequested = true; }
+
+    /**
+     * @brief Re-anchors the clock, samples the counters, serves dumps. Call
+     * once per loop().
+     */
+    void loop(unsigned long nowMs);
+
+private:
+    void streamSerial();
+    void streamChunks();
+    void updateFreeze();
+
+    SideChannel& _channel;
+    volatile bool _mqttRequested = false;
+    bool _streaming = false;
+    size_t _offset = 0;
+    bool _serialStreaming = false;
+    size_t _serialOffset = 0;
+    unsigned long _lastCounters = 0;
+    uint8_t _chunk[CHUNK_SIZE];
+};
+
+#endif // TIMELINE
+
+#endif // TIMELINE_SERVICE_H
@@ -0,0 +1,170 @@
+#ifndef TOPIC_TABLE_H
+#define TOPIC_TABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+// ============================================================================
+// Interned Topics & Fixed-Precision Payloads
+// ============================================================================
+// Publish path that builds no strings (CSV output, and MQTT with
+// -D SIDE_CHANNEL_MEASUREMENTS; the default MQTT path is brain.publish()):
+// every {moduleId}/{hardwareId}/{measurement} topic is written once, at
+// registration, into a static arena, and values are rendered with an
+// integer-only formatter at the precision of their channel.
+//
+// Pure logic (no Arduino dependency), shared with the host benchmark and the
+// load generator.
+
+static const uint8_t FIXED_MAX_DECIMALS = 4;
+static const size_t FIXED_MAX_CHARS = 16;   // Integer path: sign, 10 digits, point, NUL
+
+/**
+ * @brief Writes value with exactly decimals digits after the point
+ * ("%.*f"-like, rounded half away from zero), NUL terminated.
+ *
+ * The integer part and the scaled fraction are converted separately, so the
+ * float product never exceeds 10^decimals and stays exact enough at any
+ * magnitude. |value| >= 2^32, NaN and infinities fall back to snprintf so the
+ * output stays a valid number text.
+ *
+ * @return Length written, 0 if out is too small.
+ */
+inline size_t formatFixed(char* out, size_t size, float value, uint8_t decimals) {
+    static const uint32_t POW10[FIXED_MAX_DECIMALS + 1] = { 1, 10, 100, 1000, 10000 };
+    if (decimals > FIXED_MAX_DECIMALS) decimals = FIXED_MAX_DECIMALS;
+
+    float magnitude = fabsf(value);
+    if (!(magnitude < 4294967040.0f)) {     // Largest float below 2^32, false for NaN
+        int n = snprintf(out, size, "%.*f", decimals, value);
+        return (n < 0 || (size_t)n >= size) ? 0 : (size_t)n;
+    }
+    uint32_t whole = (uint32_t)magnitude;
+    uint32_t fraction = (uint32_t)((magnitude - (float)whole) * (float)POW10[decimals] + 0.5f);
+    if (fraction >= POW10[decimals]) {      // Rounded up into the integer part
+        fraction -= POW10[decimals];
+        whole++;
+    }
+
+    // Digits backwards, fraction first, at least one integer digit
+    char digits[12];
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < decimals; i++) {
+        digits[n++] = (char)('0' + fraction % 10);
+        fraction /= 10;
+    }
+    bool zero = whole == 0;
+    for (uint8_t i = 0; i < decimals; i++) zero = zero && digits[i] == '0';
+    do {
+        digits[n++] = (char)('0' + whole % 10);
+        whole /= 10;
+    } while (whole > 0);
+
+    bool negative = value < 0 && !zero;     // No "-0.00"
+    size_t len = n + (decimals > 0) + negative;
+    if (len + 1 > size) return 0;
+
+    size_t pos = 0;
+    if (negative) out[pos++] = '-';
+    while (n > decimals) out[pos++] = digits[--n];
+    if (decimals > 0) {
+        out[pos++] = '.';
+        while (n > 0) out[pos++] = digits[--n];
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+/**
+ * @brief Publish topics written once into a fixed arena.
+ *
+ * Each entry keeps the decimals its payloads are rendered with. Entries are
+ * never removed (an unplugged sensor keeps its topic for when it comes back),
+ * and interning the same topic twice returns the first entry.
+ *
+ * @tparam CAPACITY Maximum number of topics
+ * @tparam ARENA    Bytes for all topic strings, NULs included
+ */
+template <uint8_t CAPACITY, size_t ARENA>
+class TopicTable {
+public:
+    static const uint8_t NONE = 0xFF;
+
+    /**
+     * @brief Stores {prefix}/{hardwareId}/{measurement}.
+     * @return Topic handle, NONE when the table or the arena is full.
+     */
+    uint8_t intern(const char* prefix, const char* hardwareId, const char* measurement, uint8_t decimals) {
+        size_t a = strlen(prefix), b = strlen(hardwareId), c = strlen(measurement);
+        size_t len = a + 1 + b + 1 + c;
+
+        for (uint8_t i = 0; i < _count; i++) {
+            const char* t = _arena + _offset[i];
+            if (_length[i] == len && memcmp(t, prefix, a) == 0 && t[a] == '/' &&
+                memcmp(t + a + 1, hardwareId, b) == 0 && t[a + 1 + b] == '/' &&
+                memcmp(t + a + b + 2, measurement, c) == 0) {
+                return i;
+            }
+        }
+        if (_count >= CAPACITY || len > 0xFF || _used + len + 1 > ARENA) return NONE;
+
+        char* t = _arena + _used;
+        memcpy(t, prefix, a);
+        t[a] = '/';
+        memcpy(t + a + 1, hardwareId, b);
+        t[a + 1 + b] = '/';
+        memcpy(t + a + b + 2, measurement, c);
+        t[len] = '\0';
+
+        _offset[_count] = (uint16_t)_used;
+        _length[_count] = (uint8_t)len;
+        _label[_count] = (uint8_t)(a + 1);
+        _measurement[_count] = (uint8_t)(a + b + 2);
+        _decimals[_count] = decimals > FIXED_MAX_DECIMALS ? FIXED_MAX_DECIMALS : decimals;
+        _used += len + 1;
+        return _count++;
+    }
+
+    const char* topic(uint8_t id) const { return id < _count ? _arena + _offset[id] : nullptr; }
+    size_t topicLength(uint8_t id) const { return id < _count ? _length[id] : 0; }
+    uint8_t decimals(uint8_t id) const { return id < _count ? _decimals[id] : 0; }
+
+    /**
+     * @brief {hardwareId}/{measurement} part of topic id (NUL terminated),
+     * for outputs that do not carry the module prefix.
+     */
+    const char* label(uint8_t id) const { return id < _count ? _arena + _offset[id] + _label[id] : nullptr; }
+    const char* measurement(uint8_t id) const {
+        return id < _count ? _arena + _offset[id] + _measurement[id] : nullptr;
+    }
+    size_t hardwareIdLength(uint8_t id) const { return id < _count ? _measurement[id] - _label[id] - 1 : 0; }
+
+    /**
+     * @brief Renders value at the precision of topic id.
+     * @return Payload length, 0 for an unknown id or a too small buffer.
+     */
+    size_t render(uint8_t id, float value, char* out, size_t size) const {
+        if (id >= _count) return 0;
+        return formatFixed(out, size, value, _decimals[id]);
+    }
+
+    uint8_t count() const { return _count; }
+    size_t arenaUsed() const { return _used; }
+
+private:
+    static_assert(ARENA <= 0xFFFF, "Topic offsets are 16-bit");
+
+    char _arena[ARENA];
+    uint16_t _offset[CAPACITY];
+    uint8_t _length[CAPACITY];
+    uint8_t _label[CAPACITY];           // Offsets in the topic of the hardware ID and the measurement
+    uint8_t _measurement[CAPACITY];
+    uint8_t _decimals[CAPACITY];
+    uint8_t _count = 0;
+    size_t _used = 0;
+};
+
+#endif // TOPIC_TABLE_H
@@ -0,0 +1,103 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// ============================================================================
+// Sensor Profiles
+// ============================================================================
+// Selects which drivers, serial ports and registrations are compiled in.
+// Pick one PROFILE_* per environment in platformio.ini, like BOARD_* in pins.h.
+// PROFILE_CUSTOM leaves every SENSOR_* to the build flags (default 0).
+
+#if defined(PROFILE_FULL_BENCH)
+
+    // Every sensor of the benchmark module
+    #define PROFILE_NAME    "full-bench"
+    #define SENSOR_MHZ14A   1
+    #define SENSOR_DHT22    1
+    #define SENSOR_SGP40    1
+    #define SENSOR_SGP30    1
+    #define SENSOR_SPS30    1
+    #define SENSOR_BMP280   1
+    #define SENSOR_SHT31    1
+    #define SENSOR_SC16CO   1
+
+#elif defined(PROFILE_PM_CLIMATE)
+
+    // Particulate + climate: SPS30, SHT31, BMP280
+    #define PROFILE_NAME    "pm-climate"
+    #define SENSOR_SPS30    1
+    #define SENSOR_BMP280   1
+    #define SENSOR_SHT31    1
+
+#elif defined(PROFILE_CO2_VOC)
+
+    // Indoor air: MH-Z14A, SGP40, SHT31 (also SGP40 compensation)
+    #define PROFILE_NAME    "co2-voc"
+    #define SENSOR_MHZ14A   1
+    #define SENSOR_SGP40    1
+    #define SENSOR_SHT31    1
+
+#elif defined(PROFILE_MUX_BENCH)
+
+    // Sensor comparison bench: several identical I2C sensors behind a
+    // TCA9548A on the SGP bus (MUX_SENSORS in main.cpp), BMP280 reference
+    #define PROFILE_NAME    "mux-bench"
+    #define SENSOR_BMP280   1
+    #define SENSOR_I2C_MUX  1
+
+#elif defined(PROFILE_CUSTOM)
+
+    // Set -D SENSOR_xxx=1 for each fitted sensor
+    #define PROFILE_NAME    "custom"
+
+#else
+    #error "Sensor profile not defined! Add -D PROFILE_xxx to build_flags (see profile.h)."
+#endif
+
+#ifndef SENSOR_MHZ14A
+    #define SENSOR_MHZ14A   0
+#endif
+#ifndef SENSOR_DHT22
+    #define SENSOR_DHT22    0
+#endif
+#ifndef SENSOR_SGP40
+    #define SENSOR_SGP40    0
+#endif
+#ifndef SENSOR_SGP30
+    #define SENSOR_SGP30    0
+#endif
+#ifndef SENSOR_SPS30
+    #define SENSOR_SPS30    0
+#endif
+#ifndef SENSOR_BMP280
+    #define SENSOR_BMP280   0
+#endif
+#ifndef SENSOR_SHT31
+    #define SENSOR_SHT31    0
+#endif
+#ifndef SENSOR_SC16CO
+    #define SENSOR_SC16CO   0
+#endif
+#ifndef SENSOR_I2C_MUX
+    #define SENSOR_I2C_MUX  0   // Multi-instance sensors behind TCA9548A (I2cMux.h)
+#endif
+
+// Buses needed by the selected sensors
+#define SENSOR_I2C_MAIN_BUS (SENSOR_BMP280)
+#define SENSOR_I2C_SGP_BUS  (SENSOR_SGP40 || SENSOR_SGP30 || SENSOR_SHT31 || SENSOR_I2C_MUX)
+
+// Published measurements per profile (sizes per-channel buffers)
+#define SENSOR_CHANNEL_COUNT (SENSOR_MHZ14A * 1 + SENSOR_DHT22 * 2 + SENSOR_SGP40 * 1 + SENSOR_SGP30 * 2 + \
+                              SENSOR_SPS30 * 4 + SENSOR_BMP280 * 2 + SENSOR_SHT31 * 2 + SENSOR_SC16CO * 1)
+
+#include "Channels.h"
+
+/**
+ * @brief Compiled-in hardware, indexed by HardwareSlot.
+ */
+static const bool HARDWARE_COMPILED[HW_COUNT] = {
+    SENSOR_MHZ14A, SENSOR_DHT22, SENSOR_SGP40, SENSOR_SGP30,
+    SENSOR_SPS30, SENSOR_BMP280, SENSOR_SHT31, SENSOR_SC16CO,
+};
+
+#endif // PROFILE_H
@@ -0,0 +1,90 @@
+"""
+Post-build report for sensor profiles (see include/profile.h).
+
+Prints flash/RAM usage of the firmware, the delta against the full-bench
+environment (when it has been built) and the worst-case boot probe time
+removed by the sensors the profile leaves out.
+"""
+
+Import("env")
+
+import json
+import os
+import re
+import subprocess
+
+FULL_ENV = "esp32-devkit-v4"
+
+# Worst-case init time (ms) spent probing a sensor that is not fitted,
+# from the retry/delay loops in SensorReader::init*.
+ABSENT_PROBE_MS = {
+    "MHZ14A": 0,
+    "DHT22": 0,
+    "SGP40": 200,
+    "SGP30": 200,
+    "SPS30": 3600,
+    "BMP280": 200,
+    "SHT31": 200,
+    "SC16CO": 2000,
+}
+
+
+def profile_sensors(profile):
+    """Returns the SENSOR_* names enabled by a PROFILE_* block of profile.h."""
+    header = os.path.join(env.subst("$PROJECT_INCLUDE_DIR"), "profile.h")
+    with open(header) as f:
+        text = f.read()
+    match = re.search(r"defined\(%s\)(.*?)#(?:elif|else)" % profile, text, re.S)
+    if not match:
+        return set()
+    return set(re.findall(r"#define SENSOR_(\w+)\s+1", match.group(1)))
+
+
+def active_profile():
+    for define in env.get("CPPDEFINES", []):
+        name = define[0] if isinstance(define, (list, tuple)) else define
+        if str(name).startswith("PROFILE_"):
+            return str(name)
+    return None
+
+
+def firmware_size(elf):
+    out = subprocess.check_output([env.subst("$SIZETOOL"), "-B", elf]).decode()
+    text, data, bss = [int(v) for v in out.splitlines()[1].split()[:3]]
+    return {"flash": text + data, "ram": data + bss}
+
+
+def report(source, target, env):
+    pioenv = env.subst("$PIOENV")
+    sizes_file = os.path.join(env.subst("$PROJECT_BUILD_DIR"), "profile_sizes.json")
+    sizes = {}
+    if os.path.exists(sizes_file):
+        with open(sizes_file) as f:
+            sizes = json.load(f)
+
+    current = firmware_size(str(target[0]))
+    sizes[pioenv] = current
+    with open(sizes_file, "w") as f:
+        json.dump(sizes, f, indent=2)
+
+    profile = active_profile()
+    print("\n=== Sensor profile report: %s (%s) ===" % (pioenv, profile))
+    print("  flash: %7d bytes" % current["flash"])
+    print("  ram  : %7d bytes (static)" % current["ram"])
+
+    full = sizes.get(FULL_ENV)
+    if full and pioenv != FULL_ENV:
+        print("  vs %s: flash %+d bytes, ram %+d bytes" % (
+            FULL_ENV, current["flash"] - full["flash"], current["ram"] - full["ram"]))
+    elif not full:
+        print("  (build %s once to get deltas against the full bench)" % FULL_ENV)
+
+    if profile and profile != "PROFILE_CUSTOM":
+        dropped = sorted(set(ABSENT_PROBE_MS) - profile_sensors(profile))
+        saved = sum(ABSENT_PROBE_MS[s] for s in dropped)
+        print("  dropped sensors: %s" % (", ".join(dropped) or "none"))
+        print("  boot probe time saved (worst case, not fitted): ~%d ms" % saved)
+    print("  (measured boot time is logged at startup)\n")
+
+
+env.AddPostAction("$PROGRAM_PATH", report)
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+"""
+Converts a timeline dump (include/Timeline.h) into Chrome trace JSON, to be
+opened in chrome://tracing or https://ui.perfetto.dev.
+
+Input is either the binary dump (concatenated {moduleId}/timeline/data
+payloads) or a serial log containing the "TL:<hex>" lines printed after 'T'.
+
+    mosquitto_sub -t 'mod1/timeline/data' -C 1 > dump.bin   # after publishing timeline/get
+    python3 scripts/timeline_to_chrome.py dump.bin -o trace.json
+    python3 scripts/timeline_to_chrome.py serial.log -o trace.json
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+HEADER = struct.Struct("<2sBBHII")
+EVENT = struct.Struct("<IBBBBi")
+CORE_NAMES = {0: "core 0 (WiFi / AsyncTCP)", 1: "core 1 (loop)"}
+
+
+def load(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:2] == b"TL":
+        return data
+    # Serial log: keep the TL: lines of the last complete dump
+    chunks, last = [], []
+    for line in data.decode("ascii", "replace").splitlines():
+        line = line.strip()
+        if not line.startswith("TL:"):
+            continue
+        if line == "TL:END":
+            last, chunks = chunks, []
+        else:
+            chunks.append(line[3:])
+    return bytes.fromhex("".join(last or chunks))
+
+
+def parse(data):
+    magic, version, name_count, cycles_per_us, count, overwritten = HEADER.unpack_from(data, 0)
+    if magic != b"TL" or version != 1:
+        sys.exit("not a timeline dump (magic %r, version %d)" % (magic, version))
+    pos = HEADER.size
+    names = []
+    for _ in range(name_count):
+        n = data[pos]
+        names.append(data[pos + 1:pos + 1 + n].decode("ascii", "replace"))
+        pos += 1 + n
+    available = (len(data) - pos) // EVENT.size
+    if available < count:
+        print("warning: dump truncated, %d of %d events" % (available, count), file=sys.stderr)
+        count = available
+    events = [EVENT.unpack_from(data, pos + i * EVENT.size) for i in range(count)]
+    return names, cycles_per_us, overwritten, events
+
+
+def convert(names, cycles_per_us, events):
+    """Events are in write order; timestamps are 32-bit cycles that wrap every
+    ~18 s at 240 MHz, unwrapped against the previous event. Events of the other
+    core may be slightly out of order, hence the signed delta."""
+    out = []
+    open_spans = {}
+    last = events[0][0] if events else 0
+    unwrapped = 0
+    for cycles, kind, name_id, core, _reserved, value in events:
+        delta = (cycles - last) & 0xFFFFFFFF
+        if delta >= 0x80000000:
+            delta -= 0x100000000
+        unwrapped += delta
+        last = cycles
+        ts = unwrapped / cycles_per_us
+        name = names[name_id] if name_id < len(names) else "name%d" % name_id
+        ev = {"name": name, "pid": 1, "tid": core, "ts": round(ts, 3)}
+        kind = chr(kind)
+        if kind == "X":
+            ev.update(ph="X", dur=round(value / cycles_per_us, 3))
+        elif kind == "B":
+            open_spans.setdefault((core, name_id), []).append(ts)
+            ev["ph"] = "B"
+        elif kind == "E":
+            stack = open_spans.get((core, name_id))
+            if not stack:
+                continue  # Its begin was overwritten
+            stack.pop()
+            ev["ph"] = "E"
+        elif kind == "C":
+            ev.update(ph="C", args={name: value})
+        elif kind == "i":
+            ev.update(ph="i", s="t", args={"value": value})
+        else:
+            continue
+        out.append(ev)
+    # X events are written when the span ends: sort by start for the viewers
+    out.sort(key=lambda e: e["ts"])
+    cores = sorted({e["tid"] for e in out})
+    meta = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "module"}}]
+    for core in cores:
+        meta.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": core,
+                     "args": {"name": CORE_NAMES.get(core, "core %d" % core)}})
+    return meta + out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump", help="binary dump or serial log")
+    parser.add_argument("-o", "--output", default="-", help="output JSON (default: stdout)")
+    args = parser.parse_args()
+
+    names, cycles_per_us, overwritten, events = parse(load(args.dump))
+    trace = {"traceEvents": convert(names, cycles_per_us, events), "displayTimeUnit": "ms",
+             "otherData": {"cyclesPerUs": cycles_per_us, "overwritten": overwritten}}
+    if events:
+        span_us = trace["traceEvents"][-1]["ts"]
+        print("%d events over %.1f ms, %d overwritten" % (len(events), span_us / 1000.0, overwritten),
+              file=sys.stderr)
+    if args.output == "-":
+        json.dump(trace, sys.stdout)
+    else:
+        with open(args.output, "w") as f:
+            json.dump(trace, f)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,76 @@
+#include "CompareService.h"
+#include "TextBuffer.h"
+
+const char* CompareService::TOPIC = "compare";
+
+CompareService::CompareService(SideChannel& channel, unsigned long intervalMs, uint32_t blockMs,
+                               uint32_t maxSkewMs)
+    : _channel(channel), _intervalMs(intervalMs), _maxSkewMs(maxSkewMs) {
+    for (uint8_t i = 0; i < COMPARE_PAIR_COUNT && _pairCount < STORED_PAIRS; i++) {
+        const ComparePair& p = COMPARE_PAIRS[i];
+        if (HARDWARE_COMPILED[CHANNEL_TABLE[p.a].hw] && HARDWARE_COMPILED[CHANNEL_TABLE[p.b].hw]) {
+            _stats[_pairCount] = PairStats<WINDOW_BLOCKS>(blockMs);
+            _pair[_pairCount++] = i;
+        }
+    }
+    for (uint8_t i = 0; i < CH_COUNT; i++) {
+        _last[i] = NAN;
+        _lastMs[i] = 0;
+    }
+    _report[0] = 0;
+}
+
+void CompareService::observe(Channel ch, float value, uint32_t nowMs) {
+    if (isnan(value)) return;
+    _last[ch] = value;
+    _lastMs[ch] = nowMs;
+
+    for (uint8_t i = 0; i < _pairCount; i++) {
+        const ComparePair& p = COMPARE_PAIRS[_pair[i]];
+        if (p.a != ch && p.b != ch) continue;
+        uint8_t mine = (p.a == ch) ? FRESH_A : FRESH_B;
+        _fresh[i] |= mine;
+        if (_fresh[i] != (FRESH_A | FRESH_B)) continue;     // Partner not updated since the last sample
+        Channel other = (p.a == ch) ? p.b : p.a;
+        if (nowMs - _lastMs[other] > _maxSkewMs) {
+            _fresh[i] = mine;                               // Too old to pair: wait for the next one
+            continue;
+        }
+        _stats[i].add(_last[p.a], _last[p.b], nowMs);
+        _fresh[i] = 0;
+    }
+}
+
+// NAN (constant signal, no samples) is reported as null
+static size_t appendNumber(char* buf, size_t size, size_t pos, const char* key, double v) {
+    if (isnan(v)) return appendf(buf, size, pos, ",\"%s\":null", key);
+    return appendf(buf, size, pos, ",\"%s\":%.4f", key, v);
+}
+
+size_t CompareService::appendMoments(size_t pos, const char* key, const PairMoments& m) {
+    const size_t size = sizeof(_report);
+    pos = appendf(_report, size, pos, ",\"%s\":{\"n\":%u", key, (unsigned)m.n);
+    pos = appendNumber(_report, size, pos, "bias", m.n ? m.bias() : NAN);
+    pos = appendNumber(_report, size, pos, "rms", m.rms());
+    pos = appendNumber(_report, size, pos, "r", m.pearson());
+    pos = appendNumber(_report, size, pos, "drift", m.drift());
+    return appendf(_report, size, pos, "}");
+}
+
+void CompareService::loop(unsigned long nowMs) {
+    if (_pairCount == 0 || nowMs - _lastReport < _intervalMs) return;
+    _lastReport = nowMs;
+
+    const size_t size = sizeof(_report);
+    size_t pos = appendf(_report, size, 0, "{\"uptime\":%lu,\"windowS\":%lu,\"pairs\":[",
+                         nowMs / 1000, (unsigned long)(_stats[0].windowMs() / 1000));
+    for (uint8_t i = 0; i < _pairCount; i++) {
+        pos = appendf(_report, size, pos, "%s{\"pair\":\"%s\"", i ? "," : "", COMPARE_PAIRS[_pair[i]].name);
+        pos = appendMoments(pos, "window", _stats[i].window(nowMs));
+        pos = appendMoments(pos, "lifetime", _stats[i].lifetime());
+        pos = appendf(_report, size, pos, "}");
+    }
+    pos = appendf(_report, size, pos, "]}");
+
+    _channel.publish(TOPIC, (const uint8_t*)_report, pos);
+}
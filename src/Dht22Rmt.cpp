@@ -0,0 +1,102 @@
+#include "Dht22Rmt.h"
+#include <driver/gpio.h>
+
+Dht22Rmt::Dht22Rmt(uint8_t pin, rmt_channel_t channel) : _pin(pin), _channel(channel) {}
+
+bool Dht22Rmt::begin() {
+    if (_installed) {
+        // Reset: abort the current read and drop any pending capture
+        esp_timer_stop(_timer);
+        rmt_rx_stop(_channel);
+        size_t size;
+        void* item;
+        while ((item = xRingbufferReceive(_ring, &size, 0)) != nullptr) vRingbufferReturnItem(_ring, item);
+        gpio_set_level((gpio_num_t)_pin, 1);
+        _state = IDLE;
+        return true;
+    }
+
+    rmt_config_t config = RMT_DEFAULT_CONFIG_RX((gpio_num_t)_pin, _channel);
+    config.clk_div = 80;                                    // 1 tick = 1 us
+    config.rx_config.filter_en = true;
+    config.rx_config.filter_ticks_thresh = 100;             // Ignore glitches < 1.25 us (APB ticks)
+    config.rx_config.idle_threshold = IDLE_THRESHOLD_US;
+    if (rmt_config(&config) != ESP_OK) return false;
+    if (rmt_driver_install(_channel, 512, 0) != ESP_OK) return false;
+    if (rmt_get_ringbuf_handle(_channel, &_ring) != ESP_OK) return false;
+
+    // Open drain on the same pin: the RMT keeps sampling the input while we
+    // drive the start pulse (the module has its own pull-up)
+    gpio_set_direction((gpio_num_t)_pin, GPIO_MODE_INPUT_OUTPUT_OD);
+    gpio_pullup_en((gpio_num_t)_pin);
+    gpio_set_level((gpio_num_t)_pin, 1);
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = &Dht22Rmt::onStartPulseEnd;
+    timerArgs.arg = this;
+    timerArgs.name = "dht22";
+    if (esp_timer_create(&timerArgs, &_timer) != ESP_OK) return false;
+
+    _installed = true;
+    _state = IDLE;
+    return true;
+}
+
+bool Dht22Rmt::start(uint32_t nowMs) {
+    if (!_installed || _state != IDLE) return false;
+    if (_started && nowMs - _startMs < MIN_INTERVAL_MS) return false;
+
+    _startMs = nowMs;
+    _started = true;
+    _state = START_PULSE;
+    gpio_set_level((gpio_num_t)_pin, 0);
+    esp_timer_start_once(_timer, START_PULSE_US);
+    return true;
+}
+
+// esp_timer task: release the line and capture the response
+void Dht22Rmt::onStartPulseEnd(void* arg) {
+    Dht22Rmt* self = static_cast<Dht22Rmt*>(arg);
+    gpio_set_level((gpio_num_t)self->_pin, 1);
+    rmt_rx_start(self->_channel, true);
+    self->_state = CAPTURING;
+}
+
+bool Dht22Rmt::poll(uint32_t nowMs, DhtFrame& frame) {
+    if (_state == IDLE) return false;
+
+    if (_state == CAPTURING) {
+        size_t size = 0;
+        rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(_ring, &size, 0);
+        if (items) {
+            // Each RMT item holds two segments; a zero duration ends the capture
+            size_t count = 0;
+            size_t itemCount = size / sizeof(rmt_item32_t);
+            const size_t maxEdges = sizeof(_edges) / sizeof(_edges[0]);
+            for (size_t i = 0; i < itemCount && count + 2 <= maxEdges; i++) {
+                if (items[i].duration0 == 0) break;
+                _edges[count++] = { (uint8_t)items[i].level0, (uint16_t)items[i].duration0 };
+                if (items[i].duration1 == 0) break;
+                _edges[count++] = { (uint8_t)items[i].level1, (uint16_t)items[i].duration1 };
+            }
+            vRingbufferReturnItem(_ring, items);
+            rmt_rx_stop(_channel);
+
+            frame = decodeDht22(_edges, count);
+            if (frame.status != DHT_OK) _failures++;
+            _state = IDLE;
+            return true;
+        }
+    }
+
+    if (nowMs - _startMs >= TIMEOUT_MS) {
+        esp_timer_stop(_timer);
+        rmt_rx_stop(_channel);
+        gpio_set_level((gpio_num_t)_pin, 1);
+        frame = decodeDht22(nullptr, 0);    // DHT_NO_RESPONSE
+        _failures++;
+        _state = IDLE;
+        return true;
+    }
+    return false;
+}
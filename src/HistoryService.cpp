@@ -0,0 +1,156 @@
+#include "HistoryService.h"
+#include <ArduinoJson.h>
+
+const char* HistoryService::REQUEST_TOPIC = "history/get";
+const char* HistoryService::RESPONSE_TOPIC = "history/data";
+
+static void put16(uint8_t* p, uint16_t v) {
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+HistoryService::HistoryService(SideChannel& channel) : _channel(channel) {
+    uint8_t next = 0;
+    for (uint8_t i = 0; i < CH_COUNT; i++) {
+        _slot[i] = -1;
+        if (HARDWARE_COMPILED[CHANNEL_TABLE[i].hw] && next < STORED_CHANNELS) {
+            _slot[i] = next;
+            _history[next++].setStep(CHANNEL_TABLE[i].step);
+        }
+    }
+}
+
+void HistoryService::begin() {
+    _channel.subscribe(REQUEST_TOPIC);
+}
+
+void HistoryService::add(Channel ch, float value, uint32_t nowMs) {
+    if (!hasChannel(ch)) return;
+    _history[_slot[ch]].add(value, nowMs);
+}
+
+void HistoryService::handleRequest(const uint8_t* payload, size_t len) {
+    if (_requestPending || len > MAX_REQUEST) return;
+    memcpy(_request, payload, len);
+    _request[len] = 0;
+    _requestLen = len;
+    _requestPending = true;
+}
+
+void HistoryService::loop(uint32_t nowMs) {
+    if (_requestPending && !_streaming) {
+        if (!parseRequest(nowMs)) sendError(0xFF);
+        _requestPending = false;
+    }
+
+    for (uint8_t i = 0; i < CHUNKS_PER_LOOP && _streaming; i++) {
+        if (!_channel.connected()) {
+            _streaming = false;
+            break;
+        }
+        sendChunk(nowMs);
+    }
+}
+
+bool HistoryService::parseRequest(uint32_t nowMs) {
+    StaticJsonDocument<256> doc;
+    if (deserializeJson(doc, (const char*)_request, _requestLen)) return false;
+
+    // "channel": "hardware/measurement" or channel index
+    int channel = -1;
+    if (doc["channel"].is<int>()) {
+        channel = doc["channel"].as<int>();
+    } else {
+        const char* name = doc["channel"] | "";
+        const char* slash = strchr(name, '/');
+        if (!slash) return false;
+        for (uint8_t i = 0; i < CH_COUNT; i++) {
+            const char* hwId = HARDWARE_TABLE[CHANNEL_TABLE[i].hw].id;
+            if (strlen(hwId) == (size_t)(slash - name) && strncmp(name, hwId, slash - name) == 0 &&
+                strcmp(slash + 1, CHANNEL_TABLE[i].measurement) == 0) {
+                channel = i;
+                break;
+            }
+        }
+    }
+    if (channel < 0 || !hasChannel(channel)) return false;
+
+    uint32_t resolutionMs = (doc["resolution"] | 0UL) * 1000UL;
+    uint8_t level = HISTORY_LEVELS - 1;
+    for (uint8_t l = 0; l < HISTORY_LEVELS; l++) {
+        if (ChannelHistory::periodMs(l) >= resolutionMs) {
+            level = l;
+            break;
+        }
+    }
+
+    ChannelHistory& h = _history[_slot[channel]];
+    h.advance(nowMs);
+
+    uint16_t count = h.size(level);
+    uint32_t rangeS = doc["range"] | 0UL;
+    if (rangeS > 0) {
+        uint32_t wanted = (uint32_t)(((uint64_t)rangeS * 1000UL + ChannelHistory::periodMs(level) - 1) /
+                                     ChannelHistory::periodMs(level));
+        if (wanted < count) count = (uint16_t)wanted;
+    }
+
+    _streamChannel = (uint8_t)channel;
+    _streamLevel = level;
+    _streamNext = 0;
+    _streamEnd = count;
+    _streamSeq = 0;
+    _streaming = true;
+    return true;
+}
+
+void HistoryService::sendChunk(uint32_t nowMs) {
+    const ChannelHistory& h = _history[_slot[_streamChannel]];
+    uint32_t period = ChannelHistory::periodMs(_streamLevel);
+
+    uint16_t count = _streamEnd - _streamNext;
+    if (count > POINTS_PER_CHUNK) count = POINTS_PER_CHUNK;
+    bool last = (_streamNext + count) >= _streamEnd;
+
+    // Age of the end of the first point in this chunk
+    uint32_t age = (nowMs - h.newestEndMs(_streamLevel)) + (uint32_t)_streamNext * period;
+
+    _chunk[0] = VERSION;
+    _chunk[1] = _streamChannel;
+    _chunk[2] = _streamLevel;
+    _chunk[3] = last ? FLAG_LAST : 0;
+    put16(_chunk + 4, _streamSeq);
+    put16(_chunk + 6, count);
+    put32(_chunk + 8, period);
+    put32(_chunk + 12, age);
+    float step = h.step();
+    memcpy(_chunk + 16, &step, sizeof(float));
+
+    uint8_t* p = _chunk + HEADER_SIZE;
+    for (uint16_t i = 0; i < count; i++) {
+        const RollupPoint& pt = h.at(_streamLevel, _streamNext + i);
+        put16(p, (uint16_t)pt.min);
+        put16(p + 2, (uint16_t)pt.mean);
+        put16(p + 4, (uint16_t)pt.max);
+        p += sizeof(RollupPoint);
+    }
+
+    // Retry the same chunk next loop if the client queue is full
+    if (!_channel.publish(RESPONSE_TOPIC, _chunk, p - _chunk)) return;
+
+    _streamNext += count;
+    _streamSeq++;
+    if (last) _streaming = false;
+}
+
+void HistoryService::sendError(uint8_t channel) {
+    memset(_chunk, 0, HEADER_SIZE);
+    _chunk[0] = VERSION;
+    _chunk[1] = channel;
+    _chunk[3] = FLAG_LAST | FLAG_ERROR;
+    _channel.publish(RESPONSE_TOPIC, _chunk, HEADER_SIZE);
+}
@@ -0,0 +1,159 @@
+#include "LoopWatchdog.h"
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_task_wdt.h>
+#include "TextBuffer.h"
+#include "Timeline.h"
+#include "profile.h"
+
+const char* LoopWatchdog::TOPIC = "system/stages";
+
+// ============================================================================
+// RTC Stall Record
+// ============================================================================
+// Kept in RTC slow memory, not initialised at boot: survives watchdog, panic
+// and software resets, lost on power-on (detected by the magic / reset reason).
+
+static const uint32_t STALL_RECORD_MAGIC = 0x5354414C;  // "STAL"
+
+struct StallRecord {
+    uint32_t magic;
+    uint8_t inFlight;           // Stage running, STAGE_COUNT between stages
+    uint32_t inFlightSinceMs;
+    uint8_t lastStage;          // Last stall, STAGE_COUNT if none
+    uint8_t lastReset;          // The last stall ended in a watchdog / panic reset
+    uint32_t lastDurationMs;    // Lower bound (the timeout) when lastReset
+    uint32_t lastUptimeS;
+    uint32_t stalls;            // Since power-on
+    uint32_t resets;
+};
+
+RTC_NOINIT_ATTR static StallRecord rtcStall;
+
+static bool isWatchdogReset(esp_reset_reason_t reason) {
+    return reason == ESP_RST_TASK_WDT || reason == ESP_RST_INT_WDT || reason == ESP_RST_WDT ||
+           reason == ESP_RST_PANIC;
+}
+
+// ============================================================================
+// LoopWatchdog
+// ============================================================================
+
+LoopWatchdog::LoopWatchdog(SideChannel& channel, uint32_t timeoutS, unsigned long reportIntervalMs)
+    : _channel(channel), _timeoutS(timeoutS), _intervalMs(reportIntervalMs) {
+    _bootReport[0] = 0;
+    _report[0] = 0;
+}
+
+void LoopWatchdog::begin() {
+    esp_reset_reason_t reason = esp_reset_reason();
+    if (reason == ESP_RST_POWERON || rtcStall.magic != STALL_RECORD_MAGIC ||
+        rtcStall.lastStage > STAGE_COUNT || rtcStall.inFlight > STAGE_COUNT) {
+        memset(&rtcStall, 0, sizeof(rtcStall));
+        rtcStall.magic = STALL_RECORD_MAGIC;
+        rtcStall.inFlight = STAGE_COUNT;
+        rtcStall.lastStage = STAGE_COUNT;
+    } else if (rtcStall.inFlight < STAGE_COUNT && isWatchdogReset(reason)) {
+        // The stage in flight never returned: it is the stall
+        rtcStall.lastStage = rtcStall.inFlight;
+        rtcStall.lastReset = 1;
+        rtcStall.lastDurationMs = _timeoutS * 1000;
+        rtcStall.lastUptimeS = rtcStall.inFlightSinceMs / 1000;
+        rtcStall.stalls++;
+        rtcStall.resets++;
+        if (stageHardware(rtcStall.lastStage) < HW_COUNT) _budget.disable(rtcStall.lastStage);
+    }
+    rtcStall.inFlight = STAGE_COUNT;
+
+    if (rtcStall.lastStage < STAGE_COUNT) {
+        bool quarantined = rtcStall.lastReset && stageHardware(rtcStall.lastStage) < HW_COUNT &&
+                           !_budget.allowed(rtcStall.lastStage, 0);
+        snprintf(_bootReport, sizeof(_bootReport),
+                 "Last stall: %s %s%lu ms at uptime %lu s%s%s (%lu stalls, %lu resets since power-on)",
+                 stageName(rtcStall.lastStage), rtcStall.lastReset ? ">= " : "",
+                 (unsigned long)rtcStall.lastDurationMs, (unsigned long)rtcStall.lastUptimeS,
+                 rtcStall.lastReset ? ", watchdog reset" : "", quarantined ? ", quarantined" : "",
+                 (unsigned long)rtcStall.stalls, (unsigned long)rtcStall.resets);
+    }
+}
+
+void LoopWatchdog::arm() {
+    // Reconfigures the watchdog if the core already started it
+    esp_task_wdt_init(_timeoutS, true);
+    esp_task_wdt_add(NULL);
+}
+
+bool LoopWatchdog::enter(LoopStage stage) {
+    if (!_budget.allowed(stage, millis())) return false;
+    _stage = stage;
+    _startUs = micros();
+#ifdef TIMELINE
+    _startCycles = timelineNow();
+#endif
+    rtcStall.inFlight = stage;
+    rtcStall.inFlightSinceMs = millis();
+    esp_task_wdt_reset();
+    return true;
+}
+
+StageAction LoopWatchdog::leave(bool account) {
+    if (_stage >= STAGE_COUNT) return STAGE_OK;
+    uint32_t elapsedUs = micros() - _startUs;
+    uint8_t stage = _stage;
+    _stage = STAGE_COUNT;
+    rtcStall.inFlight = STAGE_COUNT;
+    esp_task_wdt_reset();
+#ifdef TIMELINE
+    // Idle stages would flood the ring: only the ones that did work are kept
+    if (elapsedUs >= TIMELINE_MIN_US) {
+        uint32_t cycles = timelineNow() - _startCycles;
+        timeline.record(_startCycles, TL_KIND_COMPLETE, TL_STAGE + stage, timelineCore(),
+                        cycles > INT32_MAX ? INT32_MAX : (int32_t)cycles);
+    }
+#endif
+    if (!account) return STAGE_OK;
+
+    unsigned long now = millis();
+    if (elapsedUs >= STALL_RECORD_MS * 1000) {
+        rtcStall.lastStage = stage;
+        rtcStall.lastReset = 0;
+        rtcStall.lastDurationMs = elapsedUs / 1000;
+        rtcStall.lastUptimeS = now / 1000;
+        rtcStall.stalls++;
+    }
+    return _budget.record(stage, elapsedUs, now);
+}
+
+void LoopWatchdog::loop(unsigned long nowMs) {
+    if (nowMs - _lastReport < _intervalMs) return;
+    _lastReport = nowMs;
+
+    const char* json = collect(nowMs);
+    _channel.publish(TOPIC, (const uint8_t*)json, strlen(json));
+}
+
+const char* LoopWatchdog::collect(unsigned long nowMs) {
+    size_t pos = 0;
+    const size_t size = sizeof(_report);
+
+    pos = appendf(_report, size, pos, "{\"uptime\":%lu,\"timeoutS\":%lu,\"stages\":[",
+                  nowMs / 1000, (unsigned long)_timeoutS);
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+        if (stageHardware(i) < HW_COUNT && !HARDWARE_COMPILED[stageHardware(i)]) continue;
+        const StageStats& s = _budget.stats(i);
+        const char* state = s.disabled ? "disabled" : (_budget.allowed(i, nowMs) ? "ok" : "backoff");
+        pos = appendf(_report, size, pos,
+                      "%s{\"stage\":\"%s\",\"budgetMs\":%u,\"runs\":%lu,\"overruns\":%lu,\"maxMs\":%.1f,\"state\":\"%s\"}",
+                      pos > 0 && _report[pos - 1] == '}' ? "," : "", stageName(i), STAGE_BUDGET_MS[i],
+                      (unsigned long)s.runs, (unsigned long)s.overruns, s.maxUs / 1000.0f, state);
+    }
+    pos = appendf(_report, size, pos, "],\"stalls\":%lu,\"watchdogResets\":%lu",
+                  (unsigned long)rtcStall.stalls, (unsigned long)rtcStall.resets);
+    if (rtcStall.lastStage < STAGE_COUNT) {
+        pos = appendf(_report, size, pos, ",\"lastStall\":{\"stage\":\"%s\",\"ms\":%lu,\"reset\":%s,\"uptime\":%lu}",
+                      stageName(rtcStall.lastStage), (unsigned long)rtcStall.lastDurationMs,
+                      rtcStall.lastReset ? "true" : "false", (unsigned long)rtcStall.lastUptimeS);
+    }
+    appendf(_report, size, pos, "}");
+    return _report;
+}
@@ -0,0 +1,206 @@
+#include "MuxSensors.h"
+#if SENSOR_I2C_MUX
+#include "Timeline.h"
+
+// SGP40 compensation when no SHT31 was read before it on the same channel
+// (Adafruit_SGP40 defaults)
+static const float DEFAULT_COMPENSATION_T = 25.0f;
+static const float DEFAULT_COMPENSATION_H = 50.0f;
+
+// Multiplexer state after a failed write
+static const uint8_t SELECTION_UNKNOWN = 0xFE;
+
+static uint8_t busIndex(BusId bus) {
+    return bus == BUS_I2C_MAIN ? 0 : 1;
+}
+
+MuxPlanError MuxSensors::begin(const MuxSensorSpec* specs, uint8_t count) {
+    MuxPlanError error = _plan.build(specs, count);
+    if (error != MUX_PLAN_OK) return error;
+
+    uint8_t perKind[MUX_KIND_COUNT] = {};
+    for (uint8_t i = 0; i < count; i++) {
+        if (perKind[specs[i].kind] >= MAX_PER_KIND) return MUX_PLAN_TOO_MANY;
+        _slot[i] = perKind[specs[i].kind]++;
+    }
+
+    _specs = specs;
+    _count = count;
+    for (uint8_t i = 0; i < count; i++) {
+        const MuxSensorSpec& s = specs[i];
+        TwoWire* wire = _wire[busIndex(s.bus)];
+        switch (s.kind) {
+            case MUX_SGP40: _sgp40[_slot[i]] = new Adafruit_SGP40(); break;
+            case MUX_SGP30: _sgp30[_slot[i]] = new Adafruit_SGP30(); break;
+            case MUX_SHT31: _sht31[_slot[i]] = new Adafruit_SHT31(wire); break;
+            case MUX_BMP280: _bmp280[_slot[i]] = new Adafruit_BMP280(wire); break;
+            default: break;
+        }
+        muxHardwareId(s, _id[i], ID_SIZE);
+        _present[i] = false;
+        _misses[i] = 0;
+        _holdoff[i] = 0;
+        if (s.channel != MUX_DIRECT) _mux[busIndex(s.bus)] = true;
+    }
+
+    // Power-up state of the TCA9548A is all channels off, but not after an
+    // ESP32 reset: start from a known selection
+    _selected[0] = _selected[1] = SELECTION_UNKNOWN;
+    release();
+    return MUX_PLAN_OK;
+}
+
+bool MuxSensors::startCycle() {
+    if (_running || _plan.groupCount() == 0) return false;
+    _running = true;
+    _nextGroup = 0;
+    _cycleBusUs = 0;
+    _cycleSelects = 0;
+    return true;
+}
+
+uint8_t MuxSensors::readGroup(MuxResult* out) {
+    if (!_running) return 0;
+    TL_SCOPE(TL_MUX_GROUP);
+    uint32_t start = micros();
+    const MuxReadPlan::Group& g = _plan.group(_nextGroup);
+    bool selected = select(g.bus, g.channel);
+
+    uint8_t n = 0;
+    float compensationT = DEFAULT_COMPENSATION_T;
+    float compensationH = DEFAULT_COMPENSATION_H;
+    for (uint8_t k = 0; k < g.count; k++) {
+        uint8_t i = _plan.instance(g.first + k);
+        MuxResult& r = out[n];
+        r.instance = i;
+        for (uint8_t v = 0; v < MUX_MAX_MEASUREMENTS; v++) r.values[v] = NAN;
+
+        if (!_present[i]) {
+            // Missing: one init attempt every RETRY_CYCLES cycles
+            if (_holdoff[i] > 0) {
+                _holdoff[i]--;
+                continue;
+            }
+            if (!selected || !init(i) || !read(i, r.values, compensationT, compensationH)) {
+                _holdoff[i] = RETRY_CYCLES;
+                continue;
+            }
+            _present[i] = true;
+            _misses[i] = 0;
+            r.event = MUX_APPEARED;
+        } else if (selected && read(i, r.values, compensationT, compensationH)) {
+            _misses[i] = 0;
+            r.event = MUX_SAMPLE;
+        } else if (++_misses[i] >= LOST_AFTER) {
+            _present[i] = false;
+            _misses[i] = 0;
+            r.event = MUX_LOST;
+        } else {
+            r.event = MUX_FAILED;
+        }
+        if (_specs[i].kind == MUX_SHT31 && (r.event == MUX_SAMPLE || r.event == MUX_APPEARED)) {
+            compensationT = r.values[0];
+            compensationH = r.values[1];
+        }
+        n++;
+    }
+
+    _cycleBusUs += micros() - start;
+    if (++_nextGroup >= _plan.groupCount()) {
+        _running = false;
+        _lastCycleUs = _cycleBusUs;
+        _lastCycleSelects = _cycleSelects;
+        _cycles++;
+    }
+    return n;
+}
+
+void MuxSensors::release() {
+    for (uint8_t b = 0; b < 2; b++) {
+        if (!_mux[b] || _selected[b] == MUX_DIRECT) continue;
+        _wire[b]->beginTransmission(TCA9548A_ADDRESS);
+        _wire[b]->write(0);
+        if (_wire[b]->endTransmission() == 0) _selected[b] = MUX_DIRECT;
+    }
+}
+
+/**
+ * @brief Routes bus to channel (MUX_DIRECT: nothing to do, direct devices
+ * answer whatever the selection). The multiplexer is only written when the
+ * selection changes.
+ */
+bool MuxSensors::select(BusId bus, uint8_t channel) {
+    uint8_t b = busIndex(bus);
+    if (channel == MUX_DIRECT || _selected[b] == channel) return true;
+    _wire[b]->beginTransmission(TCA9548A_ADDRESS);
+    _wire[b]->write((uint8_t)(1 << channel));
+    _cycleSelects++;
+    if (_wire[b]->endTransmission() != 0) {
+        _selected[b] = SELECTION_UNKNOWN;
+        return false;
+    }
+    _selected[b] = channel;
+    return true;
+}
+
+bool MuxSensors::init(uint8_t i) {
+    const MuxSensorSpec& s = _specs[i];
+    TwoWire* wire = _wire[busIndex(s.bus)];
+    switch (s.kind) {
+        case MUX_SGP40:
+            return _sgp40[_slot[i]]->begin(wire);
+        case MUX_SGP30:
+            return _sgp30[_slot[i]]->begin(wire) && _sgp30[_slot[i]]->IAQinit();
+        case MUX_SHT31:
+            return _sht31[_slot[i]]->begin(s.address);
+        case MUX_BMP280:
+            return _bmp280[_slot[i]]->begin(s.address);
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Address probe, for the drivers that do not report a failed read
+ * (same check as SensorReader::isSGPConnected / isBMPConnected).
+ */
+bool MuxSensors::answers(uint8_t i) {
+    TwoWire* wire = _wire[busIndex(_specs[i].bus)];
+    wire->beginTransmission(_specs[i].address);
+    return wire->endTransmission() == 0;
+}
+
+bool MuxSensors::read(uint8_t i, float* values, float compensationT, float compensationH) {
+    switch (_specs[i].kind) {
+        case MUX_SGP40: {
+            if (!answers(i)) return false;
+            int32_t voc = _sgp40[_slot[i]]->measureVocIndex(compensationT, compensationH);
+            if (voc < 0) return false;
+            values[0] = voc;
+            return true;
+        }
+        case MUX_SGP30: {
+            Adafruit_SGP30* sgp = _sgp30[_slot[i]];
+            // eCO2 stuck at 0: the sensor was power cycled, IAQinit lost
+            if (!sgp->IAQmeasure() || sgp->eCO2 == 0) return false;
+            values[0] = sgp->eCO2;
+            values[1] = sgp->TVOC;
+            return true;
+        }
+        case MUX_SHT31:
+            return _sht31[_slot[i]]->readBoth(&values[0], &values[1]) && !isnan(values[0]) && !isnan(values[1]);
+        case MUX_BMP280: {
+            if (!answers(i)) return false;
+            Adafruit_BMP280* bmp = _bmp280[_slot[i]];
+            float pa = bmp->readPressure();
+            if (isnan(pa)) return false;
+            values[0] = pa / 100.0F;
+            values[1] = bmp->readTemperature();
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+#endif // SENSOR_I2C_MUX
@@ -0,0 +1,141 @@
+#include "ResourceMonitor.h"
+
+#ifndef DISABLE_RESOURCE_TELEMETRY
+
+#include <esp_heap_caps.h>
+#include "TextBuffer.h"
+
+const char* ResourceMonitor::TOPIC = "system/resources";
+
+ResourceMonitor::ResourceMonitor(SideChannel& channel, unsigned long intervalMs)
+    : _channel(channel), _intervalMs(intervalMs) {
+    _report[0] = 0;
+}
+
+void ResourceMonitor::loop(unsigned long nowMs) {
+    if (nowMs - _lastReport < _intervalMs) return;
+    _lastReport = nowMs;
+
+    const char* json = collect(nowMs);
+    _channel.publish(TOPIC, (const uint8_t*)json, strlen(json));
+}
+
+#if configUSE_TRACE_FACILITY
+/**
+ * @brief Appends a percentage, null when unknown (NAN).
+ */
+static size_t appendPercent(char* out, size_t size, size_t pos, float percent) {
+    return isnan(percent) ? appendf(out, size, pos, "null") : appendf(out, size, pos, "%.1f", percent);
+}
+
+/**
+ * @brief Runtime counter of a task in the previous report, false for a task
+ * created since.
+ */
+bool ResourceMonitor::previousRuntime(TaskHandle_t handle, uint32_t& runtime) const {
+    for (uint8_t i = 0; i < _previousCount; i++) {
+        if (_previous[i].handle == handle) {
+            runtime = _previous[i].runtime;
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+const char* ResourceMonitor::collect(unsigned long nowMs) {
+    uint32_t start = micros();
+    size_t pos = 0;
+    const size_t size = sizeof(_report);
+
+    // ---- Heap ----
+    size_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t minFree = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    float fragmentation = freeHeap > 0 ? 1.0f - (float)largest / (float)freeHeap : 0.0f;
+
+    // ---- Loop rate ----
+    unsigned long elapsed = nowMs - _lastLoopCountMs;
+    float loopHz = elapsed > 0 ? _loopCount * 1000.0f / elapsed : 0.0f;
+    _loopCount = 0;
+    _lastLoopCountMs = nowMs;
+
+    pos = appendf(_report, size, pos,
+                  "{\"uptime\":%lu,\"heap\":{\"free\":%u,\"minFree\":%u,\"largest\":%u,\"frag\":%.3f},"
+                  "\"loopHz\":%.1f",
+                  nowMs / 1000, (unsigned)freeHeap, (unsigned)minFree, (unsigned)largest, fragmentation, loopHz);
+
+#if configUSE_TRACE_FACILITY
+    // ---- Tasks ----
+    uint32_t totalRuntime = 0;
+    UBaseType_t count = uxTaskGetSystemState(_tasks, MAX_TASKS, &totalRuntime);
+    uint32_t totalDelta = totalRuntime - _previousTotalRuntime;
+    // NAN (reported null) where no delta exists: first report, run time
+    // stats disabled, task created since the last report, core without IDLE
+    float coreBusy[portNUM_PROCESSORS];
+    for (int c = 0; c < portNUM_PROCESSORS; c++) coreBusy[c] = NAN;
+
+    // Task entries stop short of TAIL_RESERVE so the closing fields always fit
+    const size_t taskLimit = size - TAIL_RESERVE;
+    // uxTaskGetSystemState() returns 0 when more than MAX_TASKS tasks exist
+    UBaseType_t truncated = count == 0 ? uxTaskGetNumberOfTasks() : 0;
+    pos = appendf(_report, size, pos, ",\"tasks\":[");
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t& t = _tasks[i];
+        float cpu = NAN;
+#if configGENERATE_RUN_TIME_STATS
+        uint32_t previous;
+        if (_previousTotalRuntime != 0 && totalDelta > 0 && previousRuntime(t.xHandle, previous)) {
+            cpu = (t.ulRunTimeCounter - previous) * 100.0f / totalDelta;
+        }
+#endif
+        int core = -1;
+#if configTASKLIST_INCLUDE_COREID
+        if (t.xCoreID >= 0 && t.xCoreID < portNUM_PROCESSORS) core = t.xCoreID;
+#endif
+        // Per-core load is derived from the pinned idle tasks (IDLE0 / IDLE1)
+        if (core >= 0 && strncmp(t.pcTaskName, "IDLE", 4) == 0) {
+            coreBusy[core] = 100.0f - cpu;
+        }
+
+        if (truncated) {
+            truncated++;
+            continue;
+        }
+        size_t entry = pos;
+        pos = appendf(_report, taskLimit, pos, "%s{\"name\":\"%s\",\"stack\":%u,\"core\":%d,\"cpu\":",
+                      i ? "," : "", t.pcTaskName, (unsigned)t.usStackHighWaterMark, core);
+        pos = appendPercent(_report, taskLimit, pos, cpu);
+        pos = appendf(_report, taskLimit, pos, "}");
+        if (pos >= taskLimit - 1) {
+            // Entry did not fit: drop it and every later task
+            pos = entry;
+            _report[pos] = 0;
+            truncated++;
+        }
+    }
+    pos = appendf(_report, size, pos, "],\"cores\":[");
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        if (c) pos = appendf(_report, size, pos, ",");
+        pos = appendPercent(_report, size, pos, coreBusy[c]);
+    }
+    pos = appendf(_report, size, pos, "],\"truncated\":%u", (unsigned)truncated);
+
+    // Keep this report's counters for the next delta
+    _previousCount = 0;
+    for (UBaseType_t i = 0; i < count && _previousCount < MAX_TASKS; i++) {
+#if configGENERATE_RUN_TIME_STATS
+        _previous[_previousCount++] = { _tasks[i].xHandle, _tasks[i].ulRunTimeCounter };
+#endif
+    }
+    _previousTotalRuntime = totalRuntime;
+#endif
+
+    uint32_t collectUs = micros() - start;
+    if (collectUs > _collectMaxUs) _collectMaxUs = collectUs;
+    appendf(_report, size, pos, ",\"collectUs\":%u,\"collectMaxUs\":%u}", (unsigned)collectUs, (unsigned)_collectMaxUs);
+
+    return _report;
+}
+
+#endif // DISABLE_RESOURCE_TELEMETRY
@@ -1,36 +1,83 @@
 #include "SensorReader.h"
 #include <Wire.h>
-
+#include "Timeline.h"
+
+// Bus trace hooks (-D BUS_TRACE): compiled out otherwise
+#ifdef BUS_TRACE
+    #define TRACE_RX(bus, data, len)        do { if (_trace) _trace->uart(micros(), bus, true, data, len); } while (0)
+    #define TRACE_TX(bus, data, len)        do { if (_trace) _trace->uart(micros(), bus, false, data, len); } while (0)
+    #define TRACE_PROBE(bus, addr, result)  do { if (_trace) _trace->probe(micros(), bus, addr, result); } while (0)
+    #define TRACE_OP(bus, id, result, ...)  do { if (_trace) { \
+            const float _v[] = { 0, ##__VA_ARGS__ }; \
+            _trace->op(micros(), bus, id, result, _v + 1, sizeof(_v) / sizeof(float) - 1); } } while (0)
+#else
+    #define TRACE_RX(bus, data, len)        do { (void)(data); } while (0)
+    #define TRACE_TX(bus, data, len)        do { (void)(data); } while (0)
+    #define TRACE_PROBE(bus, addr, result)  do { (void)(result); } while (0)
+    #define TRACE_OP(bus, id, result, ...)  do { (void)(result); } while (0)
+#endif
+
+#if SENSOR_MHZ14A
 const uint8_t SensorReader::CO2_READ_CMD[9] = { 0xFF, 0x01, 0x86, 0, 0, 0, 0, 0, 0x79 };
+#endif
+
+SensorReader::SensorReader(const SensorPorts& ports)
+    : _ports(ports)
+#if SENSOR_SPS30
+    , sps30(*ports.sps30Serial)
+#endif
+#if SENSOR_SHT31
+    , sht(ports.wireSGP)
+#endif
+{
+}
 
-SensorReader::SensorReader(HardwareSerial& co2Serial, HardwareSerial& sps30Serial, DHT_Unified& dht, TwoWire& wireSGP, SoftwareSerial& coSerial) 
-    : co2Serial(co2Serial), sps30Serial(sps30Serial), _coSerial(coSerial), dht(dht), _wireSGP(wireSGP), sht(&wireSGP) {
+#ifdef BUS_TRACE
+void SensorReader::traceCycle(HardwareSlot hw) {
+    if (_trace) _trace->cycle(micros(), HARDWARE_TABLE[hw].bus, hw);
 }
+#endif
 
+#if SENSOR_BMP280
 bool SensorReader::initBMP(int maxAttempts, int delayBetweenMs) {
+    TL_SCOPE(TL_INIT_BMP);
     for (int attempt = 1; attempt <= maxAttempts; attempt++) {
-        if (bmp.begin(0x76)) {
+        bool ok = bmp.begin(0x76);
+        TRACE_OP(BUS_I2C_MAIN, OP_BMP_BEGIN, ok);
+        if (ok) {
             return true;
         }
         if (attempt < maxAttempts) delay(delayBetweenMs);
     }
     return false;
 }
+#endif
 
+#if SENSOR_SGP40
 bool SensorReader::initSGP(int maxAttempts, int delayBetweenMs) {
+    TL_SCOPE(TL_INIT_SGP40);
     for (int attempt = 1; attempt <= maxAttempts; attempt++) {
-        if (sgp.begin(&_wireSGP)) {
+        bool ok = sgp.begin(_ports.wireSGP);
+        TRACE_OP(BUS_I2C_SGP, OP_SGP40_BEGIN, ok);
+        if (ok) {
             return true;
         }
         if (attempt < maxAttempts) delay(delayBetweenMs);
     }
     return false;
 }
+#endif
 
+#if SENSOR_SGP30
 bool SensorReader::initSGP30(int maxAttempts, int delayBetweenMs) {
+    TL_SCOPE(TL_INIT_SGP30);
     for (int attempt = 1; attempt <= maxAttempts; attempt++) {
-        if (sgp30.begin(&_wireSGP)) {
-            if (sgp30.IAQinit()) {
+        bool ok = sgp30.begin(_ports.wireSGP);
+        TRACE_OP(BUS_I2C_SGP, OP_SGP30_BEGIN, ok);
+        if (ok) {
+            ok = sgp30.IAQinit();
+            TRACE_OP(BUS_I2C_SGP, OP_SGP30_INIT, ok);
+            if (ok) {
                 return true;
             }
         }
@@ -38,75 +85,156 @@ bool SensorReader::initSGP30(int maxAttempts, int delayBetweenMs) {
     }
     return false;
 }
+#endif
+
+#if SENSOR_SPS30
+static const uint8_t SPS30_FLOAT_FORMAT[2] = { 0x01, 0x03 };
+static const uint8_t SPS30_SERIAL_NUMBER = 0x03;
+static const int16_t SPS30_NOT_ALLOWED = 0x43;     // Command not allowed in the current state
+
+#ifdef BUS_TRACE
+static uint8_t sps30Op(uint8_t command) {
+    switch (command) {
+        case Sps30Shdlc::CMD_WAKEUP: return OP_SPS30_WAKEUP;
+        case Sps30Shdlc::CMD_STOP: return OP_SPS30_STOP;
+        case Sps30Shdlc::CMD_RESET: return OP_SPS30_RESET;
+        case Sps30Shdlc::CMD_DEVICE_INFO: return OP_SPS30_SERIAL;
+        case Sps30Shdlc::CMD_START: return OP_SPS30_START;
+        default: return OP_SPS30_READ;
+    }
+}
+#endif
 
 bool SensorReader::initSPS30(int maxAttempts, int delayBetweenMs) {
-    sps30Serial.begin(115200, SERIAL_8N1, 13, 27);
-    sps30.begin(sps30Serial);
+    TL_SCOPE(TL_INIT_SPS30);
+    sps30.begin(13, 27);
+    _sps30Reading = false;
+    _sps30Attempts = maxAttempts > 1 ? maxAttempts - 1 : 0;
+    _sps30RetryMs = delayBetweenMs;
+    queueSPS30Start(true, 0);
+    return true;
+}
 
-    for (int attempts = 0; attempts < maxAttempts; attempts++) {
-        sps30.wakeUp(); 
-        sps30.stopMeasurement(); 
-        delay(100);
-        sps30.deviceReset();
-        delay(1000);
+void SensorReader::queueSPS30Start(bool bringUp, uint16_t delayMs) {
+    sps30.clear();
+    sps30.submit(Sps30Shdlc::CMD_WAKEUP, nullptr, 0, delayMs);
+    if (bringUp) {
+        sps30.submit(Sps30Shdlc::CMD_STOP);
+        sps30.submit(Sps30Shdlc::CMD_RESET, nullptr, 0, 100);
+        sps30.submit(Sps30Shdlc::CMD_DEVICE_INFO, &SPS30_SERIAL_NUMBER, 1, 1000);
+    }
+    sps30.submit(Sps30Shdlc::CMD_START, SPS30_FLOAT_FORMAT, sizeof(SPS30_FLOAT_FORMAT));
+    _sps30State = SPS30_STARTING;
+}
 
-        int8_t serialNumber[32];
-        int16_t ret = sps30.readSerialNumber(serialNumber, 32);
-        
-        if (ret == 0) {
-            ret = sps30.startMeasurement(SPS30_OUTPUT_FORMAT_OUTPUT_FORMAT_FLOAT);
-            if (ret == 0 || ret == 1347 || (ret & 0xFF00) == 0x0500) {
-                delay(2000);
-                float p1, p2, p4, p10;
-                if (readSPS30(p1, p2, p4, p10)) {
-                    return true;
-                }
+bool SensorReader::sps30StepDone(const Sps30Shdlc::Result& result) {
+    bool ok = result.error == 0;
+    switch (result.command) {
+        case Sps30Shdlc::CMD_DEVICE_INFO:
+            break;
+        case Sps30Shdlc::CMD_START:
+            ok = ok || result.error == SPS30_NOT_ALLOWED;   // Already measuring
+            if (ok) {
+                _sps30State = SPS30_MEASURING;
+                _sps30StartedMs = millis();
             }
-        }
-        delay(delayBetweenMs);
+            break;
+        default:
+            // Wake-up, stop, reset: best effort (an awake sensor may not answer the wake-up)
+            return true;
+    }
+    if (ok) return true;
+    if (_sps30Attempts > 0) {
+        _sps30Attempts--;
+        queueSPS30Start(true, _sps30RetryMs);
+    } else {
+        sps30.clear();
+        _sps30State = SPS30_FAILED;
     }
     return false;
 }
+#endif
+
+uint8_t SensorReader::probeI2C(BusId bus, uint8_t address) {
+    TwoWire* wire = nullptr;
+#if SENSOR_I2C_MAIN_BUS
+    if (bus == BUS_I2C_MAIN) wire = &Wire;
+#endif
+#if SENSOR_I2C_SGP_BUS
+    if (bus == BUS_I2C_SGP) wire = _ports.wireSGP;
+#endif
+    if (!wire) return 2;
+    wire->beginTransmission(address);
+    uint8_t error = wire->endTransmission();
+    TRACE_PROBE(bus, address, error);
+    return error;
+}
 
-int SensorReader::scanI2C(TwoWire& wire, const char* busName) {
-    int nDevices = 0;
-    for (byte address = 1; address < 127; address++) {
-        wire.beginTransmission(address);
-        if (wire.endTransmission() == 0) {
-            nDevices++;
-        }
+#if SENSOR_SPS30
+bool SensorReader::startSPS30Read() {
+    TL_SCOPE(TL_SPS30_START);
+    if (_sps30Reading || _sps30State == SPS30_OFF || _sps30State == SPS30_STARTING) return false;
+    uint16_t delayMs = 0;
+    if (_sps30State == SPS30_FAILED) {
+        // Auto-recovery: wake it up and restart the measurement, then read
+        queueSPS30Start(false, 0);
+        delayMs = SPS30_FIRST_DATA_MS;
+    } else if (millis() - _sps30StartedMs < SPS30_FIRST_DATA_MS) {
+        return false;
     }
-    return nDevices;
+    if (!sps30.submit(Sps30Shdlc::CMD_READ, nullptr, 0, delayMs)) return false;
+    _sps30Reading = true;
+    return true;
 }
 
-bool SensorReader::readSPS30(float& pm1, float& pm25, float& pm4, float& pm10) {
-    float mc1p0, mc2p5, mc4p0, mc10p0, nc0p5, nc1p0, nc2p5, nc4p0, nc10p0, typPartSize;
-    
-    for (int i = 0; i < 3; i++) {
-        if (sps30.readMeasurementValuesFloat(mc1p0, mc2p5, mc4p0, mc10p0, 
-                                            nc0p5, nc1p0, nc2p5, nc4p0, nc10p0, typPartSize) == 0) {
-            pm1 = mc1p0; pm25 = mc2p5; pm4 = mc4p0; pm10 = mc10p0;
-            return true;
-        }
-        delay(100);
+bool SensorReader::pollSPS30(Sps30Reading& reading) {
+    TL_SCOPE_MIN(TL_SPS30_POLL, 50);
+    Sps30Shdlc::Result result;
+    if (!sps30.poll(millis(), result)) return false;
+
+    reading = { NAN, NAN, NAN, NAN, false };
+    if (result.command != Sps30Shdlc::CMD_READ) {
+        TRACE_OP(BUS_UART_SPS30, sps30Op(result.command), result.error);
+        // A failed restart also ends the read queued behind it
+        if (sps30StepDone(result) || !_sps30Reading) return false;
+        _sps30Reading = false;
+        return true;
     }
 
-    // Auto-recovery
-    sps30.wakeUp();
-    sps30.startMeasurement(SPS30_OUTPUT_FORMAT_OUTPUT_FORMAT_FLOAT);
-    return false;
+    _sps30Reading = false;
+    // 10 floats: mass concentrations PM1..PM10 first. No data: no new
+    // measurement since the last read
+    if (result.error == 0 && result.len >= 16) {
+        reading.pm1 = shdlcFloat(result.data);
+        reading.pm25 = shdlcFloat(result.data + 4);
+        reading.pm4 = shdlcFloat(result.data + 8);
+        reading.pm10 = shdlcFloat(result.data + 12);
+        reading.valid = true;
+        TRACE_OP(BUS_UART_SPS30, OP_SPS30_READ, result.error, reading.pm1, reading.pm25, reading.pm4, reading.pm10);
+        return true;
+    }
+    TRACE_OP(BUS_UART_SPS30, OP_SPS30_READ, result.error);
+    // Timeout or state error (fell back to idle): wake it up and start again
+    if (result.error != 0 && result.error != Sps30Shdlc::ERROR_FRAME) queueSPS30Start(false, 0);
+    return true;
 }
+#endif
 
+#if SENSOR_BMP280
 bool SensorReader::resetBMP() {
+    TL_SCOPE(TL_RESET_BMP);
     // Soft Reset
     Wire.beginTransmission(0x76);
     Wire.write(0xE0);
     Wire.write(0xB6);
     byte error = Wire.endTransmission();
+    TRACE_PROBE(BUS_I2C_MAIN, 0x76, error);
     delay(100);
 
-    if (error == 0 && bmp.begin(0x76)) {
-        return true;
+    if (error == 0) {
+        bool ok = bmp.begin(0x76);
+        TRACE_OP(BUS_I2C_MAIN, OP_BMP_BEGIN, ok);
+        if (ok) return true;
     }
 
     recoverI2C(21, 22);
@@ -114,25 +242,34 @@ bool SensorReader::resetBMP() {
     Wire.beginTransmission(0x76);
     Wire.write(0xE0);
     Wire.write(0xB6);
-    Wire.endTransmission();
+    error = Wire.endTransmission();
+    TRACE_PROBE(BUS_I2C_MAIN, 0x76, error);
     delay(100);
     
-    if (bmp.begin(0x76)) {
+    bool ok = bmp.begin(0x76);
+    TRACE_OP(BUS_I2C_MAIN, OP_BMP_BEGIN, ok);
+    if (ok) {
         return true;
     }
     
     return false;
 }
+#endif
 
+#if SENSOR_SGP40
 bool SensorReader::resetSGP() {
-    bool success = sgp.begin(&_wireSGP);
+    TL_SCOPE(TL_RESET_SGP);
+    bool success = sgp.begin(_ports.wireSGP);
+    TRACE_OP(BUS_I2C_SGP, OP_SGP40_BEGIN, success);
     if (!success) {
         recoverI2C(32, 33);
     }
     return success;
 }
+#endif
 
 void SensorReader::recoverI2C(int sdaPin, int sclPin) {
+    TL_SCOPE(TL_I2C_RECOVERY);
     pinMode(sdaPin, INPUT);
     pinMode(sclPin, INPUT);
     delayMicroseconds(5);
@@ -168,39 +305,65 @@ void SensorReader::recoverI2C(int sdaPin, int sclPin) {
     delay(100);
 }
 
+#if SENSOR_DHT22
 void SensorReader::resetDHT() {
-    dht.begin();
+    _ports.dht->begin();
 }
+#endif
 
+#if SENSOR_MHZ14A
 void SensorReader::resetCO2() {
-    while (co2Serial.available()) co2Serial.read();
+    while (_ports.co2Serial->available()) {
+        uint8_t b = _ports.co2Serial->read();
+        TRACE_RX(BUS_UART_CO2, &b, 1);
+    }
 }
+#endif
 
+#if SENSOR_SGP40
 bool SensorReader::isSGPConnected() {
-    _wireSGP.beginTransmission(0x59);
-    return _wireSGP.endTransmission() == 0;
+    _ports.wireSGP->beginTransmission(0x59);
+    uint8_t error = _ports.wireSGP->endTransmission();
+    TRACE_PROBE(BUS_I2C_SGP, 0x59, error);
+    return error == 0;
 }
+#endif
 
+#if SENSOR_SGP30
 bool SensorReader::isSGP30Connected() {
-    _wireSGP.beginTransmission(0x58);
-    return _wireSGP.endTransmission() == 0;
+    _ports.wireSGP->beginTransmission(0x58);
+    uint8_t error = _ports.wireSGP->endTransmission();
+    TRACE_PROBE(BUS_I2C_SGP, 0x58, error);
+    return error == 0;
 }
+#endif
 
+#if SENSOR_BMP280
 bool SensorReader::isBMPConnected() {
     Wire.beginTransmission(0x76);
-    return Wire.endTransmission() == 0;
+    uint8_t error = Wire.endTransmission();
+    TRACE_PROBE(BUS_I2C_MAIN, 0x76, error);
+    return error == 0;
 }
+#endif
 
+#if SENSOR_SGP30
 bool SensorReader::readSGP30(int& eco2, int& tvoc) {
+    TL_SCOPE(TL_READ_SGP30);
     if (!isSGP30Connected()) return false;
-    if (!sgp30.IAQmeasure()) return false;
+    bool ok = sgp30.IAQmeasure();
+    TRACE_OP(BUS_I2C_SGP, OP_SGP30_MEASURE, ok, (float)sgp30.eCO2, (float)sgp30.TVOC);
+    if (!ok) return false;
 
     // Check for invalid values (0 indicates uninitialized state)
     if (sgp30.eCO2 == 0) {
         // Sensor answered but with 0 -> definitely uninitialized or broken
         // Try to re-initialize immediately
-        if (sgp30.begin(&_wireSGP)) {
-            sgp30.IAQinit();
+        ok = sgp30.begin(_ports.wireSGP);
+        TRACE_OP(BUS_I2C_SGP, OP_SGP30_BEGIN, ok);
+        if (ok) {
+            ok = sgp30.IAQinit();
+            TRACE_OP(BUS_I2C_SGP, OP_SGP30_INIT, ok);
         }
         return false; // Don't use this reading
     }
@@ -210,53 +373,86 @@ bool SensorReader::readSGP30(int& eco2, int& tvoc) {
     return true;
 }
 
+bool SensorReader::setSGP30Humidity(float absHumidity) {
+    TL_SCOPE(TL_SGP30_HUMIDITY);
+    if (isnan(absHumidity) || absHumidity < 0) return false;
+    if (!isSGP30Connected()) return false;
+    // Driver expects mg/m³; 0 disables compensation, so clamp to the smallest step
+    uint32_t mg = (uint32_t)(absHumidity * 1000.0f + 0.5f);
+    if (mg == 0) mg = 1;
+    bool ok = sgp30.setHumidity(mg);
+    TRACE_OP(BUS_I2C_SGP, OP_SGP30_HUMIDITY, ok);
+    return ok;
+}
+#endif
+
+#if SENSOR_SGP40
 int SensorReader::readVocIndex() {
+    TL_SCOPE(TL_READ_VOC);
     if (!isSGPConnected()) return -1;
 
     // Use SHT31 for temperature/humidity compensation (with DHT22 fallback)
     float t = 25.0;  // Default
     float h = 50.0;  // Default
     
+#if SENSOR_SHT31
     if (readSHT(t, h)) {
         // SHT31 read successful, use real values
-    } else {
-        // Fallback to DHT22 if SHT31 fails
-        sensors_event_t temp, humidity;
-        dht.temperature().getEvent(&temp);
-        dht.humidity().getEvent(&humidity);
-        
-        if (!isnan(temp.temperature)) t = temp.temperature;
-        if (!isnan(humidity.relative_humidity)) h = humidity.relative_humidity;
+    } else
+#endif
+    {
+#if SENSOR_DHT22
+        // Fallback to the last DHT22 read if SHT31 fails
+        if (_lastDht.valid) {
+            t = _lastDht.temperature;
+            h = _lastDht.humidity;
+        }
+#endif
     }
     
-    return sgp.measureVocIndex(t, h);
+    int32_t voc = sgp.measureVocIndex(t, h);
+    TRACE_OP(BUS_I2C_SGP, OP_SGP40_VOC, (int16_t)voc);
+    return voc;
 }
+#endif
 
 
 
+#if SENSOR_BMP280
 float SensorReader::readPressure() {
+    TL_SCOPE(TL_READ_PRESSURE);
     if (!isBMPConnected()) return NAN;
-    return bmp.readPressure() / 100.0F;
+    float pa = bmp.readPressure();
+    TRACE_OP(BUS_I2C_MAIN, OP_BMP_PRESSURE, 0, pa);
+    return pa / 100.0F;
 }
 
 float SensorReader::readBMPTemperature() {
+    TL_SCOPE(TL_READ_BMP_TEMPERATURE);
     if (!isBMPConnected()) return NAN;
-    return bmp.readTemperature();
+    float t = bmp.readTemperature();
+    TRACE_OP(BUS_I2C_MAIN, OP_BMP_TEMPERATURE, 0, t);
+    return t;
 }
+#endif
 
+#if SENSOR_MHZ14A
 int SensorReader::readCO2() {
-    while (co2Serial.available()) co2Serial.read();
+    TL_SCOPE(TL_READ_CO2);
+    resetCO2();
 
-    co2Serial.write(CO2_READ_CMD, 9);
+    _ports.co2Serial->write(CO2_READ_CMD, 9);
+    TRACE_TX(BUS_UART_CO2, CO2_READ_CMD, 9);
     unsigned long start = millis();
-    while (co2Serial.available() < 9 && millis() - start < 500) {
+    while (_ports.co2Serial->available() < 9 && millis() - start < 500) {
         delay(10);
     }
 
-    if (co2Serial.available() < 9) return -1;
+    if (_ports.co2Serial->available() < 9) return -1;
 
     uint8_t buf[9];
-    co2Serial.readBytes(buf, 9);
+    _ports.co2Serial->readBytes(buf, 9);
+    TRACE_RX(BUS_UART_CO2, buf, 9);
 
     if (buf[0] != 0xFF || buf[1] != 0x86) return -2;
     
@@ -269,32 +465,43 @@ int SensorReader::readCO2() {
     int ppm = buf[2] * 256 + buf[3];
     return (ppm >= 0 && ppm <= 10000) ? ppm : -3;
 }
+#endif
+
+#if SENSOR_DHT22
+bool SensorReader::startDhtRead() {
+    TL_SCOPE(TL_DHT_START);
+    return _ports.dht->start(millis());
+}
 
-DhtReading SensorReader::readDhtSensors() {
-    DhtReading reading = {0.0, 0.0, false};
-    sensors_event_t event;
+bool SensorReader::pollDht(DhtReading& reading) {
+    TL_SCOPE_MIN(TL_DHT_POLL, 50);
+    DhtFrame frame;
+    if (!_ports.dht->poll(millis(), frame)) return false;
+    TRACE_OP(BUS_GPIO_DHT, OP_DHT_FRAME, frame.status, frame.temperature, frame.humidity);
 
-    dht.temperature().getEvent(&event);
-    if (!isnan(event.temperature)) {
-        reading.temperature = event.temperature;
+    reading = {0.0, 0.0, false};
+    if (frame.status == DHT_OK) {
+        reading.temperature = frame.temperature;
+        reading.humidity = frame.humidity;
         reading.valid = true;
+        _lastDht = reading;
     }
-    
-    dht.humidity().getEvent(&event);
-    if (!isnan(event.relative_humidity)) {
-        reading.humidity = event.relative_humidity;
-    }
-    
-    return reading;
+    return true;
 }
+#endif
 
+#if SENSOR_SHT31
 bool SensorReader::initSHT(int maxAttempts, int delayBetweenMs) {
-    _wireSGP.setClock(100000);
-    _wireSGP.setTimeOut(150);
+    TL_SCOPE(TL_INIT_SHT);
+    _ports.wireSGP->setClock(100000);
+    _ports.wireSGP->setTimeOut(150);
 
     for (int attempt = 1; attempt <= maxAttempts; attempt++) {
-        if (sht.begin(0x44)) {
+        bool ok = sht.begin(0x44);
+        TRACE_OP(BUS_I2C_SGP, OP_SHT_BEGIN, ok);
+        if (ok) {
             sht.reset();
+            TRACE_OP(BUS_I2C_SGP, OP_SHT_RESET, 0);
             delay(100);
             return true;
         }
@@ -304,23 +511,29 @@ bool SensorReader::initSHT(int maxAttempts, int delayBetweenMs) {
 }
 
 bool SensorReader::isSHTConnected() {
-    _wireSGP.beginTransmission(0x44);
-    return _wireSGP.endTransmission() == 0;
+    _ports.wireSGP->beginTransmission(0x44);
+    uint8_t error = _ports.wireSGP->endTransmission();
+    TRACE_PROBE(BUS_I2C_SGP, 0x44, error);
+    return error == 0;
 }
 
 bool SensorReader::readSHT(float& temp, float& hum) {
+    TL_SCOPE(TL_READ_SHT);
     if (!isSHTConnected()) return false;
     
-    _wireSGP.setClock(100000);
+    _ports.wireSGP->setClock(100000);
 
     for (int i = 0; i < 3; i++) {
-        if (sht.readBoth(&temp, &hum)) {
+        bool ok = sht.readBoth(&temp, &hum);
+        TRACE_OP(BUS_I2C_SGP, OP_SHT_READ, ok, temp, hum);
+        if (ok) {
             if (hum >= 0 && hum <= 100 && temp > -45 && temp < 130) {
                 return true;
             }
         }
         if (i < 2) {
-            sht.begin(0x44);
+            ok = sht.begin(0x44);
+            TRACE_OP(BUS_I2C_SGP, OP_SHT_BEGIN, ok);
             delay(10);
         }
     }
@@ -328,24 +541,28 @@ bool SensorReader::readSHT(float& temp, float& hum) {
 }
 
 void SensorReader::resetSHT() {
+    TL_SCOPE(TL_RESET_SHT);
     if (!initSHT()) {
         recoverI2C(32, 33);
     }
 }
+#endif
 
+#if SENSOR_SC16CO
 // ============ SC16-CO (Carbon Monoxide) ============
 
 bool SensorReader::initCO() {
+    TL_SCOPE(TL_INIT_CO);
     _coBufferIndex = 0;
     memset(_coBuffer, 0, sizeof(_coBuffer));
     
     unsigned long start = millis();
-    while (_coSerial.available() == 0 && millis() - start < 2000) {
+    while (_ports.coSerial->available() == 0 && millis() - start < 2000) {
         delay(100);
     }
     
-    if (_coSerial.available() > 0) {
-        while (_coSerial.available()) _coSerial.read(); // Clear buffer
+    if (_ports.coSerial->available() > 0) {
+        resetCOBuffer();
         return true;
     }
     
@@ -353,24 +570,27 @@ bool SensorReader::initCO() {
 }
 
 int SensorReader::readCO() {
+    TL_SCOPE(TL_READ_CO);
     // Generic Winsen Request Command (0xFF 0x01 0x86 0x00 0x00 0x00 0x00 0x00 0x79)
     // Try to request data in case sensor is not in auto-mode
     uint8_t cmd[] = {0xFF, 0x01, 0x86, 0x00, 0x00, 0x00, 0x00, 0x00, 0x79};
-    _coSerial.write(cmd, 9);
+    _ports.coSerial->write(cmd, 9);
+    TRACE_TX(BUS_SOFT_CO, cmd, 9);
     
     // Wait a bit for response
     unsigned long start = millis();
-    while (_coSerial.available() < 9 && millis() - start < 150) {
+    while (_ports.coSerial->available() < 9 && millis() - start < 150) {
         delay(10);
     }
 
-    int bytesAvailable = _coSerial.available();
+    int bytesAvailable = _ports.coSerial->available();
     if (bytesAvailable == 0) {
         return -1; 
     }
     
-    while (_coSerial.available()) {
-        uint8_t b = _coSerial.read();
+    while (_ports.coSerial->available()) {
+        uint8_t b = _ports.coSerial->read();
+        TRACE_RX(BUS_SOFT_CO, &b, 1);
         
         if (_coBufferIndex == 0 && b != 0xFF) {
             continue; 
@@ -418,6 +638,10 @@ int SensorReader::readCO() {
 }
 
 void SensorReader::resetCOBuffer() {
-    while (_coSerial.available()) _coSerial.read();
+    while (_ports.coSerial->available()) {
+        uint8_t b = _ports.coSerial->read();
+        TRACE_RX(BUS_SOFT_CO, &b, 1);
+    }
     _coBufferIndex = 0;
 }
+#endif
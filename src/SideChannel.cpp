@@ -0,0 +1,80 @@
+#include "SideChannel.h"
+#include <WiFi.h>
+#include "Timeline.h"
+
+SideChannel::SideChannel(const char* moduleId) : _moduleId(moduleId) {
+    snprintf(_clientId, sizeof(_clientId), "%s-side", moduleId);
+}
+
+void SideChannel::begin(const char* host, uint16_t port) {
+    _client.setServer(host, port);
+    _client.setClientId(_clientId);
+
+    _client.onConnect([this](bool sessionPresent) {
+        char topic[96];
+        for (uint8_t i = 0; i < _subscriptionCount; i++) {
+            buildTopic(topic, sizeof(topic), _subscriptions[i]);
+            _client.subscribe(topic, 0);
+        }
+        _backoffMs = RECONNECT_MIN_MS;
+    });
+
+    _client.onMessage([this](char* topic, char* payload, AsyncMqttClientMessageProperties properties,
+                             size_t len, size_t index, size_t total) {
+        if (!_handler || index != 0 || len != total) return; // Fragmented payloads not supported
+        TL_SCOPE(TL_SIDE_MESSAGE);
+        size_t prefixLen = strlen(_moduleId);
+        if (strncmp(topic, _moduleId, prefixLen) != 0 || topic[prefixLen] != '/') return;
+        _handler(topic + prefixLen + 1, (const uint8_t*)payload, len);
+    });
+
+    _started = true;
+}
+
+void SideChannel::loop() {
+    if (!_started || _client.connected() || WiFi.status() != WL_CONNECTED) return;
+
+    unsigned long now = millis();
+    if (now - _lastAttempt < _backoffMs) return;
+    _lastAttempt = now;
+
+    _client.connect();
+    _backoffMs = _backoffMs * 2 > RECONNECT_MAX_MS ? RECONNECT_MAX_MS : _backoffMs * 2;
+}
+
+bool SideChannel::connected() {
+    return _client.connected();
+}
+
+bool SideChannel::subscribe(const char* suffix) {
+    if (_subscriptionCount >= MAX_SUBSCRIPTIONS) return false;
+    _subscriptions[_subscriptionCount++] = suffix;
+
+    if (_client.connected()) {
+        char topic[96];
+        buildTopic(topic, sizeof(topic), suffix);
+        _client.subscribe(topic, 0);
+    }
+    return true;
+}
+
+bool SideChannel::publish(const char* suffix, const uint8_t* data, size_t len, bool retain) {
+    if (!_client.connected()) return false;
+    TL_SCOPE(TL_SIDE_PUBLISH);
+    char topic[96];
+    buildTopic(topic, sizeof(topic), suffix);
+    return _client.publish(topic, 0, retain, (const char*)data, len) != 0;
+}
+
+bool SideChannel::publishTopic(const char* topic, const char* payload, size_t len) {
+    if (!_client.connected()) return false;
+    return _client.publish(topic, 0, false, payload, len) != 0;
+}
+
+void SideChannel::onMessage(MessageHandler handler) {
+    _handler = handler;
+}
+
+void SideChannel::buildTopic(char* out, size_t outLen, const char* suffix) const {
+    snprintf(out, outLen, "%s/%s", _moduleId, suffix);
+}
@@ -0,0 +1,113 @@
+#include "Sps30Shdlc.h"
+
+static const uint32_t SPS30_BAUD = 115200;
+static const uint8_t SPS30_ADDRESS = 0x00;
+static const uint8_t WAKEUP_PULSE = 0xFF;
+
+void Sps30Shdlc::begin(int8_t rxPin, int8_t txPin) {
+    clear();
+    if (_installed) return;
+    _serial.begin(SPS30_BAUD, SERIAL_8N1, rxPin, txPin);
+    _serial.onReceive([this]() { receive(); });
+    _installed = true;
+}
+
+bool Sps30Shdlc::submit(uint8_t command, const uint8_t* data, uint8_t len, uint16_t delayMs) {
+    if (_count >= QUEUE_SIZE || len > sizeof(_queue[0].data)) return false;
+    Request& r = _queue[(_head + _count) % QUEUE_SIZE];
+    r.command = command;
+    r.len = len;
+    r.delayMs = delayMs;
+    if (len > 0) memcpy(r.data, data, len);
+    _count++;
+    return true;
+}
+
+void Sps30Shdlc::clear() {
+    _count = 0;
+    _inFlight = false;
+}
+
+bool Sps30Shdlc::poll(uint32_t nowMs, Result& result) {
+    if (_inFlight) {
+        ShdlcFrame frame;
+        ShdlcStatus status = SHDLC_PENDING;
+        portENTER_CRITICAL(&_rxLock);
+        if (_rxReady) {
+            status = _rxStatus;
+            if (status == SHDLC_FRAME) frame = _rxFrame;
+            _rxReady = false;
+        }
+        portEXIT_CRITICAL(&_rxLock);
+
+        if (status != SHDLC_PENDING) {
+            bool match = status == SHDLC_FRAME && frame.command == _command;
+            if (status != SHDLC_FRAME) _frameErrors++;
+            if (match || status != SHDLC_FRAME) {
+                result.command = _command;
+                result.error = match ? (int16_t)(frame.state & 0x7F) : ERROR_FRAME;
+                result.len = match ? frame.len : 0;
+                if (result.len > 0) memcpy(result.data, frame.data, result.len);
+                _inFlight = false;
+                _doneMs = nowMs;
+                return true;
+            }
+            // Answer to a command dropped by clear()
+        }
+        if (nowMs - _sentMs < RESPONSE_TIMEOUT_MS) return false;
+        result.command = _command;
+        result.error = ERROR_TIMEOUT;
+        result.len = 0;
+        _inFlight = false;
+        _doneMs = nowMs;
+        _guardMs = LATE_ANSWER_GUARD_MS;    // Its answer may still be on the way
+        return true;
+    }
+
+    if (_count > 0 && nowMs - _doneMs >= _queue[_head].delayMs + _guardMs) {
+        send(_queue[_head], nowMs);
+        _head = (_head + 1) % QUEUE_SIZE;
+        _count--;
+    }
+    return false;
+}
+
+void Sps30Shdlc::send(const Request& request, uint32_t nowMs) {
+    ShdlcFrame frame;
+    frame.address = SPS30_ADDRESS;
+    frame.command = request.command;
+    frame.state = 0;
+    frame.len = request.len;
+    memcpy(frame.data, request.data, request.len);
+
+    size_t n = 0;
+    if (request.command == CMD_WAKEUP) _tx[n++] = WAKEUP_PULSE;
+    n += shdlcEncode(frame, false, _tx + n, sizeof(_tx) - n);
+
+    portENTER_CRITICAL(&_rxLock);
+    _rxReady = false;       // A stale answer must not complete this command
+    _txGeneration++;
+    portEXIT_CRITICAL(&_rxLock);
+    _command = request.command;
+    _sentMs = nowMs;
+    _guardMs = 0;
+    _inFlight = true;
+    _serial.write(_tx, n);
+}
+
+// UART event task: decode what arrived, hand a completed frame to the loop.
+// A frame that started before the last send() answers an earlier command
+void Sps30Shdlc::receive() {
+    while (_serial.available() > 0) {
+        if (_decoder.empty()) _frameGeneration = _txGeneration;
+        ShdlcStatus status = _decoder.feed((uint8_t)_serial.read());
+        if (status == SHDLC_PENDING || _frameGeneration != _txGeneration) continue;
+        portENTER_CRITICAL(&_rxLock);
+        if (!_rxReady) {
+            if (status == SHDLC_FRAME) _rxFrame = _decoder.frame();
+            _rxStatus = status;
+            _rxReady = true;
+        }
+        portEXIT_CRITICAL(&_rxLock);
+    }
+}
@@ -0,0 +1,142 @@
+#include "TimelineService.h"
+
+#ifdef TIMELINE
+
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+
+Timeline timeline;
+
+const char* TimelineService::REQUEST_TOPIC = "timeline/get";
+const char* TimelineService::RESPONSE_TOPIC = "timeline/data";
+
+// ============================================================================
+// Clock
+// ============================================================================
+// The cycle counters of the two cores are not synchronised. Events on the
+// loop core use its counter directly; events from other cores (AsyncTCP
+// callbacks) are mapped onto it through an (cycles, esp_timer) anchor taken
+// by the loop core every iteration. Two anchor slots, flipped after writing,
+// so a reader never sees a half-written pair.
+
+struct ClockAnchor {
+    uint32_t cycles;
+    int64_t us;
+};
+
+static ClockAnchor anchors[2];
+static volatile uint8_t anchorIndex = 0;
+static uint8_t loopCore = 1;
+static uint32_t cyclesPerUs = 240;
+
+static void anchorClock() {
+    uint8_t next = anchorIndex ^ 1;
+    anchors[next].cycles = ESP.getCycleCount();
+    anchors[next].us = esp_timer_get_time();
+    anchorIndex = next;
+}
+
+uint32_t timelineNow() {
+    if (xPortGetCoreID() == loopCore) return ESP.getCycleCount();
+    const ClockAnchor& a = anchors[anchorIndex];
+    return a.cycles + (uint32_t)(esp_timer_get_time() - a.us) * cyclesPerUs;
+}
+
+uint8_t timelineCore() {
+    return xPortGetCoreID();
+}
+
+uint32_t timelineCyclesPerUs() {
+    return cyclesPerUs;
+}
+
+// ============================================================================
+// TimelineService
+// ============================================================================
+
+TimelineService::TimelineService(SideChannel& channel) : _channel(channel) {}
+
+void TimelineService::begin() {
+    loopCore = xPortGetCoreID();
+    cyclesPerUs = ESP.getCpuFreqMHz();
+    anchorClock();
+    _channel.subscribe(REQUEST_TOPIC);
+}
+
+void TimelineService::loop(unsigned long nowMs) {
+    anchorClock();
+
+    if (!_streaming && nowMs - _lastCounters >= COUNTER_INTERVAL_MS) {
+        _lastCounters = nowMs;
+        TL_COUNTER(TL_HEAP_FREE, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+        TL_COUNTER(TL_HEAP_LARGEST, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    }
+
+    // Anything else typed (line endings included) is discarded
+    while (Serial.available()) {
+        if (Serial.read() == 'T' && !_serialStreaming) {
+            _serialStreaming = true;
+            _serialOffset = 0;
+            updateFreeze();
+        }
+    }
+    if (_serialStreaming) streamSerial();
+
+    if (_mqttRequested && !_streaming && _channel.connected()) {
+        _mqttRequested = false;
+        _streaming = true;
+        _offset = 0;
+        updateFreeze();
+    }
+    if (_streaming) streamChunks();
+}
+
+void TimelineService::updateFreeze() {
+    timeline.freeze(_streaming || _serialStreaming);
+}
+
+void TimelineService::streamSerial() {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    TimelineDump<TIMELINE_EVENTS> dump(timeline, cyclesPerUs);
+    uint8_t bytes[SERIAL_LINE_BYTES];
+    char line[3 + SERIAL_LINE_BYTES * 2 + 2];
+    for (uint8_t i = 0; i < SERIAL_LINES_PER_LOOP; i++) {
+        // Whole lines only, never waiting on the UART
+        if ((size_t)Serial.availableForWrite() < sizeof(line)) return;
+        if (_serialOffset >= dump.size()) {
+            Serial.print("TL:END\r\n");
+            _serialStreaming = false;
+            updateFreeze();
+            return;
+        }
+        size_t n = dump.read(_serialOffset, bytes, sizeof(bytes));
+        _serialOffset += n;
+        size_t len = 0;
+        line[len++] = 'T';
+        line[len++] = 'L';
+        line[len++] = ':';
+        for (size_t k = 0; k < n; k++) {
+            line[len++] = HEX_DIGITS[bytes[k] >> 4];
+            line[len++] = HEX_DIGITS[bytes[k] & 0x0F];
+        }
+        line[len++] = '\r';
+        line[len++] = '\n';
+        Serial.write((const uint8_t*)line, len);
+    }
+}
+
+void TimelineService::streamChunks() {
+    TimelineDump<TIMELINE_EVENTS> dump(timeline, cyclesPerUs);
+    for (uint8_t i = 0; i < CHUNKS_PER_LOOP && _offset < dump.size(); i++) {
+        size_t n = dump.read(_offset, _chunk, sizeof(_chunk));
+        // Retried on the next loop when the MQTT buffer is full
+        if (!_channel.publish(RESPONSE_TOPIC, _chunk, n)) return;
+        _offset += n;
+    }
+    if (_offset >= dump.size()) {
+        _streaming = false;
+        updateFreeze();
+    }
+}
+
+#endif // TIMELINE
@@ -8,11 +8,31 @@
 
 #include <Arduino.h>
 #include <Wire.h>
-#include <DHT_U.h>
-#include <SoftwareSerial.h>
 #include <WiFi.h>
 #include <IotMesurable.h>
+#include "profile.h"
 #include "SensorReader.h"
+#include "Channels.h"
+#include "AdaptiveSampler.h"
+#include "SamplerConfig.h"
+#include "SideChannel.h"
+#include "HistoryService.h"
+#include "ResourceMonitor.h"
+#include "FilterConfig.h"
+#include "DerivedMetrics.h"
+#include "CompareService.h"
+#include "LoopWatchdog.h"
+#include "Timeline.h"
+#include "TimelineService.h"
+#include "I2cDiscovery.h"
+#include "TopicTable.h"
+#include "SampleSink.h"
+#ifdef SERIAL_CSV
+#include "CsvSink.h"
+#endif
+#if SENSOR_I2C_MUX
+#include "MuxSensors.h"
+#endif
 #include "secrets.h"
 
 // Priority logic: if a broker is defined via build flags (-D MQTT_HUB_IP), use it.
@@ -33,54 +53,410 @@
 // Hardware Configuration
 // ============================================================================
 
-#define DHT_TYPE DHT22
 #define MODULE_ID "air-quality-benchmark"
 
 // ============================================================================
 // Global Objects
 // ============================================================================
 
+// Only the buses and drivers of the selected sensor profile exist (profile.h)
+
+#if SENSOR_I2C_SGP_BUS
 // I2C buses
 TwoWire wireSGP = TwoWire(1);
+#endif
 
 // Serial connections
+#if SENSOR_MHZ14A
 HardwareSerial co2Serial(2);   // UART2 for MH-Z14A
+#endif
+#if SENSOR_SPS30
 HardwareSerial sps30Serial(1); // UART1 for SPS30
+#endif
+#if SENSOR_SC16CO
 SoftwareSerial coSerial(PIN_UART_RX_CO_SC16, PIN_UART_TX_CO_SC16);
+#endif
 
-// DHT sensor
-DHT_Unified dht(PIN_DHT, DHT_TYPE);
+#if SENSOR_DHT22
+// DHT sensor (RMT capture, does not block interrupts)
+Dht22Rmt dht(PIN_DHT, RMT_CHANNEL_0);
+#endif
+
+static SensorPorts makeSensorPorts() {
+    SensorPorts ports;
+#if SENSOR_MHZ14A
+    ports.co2Serial = &co2Serial;
+#endif
+#if SENSOR_SPS30
+    ports.sps30Serial = &sps30Serial;
+#endif
+#if SENSOR_DHT22
+    ports.dht = &dht;
+#endif
+#if SENSOR_I2C_SGP_BUS
+    ports.wireSGP = &wireSGP;
+#endif
+#if SENSOR_SC16CO
+    ports.coSerial = &coSerial;
+#endif
+    return ports;
+}
 
 // Sensor reader (low-level hardware access)
-SensorReader sensors(co2Serial, sps30Serial, dht, wireSGP, coSerial);
+SensorReader sensors(makeSensorPorts());
 
 // IotMesurable - handles MQTT, WiFi, status, enable/disable
 IotMesurable brain(MODULE_ID);
 
+// Raw MQTT connection for request/response services (history queries)
+SideChannel sideChannel(MODULE_ID);
+
+// Fixed-memory min/mean/max rollups per channel, served on {moduleId}/history/get
+HistoryService history(sideChannel);
+
+// Bias / RMS / correlation / drift of the redundant sensors on {moduleId}/compare
+CompareService compare(sideChannel);
+
+#ifndef DISABLE_RESOURCE_TELEMETRY
+// Heap / stack / CPU report on {moduleId}/system/resources
+ResourceMonitor resources(sideChannel);
+#endif
+
+// Loop stage budgets, task watchdog and RTC stall record ({moduleId}/system/stages)
+#ifndef LOOP_WDT_TIMEOUT_S
+#define LOOP_WDT_TIMEOUT_S 8
+#endif
+LoopWatchdog loopWatch(sideChannel, LOOP_WDT_TIMEOUT_S);
+
+#ifdef TIMELINE
+// Cycle-stamped spans of the loop, dumped on serial 'T' or {moduleId}/timeline/get
+// and converted by scripts/timeline_to_chrome.py
+TimelineService timelineService(sideChannel);
+#endif
+
+#define I2C_DISCOVERY (SENSOR_I2C_MAIN_BUS || SENSOR_I2C_SGP_BUS)
+#if I2C_DISCOVERY
+// Hot-plug discovery: a few probes per bus and round, appeared sensors are
+// initialised and registered, unplugged ones retired
+I2cDiscovery discovery(HARDWARE_COMPILED);
+unsigned long lastDiscovery = 0;
+const unsigned long DISCOVERY_INTERVAL = 1000;
+const uint32_t DISCOVERY_BUDGET_US = 1000;  // Bus time per bus and round
+#endif
+bool hardwareRegistered[HW_COUNT] = {};
+
+#if SENSOR_I2C_MUX
+// Identical sensors behind the TCA9548A (0x70) of the SGP bus, each published
+// as its own hardware: {kind}-{bus}{channel}-{address}, e.g. sht31-s2-44.
+// Declare the SHT31 of a channel before its SGP40: the SGP40 is compensated
+// with it. Addresses used behind the multiplexer must not be fitted directly
+// on the same bus (both would answer while the channel is selected)
+const MuxSensorSpec MUX_SENSORS[] = {
+    { MUX_SHT31, BUS_I2C_SGP, 0, 0x44 },
+    { MUX_SGP40, BUS_I2C_SGP, 0, 0x59 },
+    { MUX_SHT31, BUS_I2C_SGP, 1, 0x44 },
+    { MUX_SGP40, BUS_I2C_SGP, 1, 0x59 },
+    { MUX_SHT31, BUS_I2C_SGP, 2, 0x44 },
+    { MUX_SGP40, BUS_I2C_SGP, 2, 0x59 },
+    { MUX_SHT31, BUS_I2C_SGP, 3, 0x44 },
+    { MUX_SGP40, BUS_I2C_SGP, 3, 0x59 },
+};
+const uint8_t MUX_SENSOR_COUNT = sizeof(MUX_SENSORS) / sizeof(MUX_SENSORS[0]);
+MuxSensors muxSensors(Wire, wireSGP);
+bool muxReady = false;
+bool muxRegistered[MuxReadPlan::MAX_INSTANCES] = {};
+unsigned long lastMuxCycle = 0;
+const unsigned long MUX_CYCLE_INTERVAL = 2000;     // Cycle start; its channel groups are read one per loop pass
+#endif
+
+#ifdef BUS_TRACE
+// Raw bus traffic streamed in chunks on {moduleId}/trace, replayed on the host
+// by test/native/test_bus_replay
+static uint8_t busTraceBuffer[2048];
+BusTraceWriter busTrace(busTraceBuffer, sizeof(busTraceBuffer),
+    [](const uint8_t* data, size_t len, void*) { return sideChannel.publish("trace", data, len); });
+unsigned long lastTraceFlush = 0;
+const unsigned long TRACE_FLUSH_INTERVAL = 5000;
+#endif
+
 // ============================================================================
 // Timing
 // ============================================================================
 
-// Read sensors every 5 seconds, automatic throttling controls publish rate
-unsigned long lastRead = 0;
-const unsigned long READ_INTERVAL = 5000;
+// Each hardware is sampled on its own adaptive schedule: fast while its signal
+// moves, backing off to the floor interval when flat. Reads faster than the
+// floor share a global bus-time budget so the buses cannot be saturated.
+const uint32_t BUS_BUDGET_MS_PER_SEC = 250;
+AdaptiveSampler<HW_COUNT> sampler(BUS_BUDGET_MS_PER_SEC);     // Configured from SAMPLER_CONFIG
+
+// Current per-hardware sampling rate is published under the "sampler" hardware
+unsigned long lastRatePublish = 0;
+#if SENSOR_DHT22
+uint32_t dhtStartUs = 0;    // CPU cost of the pending DHT22 start (sampler bus budget)
+#endif
+#if SENSOR_SPS30
+uint32_t sps30StartUs = 0;  // Same for the pending SPS30 read
+#endif
+const unsigned long RATE_PUBLISH_INTERVAL = 30000;
+
+// ============================================================================
+// Filtering
+// ============================================================================
+
+// Per-channel chains (Hampel, slope limiter, EMA) configured by FILTER_CONFIG
+// (FilterConfig.h)
+ChannelFilter filters[CH_COUNT];
+
+// ============================================================================
+// Derived Metrics
+// ============================================================================
+
+// Station altitude for the sea-level pressure (-D SITE_ALTITUDE_M=...)
+#ifndef SITE_ALTITUDE_M
+  #define SITE_ALTITUDE_M 0
+#endif
+
+// Dew point, absolute humidity, pressure compensation and PM NowCast/AQI,
+// computed from the filtered values and published under the "derived" hardware
+DerivedMetrics derived(SITE_ALTITUDE_M);
+bool derivedEnabled[DM_COUNT];
+unsigned long lastDerivedPublish = 0;
+const unsigned long DERIVED_MIN_INTERVAL = 5000;
+#if SENSOR_SGP30
+float sgp30Humidity = NAN;     // Last absolute humidity sent to the SGP30 (g/m³)
+#endif
+
+// ============================================================================
+// Publish Topics
+// ============================================================================
+
+// Every {moduleId}/{hardwareId}/{measurement} topic is interned at registration
+// (TopicTable.h): samples carry a one-byte handle, and the outputs that render
+// their own payloads (CSV, -D SIDE_CHANNEL_MEASUREMENTS) do so at the channel
+// precision without building, printf-formatting or allocating a string
+#if SENSOR_I2C_MUX
+const uint8_t MUX_TOPICS = MuxReadPlan::MAX_INSTANCES * MUX_MAX_MEASUREMENTS;
+uint8_t muxTopic[MUX_TOPICS];   // [instance * MUX_MAX_MEASUREMENTS + measurement]
+#else
+const uint8_t MUX_TOPICS = 0;
+#endif
+typedef TopicTable<CH_COUNT + HW_COUNT + DM_COUNT + MUX_TOPICS, 1536 + MUX_TOPICS * 48> PublishTopics;
+PublishTopics topics;
+uint8_t channelTopic[CH_COUNT];
+uint8_t samplerTopic[HW_COUNT];
+uint8_t derivedTopic[DM_COUNT];
+const uint8_t SAMPLER_DECIMALS = 2;     // Hz
+
+// ============================================================================
+// Output Sinks
+// ============================================================================
+
+// The values published during a loop pass are collected once into a shared,
+// read-only SampleSet, handed to every output at the end of the pass; each
+// one encodes it in its own format, on its own schedule (SampleSink.h). An
+// extra output costs no sensor read and no copy of the values.
+
+/**
+ * @brief MQTT output: every value through brain.publish(), sent in the pass
+ * it was read.
+ *
+ * With -D SIDE_CHANNEL_MEASUREMENTS, values go on their interned topic with
+ * a printf-free payload over the side connection instead (other client ID
+ * and session, QoS 0, no IotMesurable throttling), brain.publish() only
+ * taking over while it is down.
+ */
+class MqttSink : public SampleSink {
+public:
+    MqttSink() : SampleSink(1, SINK_DROP_OLDEST, 0) {}
+
+protected:
+    uint8_t consume(const SampleSet& set, uint8_t from, uint32_t) override {
+        for (uint8_t i = from; i < set.size(); i++) {
+            TL_SCOPE(TL_PUBLISH);
+            const Sample& s = set[i];
+#ifdef SIDE_CHANNEL_MEASUREMENTS
+            char payload[FIXED_MAX_CHARS];
+            size_t len = topics.render(s.topic, s.value, payload, sizeof(payload));
+            if (len > 0 && sideChannel.publishTopic(topics.topic(s.topic), payload, len)) continue;
+#endif
+
+            char hardwareId[24];
+            size_t n = topics.hardwareIdLength(s.topic);
+            if (n >= sizeof(hardwareId)) continue;
+            memcpy(hardwareId, topics.label(s.topic), n);
+            hardwareId[n] = '\0';
+            brain.publish(hardwareId, topics.measurement(s.topic), s.value);
+        }
+        return set.size();
+    }
+};
+MqttSink mqttSink;
+
+#ifdef SERIAL_CSV
+// time_ms,hardware,measurement,value lines on the USB serial port, written
+// only while the UART buffer has room (CsvSink.h)
+CsvSink<PublishTopics> csvSink(topics,
+    [](const char* data, size_t len, void*) { Serial.write((const uint8_t*)data, len); },
+    [](void*) -> size_t { return Serial.availableForWrite(); });
+#endif
+
+// Pool: the set being filled + the MQTT queue (1) + the CSV queue (4)
+SampleFanout<2, 6> outputs;
+
+// ============================================================================
+// Logging Helper
+// ============================================================================
+
+void logError(const char* msg) {
+    // Log to Serial
+    Serial.printf("[ERROR] %s\n", msg);
+    
+    // Log to MQTT via brain
+    brain.log("error", msg);
+}
 
 // ============================================================================
 // Setup
 // ============================================================================
 
+/**
+ * @brief Runs one sensor init and reports how long its probe took. A hardware
+ * quarantined after a watchdog reset is not initialised.
+ */
+static bool timedInit(const char* name, HardwareSlot hw, bool (*init)()) {
+    if (!loopWatch.enter(readStage(hw))) {
+        Serial.printf(" - %s SKIPPED (quarantined after a stall)\n", name);
+        return false;
+    }
+    unsigned long start = millis();
+    bool ok = init();
+    loopWatch.leave(false);
+    Serial.printf(" - %s %s (%lu ms)\n", name, ok ? "OK" : "FAILED", millis() - start);
+    return ok;
+}
+
+/**
+ * @brief Registers a hardware and its measurements with the brain, once.
+ */
+static void registerHardware(HardwareSlot hw) {
+    if (hardwareRegistered[hw]) return;
+    hardwareRegistered[hw] = true;
+    brain.registerHardware(HARDWARE_TABLE[hw].id, HARDWARE_TABLE[hw].name);
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++) {
+        if (CHANNEL_TABLE[ch].hw == hw) {
+            brain.addSensor(HARDWARE_TABLE[hw].id, CHANNEL_TABLE[ch].measurement);
+            channelTopic[ch] = topics.intern(MODULE_ID, HARDWARE_TABLE[hw].id, CHANNEL_TABLE[ch].measurement,
+                                             CHANNEL_TABLE[ch].decimals);
+        }
+    }
+}
+
+#if SENSOR_I2C_MUX
+/**
+ * @brief Registers a multiplexed instance and its measurements, once.
+ */
+static void registerMuxInstance(uint8_t i) {
+    if (muxRegistered[i]) return;
+    muxRegistered[i] = true;
+    const MuxKindInfo& kind = MUX_KIND_TABLE[MUX_SENSORS[i].kind];
+    const char* id = muxSensors.hardwareId(i);
+    brain.registerHardware(id, kind.name);
+    for (uint8_t m = 0; m < kind.measurementCount; m++) {
+        brain.addSensor(id, kind.measurement[m]);
+        muxTopic[i * MUX_MAX_MEASUREMENTS + m] = topics.intern(MODULE_ID, id, kind.measurement[m], kind.decimals[m]);
+    }
+}
+
+/**
+ * @brief Multiplexed instance with hardware ID id, MUX_SENSOR_COUNT if none.
+ */
+static uint8_t muxInstance(const char* id) {
+    uint8_t i = 0;
+    while (i < MUX_SENSOR_COUNT && strcmp(id, muxSensors.hardwareId(i)) != 0) i++;
+    return i;
+}
+#endif
+
+/**
+ * @brief Records whether an I2C sensor answered its init: registered if so,
+ * left to the hot-plug discovery otherwise.
+ */
+static void i2cInitResult(HardwareSlot hw, bool ok) {
+#if I2C_DISCOVERY
+    discovery.setPresent(hw, ok);
+#endif
+    if (ok) registerHardware(hw);
+}
+
+/**
+ * @brief Runs the init sequence of a compiled hardware again (brain reset
+ * request).
+ */
+static bool resetHardware(HardwareSlot hw) {
+    switch (hw) {
+#if SENSOR_MHZ14A
+        case HW_MHZ14A:
+            // MH-Z14A has no init sequence: flush the UART buffer
+            sensors.resetCO2();
+            return true;
+#endif
+#if SENSOR_DHT22
+        case HW_DHT22:
+            sensors.resetDHT();
+            return true;
+#endif
+#if SENSOR_SGP40
+        case HW_SGP40: return sensors.initSGP();
+#endif
+#if SENSOR_SGP30
+        case HW_SGP30: {
+            bool ok = sensors.initSGP30();
+            sgp30Humidity = NAN;    // IAQinit clears the humidity compensation
+            return ok;
+        }
+#endif
+#if SENSOR_SPS30
+        case HW_SPS30: return sensors.initSPS30();
+#endif
+#if SENSOR_BMP280
+        case HW_BMP280: return sensors.initBMP();
+#endif
+#if SENSOR_SHT31
+        case HW_SHT31: return sensors.initSHT();
+#endif
+#if SENSOR_SC16CO
+        case HW_SC16CO: return sensors.initCO();
+#endif
+        default: return false;
+    }
+}
+
 void setup() {
+    unsigned long bootStart = millis();
     Serial.begin(115200);
     Serial.println("\n=== Air Quality Monitor (iot-mesurable) ===\n");
+    Serial.printf("Sensor profile: %s\n", PROFILE_NAME);
+    loopWatch.begin();
+    if (*loopWatch.bootReport()) Serial.println(loopWatch.bootReport());
     
     // Initialize I2C
+#if SENSOR_I2C_MAIN_BUS
     Wire.begin(PIN_I2C_SDA_MAIN, PIN_I2C_SCL_MAIN);
+#endif
+#if SENSOR_I2C_SGP_BUS
     wireSGP.begin(PIN_I2C_SDA_SGP, PIN_I2C_SCL_SGP); // SGP bus
+#endif
     
     // Initialize serial ports
+#if SENSOR_MHZ14A
     co2Serial.begin(9600, SERIAL_8N1, PIN_UART_RX_CO2, PIN_UART_TX_CO2);  // MH-Z14A
+#endif
+#if SENSOR_SPS30
     sps30Serial.begin(115200, SERIAL_8N1, PIN_UART_RX_SPS30, PIN_UART_TX_SPS30); // SPS30
+#endif
+#if SENSOR_SC16CO
     coSerial.begin(9600);
+#endif
     
     // Initialize brain (WiFi + MQTT)
     Serial.print("Connecting WiFi/MQTT...");
@@ -91,82 +467,96 @@ void setup() {
         Serial.println(" OK");
     }
     
-    // Register all hardware and sensors
+    // Register hardware and sensors (Channels.h). I2C sensors are registered
+    // once they answer: at init below, or later through hot-plug discovery
+    memset(channelTopic, topics.NONE, sizeof(channelTopic));
+    memset(samplerTopic, topics.NONE, sizeof(samplerTopic));
+    memset(derivedTopic, topics.NONE, sizeof(derivedTopic));
+#if SENSOR_I2C_MUX
+    memset(muxTopic, topics.NONE, sizeof(muxTopic));
+#endif
     brain.setModuleType("air-quality-bench");
-    brain.registerHardware("mhz14a", "MH-Z14A CO2 Sensor");
-    brain.addSensor("mhz14a", "co2");
-    
-    brain.registerHardware("dht22", "DHT22 Temp/Humidity");
-    brain.addSensor("dht22", "temperature");
-    brain.addSensor("dht22", "humidity");
-    
-    brain.registerHardware("sgp40", "SGP40 VOC Sensor");
-    brain.addSensor("sgp40", "voc");
+    for (uint8_t hw = 0; hw < HW_COUNT; hw++) {
+        if (!HARDWARE_COMPILED[hw] || isI2cHardware(hw)) continue;
+        registerHardware((HardwareSlot)hw);
+    }
     
-    brain.registerHardware("sgp30", "SGP30 eCO2/TVOC");
-    brain.addSensor("sgp30", "eco2");
-    brain.addSensor("sgp30", "tvoc");
+    brain.registerHardware("sampler", "Adaptive Sampling Rate (Hz)");
+    for (uint8_t i = 0; i < HW_COUNT; i++) {
+        if (!HARDWARE_COMPILED[i]) continue;
+        brain.addSensor("sampler", HARDWARE_TABLE[i].id);
+        samplerTopic[i] = topics.intern(MODULE_ID, "sampler", HARDWARE_TABLE[i].id, SAMPLER_DECIMALS);
+        sampler.configure(i, SAMPLER_CONFIG[i]);
+    }
     
-    brain.registerHardware("sps30", "SPS30 Particulate");
-    brain.addSensor("sps30", "pm1");
-    brain.addSensor("sps30", "pm25");
-    brain.addSensor("sps30", "pm4");
-    brain.addSensor("sps30", "pm10");
+    brain.registerHardware("derived", "Derived Metrics");
+    for (uint8_t i = 0; i < DM_COUNT; i++) {
+        derivedEnabled[i] = derivedAvailable(i, HARDWARE_COMPILED);
+        if (!derivedEnabled[i]) continue;
+        brain.addSensor("derived", DERIVED_TABLE[i].measurement);
+        derivedTopic[i] = topics.intern(MODULE_ID, "derived", DERIVED_TABLE[i].measurement,
+                                        DERIVED_TABLE[i].decimals);
+    }
     
-    brain.registerHardware("bmp280", "BMP280 Pressure");
-    brain.addSensor("bmp280", "pressure");
-    brain.addSensor("bmp280", "temperature");
+    outputs.attach(&mqttSink);
+#ifdef SERIAL_CSV
+    outputs.attach(&csvSink);
+#endif
     
-    brain.registerHardware("sht31", "SHT31 Temp/Humidity");
-    brain.addSensor("sht31", "temperature");
-    brain.addSensor("sht31", "humidity");
+    for (uint8_t i = 0; i < CH_COUNT; i++) {
+        filters[i] = makeChannelFilter(FILTER_CONFIG[i]);
+    }
     
-    brain.registerHardware("sc16co", "SC16-CO Carbon Monoxide");
-    brain.addSensor("sc16co", "co");
+    // History queries over the side channel
+    sideChannel.begin(REAL_MQTT_SERVER, 1883);
+    sideChannel.onMessage([](const char* suffix, const uint8_t* payload, size_t len) {
+        if (strcmp(suffix, HistoryService::REQUEST_TOPIC) == 0) {
+            history.handleRequest(payload, len);
+        }
+#ifdef TIMELINE
+        else if (strcmp(suffix, TimelineService::REQUEST_TOPIC) == 0) {
+            timelineService.handleRequest();
+        }
+#endif
+    });
+    history.begin();
+#ifdef TIMELINE
+    timelineService.begin();
+#endif
     
     // Callbacks for debugging (throttling is automatic, no manual interval management needed)
 
     brain.onConnect([](bool connected) {
+        TL_SCOPE(TL_BRAIN_CONNECT);
         Serial.printf("[MQTT] %s\n", connected ? "Connected" : "Disconnected");
     });
     
     brain.onResetChange([](const char* hw) {
+        TL_SCOPE(TL_BRAIN_RESET);
         Serial.printf("[Reset] Request for: %s\n", hw);
         brain.log("info", "Reset request received");
         
+        // A reset also lifts the stage backoff / disable / quarantine
+        uint8_t slot = HW_COUNT;
+        for (uint8_t i = 0; i < HW_COUNT; i++) {
+            if (strcmp(hw, HARDWARE_TABLE[i].id) == 0) {
+                loopWatch.clear((HardwareSlot)i);
+                slot = i;
+            }
+        }
+        
         bool success = false;
         
-        if (strcmp(hw, "mhz14a") == 0) {
-            // MH-Z14A doesn't have a specific init, but we can try to re-setup serial or similar if needed.
-            // For now, re-init isn't explicitly exposed in SensorReader for CO2, 
-            // but we can add resetCO2 if we want to be thorough.
-            // Let's rely on what's available. 
-            // SensorReader has resetCO2() (void).
-            sensors.resetCO2();
-            success = true;
-        }
-        else if (strcmp(hw, "dht22") == 0) {
-           sensors.resetDHT();
-           success = true;
-        }
-        else if (strcmp(hw, "sgp40") == 0) {
-            success = sensors.initSGP();
-        }
-        else if (strcmp(hw, "sgp30") == 0) {
-            success = sensors.initSGP30();
-        }
-        else if (strcmp(hw, "sps30") == 0) {
-            success = sensors.initSPS30();
+        if (slot < HW_COUNT && HARDWARE_COMPILED[slot]) {
+            success = resetHardware((HardwareSlot)slot);
         }
-        else if (strcmp(hw, "bmp280") == 0) {
-            success = sensors.initBMP();
-        }
-        else if (strcmp(hw, "sht31") == 0) {
-            success = sensors.initSHT();
-        }
-        else if (strcmp(hw, "sc16co") == 0) {
-            success = sensors.initCO();
+#if SENSOR_I2C_MUX
+        else if (muxReady && muxInstance(hw) < MUX_SENSOR_COUNT) {
+            // Initialised again by its next group read
+            muxSensors.retry(muxInstance(hw));
+            success = true;
         }
+#endif
         else {
              char msg[64];
              snprintf(msg, sizeof(msg), "Unknown hardware: %s", hw);
@@ -174,6 +564,8 @@ void setup() {
              return;
         }
         
+        if (slot < HW_COUNT && isI2cHardware(slot)) i2cInitResult((HardwareSlot)slot, success);
+        
         if (success) {
             char msg[64];
             snprintf(msg, sizeof(msg), "Hardware reset: %s", hw);
@@ -185,122 +577,482 @@ void setup() {
         }
     });
     
-    // Initialize sensors
+    // Initialize sensors (watched: a hanging init is attributed after the reset)
+    loopWatch.arm();
     Serial.println("Initializing sensors...");
-    dht.begin();
-    if (sensors.initBMP()) Serial.println(" - BMP280 OK");
-    if (sensors.initSGP()) Serial.println(" - SGP40 OK");
-    if (sensors.initSGP30()) Serial.println(" - SGP30 OK");
-    if (sensors.initSPS30()) Serial.println(" - SPS30 OK");
-    if (sensors.initSHT()) Serial.println(" - SHT31 OK");
-    if (sensors.initCO()) Serial.println(" - SC16-CO OK");
+#ifdef BUS_TRACE
+    sensors.setTrace(&busTrace);
+#endif
+    unsigned long initStart = millis();
+#if SENSOR_DHT22
+    timedInit("DHT22", HW_DHT22, []() { return dht.begin(); });
+#endif
+#if SENSOR_BMP280
+    i2cInitResult(HW_BMP280, timedInit("BMP280", HW_BMP280, []() { return sensors.initBMP(); }));
+#endif
+#if SENSOR_SGP40
+    i2cInitResult(HW_SGP40, timedInit("SGP40", HW_SGP40, []() { return sensors.initSGP(); }));
+#endif
+#if SENSOR_SGP30
+    i2cInitResult(HW_SGP30, timedInit("SGP30", HW_SGP30, []() { return sensors.initSGP30(); }));
+#endif
+#if SENSOR_SPS30
+    timedInit("SPS30", HW_SPS30, []() { return sensors.initSPS30(); });
+#endif
+#if SENSOR_SHT31
+    i2cInitResult(HW_SHT31, timedInit("SHT31", HW_SHT31, []() { return sensors.initSHT(); }));
+#endif
+#if SENSOR_SC16CO
+    timedInit("SC16-CO", HW_SC16CO, []() { return sensors.initCO(); });
+#endif
+#if SENSOR_I2C_MUX
+    // Instances are initialised and registered by their first group read
+    MuxPlanError muxError = muxSensors.begin(MUX_SENSORS, MUX_SENSOR_COUNT);
+    if (muxError == MUX_PLAN_OK) {
+        muxReady = true;
+        Serial.printf(" - Mux: %u sensors, %u channel selections per cycle (%u in declaration order)\n",
+                      MUX_SENSOR_COUNT, muxSensors.plan().switchesPerCycle(),
+                      muxSwitches(MUX_SENSORS, nullptr, MUX_SENSOR_COUNT));
+    } else {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "MUX_SENSORS rejected (error %u): multiplexed sensors disabled", muxError);
+        logError(msg);
+    }
+#endif
     
-    brain.log("info", "Module booted and connected");
+    char bootMsg[96];
+    snprintf(bootMsg, sizeof(bootMsg), "Module booted (profile %s): sensor init %lu ms, setup %lu ms",
+             PROFILE_NAME, millis() - initStart, millis() - bootStart);
+    brain.log("info", bootMsg);
+    Serial.println(bootMsg);
+    if (*loopWatch.bootReport()) brain.log("warn", loopWatch.bootReport());
     Serial.println("Setup complete!");
 }
 
 
 
 // ============================================================================
-// Logging Helper
+// Loop
 // ============================================================================
 
-void logError(const char* msg) {
-    // Log to Serial
-    Serial.printf("[ERROR] %s\n", msg);
+/**
+ * @brief Adds one value to the sample set of the pass, sent to the outputs
+ * at its end. A value whose topic could not be interned is published at once
+ * by brain.publish().
+ */
+static void publishValue(uint8_t topic, const char* hardwareId, const char* measurement, float value,
+                         unsigned long now) {
+    if (topic == topics.NONE) {
+        TL_SCOPE(TL_PUBLISH);
+        brain.publish(hardwareId, measurement, value);
+        return;
+    }
+    outputs.add(topic, value, now);
+}
+
+/**
+ * @brief Filters one measurement, then publishes it and records it in the
+ * history rollups. Samples dropped by the filter chain are not published.
+ */
+static void publishChannel(Channel ch, float value, unsigned long now) {
+    if (!filters[ch].apply(value, now)) return;
+    publishValue(channelTopic[ch], HARDWARE_TABLE[CHANNEL_TABLE[ch].hw].id, CHANNEL_TABLE[ch].measurement, value, now);
+    history.add(ch, value, now);
+    derived.observe(ch, value, now);
+    compare.observe(ch, value, now);
+}
+
+/**
+ * @brief Recomputes the derived metrics once when an input changed, publishes
+ * them, and forwards absolute humidity to the SGP30 compensation.
+ */
+static void publishDerived(unsigned long now) {
+    if (!derived.dirty() || now - lastDerivedPublish < DERIVED_MIN_INTERVAL) return;
+    lastDerivedPublish = now;
     
-    // Log to MQTT via brain
-    brain.log("error", msg);
+    float values[DM_COUNT];
+    derived.compute(now, values);
+    // Checked here since the side-channel path and the CSV output do not go
+    // through the brain
+    bool enabled = brain.isHardwareEnabled("derived");
+    for (uint8_t i = 0; i < DM_COUNT; i++) {
+        if (enabled && derivedEnabled[i] && !isnan(values[i])) {
+            publishValue(derivedTopic[i], "derived", DERIVED_TABLE[i].measurement, values[i], now);
+        }
+    }
+    
+#if SENSOR_SGP30
+    // Only rewrite the compensation when it moved by more than 0.1 g/m³
+    float ah = values[DM_ABS_HUMIDITY];
+    if (!isnan(ah) && (isnan(sgp30Humidity) || fabsf(ah - sgp30Humidity) > 0.1f)) {
+        if (sensors.setSGP30Humidity(ah)) sgp30Humidity = ah;
+    }
+#endif
 }
 
-// ============================================================================
-// Loop
-// ============================================================================
+/**
+ * @brief True when the hardware is enabled and its adaptive schedule is due.
+ */
+static bool isReadDue(HardwareSlot hw, unsigned long now) {
+#if I2C_DISCOVERY
+    // Not fitted, or unplugged: left to the discovery
+    if (isI2cHardware(hw) && !discovery.present(hw)) return false;
+#endif
+    if (!brain.isHardwareEnabled(HARDWARE_TABLE[hw].id) || !sampler.isDue(hw, now)) return false;
+    // Starts the read stage, refused while the hardware is backed off after overruns
+    if (!loopWatch.enter(readStage(hw))) return false;
+    sensors.traceCycle(hw);
+    return true;
+}
+
+#if I2C_DISCOVERY
+/**
+ * @brief Initialises a sensor that appeared on its bus (one attempt, no retry
+ * delays) and registers it.
+ */
+static void hotplugInit(HardwareSlot hw, unsigned long now) {
+    TL_SCOPE(TL_HOTPLUG);
+    char msg[96];
+    // A hardware quarantined by the watchdog stays off until a reset command
+    bool ok = false;
+    if (loopWatch.allowed(readStage(hw), now)) {
+        switch (hw) {
+#if SENSOR_BMP280
+            case HW_BMP280: ok = sensors.initBMP(1, 0); break;
+#endif
+#if SENSOR_SGP40
+            case HW_SGP40: ok = sensors.initSGP(1, 0); break;
+#endif
+#if SENSOR_SGP30
+            case HW_SGP30:
+                ok = sensors.initSGP30(1, 0);
+                sgp30Humidity = NAN;
+                break;
+#endif
+#if SENSOR_SHT31
+            case HW_SHT31: ok = sensors.initSHT(1, 0); break;
+#endif
+            default: break;
+        }
+    }
+    if (!ok) {
+        discovery.initFailed(hw);
+        snprintf(msg, sizeof(msg), "Sensor %s detected but not initialised: retrying in %lu s",
+                 HARDWARE_TABLE[hw].id, I2cDiscovery::INIT_HOLDOFF * DISCOVERY_INTERVAL / 1000);
+        brain.log("warn", msg);
+        return;
+    }
+    registerHardware(hw);
+    snprintf(msg, sizeof(msg), "Sensor %s plugged in: initialised and registered", HARDWARE_TABLE[hw].id);
+    Serial.println(msg);
+    brain.log("info", msg);
+}
+
+/**
+ * @brief Runs the discovery round of a bus within its bus-time budget (an
+ * unfinished round resumes on the next one).
+ */
+static void discoverBus(BusId bus, unsigned long now) {
+    uint32_t start = micros();
+    uint8_t address;
+    char msg[96];
+    while (micros() - start < DISCOVERY_BUDGET_US && discovery.nextProbe(bus, address)) {
+        uint8_t hw;
+        DiscoveryEvent event = discovery.report(bus, address, sensors.probeI2C(bus, address), hw);
+        if (event == DISCOVERY_APPEARED) {
+            hotplugInit((HardwareSlot)hw, now);
+        } else if (event == DISCOVERY_LOST) {
+            snprintf(msg, sizeof(msg), "Sensor %s unplugged: retired", HARDWARE_TABLE[hw].id);
+            Serial.println(msg);
+            brain.log("warn", msg);
+        } else if (event == DISCOVERY_UNKNOWN) {
+#if SENSOR_I2C_MUX
+            if (address == TCA9548A_ADDRESS) continue;
+#endif
+            snprintf(msg, sizeof(msg), "Unknown I2C device 0x%02X on the %s bus", address,
+                     bus == BUS_I2C_MAIN ? "main" : "SGP");
+            brain.log("info", msg);
+        } else if (event == DISCOVERY_BUS_FAULT) {
+            snprintf(msg, sizeof(msg), "I2C %s bus not responding: discovery paused for %u rounds",
+                     bus == BUS_I2C_MAIN ? "main" : "SGP", discovery.backoff(bus));
+            brain.log("warn", msg);
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Ends the current loop stage and logs the watchdog escalation steps.
+ */
+static void endStage() {
+    uint8_t stage = loopWatch.current();
+    StageAction action = loopWatch.leave();
+    if (action < STAGE_BACKOFF) return;
+    char msg[96];
+    if (action == STAGE_BACKOFF) {
+        snprintf(msg, sizeof(msg), "Stage %s over its %u ms budget %u times in a row: skipped for %lu s",
+                 stageName(stage), STAGE_BUDGET_MS[stage], StageBudget::BACKOFF_AFTER,
+                 (unsigned long)(StageBudget::BACKOFF_MS / 1000));
+        brain.log("warn", msg);
+    } else {
+        snprintf(msg, sizeof(msg), "Stage %s keeps overrunning its %u ms budget: disabled until reset",
+                 stageName(stage), STAGE_BUDGET_MS[stage]);
+        logError(msg);
+    }
+}
+
+#if SENSOR_I2C_MUX
+/**
+ * @brief Starts a cycle of the multiplexed sensors every MUX_CYCLE_INTERVAL
+ * and reads one channel group per loop pass. Each instance is published on
+ * its own topics (no filter chain, history or comparison: those are per
+ * Channel).
+ */
+static void readMux(unsigned long now) {
+    if (!muxSensors.busy()) {
+        if (now - lastMuxCycle < MUX_CYCLE_INTERVAL) return;
+        lastMuxCycle = now;
+        muxSensors.startCycle();
+    }
+    if (!loopWatch.enter(STAGE_MUX)) return;
+    MuxResult results[MuxReadPlan::MAX_INSTANCES];
+    uint8_t n = muxSensors.readGroup(results);
+    char msg[96];
+    for (uint8_t k = 0; k < n; k++) {
+        const MuxResult& r = results[k];
+        const char* id = muxSensors.hardwareId(r.instance);
+        if (r.event == MUX_APPEARED) {
+            registerMuxInstance(r.instance);
+            snprintf(msg, sizeof(msg), "Sensor %s answered: initialised and registered", id);
+            Serial.println(msg);
+            brain.log("info", msg);
+        } else if (r.event == MUX_LOST) {
+            snprintf(msg, sizeof(msg), "Sensor %s stopped answering: retired", id);
+            Serial.println(msg);
+            brain.log("warn", msg);
+        }
+        if ((r.event != MUX_SAMPLE && r.event != MUX_APPEARED) || !brain.isHardwareEnabled(id)) continue;
+        const MuxKindInfo& kind = MUX_KIND_TABLE[MUX_SENSORS[r.instance].kind];
+        for (uint8_t m = 0; m < kind.measurementCount; m++) {
+            if (isnan(r.values[m])) continue;
+            publishValue(muxTopic[r.instance * MUX_MAX_MEASUREMENTS + m], id, kind.measurement[m], r.values[m],
+                         now);
+        }
+    }
+    endStage();
+}
+#endif
 
 void loop() {
+    // Idle iterations are left out, like idle stages (LoopWatchdog::TIMELINE_MIN_US)
+    TL_SCOPE_MIN(TL_LOOP, LoopWatchdog::TIMELINE_MIN_US);
+    loopWatch.enter(STAGE_BRAIN_LOOP);
     brain.loop();
+    endStage();
+    loopWatch.enter(STAGE_SIDE_CHANNEL);
+    sideChannel.loop();
+    endStage();
     
     unsigned long now = millis();
+    loopWatch.enter(STAGE_SERVICES);
+    history.loop(now);
+    compare.loop(now);
+    loopWatch.loop(now);
+#ifdef TIMELINE
+    timelineService.loop(now);
+#endif
+#ifndef DISABLE_RESOURCE_TELEMETRY
+    resources.tick();
+    resources.loop(now);
+#endif
+#ifdef BUS_TRACE
+    if (sideChannel.connected() && now - lastTraceFlush >= TRACE_FLUSH_INTERVAL) {
+        lastTraceFlush = now;
+        busTrace.flush();
+    }
+#endif
+    endStage();
     
-    // Read all sensors every READ_INTERVAL, throttling controls publish rate
-    if (now - lastRead >= READ_INTERVAL) {
-        lastRead = now;
-        Serial.printf("[DEBUG] Reading sensors at %lu ms\n", now);
-        
-        // MH-Z14A (CO2)
-        if (brain.isHardwareEnabled("mhz14a")) {
-            int co2 = sensors.readCO2();
-            if (co2 > 0) {
-                Serial.printf("[PUBLISH] mhz14a CO2=%d\n", co2);
-                brain.publish("mhz14a", "co2", co2);
-            }
+#if I2C_DISCOVERY
+    if (now - lastDiscovery >= DISCOVERY_INTERVAL) {
+        lastDiscovery = now;
+        loopWatch.enter(STAGE_DISCOVERY);
+#if SENSOR_I2C_MAIN_BUS
+        discoverBus(BUS_I2C_MAIN, now);
+#endif
+#if SENSOR_I2C_SGP_BUS
+#if SENSOR_I2C_MUX
+        // Only the devices fitted directly on the bus are discovered
+        if (muxReady) muxSensors.release();
+#endif
+        discoverBus(BUS_I2C_SGP, now);
+#endif
+        endStage();
+    }
+#endif
+    uint32_t t0;
+    
+#if SENSOR_MHZ14A
+    // MH-Z14A (CO2)
+    if (isReadDue(HW_MHZ14A, now)) {
+        t0 = micros();
+        int co2 = sensors.readCO2();
+        if (co2 > 0) {
+            sampler.record(HW_MHZ14A, now, co2, micros() - t0);
+            publishChannel(CH_MHZ14A_CO2, co2, now);
+        } else {
+            sampler.recordFailure(HW_MHZ14A, now, micros() - t0);
         }
-        
-        // DHT22 (Temp/Humidity)
-        if (brain.isHardwareEnabled("dht22")) {
-            DhtReading reading = sensors.readDhtSensors();
-            if (reading.valid) {
-                brain.publish("dht22", "temperature", reading.temperature);
-                brain.publish("dht22", "humidity", reading.humidity);
-            }
+        endStage();
+    }
+#endif
+    
+#if SENSOR_DHT22
+    // DHT22 (Temp/Humidity): started on schedule, captured by the RMT in the
+    // background, published once decoded on a later loop
+    if (!sensors.isDhtBusy() && isReadDue(HW_DHT22, now)) {
+        t0 = micros();
+        if (sensors.startDhtRead()) dhtStartUs = micros() - t0;
+        endStage();
+    }
+    DhtReading reading;
+    t0 = micros();
+    if (sensors.pollDht(reading)) {
+        uint32_t busyUs = dhtStartUs + (micros() - t0);
+        if (reading.valid) {
+            sampler.record(HW_DHT22, now, reading.temperature, busyUs);
+            publishChannel(CH_DHT22_TEMPERATURE, reading.temperature, now);
+            publishChannel(CH_DHT22_HUMIDITY, reading.humidity, now);
+        } else {
+            sampler.recordFailure(HW_DHT22, now, busyUs);
         }
-        
-        // SGP40 (VOC)
-        if (brain.isHardwareEnabled("sgp40")) {
-            int voc = sensors.readVocIndex();
-            if (voc >= 0) {
-                brain.publish("sgp40", "voc", voc);
-            }
+    }
+#endif
+    
+#if SENSOR_SGP40
+    // SGP40 (VOC)
+    if (isReadDue(HW_SGP40, now)) {
+        t0 = micros();
+        int voc = sensors.readVocIndex();
+        if (voc >= 0) {
+            sampler.record(HW_SGP40, now, voc, micros() - t0);
+            publishChannel(CH_SGP40_VOC, voc, now);
+        } else {
+            sampler.recordFailure(HW_SGP40, now, micros() - t0);
         }
-        
-        // SGP30 (eCO2/TVOC)
-        if (brain.isHardwareEnabled("sgp30")) {
-            int eco2, tvoc;
-            if (sensors.readSGP30(eco2, tvoc)) {
-                brain.publish("sgp30", "eco2", eco2);
-                brain.publish("sgp30", "tvoc", tvoc);
-            }
+        endStage();
+    }
+#endif
+    
+#if SENSOR_SGP30
+    // SGP30 (eCO2/TVOC)
+    if (isReadDue(HW_SGP30, now)) {
+        t0 = micros();
+        int eco2, tvoc;
+        if (sensors.readSGP30(eco2, tvoc)) {
+            sampler.record(HW_SGP30, now, eco2, micros() - t0);
+            publishChannel(CH_SGP30_ECO2, eco2, now);
+            publishChannel(CH_SGP30_TVOC, tvoc, now);
+        } else {
+            sampler.recordFailure(HW_SGP30, now, micros() - t0);
         }
-        
-        // SPS30 (PM)
-        if (brain.isHardwareEnabled("sps30")) {
-            float pm1, pm25, pm4, pm10;
-            if (sensors.readSPS30(pm1, pm25, pm4, pm10)) {
-                brain.publish("sps30", "pm1", pm1);
-                brain.publish("sps30", "pm25", pm25);
-                brain.publish("sps30", "pm4", pm4);
-                brain.publish("sps30", "pm10", pm10);
-            }
+        endStage();
+    }
+#endif
+    
+#if SENSOR_SPS30
+    // SPS30 (PM): read queued on schedule, the SHDLC answer is decoded from
+    // the UART callback and published on a later loop
+    if (!sensors.isSps30Busy() && isReadDue(HW_SPS30, now)) {
+        t0 = micros();
+        if (sensors.startSPS30Read()) sps30StartUs = micros() - t0;
+        endStage();
+    }
+    Sps30Reading pm;
+    t0 = micros();
+    if (sensors.pollSPS30(pm)) {
+        uint32_t busyUs = sps30StartUs + (micros() - t0);
+        if (pm.valid) {
+            sampler.record(HW_SPS30, now, pm.pm25, busyUs);
+            publishChannel(CH_SPS30_PM1, pm.pm1, now);
+            publishChannel(CH_SPS30_PM25, pm.pm25, now);
+            publishChannel(CH_SPS30_PM4, pm.pm4, now);
+            publishChannel(CH_SPS30_PM10, pm.pm10, now);
+        } else {
+            sampler.recordFailure(HW_SPS30, now, busyUs);
         }
+    }
+#endif
+    
+#if SENSOR_BMP280
+    // BMP280 (Pressure/Temp)
+    if (isReadDue(HW_BMP280, now)) {
+        t0 = micros();
+        float pressure = sensors.readPressure();
+        float temp = sensors.readBMPTemperature();
         
-        // BMP280 (Pressure/Temp)
-        if (brain.isHardwareEnabled("bmp280")) {
-            float pressure = sensors.readPressure();
-            float temp = sensors.readBMPTemperature();
-            
-            if (!isnan(pressure)) {
-                brain.publish("bmp280", "pressure", pressure);
-            }
-            if (!isnan(temp)) {
-                brain.publish("bmp280", "temperature", temp);
-            }
+        if (!isnan(pressure)) {
+            sampler.record(HW_BMP280, now, pressure, micros() - t0);
+            publishChannel(CH_BMP280_PRESSURE, pressure, now);
+        } else {
+            sampler.recordFailure(HW_BMP280, now, micros() - t0);
         }
-        
-        // SHT31 (Temp/Humidity)
-        if (brain.isHardwareEnabled("sht31")) {
-            float temp, hum;
-            if (sensors.readSHT(temp, hum)) {
-                brain.publish("sht31", "temperature", temp);
-                brain.publish("sht31", "humidity", hum);
-            }
+        if (!isnan(temp)) {
+            publishChannel(CH_BMP280_TEMPERATURE, temp, now);
         }
-        
-        // SC16-CO (Carbon Monoxide)
-        if (brain.isHardwareEnabled("sc16co")) {
-            int co = sensors.readCO();
-            if (co >= 0) {
-                brain.publish("sc16co", "co", co);
-            }
+        endStage();
+    }
+#endif
+    
+#if SENSOR_SHT31
+    // SHT31 (Temp/Humidity)
+    if (isReadDue(HW_SHT31, now)) {
+        t0 = micros();
+        float temp, hum;
+        if (sensors.readSHT(temp, hum)) {
+            sampler.record(HW_SHT31, now, temp, micros() - t0);
+            publishChannel(CH_SHT31_TEMPERATURE, temp, now);
+            publishChannel(CH_SHT31_HUMIDITY, hum, now);
+        } else {
+            sampler.recordFailure(HW_SHT31, now, micros() - t0);
+        }
+        endStage();
+    }
+#endif
+    
+#if SENSOR_SC16CO
+    // SC16-CO (Carbon Monoxide)
+    if (isReadDue(HW_SC16CO, now)) {
+        t0 = micros();
+        int co = sensors.readCO();
+        if (co >= 0) {
+            sampler.record(HW_SC16CO, now, co, micros() - t0);
+            publishChannel(CH_SC16CO_CO, co, now);
+        } else {
+            sampler.recordFailure(HW_SC16CO, now, micros() - t0);
         }
+        endStage();
     }
+#endif
+    
+#if SENSOR_I2C_MUX
+    if (muxReady) readMux(now);
+#endif
+    
+    loopWatch.enter(STAGE_PUBLISH);
+    publishDerived(now);
+    
+    // Current sampling rate per hardware
+    if (now - lastRatePublish >= RATE_PUBLISH_INTERVAL) {
+        lastRatePublish = now;
+        bool enabled = brain.isHardwareEnabled("sampler");
+        for (uint8_t i = 0; i < HW_COUNT && enabled; i++) {
+            if (!HARDWARE_COMPILED[i]) continue;
+            publishValue(samplerTopic[i], "sampler", HARDWARE_TABLE[i].id, sampler.rateHz(i), now);
+        }
+    }
+    
+    // Everything published in this pass, to every output
+    outputs.flush(now);
+    endStage();
 }
@@ -0,0 +1,29 @@
+#ifndef SIM_ADAFRUIT_BMP280_H
+#define SIM_ADAFRUIT_BMP280_H
+
+#include <Wire.h>
+
+class Adafruit_BMP280 {
+public:
+    explicit Adafruit_BMP280(TwoWire* wire = &Wire) : _bus(wire->bus()) {}
+
+    bool begin(uint8_t address = 0x77, uint8_t = 0x58) {
+        _address = address;
+        const TraceRecord* r = SimBus::instance().opAt(_bus, _address, OP_BMP_BEGIN);
+        return r && r->result;
+    }
+
+    float readPressure() { return value(OP_BMP_PRESSURE); }
+    float readTemperature() { return value(OP_BMP_TEMPERATURE); }
+
+private:
+    float value(uint8_t op) {
+        const TraceRecord* r = SimBus::instance().opAt(_bus, _address, op);
+        return (r && r->len > 0) ? r->values[0] : NAN;
+    }
+
+    uint8_t _bus;
+    uint8_t _address = 0x77;
+};
+
+#endif // SIM_ADAFRUIT_BMP280_H
@@ -0,0 +1,37 @@
+#ifndef SIM_ADAFRUIT_SGP30_H
+#define SIM_ADAFRUIT_SGP30_H
+
+#include <Wire.h>
+
+class Adafruit_SGP30 {
+public:
+    static const uint8_t ADDRESS = 0x58;
+
+    uint16_t TVOC = 0;
+    uint16_t eCO2 = 0;
+
+    bool begin(TwoWire* wire = &Wire, bool = true) {
+        _bus = wire->bus();
+        return result(OP_SGP30_BEGIN);
+    }
+    bool IAQinit() { return result(OP_SGP30_INIT); }
+    bool setHumidity(uint32_t) { return result(OP_SGP30_HUMIDITY); }
+
+    bool IAQmeasure() {
+        const TraceRecord* r = SimBus::instance().opAt(_bus, ADDRESS, OP_SGP30_MEASURE);
+        if (!r) return false;
+        eCO2 = (uint16_t)r->values[0];
+        TVOC = (uint16_t)r->values[1];
+        return r->result;
+    }
+
+private:
+    bool result(uint8_t op) {
+        const TraceRecord* r = SimBus::instance().opAt(_bus, ADDRESS, op);
+        return r && r->result;
+    }
+
+    uint8_t _bus = BUS_I2C_SGP;
+};
+
+#endif // SIM_ADAFRUIT_SGP30_H
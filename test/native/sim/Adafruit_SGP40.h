@@ -0,0 +1,25 @@
+#ifndef SIM_ADAFRUIT_SGP40_H
+#define SIM_ADAFRUIT_SGP40_H
+
+#include <Wire.h>
+
+class Adafruit_SGP40 {
+public:
+    static const uint8_t ADDRESS = 0x59;
+
+    bool begin(TwoWire* wire = &Wire) {
+        _bus = wire->bus();
+        const TraceRecord* r = SimBus::instance().opAt(_bus, ADDRESS, OP_SGP40_BEGIN);
+        return r && r->result;
+    }
+
+    int32_t measureVocIndex(float, float) {
+        const TraceRecord* r = SimBus::instance().opAt(_bus, ADDRESS, OP_SGP40_VOC);
+        return r ? r->result : -1;
+    }
+
+private:
+    uint8_t _bus = BUS_I2C_SGP;
+};
+
+#endif // SIM_ADAFRUIT_SGP40_H
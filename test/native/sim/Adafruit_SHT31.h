@@ -0,0 +1,34 @@
+#ifndef SIM_ADAFRUIT_SHT31_H
+#define SIM_ADAFRUIT_SHT31_H
+
+#include <Wire.h>
+
+class Adafruit_SHT31 {
+public:
+    explicit Adafruit_SHT31(TwoWire* wire = &Wire) : _bus(wire->bus()) {}
+
+    bool begin(uint8_t address = 0x44) {
+        _address = address;
+        const TraceRecord* r = SimBus::instance().opAt(_bus, _address, OP_SHT_BEGIN);
+        return r && r->result;
+    }
+
+    void reset() { SimBus::instance().opAt(_bus, _address, OP_SHT_RESET); }
+
+    bool readBoth(float* t, float* h) {
+        const TraceRecord* r = SimBus::instance().opAt(_bus, _address, OP_SHT_READ);
+        if (!r || r->len < 2) {
+            *t = *h = NAN;
+            return false;
+        }
+        *t = r->values[0];
+        *h = r->values[1];
+        return r->result;
+    }
+
+private:
+    uint8_t _bus;
+    uint8_t _address = 0x44;
+};
+
+#endif // SIM_ADAFRUIT_SHT31_H
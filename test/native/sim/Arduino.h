@@ -0,0 +1,105 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// Minimal Arduino core for host builds of SensorReader (see SimBus.h)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "SimBus.h"
+
+typedef uint8_t byte;
+
+#define INPUT           0x01
+#define OUTPUT          0x03
+#define INPUT_PULLUP    0x05
+#define LOW             0
+#define HIGH            1
+#define SERIAL_8N1      0x800001c
+
+inline unsigned long millis() { return (unsigned long)(SimBus::instance().nowUs() / 1000); }
+inline unsigned long micros() { return (unsigned long)SimBus::instance().nowUs(); }
+inline void delay(unsigned long ms) { SimBus::instance().advanceUs((uint64_t)ms * 1000); }
+inline void delayMicroseconds(unsigned int us) { SimBus::instance().advanceUs(us); }
+// The receive callbacks run on the loop's thread: critical sections are no-ops
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t level) { SimBus::instance().pin(pin, level); }
+
+/**
+ * @brief Byte stream on a simulated bus (BusId).
+ */
+class Stream {
+public:
+    explicit Stream(uint8_t bus) : _bus(bus) {}
+    virtual ~Stream() {}
+
+    int available() { return (int)SimBus::instance().available(_bus); }
+    int read() { return SimBus::instance().read(_bus); }
+
+    size_t readBytes(uint8_t* buf, size_t len) {
+        size_t n = 0;
+        while (n < len) {
+            int b = read();
+            if (b < 0) break;
+            buf[n++] = (uint8_t)b;
+        }
+        return n;
+    }
+
+    size_t write(const uint8_t* data, size_t len) {
+        SimBus::instance().write(_bus, data, len);
+        return len;
+    }
+    size_t write(uint8_t b) { return write(&b, 1); }
+
+    void flush() {}
+
+protected:
+    uint8_t _bus;
+};
+
+class HardwareSerial : public Stream {
+public:
+    // UART2: MH-Z14A, UART1: SPS30 (as wired in main.cpp)
+    explicit HardwareSerial(int uart) : Stream(uart == 2 ? BUS_UART_CO2 : BUS_UART_SPS30) {}
+    ~HardwareSerial() { SimBus::instance().onReceive(_bus, nullptr); }
+    void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+
+    // Called as the virtual clock moves with bytes waiting (UART event task)
+    void onReceive(std::function<void()> callback, bool = false) {
+        SimBus::instance().onReceive(_bus, callback);
+    }
+};
+
+/**
+ * @brief Console: silent unless SimConsole::verbose is set.
+ */
+class SimConsole {
+public:
+    bool verbose = false;
+
+    void begin(unsigned long) {}
+
+    int printf(const char* fmt, ...) {
+        if (!verbose) return 0;
+        va_list args;
+        va_start(args, fmt);
+        int n = vprintf(fmt, args);
+        va_end(args);
+        return n;
+    }
+    void print(const char* s) { if (verbose) fputs(s, stdout); }
+    void println(const char* s = "") { if (verbose) puts(s); }
+};
+
+inline SimConsole Serial;
+
+#endif // SIM_ARDUINO_H
@@ -0,0 +1,376 @@
+#ifndef FAULT_MODEL_H
+#define FAULT_MODEL_H
+
+// ============================================================================
+// Fault-Injecting Device Model
+// ============================================================================
+// Stands in for the trace behind SimBus (setModel): every device answers with
+// fixed values and realistic timings, and one fault type is injected at a
+// configurable rate per device transaction:
+//
+//   FAULT_I2C_NACK       one transaction NACKed
+//   FAULT_SDA_STUCK      a slave holds SDA low: every transaction on that bus
+//                        times out until 9 SCL pulses clock it out
+//   FAULT_WINSEN_SHORT   MH-Z14A / SC16-CO answer cut after 1..8 bytes
+//   FAULT_WINSEN_CORRUPT one byte of the answer flipped
+//   FAULT_SHDLC_ERROR    SPS30 frame answered with a state error; the sensor
+//                        fell back to idle and needs a new start command
+//   FAULT_SILENT         the device stops answering for silentMs, then comes
+//                        back power-cycled (SGP30 uninitialised, SPS30 idle)
+//
+// Injected faults are timestamped per hardware so the harness can measure the
+// time to the next good sample.
+
+#include <stdint.h>
+#include <deque>
+#include "SimBus.h"
+#include "SimSps30.h"
+
+enum FaultType : uint8_t {
+    FAULT_NONE = 0,
+    FAULT_I2C_NACK,
+    FAULT_SDA_STUCK,
+    FAULT_WINSEN_SHORT,
+    FAULT_WINSEN_CORRUPT,
+    FAULT_SHDLC_ERROR,
+    FAULT_SILENT,
+    FAULT_TYPE_COUNT
+};
+
+inline const char* faultName(uint8_t type) {
+    static const char* const NAMES[FAULT_TYPE_COUNT] = {
+        "none", "i2c-nack", "sda-stuck", "winsen-short", "winsen-corrupt", "shdlc-error", "silent",
+    };
+    return type < FAULT_TYPE_COUNT ? NAMES[type] : "?";
+}
+
+struct FaultConfig {
+    FaultType type = FAULT_NONE;
+    float rate = 0.01f;             // Probability per device transaction
+    uint32_t silentMs = 30000;      // FAULT_SILENT duration
+    uint32_t seed = 1;
+};
+
+/**
+ * @brief Values the healthy devices report (a good read returns exactly these).
+ */
+namespace FaultTruth {
+    static const int CO2_PPM = 612;
+    static const int CO_PPM = 7;
+    static const int VOC_INDEX = 100;
+    static const int SGP30_ECO2 = 450;
+    static const int SGP30_TVOC = 12;
+    static const float PM[4] = { 5.0f, 8.0f, 9.0f, 10.0f };
+    static const float PRESSURE_PA = 101325.0f;
+    static const float BMP_TEMPERATURE = 21.5f;
+    static const float SHT_TEMPERATURE = 22.0f;
+    static const float SHT_HUMIDITY = 45.0f;
+}
+
+class FaultModel : public SimBusModel {
+public:
+    // Transaction times (virtual clock)
+    static const uint32_t I2C_ADDRESS_US = 100;         // Address + ACK at 100 kHz
+    static const uint32_t WINSEN_LATENCY_US = 10000;    // Command to first answer byte
+    static const uint32_t WINSEN_BYTE_US = 1042;        // 9600 baud
+    static const uint32_t SHDLC_FRAME_US = 3000;        // 115200 baud, command + answer
+    static const int16_t SHDLC_STATE_ERROR = 0x43;      // Command not allowed in current state
+
+    // SCL pins bit-banged by SensorReader::recoverI2C()
+    static const uint8_t SCL_PIN_MAIN = 22;
+    static const uint8_t SCL_PIN_SGP = 33;
+    static const uint8_t RECOVERY_PULSES = 9;
+
+    explicit FaultModel(const FaultConfig& config) : _config(config), _rng(config.seed ? config.seed : 1) {
+        for (uint8_t hw = 0; hw < HW_COUNT; hw++) {
+            _faultSinceUs[hw] = 0;
+            _silentUntilUs[hw] = 0;
+            _faults[hw] = 0;
+        }
+    }
+
+    // ---- Fault bookkeeping (read by the harness) ----
+
+    /**
+     * @brief Virtual time of the oldest fault not followed by a good sample,
+     * 0 if none.
+     */
+    uint64_t faultSince(uint8_t hw) const { return _faultSinceUs[hw]; }
+    void recovered(uint8_t hw) { _faultSinceUs[hw] = 0; }
+    uint32_t faults(uint8_t hw) const { return _faults[hw]; }
+
+    /**
+     * @brief Stops new faults; ongoing ones (stuck bus, silence) play out.
+     */
+    void stopInjecting() { _config.rate = 0; }
+
+    // ---- SimBusModel ----
+
+    uint8_t probe(uint8_t bus, uint8_t address) override {
+        int hw = i2cDevice(bus, address);
+        if (!_stuck[bus] && hw >= 0 && !i2cFault(bus, hw) && !isSilent(hw)) {
+            clock().advanceUs(I2C_ADDRESS_US);
+            return 0;
+        }
+        return busError(bus) ? 5 : 2;     // Timeout / NACK on address
+    }
+
+    const TraceRecord* op(uint8_t bus, uint8_t op) override {
+        int hw = opDevice(op);
+        if (hw < 0) return nullptr;
+        if (_stuck[bus] || i2cFault(bus, hw) || isSilent(hw)) {
+            busError(bus);
+            return nullptr;
+        }
+        return i2c(op);
+    }
+
+    void write(uint8_t bus, const uint8_t* data, size_t len) override {
+        // SPS30: SHDLC frames, answered at the end of the transaction time
+        if (bus == BUS_UART_SPS30) {
+            uint8_t command = 0;
+            if (_sps30.request(data, len, command)) _sps30.answer(command, sps30(SimSps30::opOf(command)));
+            return;
+        }
+        // MH-Z14A and SC16-CO answer the Winsen read command
+        if ((bus != BUS_UART_CO2 && bus != BUS_SOFT_CO) || len != 9 || data[0] != 0xFF || data[2] != 0x86) return;
+        uint8_t hw = bus == BUS_UART_CO2 ? HW_MHZ14A : HW_SC16CO;
+        if (isSilent(hw)) return;
+
+        uint8_t frame[9];
+        winsenFrame(hw == HW_MHZ14A ? 0x86 : 0x04, hw == HW_MHZ14A ? FaultTruth::CO2_PPM : FaultTruth::CO_PPM, frame);
+        size_t count = 9;
+        if (inject(hw, FAULT_WINSEN_SHORT)) count = 1 + next() % 8;
+        if (inject(hw, FAULT_WINSEN_CORRUPT)) frame[next() % 9] ^= (uint8_t)(1 + next() % 255);
+        silence(hw);
+
+        uint64_t t = clock().nowUs() + WINSEN_LATENCY_US;
+        for (size_t i = 0; i < count; i++) _pending[bus].push_back({ t + i * WINSEN_BYTE_US, frame[i] });
+    }
+
+    void deliver(uint8_t bus, std::deque<uint8_t>& rx) override {
+        if (bus == BUS_UART_SPS30) {
+            _sps30.deliver(rx);
+            return;
+        }
+        while (!_pending[bus].empty() && _pending[bus].front().timeUs <= clock().nowUs()) {
+            rx.push_back(_pending[bus].front().value);
+            _pending[bus].pop_front();
+        }
+    }
+
+    void pin(uint8_t pin, uint8_t level) override {
+        if (level != 1) return;
+        uint8_t bus = pin == SCL_PIN_MAIN ? BUS_I2C_MAIN : (pin == SCL_PIN_SGP ? BUS_I2C_SGP : BUS_COUNT);
+        if (bus == BUS_COUNT || !_stuck[bus]) return;
+        if (++_pulses[bus] >= RECOVERY_PULSES) _stuck[bus] = false;
+    }
+
+private:
+    struct TimedByte {
+        uint64_t timeUs;
+        uint8_t value;
+    };
+
+    static SimBus& clock() { return SimBus::instance(); }
+
+    uint32_t next() {
+        // xorshift32: reproducible across runs and platforms
+        _rng ^= _rng << 13;
+        _rng ^= _rng >> 17;
+        _rng ^= _rng << 5;
+        return _rng;
+    }
+
+    bool chance() { return (next() >> 8) < (uint32_t)(_config.rate * (1 << 24)); }
+
+    bool applies(uint8_t hw, FaultType type) const {
+        switch (type) {
+            case FAULT_I2C_NACK:
+            case FAULT_SDA_STUCK:
+                return HARDWARE_TABLE[hw].bus == BUS_I2C_MAIN || HARDWARE_TABLE[hw].bus == BUS_I2C_SGP;
+            case FAULT_WINSEN_SHORT:
+            case FAULT_WINSEN_CORRUPT:
+                return hw == HW_MHZ14A || hw == HW_SC16CO;
+            case FAULT_SHDLC_ERROR:
+                return hw == HW_SPS30;
+            case FAULT_SILENT:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * @brief Rolls the configured fault for one transaction of hw.
+     */
+    bool inject(uint8_t hw, FaultType type) {
+        if (_config.type != type || !applies(hw, type) || !chance()) return false;
+        mark(hw);
+        return true;
+    }
+
+    void mark(uint8_t hw) {
+        _faults[hw]++;
+        if (_faultSinceUs[hw] == 0) _faultSinceUs[hw] = clock().nowUs();
+    }
+
+    bool i2cFault(uint8_t bus, uint8_t hw) {
+        if (inject(hw, FAULT_SDA_STUCK)) {
+            _stuck[bus] = true;
+            _pulses[bus] = 0;
+            // Every device of the bus is down until the bus is recovered
+            for (uint8_t other = 0; other < HW_COUNT; other++) {
+                if (other != hw && HARDWARE_TABLE[other].bus == bus && HARDWARE_COMPILED[other]) mark(other);
+            }
+            return true;
+        }
+        if (inject(hw, FAULT_I2C_NACK)) return true;
+        silence(hw);
+        return false;
+    }
+
+    /**
+     * @brief Charges a failed transaction: the Wire timeout on a stuck bus,
+     * an address byte otherwise. True if the bus is stuck.
+     */
+    bool busError(uint8_t bus) {
+        if (!_stuck[bus]) {
+            clock().advanceUs(I2C_ADDRESS_US);
+            return false;
+        }
+        clock().advanceUs((uint64_t)clock().i2cTimeout(bus) * 1000);
+        return true;
+    }
+
+    void silence(uint8_t hw) {
+        if (!isSilent(hw) && inject(hw, FAULT_SILENT)) {
+            _silentUntilUs[hw] = clock().nowUs() + (uint64_t)_config.silentMs * 1000;
+            // Back from a power cycle
+            if (hw == HW_SGP30) _sgp30Initialised = false;
+            if (hw == HW_SPS30) _sps30Measuring = false;
+        }
+    }
+
+    bool isSilent(uint8_t hw) const { return clock().nowUs() < _silentUntilUs[hw]; }
+
+    /**
+     * @brief Result of op after durationUs. Blocking drivers wait for it (the
+     * clock moves), for the asynchronous ones the clock keeps still.
+     */
+    const TraceRecord* answer(uint8_t op, int16_t result, uint32_t durationUs, uint8_t count = 0,
+                              const float* values = nullptr, bool blocking = true) {
+        if (blocking) clock().advanceUs(durationUs);
+        _record = TraceRecord();
+        _record.type = TR_OP;
+        _record.op = op;
+        _record.result = result;
+        _record.len = count;
+        for (uint8_t i = 0; i < count; i++) _record.values[i] = values[i];
+        _record.timeUs = clock().nowUs() + (blocking ? 0 : durationUs);
+        return &_record;
+    }
+
+    const TraceRecord* i2c(uint8_t op) {
+        switch (op) {
+            case OP_SGP40_BEGIN:
+                return answer(op, 1, 10000);
+            case OP_SGP40_VOC:
+                return answer(op, FaultTruth::VOC_INDEX, 30000);
+            case OP_SGP30_BEGIN:
+                return answer(op, 1, 10000);
+            case OP_SGP30_INIT:
+                _sgp30Initialised = true;
+                return answer(op, 1, 10000);
+            case OP_SGP30_MEASURE: {
+                const float v[2] = { _sgp30Initialised ? (float)FaultTruth::SGP30_ECO2 : 0.0f,
+                                     _sgp30Initialised ? (float)FaultTruth::SGP30_TVOC : 0.0f };
+                return answer(op, 1, 12000, 2, v);
+            }
+            case OP_SGP30_HUMIDITY:
+                return answer(op, 1, 1000);
+            case OP_BMP_BEGIN:
+                return answer(op, 1, 3000);
+            case OP_BMP_PRESSURE:
+                return answer(op, 0, 1000, 1, &FaultTruth::PRESSURE_PA);
+            case OP_BMP_TEMPERATURE:
+                return answer(op, 0, 1000, 1, &FaultTruth::BMP_TEMPERATURE);
+            case OP_SHT_BEGIN:
+            case OP_SHT_RESET:
+                return answer(op, 1, 1000);
+            case OP_SHT_READ: {
+                const float v[2] = { FaultTruth::SHT_TEMPERATURE, FaultTruth::SHT_HUMIDITY };
+                return answer(op, 1, 15000, 2, v);
+            }
+            default:
+                return nullptr;
+        }
+    }
+
+    // SPS30 request: nullptr if it goes unanswered (the driver times out)
+    const TraceRecord* sps30(uint8_t op) {
+        silence(HW_SPS30);
+        if (isSilent(HW_SPS30)) return nullptr;
+        if (inject(HW_SPS30, FAULT_SHDLC_ERROR)) {
+            _sps30Measuring = false;
+            return answer(op, SHDLC_STATE_ERROR, SHDLC_FRAME_US, 0, nullptr, false);
+        }
+        switch (op) {
+            case OP_SPS30_START:
+                // Already measuring: "command not allowed in current state"
+                if (_sps30Measuring) return answer(op, SHDLC_STATE_ERROR, SHDLC_FRAME_US, 0, nullptr, false);
+                _sps30Measuring = true;
+                return answer(op, 0, SHDLC_FRAME_US, 0, nullptr, false);
+            case OP_SPS30_STOP:
+            case OP_SPS30_RESET:
+                _sps30Measuring = false;
+                return answer(op, 0, SHDLC_FRAME_US, 0, nullptr, false);
+            case OP_SPS30_READ:
+                if (!_sps30Measuring) return answer(op, SHDLC_STATE_ERROR, SHDLC_FRAME_US, 0, nullptr, false);
+                return answer(op, 0, SHDLC_FRAME_US + 5000, 4, FaultTruth::PM, false);
+            default:
+                return answer(op, 0, SHDLC_FRAME_US, 0, nullptr, false);
+        }
+    }
+
+    static int i2cDevice(uint8_t bus, uint8_t address) {
+        if (bus == BUS_I2C_MAIN) return address == 0x76 ? HW_BMP280 : -1;
+        if (bus != BUS_I2C_SGP) return -1;
+        if (address == 0x59) return HW_SGP40;
+        if (address == 0x58) return HW_SGP30;
+        if (address == 0x44) return HW_SHT31;
+        return -1;
+    }
+
+    static int opDevice(uint8_t op) {
+        if (op <= OP_SGP40_VOC) return HW_SGP40;
+        if (op <= OP_SGP30_HUMIDITY) return HW_SGP30;
+        if (op <= OP_SPS30_READ) return HW_SPS30;
+        if (op <= OP_BMP_TEMPERATURE) return HW_BMP280;
+        if (op <= OP_SHT_READ) return HW_SHT31;
+        return -1;
+    }
+
+    static void winsenFrame(uint8_t type, uint16_t value, uint8_t out[9]) {
+        uint8_t sum = 0;
+        const uint8_t f[9] = { 0xFF, type, (uint8_t)(value >> 8), (uint8_t)value, 0, 0, 0, 0, 0 };
+        for (int i = 0; i < 9; i++) out[i] = f[i];
+        for (int i = 1; i < 8; i++) sum += out[i];
+        out[8] = (uint8_t)(0xFF - sum + 1);
+    }
+
+    FaultConfig _config;
+    uint32_t _rng;
+    TraceRecord _record;
+    std::deque<TimedByte> _pending[BUS_COUNT];
+    bool _stuck[BUS_COUNT] = {};
+    uint8_t _pulses[BUS_COUNT] = {};
+    SimSps30 _sps30;
+    uint64_t _faultSinceUs[HW_COUNT];
+    uint64_t _silentUntilUs[HW_COUNT];
+    uint32_t _faults[HW_COUNT];
+    bool _sgp30Initialised = true;
+    bool _sps30Measuring = true;
+};
+
+#endif // FAULT_MODEL_H
@@ -0,0 +1,322 @@
+#ifndef SIM_BUS_H
+#define SIM_BUS_H
+
+// ============================================================================
+// Host Bus Simulation
+// ============================================================================
+// Virtual clock and trace-driven buses behind the fake Arduino, Wire, serial
+// and sensor library headers of this directory. SensorReader.cpp is compiled
+// unchanged against them.
+//
+// - UART RX bytes become available when the virtual clock reaches their
+//   recorded time (minus RX_LOOKAHEAD_US: records are stamped when read).
+// - I2C probes and driver operations are consumed in order per bus and move
+//   the clock to their recorded completion time, reproducing their duration.
+// - delay() advances the clock. Anything that does not match the trace is
+//   counted in desyncs().
+//
+// A SimBusModel (FaultModel.h) can stand in for the trace: the buses then ask
+// the model, which answers like the devices would and moves the clock by the
+// time each transaction takes.
+//
+// Drivers that own their framing record op results, not bytes: in trace mode
+// a SimUartDevice (SimSps30.h) turns those back into answers on its UART.
+// UART receive callbacks (HardwareSerial::onReceive) run whenever the clock
+// moves and bytes are waiting, like the UART event task would.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <deque>
+#include <functional>
+#include "BusTrace.h"
+
+/**
+ * @brief Device behaviour behind the buses, instead of a trace.
+ */
+class SimBusModel {
+public:
+    virtual ~SimBusModel() {}
+    virtual uint8_t probe(uint8_t bus, uint8_t address) = 0;      // Wire.endTransmission() code
+    virtual const TraceRecord* op(uint8_t bus, uint8_t op) = 0;   // nullptr: no answer
+    virtual void write(uint8_t bus, const uint8_t* data, size_t len) = 0;
+    virtual void deliver(uint8_t bus, std::deque<uint8_t>& rx) = 0; // Appends the bytes due by now
+    virtual void pin(uint8_t, uint8_t) {}                           // digitalWrite()
+
+    // Drivers of addressed devices (several instances per bus) and I2C
+    // writes with a payload (multiplexer selection). Models with one device
+    // per bus keep the defaults
+    virtual const TraceRecord* opAt(uint8_t bus, uint8_t, uint8_t op) { return this->op(bus, op); }
+    virtual uint8_t i2cWrite(uint8_t bus, uint8_t address, const uint8_t*, size_t) {
+        return probe(bus, address);
+    }
+};
+
+/**
+ * @brief Device answering command frames on a UART in trace mode.
+ */
+class SimUartDevice {
+public:
+    virtual ~SimUartDevice() {}
+    virtual void write(const uint8_t* data, size_t len) = 0;
+    virtual void deliver(std::deque<uint8_t>& rx) = 0;
+};
+
+class SimBus {
+public:
+    static const uint32_t RX_LOOKAHEAD_US = 500;
+    static const uint16_t I2C_DEFAULT_TIMEOUT_MS = 50;  // Arduino-ESP32 Wire default
+
+    static SimBus& instance() {
+        static SimBus bus;
+        return bus;
+    }
+
+    // ---- Clock ----
+
+    uint64_t nowUs() const { return _nowUs; }
+    void advanceUs(uint64_t us) {
+        _nowUs += us;
+        notify();
+    }
+    void advanceTo(uint64_t us) {
+        if (us > _nowUs) _nowUs = us;
+        notify();
+    }
+
+    // ---- Trace ----
+
+    /**
+     * @brief Loads a trace and rewinds all buses. Returns false if malformed.
+     */
+    bool load(const uint8_t* data, size_t len) {
+        _data.assign(data, data + len);
+        _records.clear();
+        BusTraceReader reader(_data.data(), _data.size());
+        TraceRecord r;
+        while (reader.next(r)) _records.push_back(r);
+        reset();
+        return !reader.error();
+    }
+
+    /**
+     * @brief Clears queues and cursors, clock at the first record.
+     */
+    void reset() {
+        for (uint8_t b = 0; b < BUS_COUNT; b++) {
+            _rx[b].clear();
+            _rxCursor[b] = 0;
+            _txCursor[b] = 0;
+            _probeCursor[b] = 0;
+            _opCursor[b] = 0;
+        }
+        _desyncs = 0;
+        _nowUs = _records.empty() ? 0 : _records.front().timeUs;
+    }
+
+    const std::vector<TraceRecord>& records() const { return _records; }
+
+    /**
+     * @brief Skips TX, probe and op records older than timeUs (init sequences,
+     * reset handlers: traffic outside the replayed cycles). RX bytes are kept,
+     * they may still be waiting in the UART buffer.
+     */
+    void seek(uint64_t timeUs) {
+        for (uint8_t b = 0; b < BUS_COUNT; b++) {
+            skipBefore(TR_UART_TX, b, _txCursor[b], timeUs);
+            skipBefore(TR_I2C_PROBE, b, _probeCursor[b], timeUs);
+            skipBefore(TR_OP, b, _opCursor[b], timeUs);
+        }
+        advanceTo(timeUs);
+    }
+
+    uint32_t desyncs() const { return _desyncs; }
+    void desync() { _desyncs++; }
+
+    // ---- Model ----
+
+    /**
+     * @brief Routes all bus traffic to model (nullptr: back to the trace).
+     * Clears the UART queues.
+     */
+    void setModel(SimBusModel* model) {
+        _model = model;
+        for (uint8_t b = 0; b < BUS_COUNT; b++) _rx[b].clear();
+    }
+
+    void pin(uint8_t pin, uint8_t level) {
+        if (_model) _model->pin(pin, level);
+    }
+
+    /**
+     * @brief Answers the trace-mode traffic of a UART (nullptr: TX/RX records).
+     */
+    void setDevice(uint8_t bus, SimUartDevice* device) { _device[bus] = device; }
+
+    void setI2cTimeout(uint8_t bus, uint16_t ms) { _i2cTimeoutMs[bus] = ms; }
+    uint16_t i2cTimeout(uint8_t bus) const { return _i2cTimeoutMs[bus]; }
+
+    // ---- UART ----
+
+    /**
+     * @brief Receive callback of bus (nullptr removes it).
+     */
+    void onReceive(uint8_t bus, std::function<void()> callback) { _onReceive[bus] = callback; }
+
+    size_t available(uint8_t bus) {
+        deliver(bus);
+        return _rx[bus].size();
+    }
+
+    int read(uint8_t bus) {
+        deliver(bus);
+        if (_rx[bus].empty()) return -1;
+        uint8_t b = _rx[bus].front();
+        _rx[bus].pop_front();
+        return b;
+    }
+
+    void write(uint8_t bus, const uint8_t* data, size_t len) {
+        if (_model) {
+            _model->write(bus, data, len);
+            return;
+        }
+        if (_device[bus]) {
+            _device[bus]->write(data, len);
+            return;
+        }
+        // Bytes must match the next recorded TX burst(s) on this bus
+        while (len > 0) {
+            const TraceRecord* r = nextOf(TR_UART_TX, bus, _txCursor[bus]);
+            if (!r) {
+                _desyncs++;
+                return;
+            }
+            size_t n = r->len < len ? r->len : len;
+            if (memcmp(r->data, data, n) != 0) _desyncs++;
+            _txCursor[bus]++;
+            data += n;
+            len -= n;
+        }
+    }
+
+    // ---- I2C ----
+
+    uint8_t probe(uint8_t bus, uint8_t address) {
+        if (_model) return _model->probe(bus, address);
+        const TraceRecord* r = nextOf(TR_I2C_PROBE, bus, _probeCursor[bus]);
+        if (!r || r->address != address) {
+            _desyncs++;
+            return 2;   // NACK on address
+        }
+        _probeCursor[bus]++;
+        advanceTo(r->timeUs);
+        return (uint8_t)r->result;
+    }
+
+    /**
+     * @brief I2C write with a payload. Traces record it as a probe.
+     */
+    uint8_t i2cWrite(uint8_t bus, uint8_t address, const uint8_t* data, size_t len) {
+        if (_model) return _model->i2cWrite(bus, address, data, len);
+        return probe(bus, address);
+    }
+
+    // ---- Driver operations ----
+
+    /**
+     * @brief Next recorded result of op on bus, nullptr (desync) if the trace
+     * has something else there.
+     */
+    const TraceRecord* op(uint8_t bus, uint8_t op) {
+        if (_model) return _model->op(bus, op);
+        const TraceRecord* r = nextOf(TR_OP, bus, _opCursor[bus]);
+        if (!r || r->op != op) {
+            _desyncs++;
+            return nullptr;
+        }
+        _opCursor[bus]++;
+        advanceTo(r->timeUs);
+        return r;
+    }
+
+    /**
+     * @brief op() for the device at address. Traces hold one device per
+     * driver and bus: the address only matters to models.
+     */
+    const TraceRecord* opAt(uint8_t bus, uint8_t address, uint8_t op) {
+        if (_model) return _model->opAt(bus, address, op);
+        return this->op(bus, op);
+    }
+
+    /**
+     * @brief Peeks the next op on bus without consuming it (asynchronous drivers).
+     */
+    const TraceRecord* peekOp(uint8_t bus) {
+        if (_model) return nullptr;
+        return nextOf(TR_OP, bus, _opCursor[bus]);
+    }
+
+    void consumeOp(uint8_t bus) { _opCursor[bus]++; }
+
+private:
+    // Cursor semantics: index of the next unconsumed record of this kind/bus
+    const TraceRecord* nextOf(TraceRecordType type, uint8_t bus, size_t& cursor) {
+        while (cursor < _records.size()) {
+            const TraceRecord& r = _records[cursor];
+            if (r.type == type && r.bus == bus) return &r;
+            cursor++;
+        }
+        return nullptr;
+    }
+
+    void skipBefore(TraceRecordType type, uint8_t bus, size_t& cursor, uint64_t timeUs) {
+        while (const TraceRecord* r = nextOf(type, bus, cursor)) {
+            if (r->timeUs >= timeUs) break;
+            cursor++;
+        }
+    }
+
+    void deliver(uint8_t bus) {
+        if (_model) {
+            _model->deliver(bus, _rx[bus]);
+            return;
+        }
+        if (_device[bus]) {
+            _device[bus]->deliver(_rx[bus]);
+            return;
+        }
+        size_t& c = _rxCursor[bus];
+        while (const TraceRecord* r = nextOf(TR_UART_RX, bus, c)) {
+            if (r->timeUs > _nowUs + RX_LOOKAHEAD_US) break;
+            _rx[bus].insert(_rx[bus].end(), r->data, r->data + r->len);
+            c++;
+        }
+    }
+
+    void notify() {
+        if (_notifying) return;
+        _notifying = true;
+        for (uint8_t b = 0; b < BUS_COUNT; b++) {
+            if (_onReceive[b] && available(b) > 0) _onReceive[b]();
+        }
+        _notifying = false;
+    }
+
+    std::vector<uint8_t> _data;
+    std::vector<TraceRecord> _records;
+    std::deque<uint8_t> _rx[BUS_COUNT];
+    size_t _rxCursor[BUS_COUNT] = {};
+    size_t _txCursor[BUS_COUNT] = {};
+    size_t _probeCursor[BUS_COUNT] = {};
+    size_t _opCursor[BUS_COUNT] = {};
+    uint64_t _nowUs = 0;
+    uint32_t _desyncs = 0;
+    SimBusModel* _model = nullptr;
+    SimUartDevice* _device[BUS_COUNT] = {};
+    std::function<void()> _onReceive[BUS_COUNT];
+    bool _notifying = false;
+    uint16_t _i2cTimeoutMs[BUS_COUNT] = { I2C_DEFAULT_TIMEOUT_MS, I2C_DEFAULT_TIMEOUT_MS };
+};
+
+#endif // SIM_BUS_H
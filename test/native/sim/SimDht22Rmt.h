@@ -0,0 +1,54 @@
+#ifndef SIM_DHT22_RMT_H
+#define SIM_DHT22_RMT_H
+
+// Host implementation of Dht22Rmt: frames come from OP_DHT_FRAME records and
+// complete when the virtual clock reaches their recorded time.
+
+#include "Dht22Rmt.h"
+
+Dht22Rmt::Dht22Rmt(uint8_t pin, rmt_channel_t channel) : _pin(pin), _channel(channel) {}
+
+bool Dht22Rmt::begin() {
+    _installed = true;
+    _state = IDLE;
+    return true;
+}
+
+bool Dht22Rmt::start(uint32_t nowMs) {
+    if (!_installed || _state != IDLE) return false;
+    if (_started && nowMs - _startMs < MIN_INTERVAL_MS) return false;
+    _startMs = nowMs;
+    _started = true;
+    _state = CAPTURING;
+    return true;
+}
+
+bool Dht22Rmt::poll(uint32_t nowMs, DhtFrame& frame) {
+    if (_state == IDLE) return false;
+
+    SimBus& bus = SimBus::instance();
+    const TraceRecord* r = bus.peekOp(BUS_GPIO_DHT);
+    if (r && r->op == OP_DHT_FRAME && r->timeUs <= bus.nowUs()) {
+        bus.consumeOp(BUS_GPIO_DHT);
+        frame = decodeDht22(nullptr, 0);
+        frame.status = (DhtStatus)r->result;
+        if (frame.status == DHT_OK) {
+            frame.temperature = r->values[0];
+            frame.humidity = r->values[1];
+        } else {
+            _failures++;
+        }
+        _state = IDLE;
+        return true;
+    }
+    // Every recorded read ends with a frame record: only a truncated trace times out
+    if (!r && nowMs - _startMs >= TIMEOUT_MS) {
+        frame = decodeDht22(nullptr, 0);
+        _failures++;
+        _state = IDLE;
+        return true;
+    }
+    return false;
+}
+
+#endif // SIM_DHT22_RMT_H
@@ -0,0 +1,166 @@
+#ifndef SIM_MUX_H
+#define SIM_MUX_H
+
+// ============================================================================
+// Simulated TCA9548A and Sensor Instances
+// ============================================================================
+// Bus model (SimBus::setModel) for MuxSensors: any number of SGP40 / SGP30 /
+// SHT31 / BMP280 instances, each at (bus, mux channel, address), behind one
+// TCA9548A per bus. A device answers when its channel is selected (or it is
+// direct); two answering devices at the same address garble the transaction.
+// Transaction times are those of FaultModel, plus the selection write.
+
+#include <stdint.h>
+#include <vector>
+#include "SimBus.h"
+#include "I2cMux.h"
+
+class SimMux : public SimBusModel {
+public:
+    static const uint32_t I2C_ADDRESS_US = 100;     // Address + ACK at 100 kHz
+    static const uint32_t SELECT_US = 200;          // Address + control byte
+
+    struct Device {
+        MuxSensorKind kind;
+        uint8_t bus;
+        uint8_t channel;
+        uint8_t address;
+        float values[2];        // SGP40: VOC index; SGP30: eCO2, TVOC; SHT31: °C, %; BMP280: Pa, °C
+        bool plugged;
+        bool initialised;       // SGP30 IAQinit since power-up
+    };
+
+    /**
+     * @brief Adds a device, plugged in.
+     * @return Device index
+     */
+    size_t add(MuxSensorKind kind, BusId bus, uint8_t channel, uint8_t address, float v0, float v1 = 0) {
+        Device d = {};
+        d.kind = kind;
+        d.bus = bus;
+        d.channel = channel;
+        d.address = address;
+        d.values[0] = v0;
+        d.values[1] = v1;
+        d.plugged = true;
+        _devices.push_back(d);
+        return _devices.size() - 1;
+    }
+
+    /**
+     * @brief Unplugs / replugs device i (replugged devices are power cycled).
+     */
+    void plug(size_t i, bool plugged) {
+        _devices[i].plugged = plugged;
+        _devices[i].initialised = false;
+    }
+
+    Device& device(size_t i) { return _devices[i]; }
+    uint32_t selects(uint8_t bus) const { return _selects[bus]; }
+    uint8_t selection(uint8_t bus) const { return _selection[bus]; }
+
+    // ---- SimBusModel ----
+
+    uint8_t probe(uint8_t bus, uint8_t address) override {
+        clock().advanceUs(I2C_ADDRESS_US);
+        if (address == TCA9548A_ADDRESS) return 0;
+        return find(bus, address) ? 0 : 2;
+    }
+
+    uint8_t i2cWrite(uint8_t bus, uint8_t address, const uint8_t* data, size_t len) override {
+        if (address != TCA9548A_ADDRESS) return probe(bus, address);
+        clock().advanceUs(SELECT_US);
+        _selection[bus] = data[len - 1];
+        _selects[bus]++;
+        return 0;
+    }
+
+    const TraceRecord* op(uint8_t, uint8_t) override { return nullptr; }
+
+    const TraceRecord* opAt(uint8_t bus, uint8_t address, uint8_t op) override {
+        Device* d = find(bus, address);
+        if (!d || d->kind != kindOf(op)) {
+            clock().advanceUs(I2C_ADDRESS_US);
+            return nullptr;
+        }
+        switch (op) {
+            case OP_SGP40_BEGIN:
+            case OP_SGP30_BEGIN:
+                return answer(op, 1, 10000);
+            case OP_SGP40_VOC:
+                return answer(op, (int16_t)d->values[0], 30000);
+            case OP_SGP30_INIT:
+                d->initialised = true;
+                return answer(op, 1, 10000);
+            case OP_SGP30_MEASURE: {
+                const float v[2] = { d->initialised ? d->values[0] : 0.0f, d->initialised ? d->values[1] : 0.0f };
+                return answer(op, 1, 12000, 2, v);
+            }
+            case OP_SGP30_HUMIDITY:
+                return answer(op, 1, 1000);
+            case OP_SHT_BEGIN:
+            case OP_SHT_RESET:
+                return answer(op, 1, 1000);
+            case OP_SHT_READ:
+                return answer(op, 1, 15000, 2, d->values);
+            case OP_BMP_BEGIN:
+                return answer(op, 1, 3000);
+            case OP_BMP_PRESSURE:
+                return answer(op, 0, 1000, 1, &d->values[0]);
+            case OP_BMP_TEMPERATURE:
+                return answer(op, 0, 1000, 1, &d->values[1]);
+            default:
+                return nullptr;
+        }
+    }
+
+    void write(uint8_t, const uint8_t*, size_t) override {}
+    void deliver(uint8_t, std::deque<uint8_t>&) override {}
+
+private:
+    static SimBus& clock() { return SimBus::instance(); }
+
+    static MuxSensorKind kindOf(uint8_t op) {
+        switch (op) {
+            case OP_SGP40_BEGIN: case OP_SGP40_VOC: return MUX_SGP40;
+            case OP_SGP30_BEGIN: case OP_SGP30_INIT: case OP_SGP30_MEASURE: case OP_SGP30_HUMIDITY: return MUX_SGP30;
+            case OP_SHT_BEGIN: case OP_SHT_RESET: case OP_SHT_READ: return MUX_SHT31;
+            case OP_BMP_BEGIN: case OP_BMP_PRESSURE: case OP_BMP_TEMPERATURE: return MUX_BMP280;
+            default: return MUX_KIND_COUNT;
+        }
+    }
+
+    /**
+     * @brief The one device answering address, nullptr if none or several.
+     */
+    Device* find(uint8_t bus, uint8_t address) {
+        Device* found = nullptr;
+        for (Device& d : _devices) {
+            if (!d.plugged || d.bus != bus || d.address != address) continue;
+            if (d.channel != MUX_DIRECT && !(_selection[bus] & (1 << d.channel))) continue;
+            if (found) return nullptr;
+            found = &d;
+        }
+        return found;
+    }
+
+    const TraceRecord* answer(uint8_t op, int16_t result, uint32_t durationUs, uint8_t count = 0,
+                              const float* values = nullptr) {
+        clock().advanceUs(durationUs);
+        _record = TraceRecord();
+        _record.type = TR_OP;
+        _record.op = op;
+        _record.result = result;
+        _record.len = count;
+        for (uint8_t i = 0; i < count; i++) _record.values[i] = values[i];
+        _record.timeUs = clock().nowUs();
+        return &_record;
+    }
+
+    std::vector<Device> _devices;
+    uint8_t _selection[BUS_COUNT] = {};
+    uint32_t _selects[BUS_COUNT] = {};
+    TraceRecord _record;
+};
+
+#endif // SIM_MUX_H
@@ -0,0 +1,117 @@
+#ifndef SIM_SPS30_H
+#define SIM_SPS30_H
+
+// SPS30 behind the simulated UART: decodes the SHDLC requests of Sps30Shdlc
+// and answers with MISO frames built from OP_SPS30_* records. In trace mode
+// (SimBus::setDevice) the records come from the trace; FaultModel passes its
+// own. The answer ends at the record time, so it is decoded by the receive
+// callback once the virtual clock gets there.
+//
+// Commands of the bring-up before the capture started have no record: they
+// are answered OK. A read without its record is a desync.
+
+#include <deque>
+#include "SimBus.h"
+#include "ShdlcCodec.h"
+
+class SimSps30 : public SimUartDevice {
+public:
+    static const uint32_t BYTE_US = 87;         // 115200 baud, 10 bits per byte
+    static const uint32_t ANSWER_US = 2000;     // Request to answer, no record
+    static const int16_t RESULT_FRAME = 0x0101; // Sps30Shdlc::ERROR_FRAME: answer corrupted
+
+    /**
+     * @brief Op record type of an SPS30 command.
+     */
+    static uint8_t opOf(uint8_t command) {
+        switch (command) {
+            case 0x11: return OP_SPS30_WAKEUP;
+            case 0x01: return OP_SPS30_STOP;
+            case 0xD3: return OP_SPS30_RESET;
+            case 0xD0: return OP_SPS30_SERIAL;
+            case 0x00: return OP_SPS30_START;
+            default: return OP_SPS30_READ;
+        }
+    }
+
+    /**
+     * @brief Decodes request bytes. True with the command of the last frame
+     * completed by data.
+     */
+    bool request(const uint8_t* data, size_t len, uint8_t& command) {
+        bool done = false;
+        for (size_t i = 0; i < len; i++) {
+            if (_decoder.feed(data[i]) != SHDLC_FRAME) continue;
+            command = _decoder.frame().command;
+            done = true;
+        }
+        return done;
+    }
+
+    /**
+     * @brief Queues the answer to command described by r (nullptr or a
+     * transport error: no answer), ending at r->timeUs at the earliest.
+     */
+    void answer(uint8_t command, const TraceRecord* r) {
+        if (!r || (r->result > 0xFF && r->result != RESULT_FRAME)) return;
+        ShdlcFrame f = {};
+        f.command = command;
+        f.state = r->result == RESULT_FRAME ? 0 : (uint8_t)r->result;
+        if (command == 0x03 && r->result == 0 && r->len >= 4) {
+            // 10 floats: mass concentrations recorded, number concentrations 0
+            f.len = 40;
+            for (uint8_t i = 0; i < 4; i++) shdlcPutFloat(f.data + 4 * i, r->values[i]);
+        } else if (command == 0xD0 && r->result == 0) {
+            static const char SERIAL_NUMBER[] = "SIM30SPS0000001";
+            f.len = sizeof(SERIAL_NUMBER);
+            memcpy(f.data, SERIAL_NUMBER, f.len);
+        }
+        uint8_t frame[SHDLC_MAX_FRAME];
+        size_t n = shdlcEncode(f, true, frame, sizeof(frame));
+        if (r->result == RESULT_FRAME) frame[n - 2] ^= 0x01;     // Checksum off
+
+        uint64_t now = SimBus::instance().nowUs();
+        uint64_t end = r->timeUs > now + n * BYTE_US ? r->timeUs : now + n * BYTE_US;
+        for (size_t i = 0; i < n; i++) _pending.push_back({ end - (n - 1 - i) * BYTE_US, frame[i] });
+    }
+
+    // ---- SimUartDevice (trace mode) ----
+
+    void write(const uint8_t* data, size_t len) override {
+        uint8_t command = 0;
+        if (!request(data, len, command)) return;
+        SimBus& bus = SimBus::instance();
+        const TraceRecord* r = bus.peekOp(BUS_UART_SPS30);
+        if (r && r->op == opOf(command)) {
+            bus.consumeOp(BUS_UART_SPS30);
+            answer(command, r);
+            return;
+        }
+        if (opOf(command) == OP_SPS30_READ) {
+            bus.desync();
+            return;
+        }
+        TraceRecord ok = {};
+        ok.timeUs = bus.nowUs() + ANSWER_US;
+        answer(command, &ok);
+    }
+
+    void deliver(std::deque<uint8_t>& rx) override {
+        uint64_t now = SimBus::instance().nowUs();
+        while (!_pending.empty() && _pending.front().timeUs <= now) {
+            rx.push_back(_pending.front().value);
+            _pending.pop_front();
+        }
+    }
+
+private:
+    struct TimedByte {
+        uint64_t timeUs;
+        uint8_t value;
+    };
+
+    ShdlcDecoder _decoder{false};
+    std::deque<TimedByte> _pending;
+};
+
+#endif // SIM_SPS30_H
@@ -0,0 +1,12 @@
+#ifndef SIM_SOFTWARE_SERIAL_H
+#define SIM_SOFTWARE_SERIAL_H
+
+#include "Arduino.h"
+
+class SoftwareSerial : public Stream {
+public:
+    SoftwareSerial(int8_t, int8_t) : Stream(BUS_SOFT_CO) {}
+    void begin(unsigned long) {}
+};
+
+#endif // SIM_SOFTWARE_SERIAL_H
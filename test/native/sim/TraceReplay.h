@@ -0,0 +1,249 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+// ============================================================================
+// Trace Replay Harness
+// ============================================================================
+// Drives the real SensorReader (compiled against the fakes of this directory)
+// from a bus trace: every TR_CYCLE record replays the same read that loop()
+// started on the device, on the virtual clock.
+//
+// Include once per test executable (it compiles SensorReader.cpp).
+
+#include <stdio.h>
+#include <vector>
+#include "SimBus.h"
+#include "../../../src/SensorReader.cpp"
+#include "../../../src/Sps30Shdlc.cpp"
+#include "SimDht22Rmt.h"
+#include "SimSps30.h"
+
+/**
+ * @brief Outcome of one replayed read.
+ */
+struct ReplayCycle {
+    uint8_t hw;
+    uint64_t startUs;       // Trace time of the cycle
+    uint32_t durationUs;    // Virtual time spent in SensorReader
+    uint32_t waitUs;        // Part of it between loop() passes (asynchronous reads)
+    bool ok;
+    uint8_t count;
+    float values[4];
+};
+
+/**
+ * @brief Bus handles and SensorReader wired like main.cpp.
+ */
+struct SimRig {
+#if SENSOR_I2C_SGP_BUS
+    TwoWire wireSGP{1};
+#endif
+#if SENSOR_MHZ14A
+    HardwareSerial co2Serial{2};
+#endif
+#if SENSOR_SPS30
+    HardwareSerial sps30Serial{1};
+    SimSps30 sps30Device;           // Trace mode: answers from the op records
+#endif
+#if SENSOR_SC16CO
+    SoftwareSerial coSerial{14, 12};
+#endif
+#if SENSOR_DHT22
+    Dht22Rmt dht{4};
+#endif
+    SensorReader sensors;
+
+    SimRig() : sensors(ports()) {
+#if SENSOR_DHT22
+        dht.begin();
+#endif
+#if SENSOR_SPS30
+        SimBus::instance().setDevice(BUS_UART_SPS30, &sps30Device);
+#endif
+    }
+
+    ~SimRig() {
+#if SENSOR_SPS30
+        SimBus::instance().setDevice(BUS_UART_SPS30, nullptr);
+#endif
+    }
+
+private:
+    SensorPorts ports() {
+        SensorPorts p;
+#if SENSOR_MHZ14A
+        p.co2Serial = &co2Serial;
+#endif
+#if SENSOR_SPS30
+        p.sps30Serial = &sps30Serial;
+#endif
+#if SENSOR_DHT22
+        p.dht = &dht;
+#endif
+#if SENSOR_I2C_SGP_BUS
+        p.wireSGP = &wireSGP;
+#endif
+#if SENSOR_SC16CO
+        p.coSerial = &coSerial;
+#endif
+        return p;
+    }
+};
+
+class TraceReplay {
+public:
+    /**
+     * @brief Loads a trace into the simulated buses. False if malformed.
+     */
+    bool load(const uint8_t* data, size_t len) {
+        return SimBus::instance().load(data, len);
+    }
+
+    /**
+     * @brief Replays every cycle of the loaded trace with a fresh SensorReader.
+     */
+    std::vector<ReplayCycle> run() {
+        SimBus& bus = SimBus::instance();
+        bus.reset();
+        SimRig rig;
+#if SENSOR_SPS30
+        // Booted by setup(): the bring-up runs with the first SPS30 read
+        rig.sensors.initSPS30();
+#endif
+        std::vector<ReplayCycle> cycles;
+        for (const TraceRecord& r : bus.records()) {
+            if (r.type != TR_CYCLE) continue;
+            bus.seek(r.timeUs);
+            ReplayCycle c = {};
+            c.hw = r.hw;
+            c.startUs = r.timeUs;
+            uint64_t start = bus.nowUs();
+            readHardware(rig.sensors, c);
+            c.durationUs = (uint32_t)(bus.nowUs() - start);
+            cycles.push_back(c);
+        }
+        return cycles;
+    }
+
+    /**
+     * @brief Prints one line per cycle: time, hardware, duration, result.
+     */
+    static void print(const std::vector<ReplayCycle>& cycles, FILE* out = stdout) {
+        fprintf(out, "%10s  %-8s %10s  %s\n", "t (ms)", "hw", "read (us)", "values");
+        for (const ReplayCycle& c : cycles) {
+            fprintf(out, "%10.1f  %-8s %10u  ", c.startUs / 1000.0, HARDWARE_TABLE[c.hw].id, c.durationUs);
+            if (!c.ok) fprintf(out, "FAIL");
+            for (uint8_t i = 0; i < c.count; i++) fprintf(out, "%s%.2f", i ? " " : (c.ok ? "" : " "), c.values[i]);
+            fprintf(out, "\n");
+        }
+        fprintf(out, "desyncs: %u\n", SimBus::instance().desyncs());
+    }
+
+    /**
+     * @brief Runs the read loop() does for c.hw and stores its outcome in c.
+     */
+    static void readHardware(SensorReader& s, ReplayCycle& c) {
+        switch (c.hw) {
+#if SENSOR_MHZ14A
+            case HW_MHZ14A: {
+                int co2 = s.readCO2();
+                set(c, co2 > 0, co2);
+                break;
+            }
+#endif
+#if SENSOR_DHT22
+            case HW_DHT22: {
+                // Started on the schedule, completed by later loop() passes
+                DhtReading reading = {0, 0, false};
+                if (s.startDhtRead()) {
+                    while (!s.pollDht(reading)) loopPass(c);
+                }
+                set(c, reading.valid, reading.temperature, reading.humidity);
+                break;
+            }
+#endif
+#if SENSOR_SGP40
+            case HW_SGP40: {
+                int voc = s.readVocIndex();
+                set(c, voc >= 0, voc);
+                break;
+            }
+#endif
+#if SENSOR_SGP30
+            case HW_SGP30: {
+                int eco2 = 0, tvoc = 0;
+                bool ok = s.readSGP30(eco2, tvoc);
+                set(c, ok, eco2, tvoc);
+                break;
+            }
+#endif
+#if SENSOR_SPS30
+            case HW_SPS30: {
+                // Queued once a pending bring-up / restart is through, completed
+                // by later loop() passes, which then run the restart a failed
+                // read queued
+                Sps30Reading pm = { NAN, NAN, NAN, NAN, false };
+                uint64_t limit = SimBus::instance().nowUs() + ASYNC_LIMIT_US;
+                bool started = false;
+                bool done = false;
+                while (!done && SimBus::instance().nowUs() < limit) {
+                    if (!started && !s.isSps30Busy()) started = s.startSPS30Read();
+                    done = s.pollSPS30(pm);
+                    if (!done) loopPass(c);
+                }
+                Sps30Reading restart;
+                while (s.isSps30Busy() && SimBus::instance().nowUs() < limit) {
+                    s.pollSPS30(restart);
+                    loopPass(c);
+                }
+                set(c, pm.valid, pm.pm1, pm.pm25, pm.pm4, pm.pm10);
+                break;
+            }
+#endif
+#if SENSOR_BMP280
+            case HW_BMP280: {
+                float p = s.readPressure();
+                float t = s.readBMPTemperature();
+                set(c, !isnan(p), p, t);
+                break;
+            }
+#endif
+#if SENSOR_SHT31
+            case HW_SHT31: {
+                float t = NAN, h = NAN;
+                bool ok = s.readSHT(t, h);
+                set(c, ok, t, h);
+                break;
+            }
+#endif
+#if SENSOR_SC16CO
+            case HW_SC16CO: {
+                int co = s.readCO();
+                set(c, co >= 0, co);
+                break;
+            }
+#endif
+            default:
+                c.ok = false;
+                break;
+        }
+    }
+
+private:
+    static const uint64_t ASYNC_LIMIT_US = 10000000;
+
+    // One loop() pass between two polls of an asynchronous read
+    static void loopPass(ReplayCycle& c) {
+        delay(1);
+        c.waitUs += 1000;
+    }
+
+    static void set(ReplayCycle& c, bool ok, float a, float b = NAN, float d = NAN, float e = NAN) {
+        c.ok = ok;
+        float v[4] = { a, b, d, e };
+        c.count = 0;
+        for (uint8_t i = 0; i < 4 && !isnan(v[i]); i++) c.values[c.count++] = v[i];
+    }
+};
+
+#endif // TRACE_REPLAY_H
@@ -0,0 +1,44 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include "Arduino.h"
+
+/**
+ * @brief I2C bus: endTransmission() returns the recorded probe result, or
+ * hands the written bytes to the bus model.
+ */
+class TwoWire {
+public:
+    // Bus 0: BMP280 (Wire), bus 1: SGP40/SGP30/SHT31 (wireSGP)
+    explicit TwoWire(uint8_t num) : _bus(num == 0 ? BUS_I2C_MAIN : BUS_I2C_SGP) {}
+
+    bool begin(int = -1, int = -1, uint32_t = 0) { return true; }
+    void setClock(uint32_t) {}
+    void setTimeOut(uint16_t ms) { SimBus::instance().setI2cTimeout(_bus, ms); }
+
+    void beginTransmission(uint8_t address) {
+        _address = address;
+        _len = 0;
+    }
+    size_t write(uint8_t b) {
+        if (_len >= sizeof(_tx)) return 0;
+        _tx[_len++] = b;
+        return 1;
+    }
+    uint8_t endTransmission(bool = true) {
+        if (_len == 0) return SimBus::instance().probe(_bus, _address);
+        return SimBus::instance().i2cWrite(_bus, _address, _tx, _len);
+    }
+
+    uint8_t bus() const { return _bus; }
+
+private:
+    uint8_t _bus;
+    uint8_t _address = 0;
+    uint8_t _tx[32];
+    uint8_t _len = 0;
+};
+
+inline TwoWire Wire(0);
+
+#endif // SIM_WIRE_H
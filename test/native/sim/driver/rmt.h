@@ -0,0 +1,15 @@
+#ifndef SIM_DRIVER_RMT_H
+#define SIM_DRIVER_RMT_H
+
+// Types used by Dht22Rmt.h; the driver itself is SimDht22Rmt.h
+
+typedef enum {
+    RMT_CHANNEL_0 = 0,
+    RMT_CHANNEL_1,
+    RMT_CHANNEL_2,
+    RMT_CHANNEL_3,
+} rmt_channel_t;
+
+typedef void* RingbufHandle_t;
+
+#endif // SIM_DRIVER_RMT_H
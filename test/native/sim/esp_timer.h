@@ -0,0 +1,6 @@
+#ifndef SIM_ESP_TIMER_H
+#define SIM_ESP_TIMER_H
+
+typedef struct esp_timer* esp_timer_handle_t;
+
+#endif // SIM_ESP_TIMER_H
@@ -0,0 +1,174 @@
+#include <unity.h>
+#include "AdaptiveSampler.h"
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+// { minIntervalMs, maxIntervalMs, slopeScale (units/s), activityHigh, activityLow }
+static const SamplerConfig CONFIG = { 1000, 16000, 1.0f, 1.0f, 0.3f };
+static const uint32_t READ_US = 2000;
+
+/**
+ * @brief Polls every 100 ms until untilMs, reading value(nowMs) whenever due.
+ * @return Number of reads.
+ */
+template <uint8_t N, typename Signal>
+static uint32_t run(AdaptiveSampler<N>& sampler, uint8_t ch, uint32_t fromMs, uint32_t untilMs,
+                    Signal value, uint32_t busyUs = READ_US) {
+    uint32_t reads = 0;
+    for (uint32_t nowMs = fromMs; nowMs < untilMs; nowMs += 100) {
+        if (!sampler.isDue(ch, nowMs)) continue;
+        sampler.record(ch, nowMs, value(nowMs), busyUs);
+        reads++;
+    }
+    return reads;
+}
+
+static float flat(uint32_t) { return 20.0f; }
+static float ramp(uint32_t nowMs) { return nowMs * 0.01f; }    // 10 units/s
+
+// ============================================================================
+// Cadence
+// ============================================================================
+
+void test_flat_signal_stays_at_floor_rate() {
+    AdaptiveSampler<1> sampler;
+    sampler.configure(0, CONFIG);
+    uint32_t reads = run(sampler, 0, 0, 64000, flat);
+    // First read at once, then one per maxIntervalMs
+    TEST_ASSERT_EQUAL_UINT32(4, reads);
+    TEST_ASSERT_FALSE(sampler.isFast(0));
+    TEST_ASSERT_EQUAL_UINT32(CONFIG.maxIntervalMs, sampler.intervalMs(0));
+}
+
+void test_change_escalates_to_ceiling_rate() {
+    AdaptiveSampler<1> sampler;
+    sampler.configure(0, CONFIG);
+    run(sampler, 0, 0, 20000, flat);
+    TEST_ASSERT_FALSE(sampler.isFast(0));
+
+    // An event on the next floor-rate read jumps straight to the ceiling
+    sampler.record(0, 32000, 200.0f, READ_US);
+    TEST_ASSERT_TRUE(sampler.isFast(0));
+    TEST_ASSERT_EQUAL_UINT32(CONFIG.minIntervalMs, sampler.intervalMs(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, sampler.rateHz(0));
+
+    // Kept there while the signal moves
+    uint32_t reads = run(sampler, 0, 32100, 42100, [](uint32_t nowMs) { return 200.0f + ramp(nowMs - 32000); });
+    TEST_ASSERT_EQUAL_UINT32(10, reads);
+    TEST_ASSERT_TRUE(sampler.isFast(0));
+}
+
+void test_flat_signal_relaxes_back_to_floor() {
+    AdaptiveSampler<1> sampler;
+    sampler.configure(0, CONFIG);
+    run(sampler, 0, 0, 20000, ramp);
+    TEST_ASSERT_TRUE(sampler.isFast(0));
+
+    // Signal holds its last value: activity decays below activityLow, then the
+    // interval grows by half a step at a time
+    uint32_t previous = sampler.intervalMs(0);
+    uint32_t reads = 0;
+    for (uint32_t nowMs = 20000; nowMs < 120000; nowMs += 100) {
+        if (!sampler.isDue(0, nowMs)) continue;
+        sampler.record(0, nowMs, ramp(20000), READ_US);
+        reads++;
+        TEST_ASSERT_TRUE(sampler.intervalMs(0) >= previous || sampler.isFast(0));
+        previous = sampler.intervalMs(0);
+        if (previous == CONFIG.maxIntervalMs) break;
+    }
+    TEST_ASSERT_FALSE(sampler.isFast(0));
+    TEST_ASSERT_EQUAL_UINT32(CONFIG.maxIntervalMs, sampler.intervalMs(0));
+    TEST_ASSERT_LESS_OR_EQUAL(15, reads);
+}
+
+void test_channels_are_independent() {
+    AdaptiveSampler<2> sampler;
+    sampler.configure(0, CONFIG);
+    sampler.configure(1, CONFIG);
+    run(sampler, 0, 0, 20000, ramp);
+    run(sampler, 1, 0, 20000, flat);
+    TEST_ASSERT_TRUE(sampler.isFast(0));
+    TEST_ASSERT_FALSE(sampler.isFast(1));
+    TEST_ASSERT_EQUAL_UINT32(CONFIG.maxIntervalMs, sampler.intervalMs(1));
+}
+
+// ============================================================================
+// Bus budget
+// ============================================================================
+
+void test_bucket_exhaustion_defers_fast_reads() {
+    // Two moving channels at 1 Hz, 6 ms of bus each: 12 ms/s against 10 ms/s
+    AdaptiveSampler<2> sampler(10);
+    sampler.configure(0, CONFIG);
+    sampler.configure(1, CONFIG);
+    uint32_t reads = 0;
+    for (uint32_t nowMs = 0; nowMs < 60000; nowMs += 100) {
+        for (uint8_t ch = 0; ch < 2; ch++) {
+            if (!sampler.isDue(ch, nowMs)) continue;
+            sampler.record(ch, nowMs, ramp(nowMs), 6000);
+            reads++;
+        }
+    }
+    TEST_ASSERT_TRUE(sampler.isFast(0));
+    TEST_ASSERT_TRUE(sampler.isFast(1));
+    TEST_ASSERT_GREATER_THAN(0, sampler.deferredCount(0) + sampler.deferredCount(1));
+    // Bus time spent stays within the budget (plus the initial bucket and one
+    // read each), and the budget is used once both are fast (from 16 s)
+    TEST_ASSERT_LESS_OR_EQUAL(60 * 10000 + 10000 + 2 * 6000, reads * 6000);
+    TEST_ASSERT_GREATER_OR_EQUAL(44 * 10000, reads * 6000);
+}
+
+void test_ample_budget_defers_nothing() {
+    AdaptiveSampler<2> sampler(250);
+    sampler.configure(0, CONFIG);
+    sampler.configure(1, CONFIG);
+    uint32_t reads = 0;
+    for (uint32_t nowMs = 0; nowMs < 60000; nowMs += 100) {
+        for (uint8_t ch = 0; ch < 2; ch++) {
+            if (!sampler.isDue(ch, nowMs)) continue;
+            sampler.record(ch, nowMs, ramp(nowMs), 6000);
+            reads++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, sampler.deferredCount(0) + sampler.deferredCount(1));
+    // Floor-rate reads at 0 and 16 s (the ramp is seen there), then 1 Hz from 17 s
+    TEST_ASSERT_EQUAL_UINT32(2 * (2 + 43), reads);
+}
+
+void test_floor_rate_granted_on_empty_bucket() {
+    AdaptiveSampler<1> sampler(1);
+    sampler.configure(0, CONFIG);
+    run(sampler, 0, 0, 20000, ramp, 50000);
+    TEST_ASSERT_TRUE(sampler.isFast(0));
+    TEST_ASSERT_LESS_THAN(50000, sampler.budgetRemainingUs());
+
+    // Fast reads are refused, the floor-rate read is not
+    uint32_t reads = run(sampler, 0, 20000, 20000 + CONFIG.maxIntervalMs, ramp, 50000);
+    TEST_ASSERT_EQUAL_UINT32(1, reads);
+    TEST_ASSERT_GREATER_THAN(0, sampler.deferredCount(0));
+}
+
+void test_failed_reads_spend_budget_and_keep_cadence() {
+    AdaptiveSampler<1> sampler(10);
+    sampler.configure(0, CONFIG);
+    TEST_ASSERT_TRUE(sampler.isDue(0, 0));
+    sampler.recordFailure(0, 0, 8000);
+    TEST_ASSERT_EQUAL_INT32(2000, sampler.budgetRemainingUs());
+    TEST_ASSERT_FALSE(sampler.isDue(0, 100));
+    TEST_ASSERT_TRUE(sampler.isDue(0, CONFIG.maxIntervalMs));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_flat_signal_stays_at_floor_rate);
+    RUN_TEST(test_change_escalates_to_ceiling_rate);
+    RUN_TEST(test_flat_signal_relaxes_back_to_floor);
+    RUN_TEST(test_channels_are_independent);
+    RUN_TEST(test_bucket_exhaustion_defers_fast_reads);
+    RUN_TEST(test_ample_budget_defers_nothing);
+    RUN_TEST(test_floor_rate_granted_on_empty_bucket);
+    RUN_TEST(test_failed_reads_spend_budget_and_keep_cadence);
+    return UNITY_END();
+}
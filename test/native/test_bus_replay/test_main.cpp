@@ -0,0 +1,244 @@
+#include <unity.h>
+#include <stdlib.h>
+#include <vector>
+#include "TraceReplay.h"
+
+// ============================================================================
+// Fixture
+// ============================================================================
+// Field-like trace, written with the same BusTraceWriter as the device:
+// normal reads plus the timing-dependent failures we see in the field.
+// Set BUS_TRACE_FILE to also replay a trace captured on a module.
+
+static std::vector<uint8_t> g_trace;
+
+static bool collect(const uint8_t* data, size_t len, void*) {
+    g_trace.insert(g_trace.end(), data, data + len);
+    return true;
+}
+
+static const uint8_t MHZ_CMD[9] = { 0xFF, 0x01, 0x86, 0, 0, 0, 0, 0, 0x79 };
+
+// Winsen answer frame for value (0xFF, 0x86 / 0x04, hi, lo, ..., checksum)
+static void winsenFrame(uint8_t type, uint16_t value, uint8_t out[9]) {
+    uint8_t f[9] = { 0xFF, type, (uint8_t)(value >> 8), (uint8_t)value, 0, 0, 0, 0, 0 };
+    uint8_t sum = 0;
+    for (int i = 1; i < 8; i++) sum += f[i];
+    f[8] = (uint8_t)(0xFF - sum + 1);
+    memcpy(out, f, 9);
+}
+
+static void buildFieldTrace() {
+    g_trace.clear();
+    static uint8_t buffer[256];     // Small chunks: exercises chunk headers
+    BusTraceWriter w(buffer, sizeof(buffer), collect);
+    uint8_t frame[9];
+    const float none[1] = { 0 };
+
+    // 1. MH-Z14A: answer after 120 ms
+    uint32_t t = 1000000;
+    w.cycle(t, BUS_UART_CO2, HW_MHZ14A);
+    w.uart(t + 50, BUS_UART_CO2, false, MHZ_CMD, 9);
+    winsenFrame(0x86, 612, frame);
+    w.uart(t + 120000, BUS_UART_CO2, true, frame, 9);
+
+    // 2. MH-Z14A: no answer within 500 ms, the late frame is flushed next cycle
+    t = 3000000;
+    w.cycle(t, BUS_UART_CO2, HW_MHZ14A);
+    w.uart(t + 50, BUS_UART_CO2, false, MHZ_CMD, 9);
+    t = 5000000;
+    w.cycle(t, BUS_UART_CO2, HW_MHZ14A);
+    winsenFrame(0x86, 640, frame);
+    w.uart(t + 20, BUS_UART_CO2, true, frame, 9);      // stale frame flushed
+    w.uart(t + 200, BUS_UART_CO2, false, MHZ_CMD, 9);
+    winsenFrame(0x86, 655, frame);
+    w.uart(t + 110000, BUS_UART_CO2, true, frame, 9);
+
+    // 3. SC16-CO: partial frame (5 bytes), the rest arrives with the next cycle
+    t = 6000000;
+    winsenFrame(0x04, 7, frame);
+    w.cycle(t, BUS_SOFT_CO, HW_SC16CO);
+    w.uart(t + 30, BUS_SOFT_CO, false, MHZ_CMD, 9);
+    for (int i = 0; i < 5; i++) w.uart(t + 40000 + i * 1100, BUS_SOFT_CO, true, frame + i, 1);
+    t = 7000000;
+    w.cycle(t, BUS_SOFT_CO, HW_SC16CO);
+    w.uart(t + 30, BUS_SOFT_CO, false, MHZ_CMD, 9);
+    for (int i = 5; i < 9; i++) w.uart(t + 20000 + i * 1100, BUS_SOFT_CO, true, frame + i, 1);
+
+    // 4. SGP30: NACK storm on the probe, then a good read
+    for (int i = 0; i < 3; i++) {
+        t = 8000000 + i * 1000000;
+        w.cycle(t, BUS_I2C_SGP, HW_SGP30);
+        w.probe(t + 1200, BUS_I2C_SGP, 0x58, 2);
+    }
+    t = 11000000;
+    w.cycle(t, BUS_I2C_SGP, HW_SGP30);
+    w.probe(t + 150, BUS_I2C_SGP, 0x58, 0);
+    const float sgp30[2] = { 455, 30 };
+    w.op(t + 12500, BUS_I2C_SGP, OP_SGP30_MEASURE, 1, sgp30, 2);
+
+    // 5. SHT31 and BMP280
+    t = 14000000;
+    w.cycle(t, BUS_I2C_SGP, HW_SHT31);
+    w.probe(t + 150, BUS_I2C_SGP, 0x44, 0);
+    const float sht[2] = { 21.37f, 44.1f };
+    w.op(t + 16000, BUS_I2C_SGP, OP_SHT_READ, 1, sht, 2);
+    t = 15000000;
+    w.cycle(t, BUS_I2C_MAIN, HW_BMP280);
+    w.probe(t + 150, BUS_I2C_MAIN, 0x76, 0);
+    const float pa[1] = { 101325.0f };
+    w.op(t + 900, BUS_I2C_MAIN, OP_BMP_PRESSURE, 0, pa, 1);
+    w.probe(t + 1050, BUS_I2C_MAIN, 0x76, 0);
+    const float bmpT[1] = { 21.9f };
+    w.op(t + 1800, BUS_I2C_MAIN, OP_BMP_TEMPERATURE, 0, bmpT, 1);
+
+    // 6. DHT22 frame completes 6 ms after the start
+    t = 16000000;
+    w.cycle(t, BUS_GPIO_DHT, HW_DHT22);
+    const float dht[2] = { 21.6f, 45.0f };
+    w.op(t + 6000, BUS_GPIO_DHT, OP_DHT_FRAME, DHT_OK, dht, 2);
+
+    // 7. SPS30 (last: its first read waits for the bring-up): a read left
+    //    unanswered, restart (wake-up + start), then a good read
+    t = 17000000;
+    w.cycle(t, BUS_UART_SPS30, HW_SPS30);
+    w.op(t + 100000, BUS_UART_SPS30, OP_SPS30_READ, Sps30Shdlc::ERROR_TIMEOUT, none, 0);
+    w.op(t + 103000, BUS_UART_SPS30, OP_SPS30_WAKEUP, 0, none, 0);
+    w.op(t + 106000, BUS_UART_SPS30, OP_SPS30_START, 0, none, 0);
+    t = 22000000;
+    w.cycle(t, BUS_UART_SPS30, HW_SPS30);
+    const float pm[4] = { 3.1f, 5.2f, 6.0f, 6.4f };
+    w.op(t + 9000, BUS_UART_SPS30, OP_SPS30_READ, 0, pm, 4);
+
+    w.flush();
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_trace_round_trip() {
+    buildFieldTrace();
+    BusTraceReader reader(g_trace.data(), g_trace.size());
+    TraceRecord r;
+    size_t cycles = 0, rxBytes = 0;
+    uint64_t last = 0;
+    while (reader.next(r)) {
+        TEST_ASSERT_TRUE(r.timeUs >= last);
+        last = r.timeUs;
+        if (r.type == TR_CYCLE) cycles++;
+        if (r.type == TR_UART_RX) rxBytes += r.len;
+    }
+    TEST_ASSERT_FALSE(reader.error());
+    TEST_ASSERT_EQUAL(14, cycles);
+    TEST_ASSERT_EQUAL(9 * 3 + 9, rxBytes);
+}
+
+void test_writer_merges_uart_bursts() {
+    g_trace.clear();
+    uint8_t buffer[64];
+    BusTraceWriter w(buffer, sizeof(buffer), collect);
+    const uint8_t bytes[3] = { 1, 2, 3 };
+    w.uart(100, BUS_SOFT_CO, true, bytes, 1);
+    w.uart(120, BUS_SOFT_CO, true, bytes + 1, 1);
+    w.uart(150, BUS_SOFT_CO, true, bytes + 2, 1);
+    w.flush();
+
+    BusTraceReader reader(g_trace.data(), g_trace.size());
+    TraceRecord r;
+    TEST_ASSERT_TRUE(reader.next(r));
+    TEST_ASSERT_EQUAL(3, r.len);
+    TEST_ASSERT_EQUAL_MEMORY(bytes, r.data, 3);
+    TEST_ASSERT_FALSE(reader.next(r));
+    // Header (8) + tag + dt + len + 3 bytes
+    TEST_ASSERT_EQUAL(14, g_trace.size());
+}
+
+void test_replay_reproduces_field_cycles() {
+#if !(SENSOR_MHZ14A && SENSOR_SC16CO && SENSOR_SGP30 && SENSOR_SPS30 && SENSOR_SHT31 && SENSOR_BMP280 && SENSOR_DHT22)
+    TEST_IGNORE_MESSAGE("field fixture needs PROFILE_FULL_BENCH");
+#endif
+    buildFieldTrace();
+    TraceReplay replay;
+    TEST_ASSERT_TRUE(replay.load(g_trace.data(), g_trace.size()));
+    std::vector<ReplayCycle> c = replay.run();
+    TraceReplay::print(c);
+
+    TEST_ASSERT_EQUAL(14, c.size());
+    TEST_ASSERT_EQUAL(0, SimBus::instance().desyncs());
+
+    // MH-Z14A: answer after ~120 ms (10 ms polling)
+    TEST_ASSERT_TRUE(c[0].ok);
+    TEST_ASSERT_EQUAL_FLOAT(612, c[0].values[0]);
+    TEST_ASSERT_UINT32_WITHIN(10000, 120000, c[0].durationUs);
+
+    // Timeout costs the full 500 ms, the stale frame does not leak into the next read
+    TEST_ASSERT_FALSE(c[1].ok);
+    TEST_ASSERT_UINT32_WITHIN(10000, 500000, c[1].durationUs);
+    TEST_ASSERT_EQUAL_FLOAT(655, c[2].values[0]);
+
+    // SC16-CO partial frame: first read fails, second completes it
+    TEST_ASSERT_FALSE(c[3].ok);
+    TEST_ASSERT_UINT32_WITHIN(10000, 150000, c[3].durationUs);
+    TEST_ASSERT_TRUE(c[4].ok);
+    TEST_ASSERT_EQUAL_FLOAT(7, c[4].values[0]);
+
+    // SGP30 NACKs fail fast, then read
+    for (int i = 5; i < 8; i++) TEST_ASSERT_FALSE(c[i].ok);
+    TEST_ASSERT_TRUE(c[8].ok);
+    TEST_ASSERT_EQUAL_FLOAT(455, c[8].values[0]);
+
+    TEST_ASSERT_EQUAL_FLOAT(21.37f, c[9].values[0]);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1013.25f, c[10].values[0]);
+    TEST_ASSERT_TRUE(c[11].ok);
+    TEST_ASSERT_UINT32_WITHIN(1000, 6000, c[11].durationUs);
+
+    // SPS30: the read timeout and the restart run between loop passes, the
+    // CPU is never held while SHDLC frames are on the wire
+    TEST_ASSERT_FALSE(c[12].ok);
+    TEST_ASSERT_GREATER_THAN(100000, c[12].waitUs);
+    TEST_ASSERT_EQUAL(c[12].waitUs, c[12].durationUs);
+    TEST_ASSERT_TRUE(c[13].ok);
+    TEST_ASSERT_EQUAL_FLOAT(5.2f, c[13].values[1]);
+    TEST_ASSERT_UINT32_WITHIN(1000, 9000, c[13].durationUs);
+}
+
+void test_replay_is_deterministic() {
+    buildFieldTrace();
+    TraceReplay replay;
+    replay.load(g_trace.data(), g_trace.size());
+    std::vector<ReplayCycle> a = replay.run();
+    std::vector<ReplayCycle> b = replay.run();
+    TEST_ASSERT_EQUAL(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        TEST_ASSERT_EQUAL(a[i].durationUs, b[i].durationUs);
+        TEST_ASSERT_EQUAL(a[i].ok, b[i].ok);
+    }
+}
+
+void test_replay_trace_file() {
+    const char* path = getenv("BUS_TRACE_FILE");
+    if (!path) TEST_IGNORE_MESSAGE("set BUS_TRACE_FILE to replay a captured trace");
+
+    FILE* f = fopen(path, "rb");
+    TEST_ASSERT_NOT_NULL_MESSAGE(f, path);
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) data.insert(data.end(), buf, buf + n);
+    fclose(f);
+
+    TraceReplay replay;
+    TEST_ASSERT_TRUE_MESSAGE(replay.load(data.data(), data.size()), "malformed trace");
+    TraceReplay::print(replay.run());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_trace_round_trip);
+    RUN_TEST(test_writer_merges_uart_bursts);
+    RUN_TEST(test_replay_reproduces_field_cycles);
+    RUN_TEST(test_replay_is_deterministic);
+    RUN_TEST(test_replay_trace_file);
+    return UNITY_END();
+}
@@ -0,0 +1,106 @@
+#include <unity.h>
+#include <string.h>
+#include "Dht22Decoder.h"
+
+// ============================================================================
+// Captured timings
+// ============================================================================
+
+// Bench capture: idle tail after the start pulse, 80/80 us preamble, 40 bits,
+// final low. 02 8C 01 5F checksum EE -> 65.2 %, 35.1 °C
+static const DhtEdge CAPTURE_65_2_35_1[] = {
+    { 1, 27 }, { 0, 78 }, { 1, 84 }, { 0, 47 }, { 1, 23 }, { 0, 55 },
+    { 1, 23 }, { 0, 52 }, { 1, 27 }, { 0, 47 }, { 1, 27 }, { 0, 50 },
+    { 1, 23 }, { 0, 48 }, { 1, 26 }, { 0, 53 }, { 1, 68 }, { 0, 50 },
+    { 1, 23 }, { 0, 55 }, { 1, 71 }, { 0, 47 }, { 1, 29 }, { 0, 56 },
+    { 1, 23 }, { 0, 50 }, { 1, 28 }, { 0, 56 }, { 1, 68 }, { 0, 56 },
+    { 1, 72 }, { 0, 53 }, { 1, 23 }, { 0, 50 }, { 1, 23 }, { 0, 55 },
+    { 1, 29 }, { 0, 49 }, { 1, 25 }, { 0, 53 }, { 1, 24 }, { 0, 55 },
+    { 1, 23 }, { 0, 56 }, { 1, 25 }, { 0, 55 }, { 1, 29 }, { 0, 49 },
+    { 1, 23 }, { 0, 56 }, { 1, 72 }, { 0, 50 }, { 1, 25 }, { 0, 48 },
+    { 1, 72 }, { 0, 48 }, { 1, 27 }, { 0, 47 }, { 1, 72 }, { 0, 50 },
+    { 1, 71 }, { 0, 55 }, { 1, 71 }, { 0, 52 }, { 1, 71 }, { 0, 56 },
+    { 1, 71 }, { 0, 52 }, { 1, 70 }, { 0, 50 }, { 1, 74 }, { 0, 49 },
+    { 1, 73 }, { 0, 50 }, { 1, 23 }, { 0, 56 }, { 1, 70 }, { 0, 55 },
+    { 1, 71 }, { 0, 52 }, { 1, 73 }, { 0, 54 }, { 1, 25 }, { 0, 52 },
+};
+static const size_t CAPTURE_LEN = sizeof(CAPTURE_65_2_35_1) / sizeof(DhtEdge);
+
+// Builds a clean pulse train for the given bytes (no leading idle segment)
+static size_t encode(const uint8_t bytes[5], DhtEdge* out) {
+    size_t n = 0;
+    out[n++] = { 0, 80 };
+    out[n++] = { 1, 80 };
+    for (uint8_t bit = 0; bit < 40; bit++) {
+        bool one = bytes[bit / 8] & (0x80 >> (bit % 8));
+        out[n++] = { 0, 50 };
+        out[n++] = { 1, (uint16_t)(one ? 70 : 27) };
+    }
+    out[n++] = { 0, 50 };
+    return n;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_decodes_capture() {
+    DhtFrame f = decodeDht22(CAPTURE_65_2_35_1, CAPTURE_LEN);
+    TEST_ASSERT_EQUAL(DHT_OK, f.status);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 65.2f, f.humidity);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 35.1f, f.temperature);
+}
+
+void test_decodes_negative_temperature() {
+    // 45.0 %, -10.1 °C
+    uint8_t bytes[5] = { 0x01, 0xC2, 0x80, 0x65, 0 };
+    bytes[4] = (uint8_t)(bytes[0] + bytes[1] + bytes[2] + bytes[3]);
+    DhtEdge edges[84];
+    size_t n = encode(bytes, edges);
+
+    DhtFrame f = decodeDht22(edges, n);
+    TEST_ASSERT_EQUAL(DHT_OK, f.status);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 45.0f, f.humidity);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -10.1f, f.temperature);
+}
+
+void test_rejects_bad_checksum() {
+    DhtEdge edges[84];
+    memcpy(edges, CAPTURE_65_2_35_1, sizeof(CAPTURE_65_2_35_1));
+    // Flip the last checksum bit (0 -> 1)
+    edges[82].us = 70;
+    DhtFrame f = decodeDht22(edges, CAPTURE_LEN);
+    TEST_ASSERT_EQUAL(DHT_BAD_CHECKSUM, f.status);
+    TEST_ASSERT_TRUE(isnan(f.temperature));
+}
+
+void test_reports_truncated_capture() {
+    // Capture buffer ended after 30 bits
+    DhtFrame f = decodeDht22(CAPTURE_65_2_35_1, 3 + 60);
+    TEST_ASSERT_EQUAL(DHT_TRUNCATED, f.status);
+}
+
+void test_reports_missing_response() {
+    const DhtEdge idle[] = { { 1, 1000 } };
+    TEST_ASSERT_EQUAL(DHT_NO_RESPONSE, decodeDht22(idle, 1).status);
+    TEST_ASSERT_EQUAL(DHT_NO_RESPONSE, decodeDht22(nullptr, 0).status);
+}
+
+void test_reports_glitch_as_bad_timing() {
+    DhtEdge edges[84];
+    memcpy(edges, CAPTURE_65_2_35_1, sizeof(CAPTURE_65_2_35_1));
+    // Line held low mid-frame (e.g. bytes lost to another interrupt on the bus)
+    edges[19].us = 250;
+    TEST_ASSERT_EQUAL(DHT_BAD_TIMING, decodeDht22(edges, CAPTURE_LEN).status);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_decodes_capture);
+    RUN_TEST(test_decodes_negative_temperature);
+    RUN_TEST(test_rejects_bad_checksum);
+    RUN_TEST(test_reports_truncated_capture);
+    RUN_TEST(test_reports_missing_response);
+    RUN_TEST(test_reports_glitch_as_bad_timing);
+    return UNITY_END();
+}
@@ -0,0 +1,320 @@
+#include <unity.h>
+#include <stdlib.h>
+#include "TraceReplay.h"
+#include "FaultModel.h"
+#include "StageBudget.h"
+
+// ============================================================================
+// Fault-Injection Stress Suite
+// ============================================================================
+// Runs the real SensorReader against FaultModel, one fault type at a time, on
+// the virtual clock: every compiled sensor is read once per cycle like loop()
+// does, and the reset path of the I2C sensors (resetBMP / resetSGP / resetSHT)
+// runs after RESET_AFTER failed reads in a row. The DHT22 (RMT capture, no
+// shared bus) is left out.
+//
+// For each fault type: worst single-read stall, reads over their stage budget,
+// samples lost, wrong values accepted, and time from a fault to the next good
+// sample of the hardware. The run ends with DRAIN_MS without new faults, so a
+// fault still open at the end is one the code never recovers from. Tunable
+// from the environment:
+//
+//   FAULT_RATE=0.01  FAULT_MINUTES=60  FAULT_SEED=1  FAULT_SILENT_MS=30000
+
+static const uint32_t CYCLE_MS = 5000;
+static const uint8_t RESET_AFTER = 3;
+static const uint32_t DRAIN_MS = 300000;
+static const uint64_t WATCHDOG_US = 8000000;   // LOOP_WDT_TIMEOUT_S
+
+struct StressResult {
+    uint32_t reads;
+    uint32_t lost;              // Failed reads
+    uint32_t wrong;             // Reads that returned a value the device never sent
+    uint32_t overruns;          // Reads over their STAGE_BUDGET_MS
+    uint32_t worstStallUs;
+    uint8_t worstHw;
+    uint32_t faults;
+    uint32_t recoveries;
+    uint64_t recoverySumUs;
+    uint64_t recoveryMaxUs;
+    uint32_t unrecovered;       // Hardware still failing after the drain
+};
+
+static float envFloat(const char* name, float fallback) {
+    const char* v = getenv(name);
+    return v ? (float)atof(v) : fallback;
+}
+
+static FaultConfig configFor(FaultType type) {
+    FaultConfig c;
+    c.type = type;
+    c.rate = envFloat("FAULT_RATE", 0.01f);
+    c.silentMs = (uint32_t)envFloat("FAULT_SILENT_MS", 30000);
+    c.seed = (uint32_t)envFloat("FAULT_SEED", 1);
+    return c;
+}
+
+/**
+ * @brief First value of a good read of hw (FaultTruth, as SensorReader scales it).
+ */
+static float expected(uint8_t hw) {
+    switch (hw) {
+        case HW_MHZ14A: return FaultTruth::CO2_PPM;
+        case HW_SGP40: return FaultTruth::VOC_INDEX;
+        case HW_SGP30: return FaultTruth::SGP30_ECO2;
+        case HW_SPS30: return FaultTruth::PM[0];
+        case HW_BMP280: return FaultTruth::PRESSURE_PA / 100.0f;
+        case HW_SHT31: return FaultTruth::SHT_TEMPERATURE;
+        case HW_SC16CO: return FaultTruth::CO_PPM;
+        default: return NAN;
+    }
+}
+
+/**
+ * @brief Bus recovery helper of hw, run after RESET_AFTER failures in a row.
+ */
+static void resetPath(SensorReader& s, uint8_t hw) {
+    switch (hw) {
+#if SENSOR_BMP280
+        case HW_BMP280: s.resetBMP(); break;
+#endif
+#if SENSOR_SGP40
+        case HW_SGP40: s.resetSGP(); break;
+#endif
+#if SENSOR_SHT31
+        case HW_SHT31: s.resetSHT(); break;
+#endif
+        default: break;
+    }
+}
+
+static StressResult runStress(const FaultConfig& config) {
+    SimBus& bus = SimBus::instance();
+    FaultModel model(config);
+    bus.setModel(&model);
+    bus.setI2cTimeout(BUS_I2C_MAIN, SimBus::I2C_DEFAULT_TIMEOUT_MS);
+    bus.setI2cTimeout(BUS_I2C_SGP, SimBus::I2C_DEFAULT_TIMEOUT_MS);
+    bus.advanceUs(1000);
+
+    SimRig rig;
+    SensorReader& s = rig.sensors;
+    // Boot like setup() (faults may already hit the init sequences)
+#if SENSOR_BMP280
+    s.initBMP();
+#endif
+#if SENSOR_SGP40
+    s.initSGP();
+#endif
+#if SENSOR_SGP30
+    s.initSGP30();
+#endif
+#if SENSOR_SPS30
+    s.initSPS30();
+#endif
+#if SENSOR_SHT31
+    s.initSHT();
+#endif
+#if SENSOR_SC16CO
+    s.initCO();
+#endif
+
+    StressResult r = {};
+    uint8_t streak[HW_COUNT] = {};
+    uint32_t minutes = (uint32_t)envFloat("FAULT_MINUTES", 60);
+    uint32_t cycles = minutes * 60000 / CYCLE_MS;
+    uint32_t drainCycles = DRAIN_MS / CYCLE_MS;
+    uint64_t cycleStart = bus.nowUs();
+
+    for (uint32_t n = 0; n < cycles + drainCycles; n++) {
+        if (n == cycles) model.stopInjecting();
+        for (uint8_t hw = 0; hw < HW_COUNT; hw++) {
+            if (!HARDWARE_COMPILED[hw] || hw == HW_DHT22) continue;
+            ReplayCycle c = {};
+            c.hw = hw;
+            uint64_t start = bus.nowUs();
+            TraceReplay::readHardware(s, c);
+            if (!c.ok && ++streak[hw] >= RESET_AFTER) {
+                resetPath(s, hw);
+                streak[hw] = 0;
+            }
+            // Waits between loop passes of the asynchronous reads do not hold the CPU
+            uint32_t stall = (uint32_t)(bus.nowUs() - start) - c.waitUs;
+
+            r.reads++;
+            if (stall > (uint32_t)STAGE_BUDGET_MS[readStage((HardwareSlot)hw)] * 1000) r.overruns++;
+            if (stall > r.worstStallUs) {
+                r.worstStallUs = stall;
+                r.worstHw = hw;
+            }
+            if (!c.ok) {
+                r.lost++;
+                continue;
+            }
+            streak[hw] = 0;
+            if (fabsf(c.values[0] - expected(hw)) > 0.01f) {
+                r.wrong++;
+                continue;
+            }
+            if (model.faultSince(hw)) {
+                uint64_t t = bus.nowUs() - model.faultSince(hw);
+                r.recoveries++;
+                r.recoverySumUs += t;
+                if (t > r.recoveryMaxUs) r.recoveryMaxUs = t;
+                model.recovered(hw);
+            }
+        }
+        cycleStart += (uint64_t)CYCLE_MS * 1000;
+        bus.advanceTo(cycleStart);
+    }
+
+    for (uint8_t hw = 0; hw < HW_COUNT; hw++) {
+        r.faults += model.faults(hw);
+        if (model.faultSince(hw)) r.unrecovered++;
+    }
+    bus.setModel(nullptr);
+    return r;
+}
+
+static void printHeader() {
+    printf("\n%-15s %6s %6s %5s %5s %8s %10s %8s %6s %11s %11s %5s\n", "fault", "reads", "lost", "lost%",
+           "wrong", "overrun", "stall(ms)", "on", "faults", "recov(ms)", "recovMax", "open");
+}
+
+static void printRow(FaultType type, const StressResult& r) {
+    printf("%-15s %6u %6u %5.1f %5u %8u %10.1f %8s %6u %11.0f %11.0f %5u\n", faultName(type), r.reads, r.lost,
+           r.reads ? 100.0 * r.lost / r.reads : 0.0, r.wrong, r.overruns, r.worstStallUs / 1000.0,
+           HARDWARE_TABLE[r.worstHw].id, r.faults, r.recoveries ? r.recoverySumUs / 1000.0 / r.recoveries : 0.0,
+           r.recoveryMaxUs / 1000.0, r.unrecovered);
+}
+
+static void stress(FaultType type, StressResult& r) {
+    r = runStress(configFor(type));
+    printRow(type, r);
+    // Whatever the fault: checksums keep bad values out, and no read comes
+    // close to a watchdog reset
+    TEST_ASSERT_EQUAL(0, r.wrong);
+    TEST_ASSERT_LESS_THAN(WATCHDOG_US, r.worstStallUs);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_healthy_buses_lose_nothing() {
+    StressResult r;
+    stress(FAULT_NONE, r);
+    TEST_ASSERT_GREATER_THAN(0, r.reads);
+    TEST_ASSERT_EQUAL(0, r.lost);
+    TEST_ASSERT_EQUAL(0, r.overruns);
+}
+
+void test_i2c_nack() {
+    StressResult r;
+    stress(FAULT_I2C_NACK, r);
+    // A NACK costs one sample, the next read is good
+    TEST_ASSERT_EQUAL(0, r.unrecovered);
+}
+
+void test_sda_stuck() {
+    StressResult r;
+    stress(FAULT_SDA_STUCK, r);
+    TEST_ASSERT_EQUAL(0, r.unrecovered);
+}
+
+void test_winsen_short_frames() {
+    StressResult r;
+    stress(FAULT_WINSEN_SHORT, r);
+    TEST_ASSERT_EQUAL(0, r.unrecovered);
+}
+
+void test_winsen_corrupt_frames() {
+    StressResult r;
+    stress(FAULT_WINSEN_CORRUPT, r);
+    TEST_ASSERT_EQUAL(0, r.unrecovered);
+}
+
+void test_shdlc_errors() {
+    StressResult r;
+    stress(FAULT_SHDLC_ERROR, r);
+    TEST_ASSERT_EQUAL(0, r.unrecovered);
+}
+
+void test_silent_devices() {
+    StressResult r;
+    stress(FAULT_SILENT, r);
+}
+
+// ============================================================================
+// SPS30 late answers
+// ============================================================================
+
+/**
+ * @brief SPS30 answering read n with PM1 = n, the first one lateUs after
+ * its request, the others after ANSWER_US.
+ */
+class LateSps30 : public SimSps30 {
+public:
+    uint64_t lateUs = 0;
+    uint8_t reads = 0;
+
+    void write(const uint8_t* data, size_t len) override {
+        uint8_t command = 0;
+        if (!request(data, len, command)) return;
+        TraceRecord r = {};
+        r.timeUs = SimBus::instance().nowUs() + (reads == 0 ? lateUs : ANSWER_US);
+        r.len = 4;
+        r.values[0] = ++reads;
+        answer(command, &r);
+    }
+};
+
+static bool readSps30(Sps30Shdlc& sps30, Sps30Shdlc::Result& result) {
+    sps30.submit(Sps30Shdlc::CMD_READ);
+    for (uint32_t ms = 0; ms < 1000; ms++) {
+        if (sps30.poll(millis(), result)) return true;
+        delay(1);
+    }
+    return false;
+}
+
+void test_sps30_late_answer_not_taken_for_the_next_read() {
+    // Answer after the timeout, then one straddling the next request
+    static const uint64_t LATE_US[] = { 150000, 202000 };
+    for (uint64_t lateUs : LATE_US) {
+        SimBus& bus = SimBus::instance();
+        LateSps30 device;
+        device.lateUs = lateUs;
+        bus.setDevice(BUS_UART_SPS30, &device);
+        HardwareSerial serial{1};
+        Sps30Shdlc sps30(serial);
+        sps30.begin(-1, -1);
+
+        Sps30Shdlc::Result result;
+        TEST_ASSERT_TRUE(readSps30(sps30, result));
+        TEST_ASSERT_EQUAL(Sps30Shdlc::ERROR_TIMEOUT, result.error);
+
+        // Same command byte: only the answer of this read may complete it
+        TEST_ASSERT_TRUE(readSps30(sps30, result));
+        TEST_ASSERT_EQUAL(0, result.error);
+        TEST_ASSERT_EQUAL(40, result.len);
+        TEST_ASSERT_EQUAL_FLOAT(2.0f, shdlcFloat(result.data));
+        TEST_ASSERT_EQUAL(0, sps30.frameErrors());
+
+        bus.setDevice(BUS_UART_SPS30, nullptr);
+        delay(1000);
+    }
+}
+
+int main() {
+    printHeader();
+    UNITY_BEGIN();
+    RUN_TEST(test_healthy_buses_lose_nothing);
+    RUN_TEST(test_i2c_nack);
+    RUN_TEST(test_sda_stuck);
+    RUN_TEST(test_winsen_short_frames);
+    RUN_TEST(test_winsen_corrupt_frames);
+    RUN_TEST(test_shdlc_errors);
+    RUN_TEST(test_silent_devices);
+    RUN_TEST(test_sps30_late_answer_not_taken_for_the_next_read);
+    return UNITY_END();
+}
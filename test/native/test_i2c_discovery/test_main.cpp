@@ -0,0 +1,239 @@
+#include <unity.h>
+#include <stdio.h>
+#include <vector>
+#include "I2cDiscovery.h"
+
+// ============================================================================
+// Fake bus: a set of answering addresses per bus, or a bus held low
+// ============================================================================
+
+static const bool ALL_COMPILED[HW_COUNT] = { true, true, true, true, true, true, true, true };
+
+struct FakeBuses {
+    std::vector<uint8_t> main;
+    std::vector<uint8_t> sgp;
+    bool stuck = false;             // Main bus SDA held low
+    uint32_t probes = 0;
+    uint32_t stallMs = 0;           // Wire timeouts spent (1 s each after a recovery)
+
+    uint8_t probe(BusId bus, uint8_t address) {
+        probes++;
+        if (stuck && bus == BUS_I2C_MAIN) {
+            stallMs += 1000;
+            return WIRE_TIMEOUT;
+        }
+        const std::vector<uint8_t>& v = bus == BUS_I2C_MAIN ? main : sgp;
+        for (uint8_t a : v) if (a == address) return WIRE_OK;
+        return WIRE_NACK_ADDRESS;
+    }
+
+    void remove(BusId bus, uint8_t address) {
+        std::vector<uint8_t>& v = bus == BUS_I2C_MAIN ? main : sgp;
+        for (size_t i = 0; i < v.size(); i++) {
+            if (v[i] == address) v.erase(v.begin() + i--);
+        }
+    }
+};
+
+struct Events {
+    std::vector<DiscoveryEvent> type;
+    std::vector<uint8_t> hw;
+    std::vector<uint8_t> address;
+};
+
+/**
+ * @brief Runs one full round on bus; returns the probes spent.
+ */
+static uint32_t round(I2cDiscovery& d, FakeBuses& buses, BusId bus, Events& events) {
+    uint32_t before = buses.probes;
+    uint8_t address;
+    while (d.nextProbe(bus, address)) {
+        uint8_t hw;
+        DiscoveryEvent e = d.report(bus, address, buses.probe(bus, address), hw);
+        if (e == DISCOVERY_NONE) continue;
+        events.type.push_back(e);
+        events.hw.push_back(hw);
+        events.address.push_back(address);
+    }
+    return buses.probes - before;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_round_probes_known_addresses_plus_a_sweep_slice() {
+    I2cDiscovery d(ALL_COMPILED);
+    FakeBuses buses;
+    Events events;
+    // SGP bus: 3 known addresses + the sweep slice
+    TEST_ASSERT_EQUAL(3 + I2cDiscovery::SWEEP_PER_ROUND, round(d, buses, BUS_I2C_SGP, events));
+    TEST_ASSERT_EQUAL(1 + I2cDiscovery::SWEEP_PER_ROUND, round(d, buses, BUS_I2C_MAIN, events));
+    TEST_ASSERT_EQUAL(0, events.type.size());
+}
+
+void test_sweep_covers_every_free_address() {
+    I2cDiscovery d(ALL_COMPILED);
+    FakeBuses buses;
+    Events events;
+    // 112 addresses, 3 of them known on the SGP bus
+    const uint32_t rounds = (112 - 3 + I2cDiscovery::SWEEP_PER_ROUND - 1) / I2cDiscovery::SWEEP_PER_ROUND;
+    for (uint32_t i = 0; i < rounds - 1; i++) round(d, buses, BUS_I2C_SGP, events);
+    TEST_ASSERT_EQUAL(0, d.sweeps(BUS_I2C_SGP));
+    round(d, buses, BUS_I2C_SGP, events);
+    TEST_ASSERT_EQUAL(1, d.sweeps(BUS_I2C_SGP));
+}
+
+void test_round_resumes_after_budget_cut() {
+    I2cDiscovery d(ALL_COMPILED);
+    uint8_t a1, a2, a3;
+    TEST_ASSERT_TRUE(d.nextProbe(BUS_I2C_SGP, a1));
+    TEST_ASSERT_TRUE(d.nextProbe(BUS_I2C_SGP, a2));
+    // Budget spent: the caller stops here; the round continues next time
+    TEST_ASSERT_TRUE(d.nextProbe(BUS_I2C_SGP, a3));
+    TEST_ASSERT_EQUAL_HEX8(0x58, a1);
+    TEST_ASSERT_EQUAL_HEX8(0x59, a2);
+    TEST_ASSERT_EQUAL_HEX8(0x44, a3);
+}
+
+void test_hot_plugged_sensor_appears_once() {
+    I2cDiscovery d(ALL_COMPILED);
+    FakeBuses buses;
+    Events events;
+    round(d, buses, BUS_I2C_SGP, events);
+    TEST_ASSERT_FALSE(d.present(HW_SHT31));
+
+    buses.sgp.push_back(0x44);
+    round(d, buses, BUS_I2C_SGP, events);
+    TEST_ASSERT_EQUAL(1, events.type.size());
+    TEST_ASSERT_EQUAL(DISCOVERY_APPEARED, events.type[0]);
+    TEST_ASSERT_EQUAL(HW_SHT31, events.hw[0]);
+    TEST_ASSERT_TRUE(d.present(HW_SHT31));
+
+    round(d, buses, BUS_I2C_SGP, events);
+    TEST_ASSERT_EQUAL(1, events.type.size());
+}
+
+void test_unplugged_sensor_is_retired_after_missed_rounds() {
+    I2cDiscovery d(ALL_COMPILED);
+    FakeBuses buses;
+    buses.main.push_back(0x76);
+    d.setPresent(HW_BMP280, true);
+    Events events;
+
+    round(d, buses, BUS_I2C_MAIN, events);
+    buses.remove(BUS_I2C_MAIN, 0x76);
+    for (int i = 0; i < I2cDiscovery::LOST_AFTER - 1; i++) round(d, buses, BUS_I2C_MAIN, events);
+    TEST_ASSERT_TRUE(d.present(HW_BMP280));
+    TEST_ASSERT_EQUAL(0, events.type.size());
+
+    round(d, buses, BUS_I2C_MAIN, events);
+    TEST_ASSERT_EQUAL(1, events.type.size());
+    TEST_ASSERT_EQUAL(DISCOVERY_LOST, events.type[0]);
+    TEST_ASSERT_FALSE(d.present(HW_BMP280));
+
+    // A single missed round does not retire it (glitch)
+    buses.main.push_back(0x76);
+    round(d, buses, BUS_I2C_MAIN, events);
+    buses.remove(BUS_I2C_MAIN, 0x76);
+    round(d, buses, BUS_I2C_MAIN, events);
+    buses.main.push_back(0x76);
+    round(d, buses, BUS_I2C_MAIN, events);
+    TEST_ASSERT_EQUAL(2, events.type.size());
+    TEST_ASSERT_EQUAL(DISCOVERY_APPEARED, events.type[1]);
+}
+
+void test_failed_init_is_held_off() {
+    I2cDiscovery d(ALL_COMPILED);
+    FakeBuses buses;
+    buses.sgp.push_back(0x58);
+    Events events;
+    round(d, buses, BUS_I2C_SGP, events);
+    TEST_ASSERT_EQUAL(1, events.type.size());
+    d.initFailed(HW_SGP30);
+
+    for (int i = 0; i < I2cDiscovery::INIT_HOLDOFF; i++) round(d, buses, BUS_I2C_SGP, events);
+    TEST_ASSERT_EQUAL(1, events.type.size());
+    round(d, buses, BUS_I2C_SGP, events);
+    TEST_ASSERT_EQUAL(2, events.type.size());
+    TEST_ASSERT_EQUAL(DISCOVERY_APPEARED, events.type[1]);
+}
+
+void test_unknown_device_reported_once() {
+    I2cDiscovery d(ALL_COMPILED);
+    FakeBuses buses;
+    buses.sgp.push_back(0x3C);     // OLED display, no driver
+    Events events;
+    for (int i = 0; i < 80; i++) round(d, buses, BUS_I2C_SGP, events);
+    TEST_ASSERT_EQUAL(1, events.type.size());
+    TEST_ASSERT_EQUAL(DISCOVERY_UNKNOWN, events.type[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x3C, events.address[0]);
+    TEST_ASSERT_EQUAL(1, d.unknownCount(BUS_I2C_SGP));
+}
+
+void test_address_without_driver_is_unknown() {
+    bool compiled[HW_COUNT] = {};
+    compiled[HW_SHT31] = true;
+    I2cDiscovery d(compiled);
+    FakeBuses buses;
+    buses.sgp.push_back(0x58);     // SGP30 fitted, driver not in this build
+    Events events;
+    // Only the SHT31 address is known
+    TEST_ASSERT_EQUAL(1 + I2cDiscovery::SWEEP_PER_ROUND, round(d, buses, BUS_I2C_SGP, events));
+    for (int i = 0; i < 80; i++) round(d, buses, BUS_I2C_SGP, events);
+    TEST_ASSERT_EQUAL(1, events.type.size());
+    TEST_ASSERT_EQUAL(DISCOVERY_UNKNOWN, events.type[0]);
+    TEST_ASSERT_FALSE(d.present(HW_SGP30));
+}
+
+void test_stuck_bus_backs_off() {
+    I2cDiscovery d(ALL_COMPILED);
+    FakeBuses buses;
+    buses.main.push_back(0x76);
+    d.setPresent(HW_BMP280, true);
+    buses.stuck = true;
+    Events events;
+
+    // One probe per attempt, attempts 1, 2, 4, ... BUS_BACKOFF_MAX rounds apart
+    const int ROUNDS = 300;
+    for (int i = 0; i < ROUNDS; i++) round(d, buses, BUS_I2C_MAIN, events);
+    uint32_t attempts = events.type.size();
+    TEST_ASSERT_EQUAL(attempts, buses.probes);
+    for (DiscoveryEvent e : events.type) TEST_ASSERT_EQUAL(DISCOVERY_BUS_FAULT, e);
+    TEST_ASSERT_TRUE(attempts <= 7 + ROUNDS / (I2cDiscovery::BUS_BACKOFF_MAX + 1) + 1);
+    char msg[80];
+    snprintf(msg, sizeof(msg), "stuck bus: %u ms of timeouts over %d rounds (%u without backoff)",
+             (unsigned)buses.stallMs, ROUNDS, ROUNDS * 1000);
+    TEST_MESSAGE(msg);
+
+    // Not counted as misses: the read stage deals with the sensor
+    TEST_ASSERT_TRUE(d.present(HW_BMP280));
+
+    // The other bus is not affected
+    uint32_t before = buses.probes;
+    round(d, buses, BUS_I2C_SGP, events);
+    TEST_ASSERT_EQUAL(3 + I2cDiscovery::SWEEP_PER_ROUND, buses.probes - before);
+
+    // Released: full rounds again within one backoff, streak reset
+    buses.stuck = false;
+    for (int i = 0; i <= I2cDiscovery::BUS_BACKOFF_MAX; i++) round(d, buses, BUS_I2C_MAIN, events);
+    TEST_ASSERT_EQUAL(0, d.backoff(BUS_I2C_MAIN));
+    TEST_ASSERT_EQUAL(1 + I2cDiscovery::SWEEP_PER_ROUND, round(d, buses, BUS_I2C_MAIN, events));
+    buses.stuck = true;
+    round(d, buses, BUS_I2C_MAIN, events);
+    TEST_ASSERT_EQUAL(1, d.backoff(BUS_I2C_MAIN));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_probes_known_addresses_plus_a_sweep_slice);
+    RUN_TEST(test_sweep_covers_every_free_address);
+    RUN_TEST(test_round_resumes_after_budget_cut);
+    RUN_TEST(test_hot_plugged_sensor_appears_once);
+    RUN_TEST(test_unplugged_sensor_is_retired_after_missed_rounds);
+    RUN_TEST(test_failed_init_is_held_off);
+    RUN_TEST(test_unknown_device_reported_once);
+    RUN_TEST(test_address_without_driver_is_unknown);
+    RUN_TEST(test_stuck_bus_backs_off);
+    return UNITY_END();
+}
@@ -0,0 +1,281 @@
+// MuxSensors is only compiled in with SENSOR_I2C_MUX: whatever the profile here
+#define SENSOR_I2C_MUX 1
+
+#include <unity.h>
+#include <stdio.h>
+#include "SimMux.h"
+#include "../../../src/MuxSensors.cpp"
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static TwoWire wireSGP(1);
+
+/**
+ * @brief Fresh bus model and clock for each test.
+ */
+static SimMux& freshMux() {
+    static SimMux* mux = nullptr;
+    delete mux;
+    mux = new SimMux();
+    SimBus::instance().load(nullptr, 0);
+    SimBus::instance().setModel(mux);
+    return *mux;
+}
+
+/**
+ * @brief Runs one full read cycle, results of every instance in events/values
+ * (events[i] = 0xFF when the instance was skipped).
+ */
+static void runCycle(MuxSensors& sensors, uint8_t* events, float (*values)[MUX_MAX_MEASUREMENTS] = nullptr) {
+    memset(events, 0xFF, MuxReadPlan::MAX_INSTANCES);
+    TEST_ASSERT_TRUE(sensors.startCycle());
+    MuxResult results[MuxReadPlan::MAX_INSTANCES];
+    while (sensors.busy()) {
+        uint8_t n = sensors.readGroup(results);
+        for (uint8_t k = 0; k < n; k++) {
+            events[results[k].instance] = results[k].event;
+            if (values) memcpy(values[results[k].instance], results[k].values, sizeof(results[k].values));
+        }
+    }
+}
+
+// Four channels with an SHT31 and an SGP40 each, declared per kind (the
+// order a bench wiring list is usually written in)
+static const MuxSensorSpec BENCH[] = {
+    { MUX_SHT31, BUS_I2C_SGP, 0, 0x44 },
+    { MUX_SHT31, BUS_I2C_SGP, 1, 0x44 },
+    { MUX_SHT31, BUS_I2C_SGP, 2, 0x44 },
+    { MUX_SHT31, BUS_I2C_SGP, 3, 0x44 },
+    { MUX_SGP40, BUS_I2C_SGP, 0, 0x59 },
+    { MUX_SGP40, BUS_I2C_SGP, 1, 0x59 },
+    { MUX_SGP40, BUS_I2C_SGP, 2, 0x59 },
+    { MUX_SGP40, BUS_I2C_SGP, 3, 0x59 },
+    { MUX_BMP280, BUS_I2C_MAIN, MUX_DIRECT, 0x76 },
+};
+static const uint8_t BENCH_COUNT = sizeof(BENCH) / sizeof(BENCH[0]);
+
+static void addBench(SimMux& mux) {
+    for (uint8_t i = 0; i < BENCH_COUNT; i++) {
+        const MuxSensorSpec& s = BENCH[i];
+        // Distinct values per instance: 20.x °C / 40+x % / VOC 100+x / 1000x Pa
+        switch (s.kind) {
+            case MUX_SHT31: mux.add(s.kind, s.bus, s.channel, s.address, 20.0f + i, 40.0f + i); break;
+            case MUX_SGP40: mux.add(s.kind, s.bus, s.channel, s.address, 100.0f + i); break;
+            default: mux.add(s.kind, s.bus, s.channel, s.address, 101325.0f, 21.5f); break;
+        }
+    }
+}
+
+// ============================================================================
+// Read plan
+// ============================================================================
+
+void test_hardware_ids() {
+    char id[MuxSensors::ID_SIZE];
+    const MuxSensorSpec sht = { MUX_SHT31, BUS_I2C_SGP, 3, 0x44 };
+    const MuxSensorSpec bmp = { MUX_BMP280, BUS_I2C_MAIN, MUX_DIRECT, 0x77 };
+    TEST_ASSERT_EQUAL(11, muxHardwareId(sht, id, sizeof(id)));
+    TEST_ASSERT_EQUAL_STRING("sht31-s3-44", id);
+    muxHardwareId(bmp, id, sizeof(id));
+    TEST_ASSERT_EQUAL_STRING("bmp280-md-77", id);
+}
+
+void test_plan_groups_by_channel() {
+    MuxReadPlan plan;
+    TEST_ASSERT_EQUAL(MUX_PLAN_OK, plan.build(BENCH, BENCH_COUNT));
+
+    // Direct BMP280 on the main bus, then channels 0-3 of the SGP bus
+    TEST_ASSERT_EQUAL(5, plan.groupCount());
+    TEST_ASSERT_EQUAL(MUX_DIRECT, plan.group(0).channel);
+    for (uint8_t g = 1; g < 5; g++) {
+        TEST_ASSERT_EQUAL(g - 1, plan.group(g).channel);
+        TEST_ASSERT_EQUAL(2, plan.group(g).count);
+        // Declaration order kept within a group: the SHT31 before the SGP40
+        TEST_ASSERT_EQUAL(MUX_SHT31, BENCH[plan.instance(plan.group(g).first)].kind);
+        TEST_ASSERT_EQUAL(MUX_SGP40, BENCH[plan.instance(plan.group(g).first + 1)].kind);
+    }
+    TEST_ASSERT_EQUAL(4, plan.switchesPerCycle());
+    TEST_ASSERT_EQUAL(8, muxSwitches(BENCH, nullptr, BENCH_COUNT));     // Declaration order
+}
+
+void test_plan_rejects_bad_specs() {
+    MuxReadPlan plan;
+    const MuxSensorSpec duplicate[] = { { MUX_SHT31, BUS_I2C_SGP, 2, 0x44 }, { MUX_SHT31, BUS_I2C_SGP, 2, 0x44 } };
+    const MuxSensorSpec channel[] = { { MUX_SHT31, BUS_I2C_SGP, 8, 0x44 } };
+    const MuxSensorSpec fixed[] = { { MUX_SGP40, BUS_I2C_SGP, 0, 0x58 } };
+    const MuxSensorSpec muxAddress[] = { { MUX_SHT31, BUS_I2C_SGP, 0, 0x70 } };
+    TEST_ASSERT_EQUAL(MUX_PLAN_DUPLICATE, plan.build(duplicate, 2));
+    TEST_ASSERT_EQUAL(MUX_PLAN_BAD_SPEC, plan.build(channel, 1));
+    TEST_ASSERT_EQUAL(MUX_PLAN_BAD_SPEC, plan.build(fixed, 1));
+    TEST_ASSERT_EQUAL(MUX_PLAN_MUX_ADDRESS, plan.build(muxAddress, 1));
+    TEST_ASSERT_EQUAL(MUX_PLAN_TOO_MANY, plan.build(BENCH, MuxReadPlan::MAX_INSTANCES + 1));
+
+    // Same address on two channels, or on the same channel of two buses: fine
+    const MuxSensorSpec ok[] = { { MUX_SHT31, BUS_I2C_SGP, 2, 0x44 }, { MUX_SHT31, BUS_I2C_SGP, 3, 0x44 },
+                                 { MUX_SHT31, BUS_I2C_MAIN, 2, 0x44 } };
+    TEST_ASSERT_EQUAL(MUX_PLAN_OK, plan.build(ok, 3));
+}
+
+// ============================================================================
+// Reads against the simulated multiplexer
+// ============================================================================
+
+void test_instances_report_their_own_values() {
+    SimMux& mux = freshMux();
+    addBench(mux);
+    MuxSensors sensors(Wire, wireSGP);
+    TEST_ASSERT_EQUAL(MUX_PLAN_OK, sensors.begin(BENCH, BENCH_COUNT));
+
+    uint8_t events[MuxReadPlan::MAX_INSTANCES];
+    float values[MuxReadPlan::MAX_INSTANCES][MUX_MAX_MEASUREMENTS];
+    runCycle(sensors, events, values);
+    for (uint8_t i = 0; i < BENCH_COUNT; i++) TEST_ASSERT_EQUAL(MUX_APPEARED, events[i]);
+
+    runCycle(sensors, events, values);
+    for (uint8_t i = 0; i < BENCH_COUNT; i++) {
+        TEST_ASSERT_EQUAL(MUX_SAMPLE, events[i]);
+        TEST_ASSERT_TRUE(sensors.present(i));
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(20.0f + i, values[i][0]);
+        TEST_ASSERT_EQUAL_FLOAT(40.0f + i, values[i][1]);
+        TEST_ASSERT_EQUAL_FLOAT(104.0f + i, values[4 + i][0]);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(1013.25f, values[8][0]);
+    TEST_ASSERT_EQUAL_STRING("sgp40-s2-59", sensors.hardwareId(6));
+}
+
+void test_one_selection_per_channel_group() {
+    SimMux& mux = freshMux();
+    addBench(mux);
+    MuxSensors sensors(Wire, wireSGP);
+    sensors.begin(BENCH, BENCH_COUNT);
+
+    uint8_t events[MuxReadPlan::MAX_INSTANCES];
+    for (int cycle = 0; cycle < 5; cycle++) {
+        uint32_t before = mux.selects(BUS_I2C_SGP);
+        runCycle(sensors, events);
+        TEST_ASSERT_EQUAL(4, mux.selects(BUS_I2C_SGP) - before);
+        TEST_ASSERT_EQUAL(4, sensors.lastCycleSelects());
+    }
+    TEST_ASSERT_EQUAL(0, mux.selects(BUS_I2C_MAIN));     // No multiplexer there
+
+    // Released for the discovery, then selected again by the next cycle
+    sensors.release();
+    TEST_ASSERT_EQUAL(0, mux.selection(BUS_I2C_SGP));
+    sensors.release();
+    uint32_t before = mux.selects(BUS_I2C_SGP);
+    runCycle(sensors, events);
+    TEST_ASSERT_EQUAL(4, mux.selects(BUS_I2C_SGP) - before);
+}
+
+void test_unplugged_instance_retired_then_back() {
+    SimMux& mux = freshMux();
+    addBench(mux);
+    MuxSensors sensors(Wire, wireSGP);
+    sensors.begin(BENCH, BENCH_COUNT);
+    uint8_t events[MuxReadPlan::MAX_INSTANCES];
+    runCycle(sensors, events);
+
+    // SHT31 of channel 2 unplugged: retired after LOST_AFTER failed cycles,
+    // its neighbours keep reading (the SGP40 of channel 2 included)
+    mux.plug(2, false);
+    for (uint8_t c = 1; c < MuxSensors::LOST_AFTER; c++) {
+        runCycle(sensors, events);
+        TEST_ASSERT_EQUAL(MUX_FAILED, events[2]);
+    }
+    runCycle(sensors, events);
+    TEST_ASSERT_EQUAL(MUX_LOST, events[2]);
+    TEST_ASSERT_FALSE(sensors.present(2));
+    for (uint8_t i = 0; i < BENCH_COUNT; i++) {
+        if (i != 2) TEST_ASSERT_EQUAL(MUX_SAMPLE, events[i]);
+    }
+
+    // Replugged: picked up by the next init attempt
+    mux.plug(2, true);
+    int cycles = 0;
+    do {
+        runCycle(sensors, events);
+        cycles++;
+    } while (events[2] != MUX_APPEARED && cycles < 3 * MuxSensors::RETRY_CYCLES);
+    TEST_ASSERT_EQUAL(MUX_APPEARED, events[2]);
+    TEST_ASSERT_LESS_OR_EQUAL(MuxSensors::RETRY_CYCLES + 1, cycles);
+}
+
+void test_same_address_direct_and_behind_mux_collides() {
+    // An SHT31 at 0x44 directly on the bus answers together with the one of
+    // the selected channel: both transactions are garbled
+    SimMux& mux = freshMux();
+    const MuxSensorSpec specs[] = { { MUX_SHT31, BUS_I2C_SGP, MUX_DIRECT, 0x44 }, { MUX_SHT31, BUS_I2C_SGP, 0, 0x44 } };
+    mux.add(MUX_SHT31, BUS_I2C_SGP, MUX_DIRECT, 0x44, 20, 40);
+    mux.add(MUX_SHT31, BUS_I2C_SGP, 0, 0x44, 21, 41);
+    MuxSensors sensors(Wire, wireSGP);
+    TEST_ASSERT_EQUAL(MUX_PLAN_OK, sensors.begin(specs, 2));
+    uint8_t events[MuxReadPlan::MAX_INSTANCES];
+    runCycle(sensors, events);
+    TEST_ASSERT_EQUAL(MUX_APPEARED, events[0]);     // Read before the channel is selected
+    TEST_ASSERT_EQUAL(0xFF, events[1]);             // Init failed, retried later
+}
+
+// ============================================================================
+// Cycle time per added sensor
+// ============================================================================
+
+/**
+ * @brief Bus time of a full cycle with the first n instances of specs.
+ */
+static uint32_t cycleUs(const MuxSensorSpec* specs, uint8_t n, uint8_t& selects) {
+    SimMux& mux = freshMux();
+    for (uint8_t i = 0; i < n; i++) mux.add(specs[i].kind, specs[i].bus, specs[i].channel, specs[i].address, 20, 40);
+    MuxSensors sensors(Wire, wireSGP);
+    selects = 0;
+    if (sensors.begin(specs, n) != MUX_PLAN_OK) return 0;
+    uint8_t events[MuxReadPlan::MAX_INSTANCES];
+    runCycle(sensors, events);      // Inits
+    runCycle(sensors, events);
+    selects = sensors.lastCycleSelects();
+    return sensors.lastCycleUs();
+}
+
+void test_cycle_time_per_added_sensor() {
+    // Same sensors added one at a time: one SHT31 per channel, then SGP40s
+    // next to them (their channel is already selected for the SHT31)
+    MuxSensorSpec specs[16];
+    for (uint8_t c = 0; c < 8; c++) {
+        specs[c] = { MUX_SHT31, BUS_I2C_SGP, c, 0x44 };
+        specs[8 + c] = { MUX_SGP40, BUS_I2C_SGP, c, 0x59 };
+    }
+
+    printf("[BENCH] sensors  cycle ms  selects  added sensor\n");
+    uint32_t previous = 0;
+    for (uint8_t n = 1; n <= 16; n++) {
+        uint8_t selects;
+        uint32_t us = cycleUs(specs, n, selects);
+        uint32_t added = us - previous;
+        printf("[BENCH] %7u  %8.1f  %7u  +%u us (%s)\n", n, us / 1000.0f, selects, added,
+               MUX_KIND_TABLE[specs[n - 1].kind].id);
+        // Each added sensor costs its own transaction, plus one selection
+        // only if it opens a new channel. A single channel stays selected
+        // from one cycle to the next
+        uint8_t channels = n <= 8 ? n : 8;
+        uint32_t expected = n <= 8 ? 15000 + SimMux::SELECT_US : 30000 + SimMux::I2C_ADDRESS_US;
+        if (n > 2) TEST_ASSERT_EQUAL(expected, added);
+        TEST_ASSERT_EQUAL(channels > 1 ? channels : 0, selects);
+        previous = us;
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_hardware_ids);
+    RUN_TEST(test_plan_groups_by_channel);
+    RUN_TEST(test_plan_rejects_bad_specs);
+    RUN_TEST(test_instances_report_their_own_values);
+    RUN_TEST(test_one_selection_per_channel_group);
+    RUN_TEST(test_unplugged_instance_retired_then_back);
+    RUN_TEST(test_same_address_direct_and_behind_mux_collides);
+    RUN_TEST(test_cycle_time_per_added_sensor);
+    return UNITY_END();
+}
@@ -0,0 +1,122 @@
+#include <unity.h>
+#include <math.h>
+#include "PairStats.h"
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static const uint32_t BLOCK_MS = 300000;
+static const uint8_t BLOCKS = 12;
+typedef PairStats<BLOCKS> Stats;
+
+/**
+ * @brief One sample per second over [startMs, startMs + durationMs), b = a + offset.
+ */
+static void feed(Stats& stats, uint32_t startMs, uint32_t durationMs, float offset) {
+    for (uint32_t t = 0; t < durationMs; t += 1000) {
+        float a = 20.0f + (t / 1000 % 10) * 0.1f;
+        stats.add(a, a + offset, startMs + t);
+    }
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_moments_of_a_constant_offset() {
+    PairMoments m;
+    for (int i = 0; i < 100; i++) {
+        double x = 20.0 + (i % 10) * 0.1;
+        m.add(x, x + 0.5, i / 3600.0);
+    }
+    TEST_ASSERT_EQUAL_UINT32(100, m.n);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, (float)m.bias());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.5f, (float)m.rms());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, (float)m.pearson());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, (float)m.drift());
+}
+
+void test_merge_matches_a_single_pass() {
+    PairMoments whole, first, second;
+    for (int i = 0; i < 200; i++) {
+        double x = sin(i * 0.1) * 3.0, y = x * 1.1 + 0.02 * i, t = i / 60.0;
+        whole.add(x, y, t);
+        (i < 70 ? first : second).add(x, y, t);
+    }
+    first.merge(second);
+    TEST_ASSERT_EQUAL_UINT32(whole.n, first.n);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9f, (float)whole.bias(), (float)first.bias());
+    TEST_ASSERT_FLOAT_WITHIN(1e-9f, (float)whole.rms(), (float)first.rms());
+    TEST_ASSERT_FLOAT_WITHIN(1e-9f, (float)whole.pearson(), (float)first.pearson());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, (float)whole.drift(), (float)first.drift());
+}
+
+void test_window_slides_one_block_at_a_time() {
+    Stats stats(BLOCK_MS);
+    feed(stats, 0, BLOCK_MS, 1.0f);
+    feed(stats, BLOCK_MS, BLOCK_MS * BLOCKS, 2.0f);
+    // The first block is exactly one block past the window
+    PairMoments w = stats.window(BLOCK_MS * (BLOCKS + 1));
+    TEST_ASSERT_EQUAL_UINT32(BLOCK_MS / 1000 * BLOCKS, w.n);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.0f, (float)w.bias());
+    TEST_ASSERT_EQUAL_UINT32(BLOCK_MS / 1000 * (BLOCKS + 1), stats.lifetime().n);
+}
+
+void test_gap_within_the_window_keeps_old_blocks() {
+    Stats stats(BLOCK_MS);
+    feed(stats, 0, 60000, 1.0f);
+    // The sampled block closed BLOCKS blocks ago: still the oldest of the window
+    stats.add(20.0f, 23.0f, BLOCK_MS * BLOCKS + 1000);
+    PairMoments w = stats.window(BLOCK_MS * BLOCKS + 1000);
+    TEST_ASSERT_EQUAL_UINT32(61, w.n);
+}
+
+void test_gap_longer_than_the_window_clears_it() {
+    Stats stats(BLOCK_MS);
+    feed(stats, 0, BLOCK_MS * 3 + 60000, 1.0f);
+    // Silence for longer than the window, including the block in progress
+    uint32_t resumeMs = BLOCK_MS * (BLOCKS + 5);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.window(resumeMs).n);
+
+    feed(stats, resumeMs, 60000, 3.0f);
+    PairMoments w = stats.window(resumeMs + 60000);
+    TEST_ASSERT_EQUAL_UINT32(60, w.n);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 3.0f, (float)w.bias());
+    // Lifetime keeps everything
+    TEST_ASSERT_EQUAL_UINT32((BLOCK_MS * 3 + 60000) / 1000 + 60, stats.lifetime().n);
+}
+
+void test_gap_longer_than_the_window_on_add() {
+    Stats stats(BLOCK_MS);
+    feed(stats, 0, 60000, 1.0f);
+    // No report in between: the next sample alone rolls the window
+    stats.add(20.0f, 23.0f, BLOCK_MS * (BLOCKS + 1) + 1000);
+    PairMoments w = stats.window(BLOCK_MS * (BLOCKS + 1) + 1000);
+    TEST_ASSERT_EQUAL_UINT32(1, w.n);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 3.0f, (float)w.bias());
+}
+
+void test_window_across_millis_wrap() {
+    Stats stats(BLOCK_MS);
+    uint32_t startMs = 0xFFFFFFFFu - BLOCK_MS / 2;
+    feed(stats, startMs, BLOCK_MS, 1.0f);
+    PairMoments w = stats.window(startMs + BLOCK_MS);
+    TEST_ASSERT_EQUAL_UINT32(BLOCK_MS / 1000, w.n);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0f, (float)w.bias());
+
+    stats.add(20.0f, 23.0f, startMs + BLOCK_MS * (BLOCKS + 2));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.window(startMs + BLOCK_MS * (BLOCKS + 2)).n);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_moments_of_a_constant_offset);
+    RUN_TEST(test_merge_matches_a_single_pass);
+    RUN_TEST(test_window_slides_one_block_at_a_time);
+    RUN_TEST(test_gap_within_the_window_keeps_old_blocks);
+    RUN_TEST(test_gap_longer_than_the_window_clears_it);
+    RUN_TEST(test_gap_longer_than_the_window_on_add);
+    RUN_TEST(test_window_across_millis_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,283 @@
+#include <unity.h>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Channels.h"
+#include "DerivedMetrics.h"
+#include "TopicTable.h"
+
+// ============================================================================
+// Heap accounting
+// ============================================================================
+
+static size_t heapAllocations = 0;
+
+void* operator new(size_t size) {
+    heapAllocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+static const char* MODULE_ID = "air-quality-benchmark";
+
+/**
+ * @brief Stand-in for the Arduino-ESP32 String used by brain.publish(): 11
+ * bytes inline (SSO), heap buffer grown on every concat past that.
+ */
+class LegacyString {
+public:
+    explicit LegacyString(const char* s) { concat(s); }
+    ~LegacyString() { if (_heap) delete[] _heap; }
+
+    void concat(const char* s) {
+        size_t n = strlen(s);
+        size_t len = _len + n;
+        if (len > SSO_CAPACITY) {
+            char* grown = new char[len + 1];
+            memcpy(grown, c_str(), _len);
+            if (_heap) delete[] _heap;
+            _heap = grown;
+        }
+        memcpy((char*)c_str() + _len, s, n + 1);
+        _len = len;
+    }
+
+    const char* c_str() const { return _heap ? _heap : _sso; }
+    size_t length() const { return _len; }
+
+private:
+    static const size_t SSO_CAPACITY = 11;
+    char _sso[SSO_CAPACITY + 1] = {};
+    char* _heap = nullptr;
+    size_t _len = 0;
+};
+
+// Transport stand-in: both paths end with (topic, payload, length)
+static volatile uint32_t transportSink = 0;
+static void transport(const char* topic, const char* payload, size_t len) {
+    transportSink += (uint8_t)topic[0] + (uint8_t)payload[0] + (uint32_t)len;
+}
+
+/**
+ * @brief brain.publish(hw, measurement, value): topic concatenated and value
+ * printed with "%.2f" on every call.
+ */
+static void legacyPublish(const char* hardwareId, const char* measurement, float value) {
+    LegacyString topic(MODULE_ID);
+    topic.concat("/");
+    topic.concat(hardwareId);
+    topic.concat("/");
+    topic.concat(measurement);
+    char buf[33];
+    snprintf(buf, sizeof(buf), "%.2f", value);
+    LegacyString payload(buf);
+    transport(topic.c_str(), payload.c_str(), payload.length());
+}
+
+typedef TopicTable<CH_COUNT + HW_COUNT + DM_COUNT, 1536> PublishTopics;
+
+static uint8_t internChannels(PublishTopics& topics, uint8_t* ids) {
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++) {
+        ids[ch] = topics.intern(MODULE_ID, HARDWARE_TABLE[CHANNEL_TABLE[ch].hw].id, CHANNEL_TABLE[ch].measurement,
+                                CHANNEL_TABLE[ch].decimals);
+    }
+    return topics.count();
+}
+
+// ============================================================================
+// Formatter
+// ============================================================================
+
+static void assertFormat(const char* expected, float value, uint8_t decimals) {
+    char out[FIXED_MAX_CHARS];
+    size_t len = formatFixed(out, sizeof(out), value, decimals);
+    TEST_ASSERT_EQUAL_STRING(expected, out);
+    TEST_ASSERT_EQUAL(strlen(expected), len);
+}
+
+void test_format_typical_values() {
+    assertFormat("612", 612.0f, 0);
+    assertFormat("21.37", 21.37f, 2);
+    assertFormat("44.1", 44.1f, 1);
+    assertFormat("1013.25", 1013.25f, 2);
+    assertFormat("0.48", 0.48f, 2);
+    assertFormat("5.2", 5.2f, 1);
+    assertFormat("60000", 60000.0f, 0);
+    assertFormat("0.0500", 0.05f, 4);
+}
+
+void test_format_rounding_and_sign() {
+    assertFormat("1.0", 0.96f, 1);
+    assertFormat("10", 9.5f, 0);
+    assertFormat("-3.25", -3.25f, 2);
+    assertFormat("-12", -11.6f, 0);
+    // No negative zero
+    assertFormat("0.00", -0.001f, 2);
+    assertFormat("0", -0.0f, 0);
+    // Precision capped at FIXED_MAX_DECIMALS
+    assertFormat("3.1416", 3.14159f, 9);
+}
+
+void test_format_matches_printf_over_sensor_ranges() {
+    // Values in the channel ranges, against "%.*f". The float product may
+    // round a near tie (x.xx5 is never exact in binary) the other way than
+    // printf's exact conversion: allowed, by one unit of the last digit
+    static const double UNIT[FIXED_MAX_DECIMALS + 1] = { 1, 0.1, 0.01, 0.001, 0.0001 };
+    uint32_t seed = 42;
+    int ties = 0;
+    for (int i = 0; i < 200000; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        uint8_t decimals = (uint8_t)(seed >> 30);
+        float value = (float)(seed % 20000000) / 100.0f - 20000.0f;
+        char fixed[FIXED_MAX_CHARS], ref[32];
+        formatFixed(fixed, sizeof(fixed), value, decimals);
+        snprintf(ref, sizeof(ref), "%.*f", decimals, value);
+        if (strcmp(fixed, ref) == 0) continue;
+
+        double scaled = fabs((double)value) / UNIT[decimals];
+        double fromTie = fabs(scaled - floor(scaled) - 0.5);
+        TEST_ASSERT_TRUE_MESSAGE(fromTie < 1e-3, ref);
+        TEST_ASSERT_TRUE_MESSAGE(fabs(atof(ref) - atof(fixed)) <= UNIT[decimals] * 1.001, ref);
+        ties++;
+    }
+    char msg[64];
+    snprintf(msg, sizeof(msg), "%d near ties rounded differently from printf", ties);
+    TEST_MESSAGE(msg);
+}
+
+void test_format_fallback_and_small_buffer() {
+    char out[FIXED_MAX_CHARS];
+    // Beyond 32 bits once scaled: printf path
+    TEST_ASSERT_EQUAL(12, formatFixed(out, sizeof(out), 5e9f, 1));
+    TEST_ASSERT_EQUAL_STRING("5000000000.0", out);
+    TEST_ASSERT_EQUAL(3, formatFixed(out, sizeof(out), NAN, 2));
+    TEST_ASSERT_EQUAL_STRING("nan", out);
+
+    char small[5];
+    TEST_ASSERT_EQUAL(0, formatFixed(small, sizeof(small), 21.37f, 2));
+    TEST_ASSERT_EQUAL(4, formatFixed(small, sizeof(small), 21.4f, 1));
+    TEST_ASSERT_EQUAL_STRING("21.4", small);
+}
+
+// ============================================================================
+// Topic table
+// ============================================================================
+
+void test_topics_interned_once() {
+    PublishTopics topics;
+    uint8_t ids[CH_COUNT];
+    TEST_ASSERT_EQUAL(CH_COUNT, internChannels(topics, ids));
+    TEST_ASSERT_EQUAL_STRING("air-quality-benchmark/sps30/pm25", topics.topic(ids[CH_SPS30_PM25]));
+    TEST_ASSERT_EQUAL(strlen("air-quality-benchmark/sps30/pm25"), topics.topicLength(ids[CH_SPS30_PM25]));
+    TEST_ASSERT_EQUAL(2, topics.decimals(ids[CH_BMP280_PRESSURE]));
+
+    // Re-registration (hot-plug) returns the same entries, arena unchanged
+    size_t used = topics.arenaUsed();
+    uint8_t again[CH_COUNT];
+    internChannels(topics, again);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(ids, again, CH_COUNT);
+    TEST_ASSERT_EQUAL(used, topics.arenaUsed());
+
+    // Same measurement name under another hardware is another topic
+    TEST_ASSERT_NOT_EQUAL(ids[CH_SHT31_TEMPERATURE], ids[CH_DHT22_TEMPERATURE]);
+}
+
+void test_topics_full_table_and_arena() {
+    TopicTable<2, 64> topics;
+    TEST_ASSERT_EQUAL(0, topics.intern("m", "a", "x", 1));
+    TEST_ASSERT_EQUAL(1, topics.intern("m", "b", "x", 1));
+    TEST_ASSERT_EQUAL(topics.NONE, topics.intern("m", "c", "x", 1));
+    TEST_ASSERT_EQUAL(0, topics.intern("m", "a", "x", 1));
+
+    TopicTable<4, 16> tight;
+    TEST_ASSERT_EQUAL(0, tight.intern("module", "hw", "m", 0));    // 11 + NUL
+    TEST_ASSERT_EQUAL(tight.NONE, tight.intern("module", "hw", "mm", 0));
+    TEST_ASSERT_NULL(tight.topic(tight.NONE));
+
+    char out[FIXED_MAX_CHARS];
+    TEST_ASSERT_EQUAL(0, tight.render(tight.NONE, 1.0f, out, sizeof(out)));
+}
+
+void test_render_uses_channel_precision() {
+    PublishTopics topics;
+    uint8_t ids[CH_COUNT];
+    internChannels(topics, ids);
+    char out[FIXED_MAX_CHARS];
+    topics.render(ids[CH_MHZ14A_CO2], 612.4f, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("612", out);
+    topics.render(ids[CH_DHT22_HUMIDITY], 45.04f, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("45.0", out);
+    topics.render(ids[CH_SHT31_TEMPERATURE], 21.374f, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("21.37", out);
+}
+
+// ============================================================================
+// Benchmark (ns per publish and heap allocations per cycle, host)
+// ============================================================================
+
+static const int BENCH_CYCLES = 100000;
+
+// One cycle: every channel published once, values drifting like the sensors
+static float benchValue(uint8_t ch, uint32_t& seed) {
+    static const float BASE[CH_COUNT] = { 612, 21.6f, 45, 100, 455, 30, 3.1f, 5.2f, 6.0f, 6.4f,
+                                          1013.25f, 21.9f, 21.37f, 44.1f, 7 };
+    seed = seed * 1664525u + 1013904223u;
+    return BASE[ch] + (float)(seed >> 24) / 64.0f;
+}
+
+template <typename Publish>
+static void runBenchmark(const char* name, Publish publish, size_t& allocationsPerCycle) {
+    uint32_t seed = 12345;
+    size_t before = heapAllocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_CYCLES; i++) {
+        for (uint8_t ch = 0; ch < CH_COUNT; ch++) publish((Channel)ch, benchValue(ch, seed));
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / ((double)BENCH_CYCLES * CH_COUNT);
+    allocationsPerCycle = (heapAllocations - before) / BENCH_CYCLES;
+
+    char msg[112];
+    snprintf(msg, sizeof(msg), "[BENCH] %-34s %7.1f ns/publish %4u allocations/cycle", name, ns,
+             (unsigned)allocationsPerCycle);
+    TEST_MESSAGE(msg);
+}
+
+void test_benchmark_publish_path() {
+    static PublishTopics topics;
+    static uint8_t ids[CH_COUNT];
+    internChannels(topics, ids);
+
+    size_t legacyAllocations, internedAllocations;
+    runBenchmark("String topic + \"%.2f\" (brain)", [](Channel ch, float v) {
+        legacyPublish(HARDWARE_TABLE[CHANNEL_TABLE[ch].hw].id, CHANNEL_TABLE[ch].measurement, v);
+    }, legacyAllocations);
+    runBenchmark("Interned topic + formatFixed", [](Channel ch, float v) {
+        char payload[FIXED_MAX_CHARS];
+        size_t len = topics.render(ids[ch], v, payload, sizeof(payload));
+        transport(topics.topic(ids[ch]), payload, len);
+    }, internedAllocations);
+
+    TEST_ASSERT_EQUAL(0, internedAllocations);
+    TEST_ASSERT_GREATER_OR_EQUAL(CH_COUNT, legacyAllocations);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_format_typical_values);
+    RUN_TEST(test_format_rounding_and_sign);
+    RUN_TEST(test_format_matches_printf_over_sensor_ranges);
+    RUN_TEST(test_format_fallback_and_small_buffer);
+    RUN_TEST(test_topics_interned_once);
+    RUN_TEST(test_topics_full_table_and_arena);
+    RUN_TEST(test_render_uses_channel_precision);
+    RUN_TEST(test_benchmark_publish_path);
+    return UNITY_END();
+}
@@ -0,0 +1,295 @@
+#include <unity.h>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include "Channels.h"
+#include "SampleSink.h"
+#include "CsvSink.h"
+#include "TopicTable.h"
+
+// ============================================================================
+// Heap accounting
+// ============================================================================
+
+static size_t heapAllocations = 0;
+
+void* operator new(size_t size) {
+    heapAllocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+typedef TopicTable<CH_COUNT, 1024> Topics;
+
+static void internChannels(Topics& topics) {
+    for (uint8_t ch = 0; ch < CH_COUNT; ch++) {
+        topics.intern("air-quality-benchmark", HARDWARE_TABLE[CHANNEL_TABLE[ch].hw].id,
+                      CHANNEL_TABLE[ch].measurement, CHANNEL_TABLE[ch].decimals);
+    }
+}
+
+/**
+ * @brief Sink keeping what it was given: set addresses and the values sum.
+ */
+class RecordingSink : public SampleSink {
+public:
+    RecordingSink(uint8_t depth, SinkPolicy policy, uint32_t intervalMs) : SampleSink(depth, policy, intervalMs) {}
+
+    const SampleSet* last = nullptr;
+    uint32_t lastSequence = 0;
+    uint32_t values = 0;
+    float sum = 0;
+
+protected:
+    uint8_t consume(const SampleSet& set, uint8_t from, uint32_t) override {
+        last = &set;
+        lastSequence = set.sequence();
+        for (uint8_t i = from; i < set.size(); i++) sum += set[i].value;
+        values += set.size() - from;
+        return set.size();
+    }
+};
+
+// CSV transport: a UART buffer of room bytes, drained by the test
+struct Uart {
+    std::string out;
+    size_t room = 1024;
+};
+
+static void uartWrite(const char* data, size_t len, void* ctx) {
+    Uart* u = (Uart*)ctx;
+    u->out.append(data, len);
+    u->room -= len;
+}
+
+static size_t uartRoom(void* ctx) {
+    return ((Uart*)ctx)->room;
+}
+
+// ============================================================================
+// Fan-out
+// ============================================================================
+
+void test_one_set_shared_by_every_sink() {
+    SampleFanout<3, 8> fanout;
+    RecordingSink a(1, SINK_DROP_OLDEST, 0), b(2, SINK_DROP_OLDEST, 0), c(4, SINK_DROP_OLDEST, 0);
+    TEST_ASSERT_TRUE(fanout.attach(&a));
+    TEST_ASSERT_TRUE(fanout.attach(&b));
+    TEST_ASSERT_TRUE(fanout.attach(&c));
+
+    fanout.add(0, 612, 1000);
+    fanout.add(1, 21.5f, 1000);
+    fanout.add(2, 45, 1000);
+    fanout.flush(1000);
+
+    // The same buffer, not three copies, and back in the pool afterwards
+    TEST_ASSERT_NOT_NULL(a.last);
+    TEST_ASSERT_EQUAL_PTR(a.last, b.last);
+    TEST_ASSERT_EQUAL_PTR(a.last, c.last);
+    TEST_ASSERT_EQUAL(3, a.last->size());
+    TEST_ASSERT_EQUAL(1000, a.last->timeMs());
+    TEST_ASSERT_EQUAL_FLOAT(678.5f, c.sum);
+    TEST_ASSERT_EQUAL(0, a.last->refs());
+    TEST_ASSERT_EQUAL(0, fanout.setsInUse());
+    TEST_ASSERT_EQUAL(1, fanout.sets());
+
+    // A pass without values dispatches nothing
+    fanout.flush(1010);
+    TEST_ASSERT_EQUAL(1, fanout.sets());
+    TEST_ASSERT_EQUAL(1, a.delivered());
+}
+
+void test_attach_bounded_by_pool() {
+    SampleFanout<3, 6> fanout;
+    RecordingSink a(4, SINK_DROP_OLDEST, 0), b(1, SINK_DROP_OLDEST, 0), c(1, SINK_DROP_OLDEST, 0);
+    TEST_ASSERT_TRUE(fanout.attach(&a));
+    TEST_ASSERT_TRUE(fanout.attach(&b));     // 1 open + 4 + 1 = 6
+    TEST_ASSERT_FALSE(fanout.attach(&c));
+    TEST_ASSERT_EQUAL(2, fanout.sinkCount());
+}
+
+void test_full_pass_split_into_sets() {
+    SampleFanout<1, 4> fanout;
+    RecordingSink a(2, SINK_DROP_NEWEST, 0);
+    fanout.attach(&a);
+    for (uint8_t i = 0; i < SampleSet::CAPACITY + 5; i++) fanout.add(i, 1, 0);
+    fanout.flush(0);
+    TEST_ASSERT_EQUAL(2, fanout.sets());
+    TEST_ASSERT_EQUAL(SampleSet::CAPACITY + 5, a.values);
+    TEST_ASSERT_EQUAL(0, a.dropped());
+}
+
+void test_slow_sink_drops_only_its_own_sets() {
+    SampleFanout<2, 4> fanout;
+    RecordingSink fast(1, SINK_DROP_OLDEST, 0);
+    RecordingSink slow(2, SINK_DROP_OLDEST, 1000);     // A display refreshed every second
+    fanout.attach(&fast);
+    fanout.attach(&slow);
+
+    // One set every 100 ms for 2 s
+    for (uint32_t t = 0; t < 2000; t += 100) {
+        fanout.add(0, (float)t, t);
+        fanout.flush(t);
+        TEST_ASSERT_TRUE(fanout.setsInUse() <= 3);
+    }
+    TEST_ASSERT_EQUAL(20, fast.delivered());
+    TEST_ASSERT_EQUAL(0, fast.dropped());
+
+    // Serviced at 0 and 1000 ms, with the last two sets of each second
+    TEST_ASSERT_EQUAL(3, slow.delivered());
+    TEST_ASSERT_EQUAL(15, slow.dropped());
+    TEST_ASSERT_EQUAL(10, slow.lastSequence);
+    TEST_ASSERT_EQUAL(2, slow.queued());
+
+    // The held set is still intact while the fast sink moved on
+    fanout.add(0, 5, 2000);
+    fanout.flush(2000);
+    TEST_ASSERT_EQUAL(20, slow.lastSequence);
+    TEST_ASSERT_EQUAL(0, fanout.setsInUse());
+}
+
+void test_drop_newest_keeps_the_queue() {
+    SampleFanout<1, 3> fanout;
+    RecordingSink sink(2, SINK_DROP_NEWEST, 1000);
+    fanout.attach(&sink);
+    fanout.add(0, 1, 0);
+    fanout.flush(0);                        // Serviced at once
+    for (uint32_t t = 100; t <= 400; t += 100) {
+        fanout.add(0, (float)t, t);
+        fanout.flush(t);
+    }
+    TEST_ASSERT_EQUAL(2, sink.dropped());
+    fanout.flush(1000);
+    TEST_ASSERT_EQUAL(2, sink.lastSequence);     // Sets 1 and 2 kept, 3 and 4 refused
+    TEST_ASSERT_EQUAL_FLOAT(1 + 100 + 200, sink.sum);
+}
+
+// ============================================================================
+// CSV sink
+// ============================================================================
+
+void test_csv_lines() {
+    static Topics topics;
+    internChannels(topics);
+    Uart uart;
+    CsvSink<Topics> csv(topics, uartWrite, uartRoom, &uart);
+    SampleFanout<1, 6> fanout;
+    fanout.attach(&csv);
+
+    fanout.add(CH_SHT31_TEMPERATURE, 21.374f, 183004);
+    fanout.add(CH_MHZ14A_CO2, 612.4f, 183004);
+    fanout.flush(183004);
+    TEST_ASSERT_EQUAL_STRING("time_ms,hardware,measurement,value\n"
+                             "183004,sht31,temperature,21.37\n"
+                             "183004,mhz14a,co2,612\n", uart.out.c_str());
+    TEST_ASSERT_EQUAL(2, csv.lines());
+}
+
+void test_csv_waits_for_room_and_reports_drops() {
+    static Topics topics;
+    internChannels(topics);
+    Uart uart;
+    uart.room = 0;
+    CsvSink<Topics> csv(topics, uartWrite, uartRoom, &uart);
+    SampleFanout<1, 6> fanout;
+    fanout.attach(&csv);
+
+    // UART full: six sets offered, the oldest two pushed out of the queue
+    for (uint32_t t = 1; t <= 6; t++) {
+        fanout.add(CH_SGP40_VOC, 100 + t, t);
+        fanout.add(CH_SPS30_PM25, 5.2f, t);
+        fanout.flush(t);
+    }
+    TEST_ASSERT_EQUAL(0, uart.out.size());
+    TEST_ASSERT_EQUAL(4, csv.queued());
+    TEST_ASSERT_EQUAL(2, csv.dropped());
+
+    // Room for the header, the drop notice and one line: stops inside the set
+    uart.room = 35 + 12 + 16;
+    fanout.flush(7);
+    TEST_ASSERT_EQUAL_STRING("time_ms,hardware,measurement,value\n"
+                             "# dropped 2\n"
+                             "3,sgp40,voc,103\n", uart.out.c_str());
+    TEST_ASSERT_EQUAL(1, csv.lines());
+
+    // Resumes with the second sample of the same set
+    uart.out.clear();
+    uart.room = 1024;
+    fanout.flush(8);
+    TEST_ASSERT_EQUAL_STRING("3,sps30,pm25,5.2\n"
+                             "4,sgp40,voc,104\n4,sps30,pm25,5.2\n"
+                             "5,sgp40,voc,105\n5,sps30,pm25,5.2\n"
+                             "6,sgp40,voc,106\n6,sps30,pm25,5.2\n", uart.out.c_str());
+    TEST_ASSERT_EQUAL(0, fanout.setsInUse());
+}
+
+// ============================================================================
+// Benchmark (cost of an extra output, host)
+// ============================================================================
+
+static const int BENCH_PASSES = 200000;
+
+// Consumes without encoding: what is left is the fan-out itself
+class NullSink : public SampleSink {
+public:
+    NullSink() : SampleSink(1, SINK_DROP_OLDEST, 0) {}
+    volatile uint32_t seen = 0;
+
+protected:
+    uint8_t consume(const SampleSet& set, uint8_t, uint32_t) override {
+        seen += set.size();
+        return set.size();
+    }
+};
+
+static double benchmarkSinks(uint8_t sinkCount, size_t& allocations) {
+    static NullSink sinks[4];
+    SampleFanout<4, 5> fanout;
+    for (uint8_t i = 0; i < sinkCount; i++) fanout.attach(&sinks[i]);
+
+    size_t before = heapAllocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < BENCH_PASSES; p++) {
+        // A busy pass: two channels read
+        fanout.add(CH_SHT31_TEMPERATURE, 21.37f, p);
+        fanout.add(CH_SHT31_HUMIDITY, 44.1f, p);
+        fanout.flush(p);
+    }
+    auto end = std::chrono::steady_clock::now();
+    allocations = heapAllocations - before;
+    return std::chrono::duration<double, std::nano>(end - start).count() / BENCH_PASSES;
+}
+
+void test_benchmark_extra_output() {
+    size_t allocations[4];
+    double ns[4];
+    char msg[96];
+    for (uint8_t n = 1; n <= 4; n++) {
+        ns[n - 1] = benchmarkSinks(n, allocations[n - 1]);
+        snprintf(msg, sizeof(msg), "[BENCH] %u sinks %6.1f ns/pass %3u allocations", n, ns[n - 1],
+                 (unsigned)allocations[n - 1]);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_EQUAL(0, allocations[n - 1]);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_one_set_shared_by_every_sink);
+    RUN_TEST(test_attach_bounded_by_pool);
+    RUN_TEST(test_full_pass_split_into_sets);
+    RUN_TEST(test_slow_sink_drops_only_its_own_sets);
+    RUN_TEST(test_drop_newest_keeps_the_queue);
+    RUN_TEST(test_csv_lines);
+    RUN_TEST(test_csv_waits_for_room_and_reports_drops);
+    RUN_TEST(test_benchmark_extra_output);
+    return UNITY_END();
+}
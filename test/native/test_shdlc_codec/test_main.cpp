@@ -0,0 +1,195 @@
+#include <unity.h>
+#include <string.h>
+#include "ShdlcCodec.h"
+
+// ============================================================================
+// Captured traffic
+// ============================================================================
+
+// Bench capture, SPS30 fw 2.2 at 115200 baud. Requests as sent by the
+// Sensirion library (identical to the datasheet examples)
+static const uint8_t MOSI_START[] = { 0x7E, 0x00, 0x00, 0x02, 0x01, 0x03, 0xF9, 0x7E };
+static const uint8_t MOSI_READ[] = { 0x7E, 0x00, 0x03, 0x00, 0xFC, 0x7E };
+static const uint8_t MOSI_WAKEUP[] = { 0x7E, 0x00, 0x7D, 0x31, 0x00, 0xEE, 0x7E };    // 0x11 stuffed
+static const uint8_t MOSI_SERIAL[] = { 0x7E, 0x00, 0xD0, 0x01, 0x03, 0x2B, 0x7E };
+
+static const uint8_t MISO_START_ACK[] = { 0x7E, 0x00, 0x00, 0x00, 0x00, 0xFF, 0x7E };
+
+// Read answer: PM1 1.1, PM2.5 2.3, PM4 2.9, PM10 3.0 µg/m³, number
+// concentrations 7.4 .. 9.2 #/cm³, typical size 0.48 µm. 0x13 and 0x11 in
+// the floats are stuffed
+static const uint8_t MISO_MEASUREMENT[] = {
+    0x7E, 0x00, 0x03, 0x00, 0x28, 0x3F, 0x8C, 0xCC, 0xCD, 0x40, 0x7D, 0x33,
+    0x33, 0x33, 0x40, 0x39, 0x99, 0x9A, 0x40, 0x40, 0x00, 0x00, 0x40, 0xEC,
+    0xCC, 0xCD, 0x41, 0x0E, 0x66, 0x66, 0x41, 0x7D, 0x31, 0x99, 0x9A, 0x41,
+    0x7D, 0x33, 0x33, 0x33, 0x41, 0x7D, 0x33, 0x33, 0x33, 0x3E, 0xF5, 0xC2,
+    0x8F, 0x2E, 0x7E,
+};
+
+// Serial number "8D2F0C9A1B6E4477" + NUL: length 0x11 stuffed
+static const uint8_t MISO_SERIAL[] = {
+    0x7E, 0x00, 0xD0, 0x00, 0x7D, 0x31, 0x38, 0x44, 0x32, 0x46, 0x30, 0x43, 0x39,
+    0x41, 0x31, 0x42, 0x36, 0x45, 0x34, 0x34, 0x37, 0x37, 0x00, 0x79, 0x7E,
+};
+
+// Read while idle: state 0x43 (command not allowed in current state)
+static const uint8_t MISO_NOT_ALLOWED[] = { 0x7E, 0x00, 0x03, 0x43, 0x00, 0xB9, 0x7E };
+
+/**
+ * @brief Feeds bytes, returns the status of the last one that was not
+ * SHDLC_PENDING (SHDLC_PENDING if none).
+ */
+static ShdlcStatus feed(ShdlcDecoder& d, const uint8_t* bytes, size_t len) {
+    ShdlcStatus last = SHDLC_PENDING;
+    for (size_t i = 0; i < len; i++) {
+        ShdlcStatus s = d.feed(bytes[i]);
+        if (s != SHDLC_PENDING) last = s;
+    }
+    return last;
+}
+
+static ShdlcFrame request(uint8_t command, const uint8_t* data, uint8_t len) {
+    ShdlcFrame f = {};
+    f.command = command;
+    f.len = len;
+    memcpy(f.data, data, len);
+    return f;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_encode_matches_captured_requests() {
+    uint8_t out[SHDLC_MAX_FRAME];
+    const uint8_t floatFormat[2] = { 0x01, 0x03 };
+    const uint8_t serial = 0x03;
+
+    size_t n = shdlcEncode(request(0x00, floatFormat, 2), false, out, sizeof(out));
+    TEST_ASSERT_EQUAL(sizeof(MOSI_START), n);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(MOSI_START, out, n);
+
+    n = shdlcEncode(request(0x03, nullptr, 0), false, out, sizeof(out));
+    TEST_ASSERT_EQUAL(sizeof(MOSI_READ), n);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(MOSI_READ, out, n);
+
+    n = shdlcEncode(request(0x11, nullptr, 0), false, out, sizeof(out));
+    TEST_ASSERT_EQUAL(sizeof(MOSI_WAKEUP), n);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(MOSI_WAKEUP, out, n);
+
+    n = shdlcEncode(request(0xD0, &serial, 1), false, out, sizeof(out));
+    TEST_ASSERT_EQUAL(sizeof(MOSI_SERIAL), n);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(MOSI_SERIAL, out, n);
+}
+
+void test_encode_rejects_small_buffer() {
+    uint8_t out[5];
+    TEST_ASSERT_EQUAL(0, shdlcEncode(request(0x03, nullptr, 0), false, out, sizeof(out)));
+}
+
+void test_decode_measurement_byte_by_byte() {
+    ShdlcDecoder d;
+    for (size_t i = 0; i < sizeof(MISO_MEASUREMENT) - 1; i++) {
+        TEST_ASSERT_EQUAL(SHDLC_PENDING, d.feed(MISO_MEASUREMENT[i]));
+    }
+    TEST_ASSERT_EQUAL(SHDLC_FRAME, d.feed(MISO_MEASUREMENT[sizeof(MISO_MEASUREMENT) - 1]));
+
+    const ShdlcFrame& f = d.frame();
+    TEST_ASSERT_EQUAL_HEX8(0x03, f.command);
+    TEST_ASSERT_EQUAL_HEX8(0x00, f.state);
+    TEST_ASSERT_EQUAL(40, f.len);
+    TEST_ASSERT_EQUAL_FLOAT(1.1f, shdlcFloat(f.data));
+    TEST_ASSERT_EQUAL_FLOAT(2.3f, shdlcFloat(f.data + 4));
+    TEST_ASSERT_EQUAL_FLOAT(2.9f, shdlcFloat(f.data + 8));
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, shdlcFloat(f.data + 12));
+    TEST_ASSERT_EQUAL_FLOAT(0.48f, shdlcFloat(f.data + 36));
+}
+
+void test_decode_round_trip_of_answers() {
+    const uint8_t* frames[] = { MISO_START_ACK, MISO_MEASUREMENT, MISO_SERIAL, MISO_NOT_ALLOWED };
+    const size_t sizes[] = { sizeof(MISO_START_ACK), sizeof(MISO_MEASUREMENT), sizeof(MISO_SERIAL),
+                             sizeof(MISO_NOT_ALLOWED) };
+    ShdlcDecoder d;
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(SHDLC_FRAME, feed(d, frames[i], sizes[i]));
+        uint8_t out[SHDLC_MAX_FRAME];
+        size_t n = shdlcEncode(d.frame(), true, out, sizeof(out));
+        TEST_ASSERT_EQUAL(sizes[i], n);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(frames[i], out, n);
+    }
+}
+
+void test_decode_state_error_and_serial() {
+    ShdlcDecoder d;
+    TEST_ASSERT_EQUAL(SHDLC_FRAME, feed(d, MISO_NOT_ALLOWED, sizeof(MISO_NOT_ALLOWED)));
+    TEST_ASSERT_EQUAL_HEX8(0x43, d.frame().state);
+    TEST_ASSERT_EQUAL(0, d.frame().len);
+
+    TEST_ASSERT_EQUAL(SHDLC_FRAME, feed(d, MISO_SERIAL, sizeof(MISO_SERIAL)));
+    TEST_ASSERT_EQUAL(17, d.frame().len);
+    TEST_ASSERT_EQUAL_STRING("8D2F0C9A1B6E4477", (const char*)d.frame().data);
+}
+
+void test_noise_outside_frames_is_ignored() {
+    // Wake-up pulse and line noise before the answer
+    const uint8_t noise[] = { 0xFF, 0x00, 0x55 };
+    ShdlcDecoder d;
+    TEST_ASSERT_EQUAL(SHDLC_PENDING, feed(d, noise, sizeof(noise)));
+    TEST_ASSERT_EQUAL(SHDLC_FRAME, feed(d, MISO_START_ACK, sizeof(MISO_START_ACK)));
+}
+
+void test_bad_checksum_then_resync() {
+    uint8_t corrupt[sizeof(MISO_MEASUREMENT)];
+    memcpy(corrupt, MISO_MEASUREMENT, sizeof(corrupt));
+    corrupt[6] ^= 0x04;
+    ShdlcDecoder d;
+    TEST_ASSERT_EQUAL(SHDLC_BAD_CHECKSUM, feed(d, corrupt, sizeof(corrupt)));
+    TEST_ASSERT_EQUAL(SHDLC_FRAME, feed(d, MISO_START_ACK, sizeof(MISO_START_ACK)));
+}
+
+void test_truncated_frame_then_resync() {
+    // Answer cut before its end flag: the next start flag closes it as bad
+    // and starts the next frame
+    ShdlcDecoder d;
+    TEST_ASSERT_EQUAL(SHDLC_PENDING, feed(d, MISO_MEASUREMENT, 20));
+    TEST_ASSERT_EQUAL(SHDLC_BAD_LENGTH, d.feed(SHDLC_FLAG));
+    ShdlcStatus last = SHDLC_PENDING;
+    for (size_t i = 1; i < sizeof(MISO_NOT_ALLOWED); i++) {
+        ShdlcStatus s = d.feed(MISO_NOT_ALLOWED[i]);
+        if (s != SHDLC_PENDING) last = s;
+    }
+    TEST_ASSERT_EQUAL(SHDLC_FRAME, last);
+    TEST_ASSERT_EQUAL_HEX8(0x43, d.frame().state);
+}
+
+void test_oversized_frame_rejected() {
+    ShdlcDecoder d;
+    d.feed(SHDLC_FLAG);
+    for (int i = 0; i < 200; i++) d.feed(0x20);
+    TEST_ASSERT_EQUAL(SHDLC_BAD_LENGTH, d.feed(SHDLC_FLAG));
+    TEST_ASSERT_EQUAL(SHDLC_FRAME, feed(d, MISO_START_ACK, sizeof(MISO_START_ACK)));
+}
+
+void test_request_decoder_reads_mosi() {
+    ShdlcDecoder d(false);
+    TEST_ASSERT_EQUAL(SHDLC_FRAME, feed(d, MOSI_START, sizeof(MOSI_START)));
+    TEST_ASSERT_EQUAL_HEX8(0x00, d.frame().command);
+    TEST_ASSERT_EQUAL(2, d.frame().len);
+    TEST_ASSERT_EQUAL(SHDLC_FRAME, feed(d, MOSI_WAKEUP, sizeof(MOSI_WAKEUP)));
+    TEST_ASSERT_EQUAL_HEX8(0x11, d.frame().command);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_encode_matches_captured_requests);
+    RUN_TEST(test_encode_rejects_small_buffer);
+    RUN_TEST(test_decode_measurement_byte_by_byte);
+    RUN_TEST(test_decode_round_trip_of_answers);
+    RUN_TEST(test_decode_state_error_and_serial);
+    RUN_TEST(test_noise_outside_frames_is_ignored);
+    RUN_TEST(test_bad_checksum_then_resync);
+    RUN_TEST(test_truncated_frame_then_resync);
+    RUN_TEST(test_oversized_frame_rejected);
+    RUN_TEST(test_request_decoder_reads_mosi);
+    return UNITY_END();
+}
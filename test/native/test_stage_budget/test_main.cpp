@@ -0,0 +1,88 @@
+#include <unity.h>
+#include "StageBudget.h"
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+static const uint8_t READ_STAGE = STAGE_READ + HW_BMP280;
+static const uint32_t OVER_US = (uint32_t)STAGE_BUDGET_MS[READ_STAGE] * 1000 + 1;
+
+/**
+ * @brief Overruns the read stage until it is backed off at nowMs.
+ */
+static void backOff(StageBudget& budget, uint32_t nowMs) {
+    StageAction action = STAGE_OK;
+    for (uint8_t i = 0; i < StageBudget::BACKOFF_AFTER; i++) action = budget.record(READ_STAGE, OVER_US, nowMs);
+    TEST_ASSERT_EQUAL(STAGE_BACKOFF, action);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+void test_fresh_stages_allowed_at_any_uptime() {
+    StageBudget budget;
+    // Boot, the int32 boundary (24.8 days) and the wrap (49.7 days)
+    const uint32_t TIMES[] = { 0, 1000, 0x7FFFFFFFu, 0x80000000u, 2147484000u, 0xFFFFFFFFu };
+    for (uint32_t t : TIMES) {
+        TEST_ASSERT_TRUE(budget.allowed(STAGE_BRAIN_LOOP, t));
+        TEST_ASSERT_TRUE(budget.allowed(READ_STAGE, t));
+    }
+}
+
+void test_cleared_stage_allowed_past_the_boundary() {
+    StageBudget budget;
+    backOff(budget, 1000);
+    budget.clear(READ_STAGE);
+    TEST_ASSERT_TRUE(budget.allowed(READ_STAGE, 2000));
+    TEST_ASSERT_TRUE(budget.allowed(READ_STAGE, 0x80000000u + 2000));
+}
+
+void test_backoff_across_the_int32_boundary() {
+    StageBudget budget;
+    const uint32_t start = 0x80000000u - 10000;
+    backOff(budget, start);
+    TEST_ASSERT_FALSE(budget.allowed(READ_STAGE, start));
+    TEST_ASSERT_FALSE(budget.allowed(READ_STAGE, start + StageBudget::BACKOFF_MS - 1));
+    TEST_ASSERT_TRUE(budget.allowed(READ_STAGE, start + StageBudget::BACKOFF_MS));
+    // Lifted for good: still allowed half a wrap later
+    TEST_ASSERT_TRUE(budget.allowed(READ_STAGE, start + StageBudget::BACKOFF_MS + 0x80000000u));
+}
+
+void test_backoff_across_the_wrap() {
+    StageBudget budget;
+    const uint32_t start = 0xFFFFFFFFu - 10000;
+    backOff(budget, start);
+    TEST_ASSERT_FALSE(budget.allowed(READ_STAGE, 0));
+    TEST_ASSERT_FALSE(budget.allowed(READ_STAGE, StageBudget::BACKOFF_MS - 10002));
+    TEST_ASSERT_TRUE(budget.allowed(READ_STAGE, StageBudget::BACKOFF_MS - 10001));
+    TEST_ASSERT_TRUE(budget.allowed(READ_STAGE, 0x90000000u));
+}
+
+void test_escalation_ladder() {
+    StageBudget budget;
+    TEST_ASSERT_EQUAL(STAGE_OVERRUN, budget.record(READ_STAGE, OVER_US, 0));
+    TEST_ASSERT_EQUAL(STAGE_OVERRUN, budget.record(READ_STAGE, OVER_US, 0));
+    TEST_ASSERT_EQUAL(STAGE_BACKOFF, budget.record(READ_STAGE, OVER_US, 0));
+    TEST_ASSERT_EQUAL(STAGE_OVERRUN, budget.record(READ_STAGE, OVER_US, 0));
+    TEST_ASSERT_EQUAL(STAGE_OVERRUN, budget.record(READ_STAGE, OVER_US, 0));
+    TEST_ASSERT_EQUAL(STAGE_DISABLED, budget.record(READ_STAGE, OVER_US, 0));
+    TEST_ASSERT_FALSE(budget.allowed(READ_STAGE, 0x80000000u));
+
+    // Non-read stages only count
+    for (uint8_t i = 0; i < StageBudget::DISABLE_AFTER; i++) {
+        TEST_ASSERT_EQUAL(STAGE_OVERRUN, budget.record(STAGE_SERVICES, 1000000, 0));
+    }
+    TEST_ASSERT_TRUE(budget.allowed(STAGE_SERVICES, 0));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fresh_stages_allowed_at_any_uptime);
+    RUN_TEST(test_cleared_stage_allowed_past_the_boundary);
+    RUN_TEST(test_backoff_across_the_int32_boundary);
+    RUN_TEST(test_backoff_across_the_wrap);
+    RUN_TEST(test_escalation_ladder);
+    return UNITY_END();
+}
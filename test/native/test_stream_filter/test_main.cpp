@@ -0,0 +1,252 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include "StreamFilter.h"
+#include "FilterConfig.h"
+
+// ============================================================================
+// Stage behaviour
+// ============================================================================
+
+void test_running_median_rejects_single_spike() {
+    RunningMedian<float, 5> median;
+    const float input[] = { 10, 11, 10, 500, 11, 10, 11 };
+    float out = 0;
+    for (float v : input) {
+        out = v;
+        median.apply(out, 0);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 10.5f, out);
+}
+
+void test_sliding_window_median_and_mad() {
+    SlidingWindow<float, 5> w;
+    const float input[] = { 1, 2, 3, 4, 100 };
+    for (float v : input) w.push(v);
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, w.median());
+    // |x - 3| = 2, 1, 0, 1, 97 -> MAD 1
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, w.mad(3.0f));
+
+    // Oldest value (1) leaves the window
+    w.push(5);
+    TEST_ASSERT_EQUAL_FLOAT(4.0f, w.median());
+}
+
+void test_hampel_replaces_outlier_with_median() {
+    Hampel<float, 7> hampel(3.0f);
+    const float input[] = { 20.0f, 20.2f, 19.9f, 20.1f, 20.0f, 20.3f, 19.8f };
+    for (float v : input) {
+        float x = v;
+        hampel.apply(x, 0);
+    }
+    float spike = 45.0f;
+    TEST_ASSERT_TRUE(hampel.apply(spike, 0));
+    TEST_ASSERT_FLOAT_WITHIN(0.2f, 20.0f, spike);
+    TEST_ASSERT_EQUAL_UINT32(1, hampel.outliers());
+
+    float normal = 20.1f;
+    hampel.apply(normal, 0);
+    TEST_ASSERT_EQUAL_FLOAT(20.1f, normal);
+}
+
+void test_hampel_reject_mode_drops_sample() {
+    Hampel<int, 5> hampel(3.0f, HAMPEL_REJECT);
+    hampel.setMinDeviation(2);
+    const int input[] = { 3, 3, 4, 3, 3 };
+    for (int v : input) {
+        int x = v;
+        hampel.apply(x, 0);
+    }
+    int spike = 250;
+    TEST_ASSERT_FALSE(hampel.apply(spike, 0));
+
+    // Within the minimum deviation on a flat window: kept
+    int small = 4;
+    TEST_ASSERT_TRUE(hampel.apply(small, 0));
+    TEST_ASSERT_EQUAL_INT(4, small);
+}
+
+void test_hampel_clamp_mode_bounds_outlier() {
+    Hampel<float, 5> hampel(3.0f, HAMPEL_CLAMP);
+    hampel.setMinDeviation(5.0f);
+    for (int i = 0; i < 5; i++) {
+        float x = 10;
+        hampel.apply(x, 0);
+    }
+    float up = 90;
+    TEST_ASSERT_TRUE(hampel.apply(up, 0));
+    TEST_ASSERT_EQUAL_FLOAT(15.0f, up);
+    float down = -40;
+    TEST_ASSERT_TRUE(hampel.apply(down, 0));
+    TEST_ASSERT_EQUAL_FLOAT(5.0f, down);
+    TEST_ASSERT_EQUAL_UINT32(2, hampel.outliers());
+}
+
+void test_hampel_accepts_level_shift() {
+    Hampel<float, 5> hampel(3.0f);
+    hampel.setMinDeviation(0.5f);
+    for (int i = 0; i < 5; i++) {
+        float x = 400;
+        hampel.apply(x, 0);
+    }
+    float out = 0;
+    for (int i = 0; i < 5; i++) {
+        out = 800;
+        hampel.apply(out, 0);
+    }
+    TEST_ASSERT_EQUAL_FLOAT(800.0f, out);
+}
+
+void test_ema_smooths_and_passthrough() {
+    Ema<float> ema(0.5f);
+    float a = 10, b = 20;
+    ema.apply(a, 0);
+    ema.apply(b, 0);
+    TEST_ASSERT_EQUAL_FLOAT(15.0f, b);
+
+    Ema<float> pass(1.0f);
+    float c = 3, d = 7;
+    pass.apply(c, 0);
+    pass.apply(d, 0);
+    TEST_ASSERT_EQUAL_FLOAT(7.0f, d);
+}
+
+void test_rate_limiter_clamps_slope() {
+    RateLimiter<float> limiter(10.0f);  // 10 units/s
+    float a = 100;
+    limiter.apply(a, 0);
+    float b = 200;
+    limiter.apply(b, 1000);
+    TEST_ASSERT_EQUAL_FLOAT(110.0f, b);
+    float c = 50;
+    limiter.apply(c, 1500);
+    TEST_ASSERT_EQUAL_FLOAT(105.0f, c);
+}
+
+void test_chain_stops_on_drop() {
+    FilterChain<Hampel<float, 5>, Ema<float>> chain(Hampel<float, 5>(3.0f, HAMPEL_REJECT), Ema<float>(0.5f));
+    chain.first().setMinDeviation(5.0f);
+    for (int i = 0; i < 5; i++) {
+        float x = 10;
+        TEST_ASSERT_TRUE(chain.apply(x, 0));
+    }
+    float spike = 90;
+    TEST_ASSERT_FALSE(chain.apply(spike, 0));
+
+    // EMA state was not polluted by the dropped spike
+    float next = 12;
+    TEST_ASSERT_TRUE(chain.apply(next, 0));
+    TEST_ASSERT_EQUAL_FLOAT(11.0f, next);
+}
+
+// ============================================================================
+// Configured chains (FILTER_CONFIG)
+// ============================================================================
+
+/**
+ * @brief Feeds baseline for 20 samples, then stepLength samples of step and
+ * the baseline again, every periodMs. Writes the outputs of the step phase.
+ */
+static void runStep(Channel ch, float baseline, float step, uint8_t stepLength, uint32_t periodMs,
+                    float* out, uint8_t count) {
+    ChannelFilter filter = makeChannelFilter(FILTER_CONFIG[ch]);
+    uint32_t nowMs = 0;
+    for (int i = 0; i < 20; i++, nowMs += periodMs) {
+        float v = baseline;
+        filter.apply(v, nowMs);
+    }
+    for (uint8_t i = 0; i < count; i++, nowMs += periodMs) {
+        out[i] = i < stepLength ? step : baseline;
+        TEST_ASSERT_TRUE(filter.apply(out[i], nowMs));
+    }
+}
+
+void test_co_step_reaches_output() {
+    // Flat 2 ppm baseline (MAD 0), then 50 ppm, at the sc16co fastest cadence (1 s)
+    float out[20];
+    runStep(CH_SC16CO_CO, 2.0f, 50.0f, 20, 1000, out, 20);
+    TEST_ASSERT_GREATER_THAN(3.0f, out[0]);
+    for (uint8_t i = 1; i < 20; i++) TEST_ASSERT_TRUE(out[i] >= out[i - 1]);
+    // Hampel (4 samples), slope limiter (5 ppm/s) and EMA: settled after 16
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 50.0f, out[15]);
+}
+
+void test_short_co_spike_is_published() {
+    // Three samples at 100 ppm: shorter than it takes to move the Hampel median
+    float out[10];
+    runStep(CH_SC16CO_CO, 2.0f, 100.0f, 3, 1000, out, 10);
+    float peak = 0;
+    for (float v : out) peak = v > peak ? v : peak;
+    TEST_ASSERT_GREATER_THAN(5.0f, peak);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 2.0f, out[9]);
+}
+
+void test_co2_step_reaches_output() {
+    // 420 -> 1200 ppm at the mhz14a fastest cadence (2 s)
+    float out[25];
+    runStep(CH_MHZ14A_CO2, 420.0f, 1200.0f, 25, 2000, out, 25);
+    TEST_ASSERT_GREATER_THAN(420.0f, out[0]);
+    TEST_ASSERT_EQUAL_FLOAT(1200.0f, out[22]);
+}
+
+// ============================================================================
+// Micro-benchmarks (ns per sample, host)
+// ============================================================================
+
+static const int BENCH_SAMPLES = 1000000;
+
+template <typename Filter>
+static void runBenchmark(const char* name, Filter& filter) {
+    volatile float sink = 0;
+    uint32_t seed = 12345;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        float v = 400.0f + (float)(seed >> 24) / 16.0f + ((seed & 0xFFF) == 0 ? 300.0f : 0.0f);
+        if (filter.apply(v, (uint32_t)i * 1000)) sink = v;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / BENCH_SAMPLES;
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "[BENCH] %-28s %7.1f ns/sample", name, ns);
+    TEST_MESSAGE(msg);
+    (void)sink;
+}
+
+void test_benchmark_filters() {
+    RunningMedian<float, 5> median5;
+    RunningMedian<float, 15> median15;
+    Hampel<float, 7> hampel7(3.0f);
+    Hampel<float, 15> hampel15(3.0f);
+    Ema<float> ema(0.3f);
+    RateLimiter<float> limiter(50.0f);
+    FilterChain<Hampel<float, 7>, RateLimiter<float>, Ema<float>> chain(
+        Hampel<float, 7>(3.0f), RateLimiter<float>(50.0f), Ema<float>(0.5f));
+
+    runBenchmark("RunningMedian<float,5>", median5);
+    runBenchmark("RunningMedian<float,15>", median15);
+    runBenchmark("Hampel<float,7>", hampel7);
+    runBenchmark("Hampel<float,15>", hampel15);
+    runBenchmark("Ema<float>", ema);
+    runBenchmark("RateLimiter<float>", limiter);
+    runBenchmark("Hampel7 > RateLimiter > Ema", chain);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_running_median_rejects_single_spike);
+    RUN_TEST(test_sliding_window_median_and_mad);
+    RUN_TEST(test_hampel_replaces_outlier_with_median);
+    RUN_TEST(test_hampel_reject_mode_drops_sample);
+    RUN_TEST(test_hampel_clamp_mode_bounds_outlier);
+    RUN_TEST(test_hampel_accepts_level_shift);
+    RUN_TEST(test_ema_smooths_and_passthrough);
+    RUN_TEST(test_rate_limiter_clamps_slope);
+    RUN_TEST(test_chain_stops_on_drop);
+    RUN_TEST(test_co_step_reaches_output);
+    RUN_TEST(test_short_co_spike_is_published);
+    RUN_TEST(test_co2_step_reaches_output);
+    RUN_TEST(test_benchmark_filters);
+    return UNITY_END();
+}
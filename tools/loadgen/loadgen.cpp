@@ -0,0 +1,1108 @@
+/**
+ * @file loadgen.cpp
+ * @brief Fleet load generator: N simulated air-quality modules against a broker.
+ *
+ * Host-side (Linux) tool. Every simulated module opens the same two MQTT
+ * connections as the firmware (IotMesurable + SideChannel "{moduleId}-side"),
+ * registers the hardware / measurement set of the compiled sensor profile and
+ * publishes {moduleId}/{hardwareId}/{measurement} at the adaptive sampler
+ * cadence of the firmware (SamplerConfig.h), plus the sampler rates, derived metrics and the side
+ * channel reports. A monitor connection subscribed to +/+/+ timestamps every
+ * delivery to measure end-to-end latency.
+ *
+ * Build (from the repository root, profile as in platformio.ini):
+ *
+ *   g++ -std=gnu++17 -O2 -Wall -D PROFILE_FULL_BENCH -Iinclude tools/loadgen/loadgen.cpp -o loadgen
+ *
+ * Run against a local mosquitto (broker CPU is read from /proc):
+ *
+ *   ./loadgen --sweep 50,100,200,400,800 --duration 60 --speed 10 --storm 20
+ *
+ * --speed compresses time: a module at speed 10 publishes like 10 modules.
+ * Raise the fd limit (ulimit -n) above 2 x N + 16 for large sweeps.
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "profile.h"
+#include "Channels.h"
+#include "SamplerConfig.h"
+#include "DerivedMetrics.h"
+#include "TopicTable.h"
+
+// ============================================================================
+// Firmware model
+// ============================================================================
+
+// Same periods as main.cpp / the side channel services
+static const uint32_t RATE_PUBLISH_INTERVAL_MS = 30000;
+static const uint32_t DERIVED_MIN_INTERVAL_MS = 5000;
+static const uint32_t SIDE_REPORT_INTERVAL_MS = 60000;     // compare, system/resources
+static const uint8_t BRAIN_DECIMALS = 2;                    // brain.publish() payload: "%.2f"
+static const uint8_t SAMPLER_DECIMALS = 2;
+static const uint16_t KEEPALIVE_S = 15;
+static const uint32_t RECONNECT_MIN_MS = 2000;             // SideChannel backoff floor
+
+/**
+ * @brief Signal of one channel: daily cycle, noise and decaying events
+ * (cooking, window opening) that push the sampler to its fast cadence.
+ */
+struct ValueModel {
+    float base;
+    float diurnal;      // Amplitude of the 24 h cycle
+    float noise;        // Gaussian sigma
+    float eventPeak;    // Added at the start of an event
+};
+
+static const ValueModel VALUE_MODELS[CH_COUNT] = {
+    { 650,    150,  8,     900  },   // mhz14a co2
+    { 21.5f,  2,    0.1f,  1.5f },   // dht22 temperature
+    { 45,     8,    0.5f,  15   },   // dht22 humidity
+    { 100,    25,   3,     180  },   // sgp40 voc
+    { 500,    80,   10,    1200 },   // sgp30 eco2
+    { 60,     30,   5,     600  },   // sgp30 tvoc
+    { 3,      1,    0.3f,  40   },   // sps30 pm1
+    { 5,      2,    0.5f,  60   },   // sps30 pm25
+    { 6,      2,    0.5f,  70   },   // sps30 pm4
+    { 7,      2.5f, 0.6f,  80   },   // sps30 pm10
+    { 1013,   3,    0.05f, 0    },   // bmp280 pressure
+    { 22.5f,  2,    0.05f, 1.5f },   // bmp280 temperature
+    { 21.4f,  2,    0.05f, 1.5f },   // sht31 temperature
+    { 44,     8,    0.2f,  15   },   // sht31 humidity
+    { 1,      0.5f, 0.2f,  25   },   // sc16co co
+};
+
+static const float EVENTS_PER_HOUR = 0.5f;
+static const float EVENT_DECAY_S = 600;
+static const float EVENT_ACTIVE = 0.05f;    // Below this the sampler backs off
+
+// ============================================================================
+// Options
+// ============================================================================
+
+struct Options {
+    std::string host = "127.0.0.1";
+    uint16_t port = 1883;
+    std::vector<int> sweep = { 50 };
+    double durationS = 30;
+    double speed = 1;
+    double rampS = 2;              // Initial connections spread over this
+    double stormIntervalS = 0;     // 0: no reconnect storms
+    double stormFraction = 0.5;
+    double stormJitterS = 1;
+    bool side = true;
+    int brokerPid = 0;             // 0: first process named mosquitto
+    std::string prefix = "lg";
+    std::string csv;
+};
+
+static void usage(const char* argv0) {
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --host H            broker host (127.0.0.1)\n"
+        "  --port P            broker port (1883)\n"
+        "  --modules N         simulated modules (50)\n"
+        "  --sweep A,B,C       run one step per module count\n"
+        "  --duration S        measured seconds per step (30)\n"
+        "  --speed K           time compression of the publish cadence (1)\n"
+        "  --ramp S            initial connections spread over S seconds (2)\n"
+        "  --storm S           reconnect storm every S seconds (off)\n"
+        "  --storm-fraction F  share of modules dropped per storm (0.5)\n"
+        "  --storm-jitter S    reconnects spread over S seconds (1)\n"
+        "  --no-side           skip the SideChannel connection\n"
+        "  --broker-pid PID    broker process for CPU usage (auto: mosquitto)\n"
+        "  --prefix P          module ID prefix (lg)\n"
+        "  --csv FILE          also write one CSV row per step\n",
+        argv0);
+}
+
+static bool parseOptions(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "missing value for %s\n", a.c_str());
+                exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "--host") o.host = value();
+        else if (a == "--port") o.port = (uint16_t)atoi(value());
+        else if (a == "--modules") o.sweep = { atoi(value()) };
+        else if (a == "--sweep") {
+            o.sweep.clear();
+            std::string list = value();
+            for (size_t p = 0; p < list.size();) {
+                size_t c = list.find(',', p);
+                if (c == std::string::npos) c = list.size();
+                o.sweep.push_back(atoi(list.substr(p, c - p).c_str()));
+                p = c + 1;
+            }
+        }
+        else if (a == "--duration") o.durationS = atof(value());
+        else if (a == "--speed") o.speed = atof(value());
+        else if (a == "--ramp") o.rampS = atof(value());
+        else if (a == "--storm") o.stormIntervalS = atof(value());
+        else if (a == "--storm-fraction") o.stormFraction = atof(value());
+        else if (a == "--storm-jitter") o.stormJitterS = atof(value());
+        else if (a == "--no-side") o.side = false;
+        else if (a == "--broker-pid") o.brokerPid = atoi(value());
+        else if (a == "--prefix") o.prefix = value();
+        else if (a == "--csv") o.csv = value();
+        else return false;
+    }
+    for (int n : o.sweep) {
+        if (n <= 0) return false;
+    }
+    return !o.sweep.empty() && o.speed > 0 && o.durationS > 0;
+}
+
+// ============================================================================
+// Clock / process stats
+// ============================================================================
+
+static uint64_t nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static const uint64_t MS = 1000000ull;
+
+/**
+ * @brief utime + stime of a process, in clock ticks. -1 if unreadable.
+ */
+static long long processTicks(int pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE* f = fopen(path, "r");
+    if (!f) return -1;
+    char buf[1024];
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = 0;
+    // Fields after the parenthesised comm: state is field 3, utime 14, stime 15
+    const char* p = strrchr(buf, ')');
+    if (!p) return -1;
+    unsigned long long utime = 0, stime = 0;
+    if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu", &utime, &stime) != 2) return -1;
+    return (long long)(utime + stime);
+}
+
+static int findProcess(const char* name) {
+    DIR* d = opendir("/proc");
+    if (!d) return 0;
+    int found = 0;
+    while (dirent* e = readdir(d)) {
+        int pid = atoi(e->d_name);
+        if (pid <= 0) continue;
+        char path[64], comm[64] = {0};
+        snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+        FILE* f = fopen(path, "r");
+        if (!f) continue;
+        if (fgets(comm, sizeof(comm), f)) {
+            comm[strcspn(comm, "\n")] = 0;
+            if (strcmp(comm, name) == 0) found = pid;
+        }
+        fclose(f);
+        if (found) break;
+    }
+    closedir(d);
+    return found;
+}
+
+static double selfCpuSeconds() {
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+// ============================================================================
+// MQTT 3.1.1 client (QoS 0, non-blocking)
+// ============================================================================
+
+enum PacketType : uint8_t {
+    MQTT_CONNECT = 1,
+    MQTT_CONNACK = 2,
+    MQTT_PUBLISH = 3,
+    MQTT_SUBSCRIBE = 8,
+    MQTT_SUBACK = 9,
+    MQTT_PINGREQ = 12,
+    MQTT_PINGRESP = 13,
+};
+
+static void putRemainingLength(std::string& out, size_t len) {
+    do {
+        uint8_t b = len % 128;
+        len /= 128;
+        if (len > 0) b |= 0x80;
+        out.push_back((char)b);
+    } while (len > 0);
+}
+
+static void putString(std::string& out, const char* s, size_t len) {
+    out.push_back((char)(len >> 8));
+    out.push_back((char)(len & 0xFF));
+    out.append(s, len);
+}
+
+class MqttConn {
+public:
+    enum State { CLOSED, CONNECTING, WAIT_CONNACK, UP };
+
+    // Above this much unsent data publishes are refused, like AsyncMqttClient
+    // when the TCP window is full
+    static const size_t MAX_PENDING_BYTES = 32 * 1024;
+
+    typedef void (*PublishHandler)(void* ctx, const char* topic, size_t topicLen,
+                                   const char* payload, size_t payloadLen);
+
+    ~MqttConn() { close(); }
+
+    bool open(const sockaddr_in& addr, const std::string& clientId) {
+        close();
+        _fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (_fd < 0) return false;
+        int one = 1;
+        setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        _clientId = clientId;
+        _out.clear();
+        _outPos = 0;
+        _in.clear();
+        _openNs = nowNs();
+        if (connect(_fd, (const sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+            close();
+            return false;
+        }
+        _state = CONNECTING;
+        return true;
+    }
+
+    /**
+     * @brief Drops the connection without DISCONNECT (Wi-Fi loss, AP reboot).
+     */
+    void close() {
+        if (_fd >= 0) {
+            linger l = { 1, 0 };    // RST, like a vanished station
+            setsockopt(_fd, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+            ::close(_fd);
+        }
+        _fd = -1;
+        _state = CLOSED;
+    }
+
+    bool publish(const char* topic, const char* payload, size_t len, bool retain = false) {
+        if (_state != UP || pendingBytes() > MAX_PENDING_BYTES) return false;
+        size_t topicLen = strlen(topic);
+        _out.push_back((char)(MQTT_PUBLISH << 4 | (retain ? 1 : 0)));
+        putRemainingLength(_out, 2 + topicLen + len);
+        putString(_out, topic, topicLen);
+        _out.append(payload, len);
+        _lastSendNs = nowNs();
+        return flush();
+    }
+
+    bool subscribe(const char* filter) {
+        if (_state != UP) return false;
+        size_t len = strlen(filter);
+        _out.push_back((char)(MQTT_SUBSCRIBE << 4 | 0x02));
+        putRemainingLength(_out, 2 + 2 + len + 1);
+        uint16_t id = ++_packetId;
+        _out.push_back((char)(id >> 8));
+        _out.push_back((char)(id & 0xFF));
+        putString(_out, filter, len);
+        _out.push_back(0);     // QoS 0
+        _lastSendNs = nowNs();
+        return flush();
+    }
+
+    /**
+     * @brief Sends PINGREQ when nothing was sent for half the keep-alive.
+     */
+    void keepAlive(uint64_t now) {
+        if (_state != UP || now - _lastSendNs < KEEPALIVE_S * 500 * MS) return;
+        _out.push_back((char)(MQTT_PINGREQ << 4));
+        _out.push_back(0);
+        _lastSendNs = now;
+        flush();
+    }
+
+    /**
+     * @brief Handles poll() events. Returns true when the connection just came
+     * up (CONNACK accepted).
+     */
+    bool onEvents(short revents, PublishHandler handler, void* ctx) {
+        if (_fd < 0) return false;
+        if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            close();
+            return false;
+        }
+        bool up = false;
+        if (_state == CONNECTING && (revents & POLLOUT)) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(_fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err != 0) {
+                close();
+                return false;
+            }
+            sendConnect();
+            _state = WAIT_CONNACK;
+        }
+        if (revents & POLLOUT) flush();
+        if (revents & POLLIN) {
+            char buf[16384];
+            for (;;) {
+                ssize_t n = recv(_fd, buf, sizeof(buf), 0);
+                if (n > 0) {
+                    _in.append(buf, n);
+                    continue;
+                }
+                if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    close();
+                    return false;
+                }
+                break;
+            }
+            up = parse(handler, ctx);
+        }
+        return up;
+    }
+
+    short pollEvents() const {
+        if (_fd < 0) return 0;
+        if (_state == CONNECTING) return POLLOUT;
+        return POLLIN | (pendingBytes() > 0 ? POLLOUT : 0);
+    }
+
+    int fd() const { return _fd; }
+    State state() const { return _state; }
+    uint64_t openNs() const { return _openNs; }
+    size_t pendingBytes() const { return _out.size() - _outPos; }
+
+private:
+    void sendConnect() {
+        size_t idLen = _clientId.size();
+        _out.push_back((char)(MQTT_CONNECT << 4));
+        putRemainingLength(_out, 10 + 2 + idLen);
+        putString(_out, "MQTT", 4);
+        _out.push_back(4);                 // Protocol level 3.1.1
+        _out.push_back(0x02);              // Clean session
+        _out.push_back((char)(KEEPALIVE_S >> 8));
+        _out.push_back((char)(KEEPALIVE_S & 0xFF));
+        putString(_out, _clientId.data(), idLen);
+        _lastSendNs = nowNs();
+        flush();
+    }
+
+    bool flush() {
+        while (_fd >= 0 && _outPos < _out.size()) {
+            ssize_t n = send(_fd, _out.data() + _outPos, _out.size() - _outPos, MSG_NOSIGNAL);
+            if (n > 0) {
+                _outPos += n;
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            close();
+            return false;
+        }
+        if (_outPos == _out.size()) {
+            _out.clear();
+            _outPos = 0;
+        } else if (_outPos > 65536) {
+            _out.erase(0, _outPos);
+            _outPos = 0;
+        }
+        return true;
+    }
+
+    bool parse(PublishHandler handler, void* ctx) {
+        bool up = false;
+        size_t pos = 0;
+        while (_in.size() - pos >= 2) {
+            size_t len = 0, mult = 1, i = pos + 1;
+            bool complete = false;
+            for (; i < _in.size() && i < pos + 5; i++) {
+                uint8_t b = (uint8_t)_in[i];
+                len += (b & 0x7F) * mult;
+                mult *= 128;
+                if (!(b & 0x80)) {
+                    complete = true;
+                    i++;
+                    break;
+                }
+            }
+            if (!complete || _in.size() - i < len) break;
+            uint8_t type = (uint8_t)_in[pos] >> 4;
+            const char* body = _in.data() + i;
+            if (type == MQTT_CONNACK && len >= 2) {
+                if (body[1] != 0) {
+                    fprintf(stderr, "%s: connection refused (%d)\n", _clientId.c_str(), body[1]);
+                    close();
+                    return false;
+                }
+                _state = UP;
+                up = true;
+            } else if (type == MQTT_PUBLISH && len >= 2 && handler) {
+                size_t topicLen = ((uint8_t)body[0] << 8) | (uint8_t)body[1];
+                size_t header = 2 + topicLen + (((uint8_t)_in[pos] & 0x06) ? 2 : 0);
+                if (header <= len) handler(ctx, body + 2, topicLen, body + header, len - header);
+            }
+            pos = i + len;
+        }
+        _in.erase(0, pos);
+        return up;
+    }
+
+    int _fd = -1;
+    State _state = CLOSED;
+    std::string _clientId;
+    std::string _out;
+    size_t _outPos = 0;
+    std::string _in;
+    uint64_t _openNs = 0;
+    uint64_t _lastSendNs = 0;
+    uint16_t _packetId = 0;
+};
+
+// ============================================================================
+// Simulated module
+// ============================================================================
+
+enum TimerKind : uint8_t {
+    T_HARDWARE = 0,     // + HardwareSlot
+    T_SAMPLER = HW_COUNT,
+    T_DERIVED,
+    T_SIDE_REPORT,
+    T_RECONNECT,
+};
+
+struct Timer {
+    uint64_t dueNs;
+    uint32_t module;
+    uint8_t kind;
+    bool operator>(const Timer& o) const { return dueNs > o.dueNs; }
+};
+
+struct Module {
+    std::string id;
+    MqttConn main;
+    MqttConn side;
+    float event[HW_COUNT] = {};
+    uint64_t eventNs[HW_COUNT] = {};
+    float phase = 0;                   // Position in the daily cycle
+    DerivedMetrics derived;
+    bool booted = false;               // Schedules started
+    bool registered = false;
+    bool reconnectPending = false;
+};
+
+/**
+ * @brief Read interval of hw like the firmware sampler: minIntervalMs during
+ * an event, maxIntervalMs when the signal is flat.
+ */
+static uint32_t cadenceMs(const Module& m, uint8_t hw) {
+    return m.event[hw] > EVENT_ACTIVE ? SAMPLER_CONFIG[hw].minIntervalMs : SAMPLER_CONFIG[hw].maxIntervalMs;
+}
+
+/**
+ * @brief One delivery expected by the monitor.
+ */
+struct Pending {
+    uint64_t sentNs;
+    char payload[FIXED_MAX_CHARS];
+};
+
+struct StepResult {
+    int modules = 0;
+    size_t topics = 0;
+    double seconds = 0;
+    uint64_t offered = 0;          // Publishes attempted while connected
+    uint64_t refused = 0;          // Client-side backpressure (send buffer full)
+    uint64_t offline = 0;          // Scheduled while disconnected (firmware drops them)
+    uint64_t delivered = 0;
+    uint64_t lost = 0;
+    uint64_t bytes = 0;
+    std::vector<uint32_t> latencyUs;
+    std::vector<uint32_t> connectUs;
+    uint32_t storms = 0;
+    double brokerCpu = -1;         // % of one core
+    double selfCpu = 0;
+};
+
+class FleetStep {
+public:
+    FleetStep(const Options& o, const sockaddr_in& addr, int modules, int step)
+        : _o(o), _addr(addr), _rng(12345 + step) {
+        _modules.reserve(modules);
+        for (int i = 0; i < modules; i++) {
+            char id[48];
+            snprintf(id, sizeof(id), "%s%d-%04d", o.prefix.c_str(), step, i);
+            _modules.emplace_back(new Module());
+            _modules.back()->id = id;
+            _modules.back()->phase = std::uniform_real_distribution<float>(0, 1)(_rng);
+        }
+        for (uint8_t hw = 0; hw < HW_COUNT; hw++) _compiled[hw] = HARDWARE_COMPILED[hw];
+        for (uint8_t m = 0; m < DM_COUNT; m++) _derivedEnabled[m] = derivedAvailable(m, _compiled);
+    }
+
+    StepResult run() {
+        StepResult r;
+        r.modules = (int)_modules.size();
+        r.topics = topicsPerModule() * _modules.size();
+        _result = &r;
+
+        if (!openMonitor()) {
+            fprintf(stderr, "monitor: cannot connect to %s:%u\n", _o.host.c_str(), _o.port);
+            return r;
+        }
+
+        // Boot: connections spread over the ramp, like modules powering up
+        uint64_t start = nowNs();
+        for (size_t i = 0; i < _modules.size(); i++) {
+            uint64_t at = start + (uint64_t)(_o.rampS * 1e9 * i / _modules.size());
+            _timers.push({ at, (uint32_t)i, T_RECONNECT });
+            _modules[i]->reconnectPending = true;
+        }
+
+        uint64_t measureStart = start + (uint64_t)(_o.rampS * 1e9);
+        uint64_t measureEnd = measureStart + (uint64_t)(_o.durationS * 1e9);
+        uint64_t nextStorm = _o.stormIntervalS > 0 ? measureStart + (uint64_t)(_o.stormIntervalS * 1e9) : UINT64_MAX;
+        uint64_t nextKeepAlive = start;
+        long long brokerStart = _brokerPid ? processTicks(_brokerPid) : -1;
+        double selfStart = 0;
+        bool measuring = false;
+
+        for (;;) {
+            uint64_t now = nowNs();
+            if (!measuring && now >= measureStart) {
+                measuring = true;
+                _measuring = true;
+                brokerStart = _brokerPid ? processTicks(_brokerPid) : -1;
+                selfStart = selfCpuSeconds();
+            }
+            if (now >= measureEnd) break;
+            if (now >= nextStorm) {
+                storm(now);
+                nextStorm += (uint64_t)(_o.stormIntervalS * 1e9);
+            }
+            if (now >= nextKeepAlive) {
+                for (auto& m : _modules) {
+                    m->main.keepAlive(now);
+                    m->side.keepAlive(now);
+                }
+                _monitor.keepAlive(now);
+                nextKeepAlive = now + 1000 * MS;
+            }
+            while (!_timers.empty() && _timers.top().dueNs <= now) {
+                Timer t = _timers.top();
+                _timers.pop();
+                fire(t, now);
+            }
+            uint64_t next = _timers.empty() ? now + 10 * MS : _timers.top().dueNs;
+            pollOnce(next > now ? (int)std::min<uint64_t>((next - now) / MS, 10) : 0);
+        }
+
+        // Measurement window closed: let in-flight messages arrive
+        _measuring = false;
+        double seconds = (nowNs() - measureStart) / 1e9;
+        long long brokerEnd = _brokerPid ? processTicks(_brokerPid) : -1;
+        r.selfCpu = 100.0 * (selfCpuSeconds() - selfStart) / seconds;
+        if (brokerStart >= 0 && brokerEnd >= 0) {
+            r.brokerCpu = 100.0 * (brokerEnd - brokerStart) / sysconf(_SC_CLK_TCK) / seconds;
+        }
+        r.seconds = seconds;
+        uint64_t drainEnd = nowNs() + 2000 * MS;
+        while (nowNs() < drainEnd && outstanding() > 0) pollOnce(10);
+        r.lost += outstanding();
+
+        for (auto& m : _modules) {
+            m->main.close();
+            m->side.close();
+        }
+        _monitor.close();
+        return r;
+    }
+
+    void setBrokerPid(int pid) { _brokerPid = pid; }
+
+private:
+    size_t topicsPerModule() const {
+        size_t n = 0;
+        for (uint8_t ch = 0; ch < CH_COUNT; ch++) n += _compiled[CHANNEL_TABLE[ch].hw];
+        for (uint8_t hw = 0; hw < HW_COUNT; hw++) n += _compiled[hw];      // sampler/{hw}
+        for (uint8_t m = 0; m < DM_COUNT; m++) n += _derivedEnabled[m];
+        return n;
+    }
+
+    // ---- Monitor ----
+
+    bool openMonitor() {
+        char id[48];
+        snprintf(id, sizeof(id), "%s-monitor-%d", _o.prefix.c_str(), (int)getpid());
+        if (!_monitor.open(_addr, id)) return false;
+        int rcv = 4 * 1024 * 1024;
+        setsockopt(_monitor.fd(), SOL_SOCKET, SO_RCVBUF, &rcv, sizeof(rcv));
+        uint64_t deadline = nowNs() + 5000 * MS;
+        while (nowNs() < deadline) {
+            pollfd p = { _monitor.fd(), _monitor.pollEvents(), 0 };
+            if (p.fd < 0) return false;
+            if (poll(&p, 1, 50) > 0 && _monitor.onEvents(p.revents, onDelivery, this)) {
+                _monitor.subscribe("+/+/+");
+                // Give the SUBACK a moment before the fleet starts
+                usleep(200000);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void onDelivery(void* ctx, const char* topic, size_t topicLen, const char* payload, size_t len) {
+        FleetStep* self = (FleetStep*)ctx;
+        uint64_t now = nowNs();
+        auto it = self->_pending.find(std::string(topic, topicLen));
+        if (it == self->_pending.end()) return;     // Not ours (other steps, retained)
+        std::deque<Pending>& q = it->second;
+        // QoS 0 keeps per-topic order: anything ahead of the match was dropped
+        while (!q.empty()) {
+            Pending p = q.front();
+            q.pop_front();
+            if (strlen(p.payload) == len && memcmp(p.payload, payload, len) == 0) {
+                if (p.sentNs != 0) {
+                    self->_result->delivered++;
+                    self->_result->latencyUs.push_back((uint32_t)std::min<uint64_t>((now - p.sentNs) / 1000, UINT32_MAX));
+                }
+                return;
+            }
+            if (p.sentNs != 0) self->_result->lost++;
+        }
+    }
+
+    size_t outstanding() const {
+        size_t n = 0;
+        for (const auto& kv : _pending) {
+            for (const Pending& p : kv.second) n += p.sentNs != 0;
+        }
+        return n;
+    }
+
+    // ---- Module behaviour ----
+
+    void fire(const Timer& t, uint64_t now) {
+        Module& m = *_modules[t.module];
+        if (t.kind == T_RECONNECT) {
+            m.reconnectPending = false;
+            m.registered = false;
+            bool ok = m.main.open(_addr, m.id) && (!_o.side || m.side.open(_addr, m.id + "-side"));
+            if (!ok) {
+                fprintf(stderr, "%s: socket failed (%s)\n", m.id.c_str(), strerror(errno));
+                onDown(t.module, now);
+            }
+            return;
+        }
+        if (t.kind < HW_COUNT) {
+            HardwareSlot hw = (HardwareSlot)t.kind;
+            readHardware(m, hw, now);
+            uint32_t interval = cadenceMs(m, hw);
+            schedule(t.module, t.kind, now, interval);
+        } else if (t.kind == T_SAMPLER) {
+            for (uint8_t hw = 0; hw < HW_COUNT; hw++) {
+                if (!_compiled[hw]) continue;
+                uint32_t interval = cadenceMs(m, hw);
+                char topic[96];
+                snprintf(topic, sizeof(topic), "%s/sampler/%s", m.id.c_str(), HARDWARE_TABLE[hw].id);
+                publishValue(m, topic, 1000.0f / interval, SAMPLER_DECIMALS, now);
+            }
+            schedule(t.module, t.kind, now, RATE_PUBLISH_INTERVAL_MS);
+        } else if (t.kind == T_DERIVED) {
+            if (m.derived.dirty()) {
+                float values[DM_COUNT];
+                m.derived.compute(simMs(now), values);
+                for (uint8_t i = 0; i < DM_COUNT; i++) {
+                    if (!_derivedEnabled[i] || isnan(values[i])) continue;
+                    char topic[96];
+                    snprintf(topic, sizeof(topic), "%s/derived/%s", m.id.c_str(), DERIVED_TABLE[i].measurement);
+                    publishValue(m, topic, values[i], DERIVED_TABLE[i].decimals, now);
+                }
+            }
+            schedule(t.module, t.kind, now, DERIVED_MIN_INTERVAL_MS);
+        } else if (t.kind == T_SIDE_REPORT) {
+            publishSideReports(m);
+            schedule(t.module, t.kind, now, SIDE_REPORT_INTERVAL_MS);
+        }
+    }
+
+    void readHardware(Module& m, HardwareSlot hw, uint64_t now) {
+        // Event: decays, occasionally restarts
+        double dtS = m.eventNs[hw] ? (now - m.eventNs[hw]) / 1e9 * _o.speed : 0;
+        m.eventNs[hw] = now;
+        m.event[hw] *= expf(-(float)dtS / EVENT_DECAY_S);
+        if (std::uniform_real_distribution<float>(0, 1)(_rng) < EVENTS_PER_HOUR * dtS / 3600) m.event[hw] = 1;
+
+        float day = 2 * (float)M_PI * (m.phase + (float)(simMs(now) / 86400000.0));
+        std::normal_distribution<float> gauss(0, 1);
+        for (uint8_t ch = 0; ch < CH_COUNT; ch++) {
+            if (CHANNEL_TABLE[ch].hw != hw) continue;
+            const ValueModel& v = VALUE_MODELS[ch];
+            float value = v.base + v.diurnal * sinf(day) + v.noise * gauss(_rng) + v.eventPeak * m.event[hw];
+            if (value < 0) value = 0;
+            m.derived.observe((Channel)ch, value, simMs(now));
+            char topic[96];
+            snprintf(topic, sizeof(topic), "%s/%s/%s", m.id.c_str(), HARDWARE_TABLE[hw].id, CHANNEL_TABLE[ch].measurement);
+            publishValue(m, topic, value, CHANNEL_TABLE[ch].decimals, now);
+        }
+    }
+
+    /**
+     * @brief Measurement publish of main.cpp MqttSink: brain.publish() on the
+     * IotMesurable connection, "%.2f" payload. Built with
+     * -D SIDE_CHANNEL_MEASUREMENTS, like the firmware: payload at the channel
+     * precision, on the side connection while it is up.
+     */
+    void publishValue(Module& m, const char* topic, float value, uint8_t decimals, uint64_t now) {
+#ifdef SIDE_CHANNEL_MEASUREMENTS
+        MqttConn& conn = m.side.state() == MqttConn::UP ? m.side : m.main;
+#else
+        MqttConn& conn = m.main;
+        decimals = BRAIN_DECIMALS;
+#endif
+        if (!_measuring) {
+            // Warm-up (ramp): traffic without statistics
+            char payload[FIXED_MAX_CHARS];
+            size_t len = formatFixed(payload, sizeof(payload), value, decimals);
+            if (m.registered) conn.publish(topic, payload, len);
+            return;
+        }
+        if (!m.registered) {
+            _result->offline++;
+            return;
+        }
+        Pending p;
+        size_t len = formatFixed(p.payload, sizeof(p.payload), value, decimals);
+        _result->offered++;
+        if (!conn.publish(topic, p.payload, len)) {
+            _result->refused++;
+            return;
+        }
+        p.sentNs = now;
+        _result->bytes += 2 + 2 + strlen(topic) + len;
+        _pending[topic].push_back(p);
+    }
+
+    /**
+     * @brief Registration on (re)connect: the hardware / measurement set of
+     * main.cpp setup(), retained, plus the status report and subscriptions.
+     */
+    void registerModule(Module& m) {
+        std::string config = "{\"moduleType\":\"air-quality-bench\",\"profile\":\"" PROFILE_NAME "\",\"hardware\":[";
+        bool firstHw = true;
+        auto addHardware = [&](const char* id, const char* name, const std::vector<const char*>& sensors) {
+            config += firstHw ? "" : ",";
+            firstHw = false;
+            config += std::string("{\"id\":\"") + id + "\",\"name\":\"" + name + "\",\"sensors\":[";
+            for (size_t i = 0; i < sensors.size(); i++) config += (i ? ",\"" : "\"") + std::string(sensors[i]) + "\"";
+            config += "]}";
+        };
+        std::vector<const char*> samplerSensors, derivedSensors;
+        for (uint8_t hw = 0; hw < HW_COUNT; hw++) {
+            if (!_compiled[hw]) continue;
+            std::vector<const char*> sensors;
+            for (uint8_t ch = 0; ch < CH_COUNT; ch++) {
+                if (CHANNEL_TABLE[ch].hw == hw) sensors.push_back(CHANNEL_TABLE[ch].measurement);
+            }
+            addHardware(HARDWARE_TABLE[hw].id, HARDWARE_TABLE[hw].name, sensors);
+            samplerSensors.push_back(HARDWARE_TABLE[hw].id);
+        }
+        addHardware("sampler", "Adaptive Sampling Rate (Hz)", samplerSensors);
+        for (uint8_t i = 0; i < DM_COUNT; i++) {
+            if (_derivedEnabled[i]) derivedSensors.push_back(DERIVED_TABLE[i].measurement);
+        }
+        addHardware("derived", "Derived Metrics", derivedSensors);
+        config += "]}";
+
+        std::string topic = m.id + "/system/config";
+        m.main.publish(topic.c_str(), config.data(), config.size(), true);
+
+        std::string status = "{";
+        for (uint8_t hw = 0; hw < HW_COUNT; hw++) {
+            if (!_compiled[hw]) continue;
+            status += (status.size() > 1 ? ",\"" : "\"") + std::string(HARDWARE_TABLE[hw].id) + "\":\"ok\"";
+        }
+        status += "}";
+        topic = m.id + "/sensors/status";
+        m.main.publish(topic.c_str(), status.data(), status.size(), true);
+
+        m.main.subscribe((m.id + "/sensors/reset").c_str());
+        m.main.subscribe((m.id + "/sensors/config").c_str());
+        m.registered = true;
+    }
+
+    void publishSideReports(Module& m) {
+        if (m.side.state() != MqttConn::UP) return;
+        // Sizes of the CompareService and ResourceMonitor reports
+        static const std::string compare(1100, 'c');
+        static const std::string resources(900, 'r');
+        m.side.publish((m.id + "/compare").c_str(), compare.data(), compare.size());
+        m.side.publish((m.id + "/system/resources").c_str(), resources.data(), resources.size());
+    }
+
+    void onUp(uint32_t index, bool side, uint64_t now) {
+        Module& m = *_modules[index];
+        MqttConn& c = side ? m.side : m.main;
+        if (_measuring) _result->connectUs.push_back((uint32_t)((now - c.openNs()) / 1000));
+        if (side) {
+            m.side.subscribe((m.id + "/history/get").c_str());
+            return;
+        }
+        registerModule(m);
+        if (m.booted) return;
+        m.booted = true;
+        // First boot: start every schedule with a random offset
+        for (uint8_t hw = 0; hw < HW_COUNT; hw++) {
+            if (_compiled[hw]) schedule(index, hw, now, std::uniform_int_distribution<uint32_t>(0, SAMPLER_CONFIG[hw].maxIntervalMs)(_rng));
+        }
+        schedule(index, T_SAMPLER, now, std::uniform_int_distribution<uint32_t>(0, RATE_PUBLISH_INTERVAL_MS)(_rng));
+        schedule(index, T_DERIVED, now, DERIVED_MIN_INTERVAL_MS);
+        if (_o.side) schedule(index, T_SIDE_REPORT, now, std::uniform_int_distribution<uint32_t>(0, SIDE_REPORT_INTERVAL_MS)(_rng));
+    }
+
+    void onDown(uint32_t index, uint64_t now) {
+        Module& m = *_modules[index];
+        m.registered = false;
+        if (m.reconnectPending) return;
+        m.reconnectPending = true;
+        m.main.close();
+        m.side.close();
+        schedule(index, T_RECONNECT, now, RECONNECT_MIN_MS, false);
+    }
+
+    /**
+     * @brief Reconnect storm: a share of the fleet loses its link at once
+     * (AP reboot) and comes back within the jitter window.
+     */
+    void storm(uint64_t now) {
+        _result->storms++;
+        std::uniform_real_distribution<double> u(0, 1);
+        for (uint32_t i = 0; i < _modules.size(); i++) {
+            Module& m = *_modules[i];
+            if (m.reconnectPending || u(_rng) >= _o.stormFraction) continue;
+            m.main.close();
+            m.side.close();
+            m.registered = false;
+            m.reconnectPending = true;
+            uint64_t delay = RECONNECT_MIN_MS * MS + (uint64_t)(u(_rng) * _o.stormJitterS * 1e9);
+            _timers.push({ now + delay, i, T_RECONNECT });
+        }
+    }
+
+    void schedule(uint32_t index, uint8_t kind, uint64_t now, uint32_t intervalMs, bool scaled = true) {
+        double ms = scaled ? intervalMs / _o.speed : intervalMs;
+        ms *= std::uniform_real_distribution<double>(0.95, 1.05)(_rng);
+        _timers.push({ now + (uint64_t)(ms * MS), index, kind });
+    }
+
+    uint32_t simMs(uint64_t now) const {
+        return (uint32_t)((now / MS) * _o.speed);
+    }
+
+    // ---- I/O ----
+
+    void pollOnce(int timeoutMs) {
+        _fds.clear();
+        _owners.clear();
+        auto add = [&](MqttConn& c, int32_t owner) {
+            if (c.fd() < 0) return;
+            _fds.push_back({ c.fd(), c.pollEvents(), 0 });
+            _owners.push_back(owner);
+        };
+        add(_monitor, -1);
+        for (uint32_t i = 0; i < _modules.size(); i++) {
+            add(_modules[i]->main, (int32_t)(i * 2));
+            add(_modules[i]->side, (int32_t)(i * 2 + 1));
+        }
+        if (poll(_fds.data(), _fds.size(), timeoutMs) <= 0) return;
+        uint64_t now = nowNs();
+        for (size_t k = 0; k < _fds.size(); k++) {
+            short ev = _fds[k].revents;
+            if (!ev) continue;
+            int32_t owner = _owners[k];
+            if (owner < 0) {
+                _monitor.onEvents(ev, onDelivery, this);
+                if (_monitor.state() == MqttConn::CLOSED) fprintf(stderr, "monitor: connection lost\n");
+                continue;
+            }
+            uint32_t index = owner / 2;
+            bool side = owner & 1;
+            MqttConn& c = side ? _modules[index]->side : _modules[index]->main;
+            if (c.onEvents(ev, nullptr, nullptr)) onUp(index, side, now);
+            if (c.state() == MqttConn::CLOSED) onDown(index, now);
+        }
+    }
+
+    const Options& _o;
+    sockaddr_in _addr;
+    std::mt19937 _rng;
+    std::vector<std::unique_ptr<Module>> _modules;
+    bool _compiled[HW_COUNT];
+    bool _derivedEnabled[DM_COUNT];
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> _timers;
+    std::unordered_map<std::string, std::deque<Pending>> _pending;
+    MqttConn _monitor;
+    std::vector<pollfd> _fds;
+    std::vector<int32_t> _owners;
+    StepResult* _result = nullptr;
+    bool _measuring = false;
+    int _brokerPid = 0;
+};
+
+// ============================================================================
+// Report
+// ============================================================================
+
+static double percentileMs(std::vector<uint32_t>& v, double p) {
+    if (v.empty()) return NAN;
+    size_t k = (size_t)(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k] / 1000.0;
+}
+
+static void printHeader(FILE* out) {
+    fprintf(out, "%6s %7s %9s %9s %8s %8s %7s %8s %8s %8s %8s %9s %7s %7s\n",
+            "N", "topics", "offer/s", "deliv/s", "KB/s", "lost%", "refused",
+            "p50 ms", "p90 ms", "p99 ms", "max ms", "conn p99", "broker", "self");
+}
+
+static void printRow(FILE* out, StepResult& r) {
+    double lostPct = r.offered ? 100.0 * (r.lost + r.refused) / r.offered : 0;
+    double p50 = percentileMs(r.latencyUs, 0.50);
+    double p90 = percentileMs(r.latencyUs, 0.90);
+    double p99 = percentileMs(r.latencyUs, 0.99);
+    double pmax = percentileMs(r.latencyUs, 1.0);
+    double c99 = percentileMs(r.connectUs, 0.99);
+    char broker[16];
+    if (r.brokerCpu < 0) snprintf(broker, sizeof(broker), "n/a");
+    else snprintf(broker, sizeof(broker), "%.0f%%", r.brokerCpu);
+    fprintf(out, "%6d %7zu %9.0f %9.0f %8.1f %8.2f %7llu %8.2f %8.2f %8.2f %8.1f %9.1f %7s %6.0f%%\n",
+            r.modules, r.topics, r.offered / r.seconds, r.delivered / r.seconds,
+            r.bytes / r.seconds / 1024, lostPct, (unsigned long long)r.refused,
+            p50, p90, p99, pmax, c99, broker, r.selfCpu);
+}
+
+static void writeCsv(FILE* f, StepResult& r, bool header) {
+    if (header) {
+        fprintf(f, "modules,topics,seconds,offered,delivered,lost,refused,offline,bytes,"
+                   "p50_ms,p90_ms,p99_ms,max_ms,connect_p50_ms,connect_p99_ms,storms,broker_cpu,self_cpu\n");
+    }
+    fprintf(f, "%d,%zu,%.2f,%llu,%llu,%llu,%llu,%llu,%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%u,%.1f,%.1f\n",
+            r.modules, r.topics, r.seconds, (unsigned long long)r.offered, (unsigned long long)r.delivered,
+            (unsigned long long)r.lost, (unsigned long long)r.refused, (unsigned long long)r.offline,
+            (unsigned long long)r.bytes, percentileMs(r.latencyUs, 0.5), percentileMs(r.latencyUs, 0.9),
+            percentileMs(r.latencyUs, 0.99), percentileMs(r.latencyUs, 1.0), percentileMs(r.connectUs, 0.5),
+            percentileMs(r.connectUs, 0.99), r.storms, r.brokerCpu, r.selfCpu);
+}
+
+/**
+ * @brief A step saturates when deliveries are lost, the tail latency exceeds
+ * one second or the broker uses most of a core.
+ */
+static bool saturated(StepResult& r) {
+    double lostPct = r.offered ? 100.0 * (r.lost + r.refused) / r.offered : 0;
+    return lostPct > 1.0 || percentileMs(r.latencyUs, 0.99) > 1000 || r.brokerCpu > 80;
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(int argc, char** argv) {
+    Options o;
+    if (!parseOptions(argc, argv, o)) {
+        usage(argv[0]);
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    addrinfo hints = {}, *res = nullptr;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    char port[8];
+    snprintf(port, sizeof(port), "%u", o.port);
+    if (getaddrinfo(o.host.c_str(), port, &hints, &res) != 0 || !res) {
+        fprintf(stderr, "cannot resolve %s\n", o.host.c_str());
+        return 1;
+    }
+    sockaddr_in addr = *(sockaddr_in*)res->ai_addr;
+    freeaddrinfo(res);
+
+    int brokerPid = o.brokerPid ? o.brokerPid : findProcess("mosquitto");
+    rlimit fdLimit;
+    getrlimit(RLIMIT_NOFILE, &fdLimit);
+    int maxModules = *std::max_element(o.sweep.begin(), o.sweep.end());
+    if ((rlim_t)(2 * maxModules + 16) > fdLimit.rlim_cur) {
+        fprintf(stderr, "warning: fd limit %llu too low for %d modules (ulimit -n)\n",
+                (unsigned long long)fdLimit.rlim_cur, maxModules);
+    }
+
+    printf("Profile %s, %s:%u, speed x%.1f, %.0f s per step%s\n", PROFILE_NAME, o.host.c_str(), o.port,
+           o.speed, o.durationS, o.side ? ", with side channel" : "");
+    if (o.stormIntervalS > 0) {
+        printf("Reconnect storm every %.0f s: %.0f%% of modules, back within %.1f s\n",
+               o.stormIntervalS, o.stormFraction * 100, RECONNECT_MIN_MS / 1000.0 + o.stormJitterS);
+    }
+    if (brokerPid) printf("Broker CPU from pid %d\n", brokerPid);
+    else printf("Broker process not found: CPU not reported (--broker-pid)\n");
+    printf("\n");
+    printHeader(stdout);
+
+    FILE* csv = o.csv.empty() ? nullptr : fopen(o.csv.c_str(), "w");
+    int saturation = 0;
+    for (size_t i = 0; i < o.sweep.size(); i++) {
+        FleetStep step(o, addr, o.sweep[i], (int)i);
+        step.setBrokerPid(brokerPid);
+        StepResult r = step.run();
+        if (r.seconds <= 0) return 1;
+        printRow(stdout, r);
+        fflush(stdout);
+        if (csv) writeCsv(csv, r, i == 0);
+        if (!saturation && saturated(r)) saturation = r.modules;
+        if (r.selfCpu > 90) {
+            printf("  (load generator CPU-bound: latency above includes its own queueing)\n");
+        }
+    }
+    if (csv) fclose(csv);
+
+    printf("\n");
+    if (saturation) {
+        printf("Per-measurement topics saturate at %d modules (loss > 1%%, p99 > 1 s or broker > 80%% CPU)\n",
+               saturation);
+    } else {
+        printf("No saturation up to %d modules\n", maxModules);
+    }
+    return 0;
+}